@@ -0,0 +1,52 @@
+#ifndef MP_FACE_LANDMARKER_BLENDSHAPE_BINDING_H
+#define MP_FACE_LANDMARKER_BLENDSHAPE_BINDING_H
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+// Landmarker category index -> morph target slot, resolved once per key list
+// by BindBlendshapes(). Unknown names map to the scratch slot right after
+// the last morph target, so applying a frame needs no branches.
+struct BlendshapeBinding {
+  int count = 0;
+  int slots[52] = {0};
+};
+
+//
+// Binds landmarker `keys` to the morph targets of a primitive with
+// `targetCount` targets, named by `targetNames`(name -> target index, e.g.
+// from mesh.extras.targetNames). Keys without a target, and names whose index
+// is not below `targetCount`, get the scratch slot `targetCount`.
+//
+inline void BindBlendshapes(const std::vector<std::string> &keys,
+                            const std::map<std::string, int> &targetNames,
+                            size_t targetCount, BlendshapeBinding *binding) {
+  const int scratch = static_cast<int>(targetCount);
+  binding->count = static_cast<int>(std::min<size_t>(keys.size(), 52));
+  for (int i = 0; i < binding->count; i++) {
+    std::map<std::string, int>::const_iterator it = targetNames.find(keys[i]);
+    binding->slots[i] = scratch;
+    if (it != targetNames.end() && it->second >= 0 && it->second < scratch) {
+      binding->slots[i] = it->second;
+    }
+  }
+}
+
+//
+// influences[binding.slots[i]] = weights[i]; all other influences become 0.
+// `influences` holds `targetCount + 1` floats, the last being the scratch
+// slot.
+//
+inline void ApplyBlendshapes(const float *weights,
+                             const BlendshapeBinding &binding,
+                             float *influences, size_t targetCount) {
+  std::fill(influences, influences + targetCount + 1, 0.0f);
+  for (int i = 0; i < binding.count; i++) {
+    influences[binding.slots[i]] = weights[i];
+  }
+}
+
+#endif  // MP_FACE_LANDMARKER_BLENDSHAPE_BINDING_H
@@ -0,0 +1,61 @@
+#ifndef MP_FACE_LANDMARKER_FACE_FRAME_CHANNEL_H
+#define MP_FACE_LANDMARKER_FACE_FRAME_CHANNEL_H
+
+#include <atomic>
+#include <cstdint>
+
+// One face landmarker result.
+struct alignas(64) FaceFrame {
+  float weights[52] = {0.0f};      // blendshape scores, landmarker order
+  float matrix[4][4] = {{0.0f}};   // facial transformation matrix
+  int64_t timestampNs = 0;         // steady clock, when it was published
+};
+
+//
+// Lock-free triple buffer handing values from one producer thread (JNI) to
+// one consumer thread (GL).
+//
+// The producer fills the slot from BeginWrite() and calls Publish(); the
+// consumer calls Acquire() and reads Latest(). Neither side ever blocks, the
+// consumer always sees the most recent complete value, and a value is never
+// mixed with another one.
+//
+template <typename T>
+class TripleBuffer {
+ public:
+  // Producer only.
+  T &BeginWrite() { return frames_[back_]; }
+
+  // Producer only. Makes the value from BeginWrite() the latest one.
+  void Publish() {
+    const int prev =
+        middle_.exchange(back_ | kFresh, std::memory_order_acq_rel);
+    back_ = prev & kIndexMask;
+  }
+
+  // Consumer only. Returns true when a newer value became Latest().
+  bool Acquire() {
+    if ((middle_.load(std::memory_order_relaxed) & kFresh) == 0) {
+      return false;
+    }
+    const int prev = middle_.exchange(front_, std::memory_order_acq_rel);
+    front_ = prev & kIndexMask;
+    return true;
+  }
+
+  // Consumer only. Stays valid until the next Acquire().
+  const T &Latest() const { return frames_[front_]; }
+
+ private:
+  static const int kIndexMask = 3;
+  static const int kFresh = 4;
+
+  T frames_[3];
+  std::atomic<int> middle_{1};  // slot index | kFresh
+  int back_ = 0;                // owned by the producer
+  int front_ = 2;               // owned by the consumer
+};
+
+typedef TripleBuffer<FaceFrame> FaceFrameChannel;
+
+#endif  // MP_FACE_LANDMARKER_FACE_FRAME_CHANNEL_H
@@ -1,10 +1,13 @@
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <limits>
 #include <string>
+#include <thread>
 #include <vector>
 #include <sstream>
 
@@ -13,6 +16,9 @@
 #include <EGL/egl.h>
 #include <GLES3/gl3.h>
 #include "trackball.h"
+#include "morph_evaluator.h"
+#include "skin_evaluator.h"
+#include "worker_pool.h"
 #define TINYGLTF_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -35,6 +41,8 @@ out vec3 normal;
 out vec2 texcoord;
 
 uniform mat4 modelViewProjectionMatrix;
+uniform mat4 nodeMatrix;
+uniform mat3 nodeNormalMatrix;
 uniform float morphTargetBaseInfluence;
 uniform float morphTargetInfluences[MORPHTARGETS_COUNT];
 uniform sampler2DArray morphTargetsTexture;
@@ -59,11 +67,12 @@ void main(void)
       if (morphTargetInfluences[i] != 0.0) transformed += getMorph( gl_VertexID, i, 0 ).xyz * morphTargetInfluences[ i ];
     }
   }
-  vec4 p = modelViewProjectionMatrix * vec4(transformed, 1);
+  vec4 p = modelViewProjectionMatrix * nodeMatrix * vec4(transformed, 1);
   gl_Position = p;
 
 
-  vec4 nn = inverse(modelViewProjectionMatrix) * vec4(normalize(in_normal), 0);
+  vec4 nn = inverse(modelViewProjectionMatrix) *
+            vec4(normalize(nodeNormalMatrix * in_normal), 0);
   normal = nn.xyz;
 
   texcoord = in_texcoord;
@@ -124,12 +133,6 @@ std::map<int, GLCurvesState> gCurvesMesh;
 GLProgramState gGLProgramState;
 GLuint gGLVao;
 
-class BlendShapesInfluences {
-public:
-  std::map<std::string, float> influences;
-  float matrix[16] = {0.f};
-};
-
 typedef std::map<int, std::map<std::string, int> > MorphTargets;
 
 class MorphTargetInfo {
@@ -137,22 +140,14 @@ public:
   MorphTargetInfo() {
   }
   
-  void applyFaceMesh(const BlendShapesInfluences& shapes) {
+  void applyFaceFrame(const FaceFrame &frame, const BlendshapeBinding &binding) {
     if (targetCount == 0) {
-      std::cout << "applyFaceMesh, not loaded" << std::endl;
+      std::cout << "applyFaceFrame, not loaded" << std::endl;
       return;
     }
-    assert(!influences.empty());
-    for (auto &it : influences)
-      it = 0.0f;
-    
-    for (const auto &it : shapes.influences) {
-      const std::string name = it.first;
-      float influence = it.second;
-      int idx = targetMap[name];
-      assert(idx >= 0 && idx < targetCount);
-      influences[idx] = influence;
-    }
+    // `influences` has one extra scratch slot for unbound keys.
+    assert(influences.size() == targetCount + 1);
+    ApplyBlendshapes(frame.weights, binding, influences.data(), targetCount);
   }
   
   int meshId = 0;
@@ -168,12 +163,38 @@ public:
   size_t targetCount = 0;
   std::vector<float> influences;
   std::map<std::string, int> targetMap;
+  // Vertex buffer with CPU-blended positions (and normals), see
+  // SetupCpuMorph(). Zero when blending on the GPU from the morph texture.
+  GLuint morphedVb = 0;
 };
 
-void CheckErrors(std::string desc) {
+// CPU blending state, used when the morph texture path is unavailable.
+MorphEvaluator cpuMorph;
+std::vector<float> cpuMorphVertices;
+// Blendshape weights below this barely move the mesh; skip them on the CPU.
+const float kCpuMorphMinWeight = 1e-3f;
+
+// A primitive posed on the CPU from gScene every frame.
+struct SkinnedPrimitive {
+  SkinEvaluator evaluator;
+  GLuint vb = 0;  // posed positions (and normals)
+  std::vector<float> vertices;
+  bool morphed = false;  // skins cpuMorphVertices instead of the base mesh
+  // Vertex ranges handed to gSkinPool, split once in BuildDrawList().
+  // Empty when the primitive is skinned on the render thread alone.
+  std::vector<size_t> rangeStarts;  // one more than there are ranges
+};
+std::vector<SkinnedPrimitive> gSkinned;
+// Meshes with fewer vertices per available thread are skinned on the render
+// thread alone; waking workers would cost more than it saves.
+const size_t kSkinVerticesPerThread = 16384;
+// Started once by BuildDrawList() when a mesh is large enough to split.
+WorkerPool gSkinPool;
+
+void CheckErrors(const char *desc) {
   GLenum e = glGetError();
   if (e != GL_NO_ERROR) {
-    fprintf(stderr, "OpenGL error in \"%s\": %d (%d)\n", desc.c_str(), e, e);
+    fprintf(stderr, "OpenGL error in \"%s\": %d (%d)\n", desc, e, e);
     exit(20);
   }
 }
@@ -184,26 +205,6 @@ static std::string GetFilePathExtension(const std::string &FileName) {
   return "";
 }
 
-static size_t ComponentTypeByteSize(int type) {
-  switch (type) {
-    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-    case TINYGLTF_COMPONENT_TYPE_BYTE:
-      return sizeof(char);
-    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-    case TINYGLTF_COMPONENT_TYPE_SHORT:
-      return sizeof(short);
-    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
-    case TINYGLTF_COMPONENT_TYPE_INT:
-      return sizeof(int);
-    case TINYGLTF_COMPONENT_TYPE_FLOAT:
-      return sizeof(float);
-    case TINYGLTF_COMPONENT_TYPE_DOUBLE:
-      return sizeof(double);
-    default:
-      return 0;
-  }
-}
-
 static tinygltf::Texture* findTextureByName(tinygltf::Model &model, const std::string& name) {
   for (auto it = model.textures.begin(); it != model.textures.end(); it++) {
     if (it->name == name) {
@@ -246,95 +247,41 @@ static void SetupMeshState(tinygltf::Model &model, GLuint progId) {
       GLBufferState state;
       glGenBuffers(1, &state.vb);
       glBindBuffer(bufferView.target, state.vb);
-      std::cout << "buffer.size= " << buffer.data.size()
+      std::cout << "buffer.size= " << buffer.Size()
                 << ", byteOffset = " << bufferView.byteOffset << std::endl;
 
       if (sparse_accessor < 0)
         glBufferData(bufferView.target, bufferView.byteLength,
-                     &buffer.data.at(0) + bufferView.byteOffset,
+                     buffer.Data() + bufferView.byteOffset,
                      GL_STATIC_DRAW);
       else {
-        const auto accessor = model.accessors[sparse_accessor];
+        const auto &accessor = model.accessors[sparse_accessor];
         // copy the buffer to a temporary one for sparse patching
-        unsigned char *tmp_buffer = new unsigned char[bufferView.byteLength];
-        memcpy(tmp_buffer, buffer.data.data() + bufferView.byteOffset,
-               bufferView.byteLength);
-
-        const size_t size_of_object_in_buffer =
-            ComponentTypeByteSize(accessor.componentType);
-        const size_t size_of_sparse_indices =
-            ComponentTypeByteSize(accessor.sparse.indices.componentType);
-
-        const auto &indices_buffer_view =
-            model.bufferViews[accessor.sparse.indices.bufferView];
-        const auto &indices_buffer = model.buffers[indices_buffer_view.buffer];
-
-        const auto &values_buffer_view =
-            model.bufferViews[accessor.sparse.values.bufferView];
-        const auto &values_buffer = model.buffers[values_buffer_view.buffer];
-
-        for (size_t sparse_index = 0; sparse_index < accessor.sparse.count;
-             ++sparse_index) {
-          int index = 0;
-          // std::cout << "accessor.sparse.indices.componentType = " <<
-          // accessor.sparse.indices.componentType << std::endl;
-          switch (accessor.sparse.indices.componentType) {
-            case TINYGLTF_COMPONENT_TYPE_BYTE:
-            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-              index = (int)*(
-                  unsigned char *)(indices_buffer.data.data() +
-                                   indices_buffer_view.byteOffset +
-                                   accessor.sparse.indices.byteOffset +
-                                   (sparse_index * size_of_sparse_indices));
-              break;
-            case TINYGLTF_COMPONENT_TYPE_SHORT:
-            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-              index = (int)*(
-                  unsigned short *)(indices_buffer.data.data() +
-                                    indices_buffer_view.byteOffset +
-                                    accessor.sparse.indices.byteOffset +
-                                    (sparse_index * size_of_sparse_indices));
-              break;
-            case TINYGLTF_COMPONENT_TYPE_INT:
-            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
-              index = (int)*(
-                  unsigned int *)(indices_buffer.data.data() +
-                                  indices_buffer_view.byteOffset +
-                                  accessor.sparse.indices.byteOffset +
-                                  (sparse_index * size_of_sparse_indices));
-              break;
+        std::vector<unsigned char> tmp(
+            buffer.Data() + bufferView.byteOffset,
+            buffer.Data() + bufferView.byteOffset + bufferView.byteLength);
+
+        std::vector<unsigned char> dense;
+        std::string err;
+        const int stride = accessor.ByteStride(bufferView);
+        if (stride > 0 &&
+            tinygltf::ResolveSparseAccessor(model, accessor, &dense, &err)) {
+          const size_t element_size =
+              size_t(tinygltf::GetComponentSizeInBytes(
+                  uint32_t(accessor.componentType))) *
+              size_t(tinygltf::GetNumComponentsInType(
+                  uint32_t(accessor.type)));
+          for (size_t e = 0; e < accessor.count; e++) {
+            memcpy(tmp.data() + accessor.byteOffset + e * size_t(stride),
+                   dense.data() + e * element_size, element_size);
           }
-          std::cout << "updating sparse data at index  : " << index
+        } else {
+          std::cerr << "Failed to resolve sparse accessor: " << err
                     << std::endl;
-          // index is now the target of the sparse index to patch in
-          const unsigned char *read_from =
-              values_buffer.data.data() +
-              (values_buffer_view.byteOffset +
-               accessor.sparse.values.byteOffset) +
-              (sparse_index * (size_of_object_in_buffer * accessor.type));
-
-          /*
-          std::cout << ((float*)read_from)[0] << "\n";
-          std::cout << ((float*)read_from)[1] << "\n";
-          std::cout << ((float*)read_from)[2] << "\n";
-          */
-
-          unsigned char *write_to =
-              tmp_buffer + index * (size_of_object_in_buffer * accessor.type);
-
-          memcpy(write_to, read_from, size_of_object_in_buffer * accessor.type);
         }
 
-        // debug:
-        /*for(size_t p = 0; p < bufferView.byteLength/sizeof(float); p++)
-        {
-          float* b = (float*)tmp_buffer;
-          std::cout << "modified_buffer [" << p << "] = " << b[p] << '\n';
-        }*/
-
-        glBufferData(bufferView.target, bufferView.byteLength, tmp_buffer,
+        glBufferData(bufferView.target, bufferView.byteLength, tmp.data(),
                      GL_STATIC_DRAW);
-        delete[] tmp_buffer;
       }
       glBindBuffer(bufferView.target, 0);
 
@@ -365,6 +312,11 @@ static void SetupMeshState(tinygltf::Model &model, GLuint progId) {
 					if (texIt) {
 						if (texIt->source >= 0) {
               tinygltf::Image &image = model.images[texIt->source];
+              std::string err, warn;
+              if (!modelLoader.DecodeImage(&model, texIt->source, &err, &warn)) {
+                std::cerr << "Failed to decode image: " << err << std::endl;
+                continue;
+              }
 							GLuint texId;
 							glGenTextures(1, &texId);
               GLenum texTarget = GL_TEXTURE_2D; //tex.target
@@ -382,6 +334,8 @@ static void SetupMeshState(tinygltf::Model &model, GLuint progId) {
 									image.height, 0, format, GL_UNSIGNED_BYTE,
 									&image.image.at(0));
               glGenerateMipmap(texTarget);
+              // Pixels live on the GPU now.
+              image.ReleaseDecoded();
 
 							CheckErrors("texImage2D");
 							glBindTexture(texTarget, 0);
@@ -578,54 +532,111 @@ static void SetupCurvesState(tinygltf::Scene &scene, GLuint progId) {
 };
 #endif
 
-static void DrawMesh(tinygltf::Model &model, const tinygltf::Mesh &mesh, const MorphTargetInfo& morphInfo) {
-  if (gGLProgramState.uniforms["diffuseTex"] >= 0) {
-    glUniform1i(gGLProgramState.uniforms["diffuseTex"], 0);  // TEXTURE0
-  }
-
-  if (gGLProgramState.uniforms["isCurvesLoc"] >= 0) {
-    glUniform1i(gGLProgramState.uniforms["isCurvesLoc"], 1);
-  }
-  
-  if (gGLProgramState.uniforms["morphTargetBaseInfluence"] >= 0) {
-    glUniform1f(gGLProgramState.uniforms["morphTargetBaseInfluence"], 1.f);
+// One primitive, ready to draw: vertex/index bindings live in `vao`.
+typedef struct {
+  GLuint vao;
+  GLuint diffuseTex;
+  GLenum mode;
+  GLsizei indexCount;
+  GLenum indexType;
+  size_t indexOffset;
+  int hasTargets;  // uses the morph target texture
+  // Node in gScene whose world transform, which also dequantizes
+  // KHR_mesh_quantization positions, places the primitive.
+  size_t sceneNode;
+  int skinned;  // index into gSkinned, -1 when not skinned
+} DrawItem;
+
+// Uniform locations used by DrawModel(), resolved once in BuildDrawList().
+typedef struct {
+  GLint diffuseTex;
+  GLint isCurves;
+  GLint morphTargetBaseInfluence;
+  GLint morphTargetInfluences;
+  GLint morphTargetsTextureSize;
+  GLint morphTargetsTexture;
+  GLint hasTargets;
+  GLint nodeMatrix;
+  GLint nodeNormalMatrix;
+} DrawUniforms;
+
+std::vector<DrawItem> gDrawList;
+DrawUniforms gDrawUniforms;
+tinygltf::FlatScene gScene;
+
+// Inverse transpose of the upper 3x3 of `m`, i.e. its cofactors / det.
+static void NormalMatrix(const float m[16], float n[3][3]) {
+  for (int c = 0; c < 3; c++) {
+    const float *a = m + ((c + 1) % 3) * 4;
+    const float *b = m + ((c + 2) % 3) * 4;
+    n[c][0] = a[1] * b[2] - a[2] * b[1];
+    n[c][1] = a[2] * b[0] - a[0] * b[2];
+    n[c][2] = a[0] * b[1] - a[1] * b[0];
   }
-
-  if (gGLProgramState.uniforms["morphTargetInfluences"] >= 0) {
-    GLfloat *v = new GLfloat[morphInfo.targetCount];
-    memset(v, 0, sizeof(GLfloat) * morphInfo.targetCount);
-    if (morphInfo.meshName == mesh.name) {
-      for (int i = 0; i < morphInfo.targetCount; i++) {
-        v[i] = morphInfo.influences[i];
-      }
-    }
-    glUniform1fv(gGLProgramState.uniforms["morphTargetInfluences"], morphInfo.targetCount, v);
-    delete [] v;
+  const float det = m[0] * n[0][0] + m[1] * n[0][1] + m[2] * n[0][2];
+  const float inv = det != 0.0f ? 1.0f / det : 1.0f;
+  for (int c = 0; c < 3; c++) {
+    for (int k = 0; k < 3; k++) n[c][k] *= inv;
   }
+}
 
-  if (gGLProgramState.uniforms["morphTargetsTextureSize"] >= 0) {
-    glUniform2i(gGLProgramState.uniforms["morphTargetsTextureSize"], morphInfo.width, morphInfo.height);
-  }
-  
-  int hasTargets = 0;
-  if (gGLProgramState.uniforms["morphTargetsTexture"] >= 0) {
-    glUniform1i(gGLProgramState.uniforms["morphTargetsTexture"], 1);  // TEXTURE1
-    if (morphInfo.meshName == mesh.name) {
-      hasTargets = 1;
-    }
-  }
-  if (gGLProgramState.uniforms["hasTargets"] >= 0) {
-    glUniform1i(gGLProgramState.uniforms["hasTargets"], hasTargets);
+// Sets up CPU skinning of `primitive` by `model.skins[skin]` and returns its
+// index into gSkinned, or -1 when it isn't skinned.
+static int SetupSkinnedPrimitive(const tinygltf::Model &model,
+                                 const tinygltf::Primitive &primitive,
+                                 int skin, bool morphed) {
+  if (skin < 0 || primitive.attributes.count("JOINTS_0") == 0) return -1;
+  SkinnedPrimitive skinned;
+  std::string err;
+  if (!skinned.evaluator.Init(model, primitive, skin, &err)) {
+    std::cerr << "Skinning setup failed: " << err << std::endl;
+    return -1;
   }
+  skinned.morphed = morphed;
+  skinned.vertices.resize(skinned.evaluator.FloatCount());
+  glGenBuffers(1, &skinned.vb);
+  glBindBuffer(GL_ARRAY_BUFFER, skinned.vb);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * skinned.vertices.size(),
+               nullptr, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  gSkinned.push_back(std::move(skinned));
+  return static_cast<int>(gSkinned.size() - 1);
+}
 
+static void PrepareMesh(tinygltf::Model &model, const tinygltf::Mesh &mesh,
+                        size_t sceneNode, int skin,
+                        const MorphTargetInfo& morphInfo) {
   for (size_t i = 0; i < mesh.primitives.size(); i++) {
     const tinygltf::Primitive &primitive = mesh.primitives[i];
 
     if (primitive.indices < 0) return;
 
-    // Assume TEXTURE_2D target for the texture object.
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gMeshState[mesh.name].diffuseTex[i]);
+    DrawItem item;
+    glGenVertexArrays(1, &item.vao);
+    glBindVertexArray(item.vao);
+    item.diffuseTex = gMeshState[mesh.name].diffuseTex[i];
+    item.sceneNode = sceneNode;
+    item.hasTargets = 0;
+    if (morphInfo.meshName == mesh.name && morphInfo.morphedVb == 0 &&
+        gDrawUniforms.morphTargetsTexture >= 0) {
+      item.hasTargets = 1;
+    }
+    const bool cpuMorphed = morphInfo.morphedVb != 0 &&
+                            morphInfo.meshName == mesh.name &&
+                            static_cast<int>(i) == morphInfo.primitiveIdx;
+    // With GPU morphing the deltas are added after skinning, unrotated.
+    item.skinned = SetupSkinnedPrimitive(model, primitive, skin, cpuMorphed);
+
+    // CPU-skinned or -blended attributes are interleaved in their own buffer.
+    GLuint cpuVb = 0;
+    size_t cpuStride = 0;
+    if (item.skinned >= 0) {
+      cpuVb = gSkinned[item.skinned].vb;
+      cpuStride = gSkinned[item.skinned].evaluator.Stride();
+    } else if (cpuMorphed) {
+      cpuVb = morphInfo.morphedVb;
+      cpuStride = cpuMorph.Stride();
+    }
 
     std::map<std::string, int>::const_iterator it(primitive.attributes.begin());
     std::map<std::string, int>::const_iterator itEnd(
@@ -634,7 +645,17 @@ static void DrawMesh(tinygltf::Model &model, const tinygltf::Mesh &mesh, const M
     for (; it != itEnd; it++) {
       assert(it->second >= 0);
       const tinygltf::Accessor &accessor = model.accessors[it->second];
-      glBindBuffer(GL_ARRAY_BUFFER, gBufferState[accessor.bufferView].vb);
+      size_t cpuOffset = 0;
+      bool onCpu = cpuVb != 0;
+      if (onCpu && it->first == "POSITION") {
+        cpuOffset = 0;
+      } else if (onCpu && it->first == "NORMAL" && cpuStride == 6) {
+        cpuOffset = 3 * sizeof(float);
+      } else {
+        onCpu = false;
+      }
+      glBindBuffer(GL_ARRAY_BUFFER,
+                   onCpu ? cpuVb : gBufferState[accessor.bufferView].vb);
       CheckErrors("bind buffer");
       int size = 1;
       if (accessor.type == TINYGLTF_TYPE_SCALAR) {
@@ -652,7 +673,14 @@ static void DrawMesh(tinygltf::Model &model, const tinygltf::Mesh &mesh, const M
       if ((it->first.compare("POSITION") == 0) ||
           (it->first.compare("NORMAL") == 0) ||
           (it->first.compare("TEXCOORD_0") == 0)) {
-        if (gGLProgramState.attribs[it->first] >= 0) {
+        if (gGLProgramState.attribs[it->first] >= 0 && onCpu) {
+          glVertexAttribPointer(gGLProgramState.attribs[it->first], 3,
+                                GL_FLOAT, GL_FALSE, cpuStride * sizeof(float),
+                                BUFFER_OFFSET(cpuOffset));
+          CheckErrors("vertex attrib pointer");
+          glEnableVertexAttribArray(gGLProgramState.attribs[it->first]);
+          CheckErrors("enable vertex attrib array");
+        } else if (gGLProgramState.attribs[it->first] >= 0) {
           // Compute byteStride from Accessor + BufferView combination.
           int byteStride =
               accessor.ByteStride(model.bufferViews[accessor.bufferView]);
@@ -689,26 +717,15 @@ static void DrawMesh(tinygltf::Model &model, const tinygltf::Mesh &mesh, const M
     } else {
       assert(0);
     }
-    glDrawElements(mode, (GLsizei)indexAccessor.count, indexAccessor.componentType,
-                   BUFFER_OFFSET(indexAccessor.byteOffset));
-    CheckErrors("draw elements");
-
-    {
-      std::map<std::string, int>::const_iterator it(
-          primitive.attributes.begin());
-      std::map<std::string, int>::const_iterator itEnd(
-          primitive.attributes.end());
-
-      for (; it != itEnd; it++) {
-        if ((it->first.compare("POSITION") == 0) ||
-            (it->first.compare("NORMAL") == 0) ||
-            (it->first.compare("TEXCOORD_0") == 0)) {
-          if (gGLProgramState.attribs[it->first] >= 0) {
-            glDisableVertexAttribArray(gGLProgramState.attribs[it->first]);
-          }
-        }
-      }
-    }
+    item.mode = mode;
+    item.indexCount = (GLsizei)indexAccessor.count;
+    item.indexType = indexAccessor.componentType;
+    item.indexOffset = indexAccessor.byteOffset;
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    gDrawList.push_back(item);
   }
 }
 
@@ -767,46 +784,114 @@ static void QuatToAngleAxis(const std::vector<double> quaternion,
   axis[2] = qz / denom;
 }
 
-// Hierarchically draw nodes
-static void DrawNode(tinygltf::Model &model, const tinygltf::Node &node, const MorphTargetInfo& morphInfo) {
-  // Apply xform
-  // std::cout << "node " << node.name << ", Meshes " << node.meshes.size() <<
-  // std::endl;
-
-  // std::cout << it->first << std::endl;
-  // FIXME(syoyo): Refactor.
-  // DrawCurves(scene, it->second);
-  if (node.mesh > -1) {
-    assert(node.mesh < model.meshes.size());
-    DrawMesh(model, model.meshes[node.mesh], morphInfo);
-  }
-
-  // Draw child nodes.
-  for (size_t i = 0; i < node.children.size(); i++) {
-    assert(node.children[i] < model.nodes.size());
-    DrawNode(model, model.nodes[node.children[i]], morphInfo);
+// Splits large skinned primitives into vertex ranges, one per thread, and
+// starts gSkinPool for them. Frames then only wake the pool.
+static void SetupSkinPool() {
+  const size_t cores =
+      std::max<size_t>(1, std::thread::hardware_concurrency());
+  for (size_t i = 0; i < gSkinned.size(); i++) {
+    SkinnedPrimitive &skinned = gSkinned[i];
+    const size_t count = skinned.evaluator.VertexCount();
+    const size_t ranges = std::min(cores, count / kSkinVerticesPerThread);
+    skinned.rangeStarts.clear();
+    if (ranges < 2) continue;
+    for (size_t r = 0; r <= ranges; r++) {
+      skinned.rangeStarts.push_back(count * r / ranges);
+    }
+    gSkinPool.Start(cores - 1);
   }
 }
 
-static void DrawModel(tinygltf::Model &model, MorphTargetInfo morphInfo) {
-#if 0
-	std::map<std::string, tinygltf::Mesh>::const_iterator it(scene.meshes.begin());
-	std::map<std::string, tinygltf::Mesh>::const_iterator itEnd(scene.meshes.end());
-
-	for (; it != itEnd; it++) {
-		DrawMesh(scene, it->second);
-		DrawCurves(scene, it->second);
-	}
-#else
+// Builds gDrawList once so that DrawModel() needs no lookups or allocations.
+// Call after SetupMeshState() and the morph target setup.
+static void BuildDrawList(tinygltf::Model &model, const MorphTargetInfo& morphInfo) {
+  gDrawUniforms.diffuseTex = gGLProgramState.uniforms["diffuseTex"];
+  gDrawUniforms.isCurves = gGLProgramState.uniforms["isCurvesLoc"];
+  gDrawUniforms.morphTargetBaseInfluence =
+      gGLProgramState.uniforms["morphTargetBaseInfluence"];
+  gDrawUniforms.morphTargetInfluences =
+      gGLProgramState.uniforms["morphTargetInfluences"];
+  gDrawUniforms.morphTargetsTextureSize =
+      gGLProgramState.uniforms["morphTargetsTextureSize"];
+  gDrawUniforms.morphTargetsTexture =
+      gGLProgramState.uniforms["morphTargetsTexture"];
+  gDrawUniforms.hasTargets = gGLProgramState.uniforms["hasTargets"];
+  gDrawUniforms.nodeMatrix = gGLProgramState.uniforms["nodeMatrix"];
+  gDrawUniforms.nodeNormalMatrix = gGLProgramState.uniforms["nodeNormalMatrix"];
+
+  gDrawList.clear();
+  gSkinned.clear();
   // If the glTF asset has at least one scene, and doesn't define a default one
   // just show the first one we can find
   assert(model.scenes.size() > 0);
   int scene_to_display = model.defaultScene > -1 ? model.defaultScene : 0;
-  const tinygltf::Scene &scene = model.scenes[scene_to_display];
-  for (size_t i = 0; i < scene.nodes.size(); i++) {
-    DrawNode(model, model.nodes[scene.nodes[i]], morphInfo);
+  std::string err;
+  if (!gScene.Build(model, scene_to_display, &err)) {
+    std::cerr << "Failed to flatten scene: " << err << std::endl;
+    return;
   }
-#endif
+  // Parents come before children, as the recursive walk used to visit them.
+  for (size_t i = 0; i < gScene.NodeCount(); i++) {
+    const tinygltf::Node &node = model.nodes[gScene.ModelNode(i)];
+    if (node.mesh > -1) {
+      assert(node.mesh < model.meshes.size());
+      PrepareMesh(model, model.meshes[node.mesh], i, node.skin, morphInfo);
+    }
+  }
+  SetupSkinPool();
+}
+
+static void DrawModel(const MorphTargetInfo& morphInfo) {
+  gScene.Update();  // no-op unless a node transform changed
+  if (gDrawUniforms.diffuseTex >= 0) {
+    glUniform1i(gDrawUniforms.diffuseTex, 0);  // TEXTURE0
+  }
+  if (gDrawUniforms.isCurves >= 0) {
+    glUniform1i(gDrawUniforms.isCurves, 1);
+  }
+  if (gDrawUniforms.morphTargetBaseInfluence >= 0) {
+    glUniform1f(gDrawUniforms.morphTargetBaseInfluence, 1.f);
+  }
+  // Only read by items with hasTargets set, i.e. the morph target mesh.
+  if (gDrawUniforms.morphTargetInfluences >= 0 && morphInfo.targetCount > 0) {
+    glUniform1fv(gDrawUniforms.morphTargetInfluences, morphInfo.targetCount,
+                 morphInfo.influences.data());
+  }
+  if (gDrawUniforms.morphTargetsTextureSize >= 0) {
+    glUniform2i(gDrawUniforms.morphTargetsTextureSize, morphInfo.width, morphInfo.height);
+  }
+  if (gDrawUniforms.morphTargetsTexture >= 0) {
+    glUniform1i(gDrawUniforms.morphTargetsTexture, 1);  // TEXTURE1
+  }
+
+  for (size_t i = 0; i < gDrawList.size(); i++) {
+    const DrawItem &item = gDrawList[i];
+    if (gDrawUniforms.hasTargets >= 0) {
+      glUniform1i(gDrawUniforms.hasTargets, item.hasTargets);
+    }
+    // Skinned vertices are posed already; their node's transform is ignored.
+    static const float kIdentity[16] = {1, 0, 0, 0, 0, 1, 0, 0,
+                                        0, 0, 1, 0, 0, 0, 0, 1};
+    const float *world =
+        item.skinned >= 0 ? kIdentity : gScene.WorldMatrix(item.sceneNode);
+    if (gDrawUniforms.nodeMatrix >= 0) {
+      glUniformMatrix4fv(gDrawUniforms.nodeMatrix, 1, GL_FALSE, world);
+    }
+    if (gDrawUniforms.nodeNormalMatrix >= 0) {
+      float normalMatrix[3][3];
+      NormalMatrix(world, normalMatrix);
+      glUniformMatrix3fv(gDrawUniforms.nodeNormalMatrix, 1, GL_FALSE,
+                         &normalMatrix[0][0]);
+    }
+    // Assume TEXTURE_2D target for the texture object.
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, item.diffuseTex);
+    glBindVertexArray(item.vao);
+    glDrawElements(item.mode, item.indexCount, item.indexType,
+                   BUFFER_OFFSET(item.indexOffset));
+    CheckErrors("draw elements");
+  }
+  glBindVertexArray(0);
 }
 
 static void PrintNodes(const tinygltf::Scene &scene) {
@@ -839,23 +924,50 @@ MorphTargets findAllMorphTargets(const tinygltf::Model& model) {
   return targets;
 }
 
+// The primitive of `mesh` the face morphs: the one with the most targets.
+static int FindMorphPrimitive(const tinygltf::Mesh &mesh) {
+  int best = 0;
+  for (size_t i = 1; i < mesh.primitives.size(); i++) {
+    if (mesh.primitives[i].targets.size() >
+        mesh.primitives[best].targets.size()) {
+      best = static_cast<int>(i);
+    }
+  }
+  return best;
+}
+
+// Caller holds blendshapeProducerMutex.
+void BindBlendshapeKeys() {
+  MorphTargets morphTargets = findAllMorphTargets(model);
+  BlendshapeBinding &binding = blendshapeBindings.BeginWrite();
+  binding.count = 0;
+  if (!morphTargets.empty()) {
+    // Slots index the targets of the primitive buildMorphTargetTexture()
+    // picks, which may have more targets than named ones.
+    const tinygltf::Mesh &mesh = model.meshes[morphTargets.begin()->first];
+    const size_t targetCount =
+        mesh.primitives.empty()
+            ? 0
+            : mesh.primitives[FindMorphPrimitive(mesh)].targets.size();
+    BindBlendshapes(BlendShapeKeyList, morphTargets.begin()->second,
+                    targetCount, &binding);
+  }
+  blendshapeBindings.Publish();
+}
+
 MorphTargetInfo buildMorphTargetTexture(tinygltf::Model& model, const MorphTargets& morphTargets) {
   MorphTargetInfo ret;
   assert(!morphTargets.empty());
   ret.targetMap = morphTargets.begin()->second;
   ret.meshId = morphTargets.begin()->first;
-  ret.targetCount = morphTargets.begin()->second.size();
   std::cout << "buildMorphTargetTexture, meshId=" << ret.meshId << std::endl;
   tinygltf::Mesh& mesh = model.meshes[ret.meshId];
   ret.meshName = mesh.name;
-  for (int i = 0; i < mesh.primitives.size(); i++) {
-    const tinygltf::Primitive & primitive = mesh.primitives[i];
-    if (primitive.targets.size() == ret.targetCount) {
-      ret.primitiveIdx = i;
-    }
-  }
+  ret.primitiveIdx = FindMorphPrimitive(mesh);
 
   const tinygltf::Primitive& primitive = mesh.primitives[ret.primitiveIdx];
+  // Same count as BindBlendshapeKeys() binds against.
+  ret.targetCount = primitive.targets.size();
   for (int i = 0; i < primitive.targets.size(); i++) {
     for (auto &it : primitive.targets[i]) {
       if (it.first == "POSITION") {
@@ -879,7 +991,7 @@ MorphTargetInfo buildMorphTargetTexture(tinygltf::Model& model, const MorphTarge
   
   ret.width = ret.positionCount * ret.vertexDataCount;
   ret.height = 1;
-  ret.influences.resize(ret.targetCount);
+  ret.influences.resize(ret.targetCount + 1);
 
   if (ret.width > maxTextureSize) {
     ret.height = ceil(ret.width / maxTextureSize);
@@ -888,25 +1000,60 @@ MorphTargetInfo buildMorphTargetTexture(tinygltf::Model& model, const MorphTarge
   return ret;
 }
 
-static void SetupMorphTextures(tinygltf::Model &model, const MorphTargetInfo& morphInfo, GLuint progId) {
+static void SetupMorphUniforms(GLuint progId) {
+  GLint morphTargetsTextureSize = glGetUniformLocation(progId, "morphTargetsTextureSize");
+  GLint morphTargetInfluences = glGetUniformLocation(progId, "morphTargetInfluences");
+  GLint morphTargetsTexture = glGetUniformLocation(progId, "morphTargetsTexture");
+  GLint hasTargets = glGetUniformLocation(progId, "hasTargets");
+  
+
+  gGLProgramState.uniforms["morphTargetsTextureSize"] = morphTargetsTextureSize;
+  gGLProgramState.uniforms["morphTargetInfluences"] = morphTargetInfluences;
+  gGLProgramState.uniforms["morphTargetsTexture"] = morphTargetsTexture;
+  gGLProgramState.uniforms["hasTargets"] = hasTargets;
+  gGLProgramState.uniforms["nodeMatrix"] =
+      glGetUniformLocation(progId, "nodeMatrix");
+  gGLProgramState.uniforms["nodeNormalMatrix"] =
+      glGetUniformLocation(progId, "nodeNormalMatrix");
+}
+
+static void SetupMorphTextures(tinygltf::Model &model, const MorphTargetInfo& morphInfo) {
   const tinygltf::Mesh& mesh = model.meshes[morphInfo.meshId];
   const tinygltf::Primitive& primitive = mesh.primitives[morphInfo.primitiveIdx];
   size_t layerCount = primitive.targets.size();
+
+  // 8-bit targets(KHR_mesh_quantization) lose nothing in half floats, which
+  // halves the texture. Wider integers and floats need 32 bits.
+  GLenum internalFormat = GL_RGBA16F;
+  for (size_t i = 0; i < layerCount; i++) {
+    for (auto &it : primitive.targets[i]) {
+      const int type = model.accessors[it.second].componentType;
+      if (type != TINYGLTF_COMPONENT_TYPE_BYTE &&
+          type != TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
+        internalFormat = GL_RGBA32F;
+      }
+    }
+  }
+
   GLuint texture = 0;
   glGenTextures(1, &texture);
   glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
-  glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA32F, morphInfo.width, morphInfo.height, layerCount);
+  glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, internalFormat, morphInfo.width, morphInfo.height, layerCount);
   CheckErrors("allocate morph textures");
   
   float_t *dstBuffer = new float[morphInfo.width * morphInfo.height * 4];
+  std::vector<float> values;
   for (int i = 0; i < layerCount; i++) {
     for (auto &it : primitive.targets[i]) {
       const auto &accessor = model.accessors[it.second];
-      const auto &bufferView = model.bufferViews[accessor.bufferView];
-      const tinygltf::Buffer &buffer = model.buffers[bufferView.buffer];
-      
-      //std::cout << "layer=" << i << ", component type=" << accessor.componentType << std::endl;
-      assert(accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT); //5126
+
+      // Float or quantized, dequantized by `normalized`; the node transform
+      // applies to the sum of base and deltas.
+      std::string err;
+      if (!tinygltf::ReadAccessor(model, accessor, &values, &err)) {
+        std::cerr << "Morph target " << it.first << ": " << err << std::endl;
+        continue;
+      }
       size_t srcComponentCount = 3;
       switch (accessor.type) {
         case TINYGLTF_TYPE_VEC4:
@@ -919,7 +1066,7 @@ static void SetupMorphTextures(tinygltf::Model &model, const MorphTargetInfo& mo
           assert(false);
           break;
       }
-      const float *srcBuffer = (const float*)(&(buffer.data.at(0)) + bufferView.byteOffset);
+      const float *srcBuffer = values.data();
 
       size_t positionCount = accessor.count;
       for (int j = 0; j < positionCount; j ++ ) {
@@ -949,34 +1096,149 @@ static void SetupMorphTextures(tinygltf::Model &model, const MorphTargetInfo& mo
   }
   gMeshState[mesh.name].morphTex = texture;
   delete [] dstBuffer;
-  
-  GLint morphTargetsTextureSize = glGetUniformLocation(progId, "morphTargetsTextureSize");
-  GLint morphTargetInfluences = glGetUniformLocation(progId, "morphTargetInfluences");
-  GLint morphTargetsTexture = glGetUniformLocation(progId, "morphTargetsTexture");
-  GLint hasTargets = glGetUniformLocation(progId, "hasTargets");
-  
-
-  gGLProgramState.uniforms["morphTargetsTextureSize"] = morphTargetsTextureSize;
-  gGLProgramState.uniforms["morphTargetInfluences"] = morphTargetInfluences;
-  gGLProgramState.uniforms["morphTargetsTexture"] = morphTargetsTexture;
-  gGLProgramState.uniforms["hasTargets"] = hasTargets;
 
   glActiveTexture(GL_TEXTURE1);
   glBindTexture(GL_TEXTURE_2D_ARRAY, gMeshState[mesh.name].morphTex);
 }
 
+// Blends morph targets on the CPU into `morphInfo.morphedVb`, which the draw
+// list binds in place of the base POSITION/NORMAL.
+static bool SetupCpuMorph(tinygltf::Model &model, MorphTargetInfo &morphInfo) {
+  const tinygltf::Mesh &mesh = model.meshes[morphInfo.meshId];
+  const tinygltf::Primitive &primitive = mesh.primitives[morphInfo.primitiveIdx];
+  std::string err;
+  // Blendshape deltas are small, so 16-bit with a per-target scale is plenty.
+  cpuMorph.SetDeltaEncoding(MorphEvaluator::kDeltaInt16);
+  if (!cpuMorph.Init(model, primitive, &err)) {
+    std::cerr << "CPU morph setup failed: " << err << std::endl;
+    return false;
+  }
+  std::cout << "CPU morph deltas: " << cpuMorph.DeltaBytes() << " bytes"
+            << std::endl;
+  cpuMorph.SetMinWeight(kCpuMorphMinWeight);
+  cpuMorphVertices.resize(cpuMorph.FloatCount());
+  glGenBuffers(1, &morphInfo.morphedVb);
+  glBindBuffer(GL_ARRAY_BUFFER, morphInfo.morphedVb);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * cpuMorphVertices.size(),
+               nullptr, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  return true;
+}
+
+static void UpdateCpuMorph(const MorphTargetInfo &morphInfo) {
+  if (morphInfo.morphedVb == 0) return;
+  cpuMorph.Evaluate(morphInfo.influences.data(), morphInfo.influences.size(),
+                    cpuMorphVertices.data());
+  glBindBuffer(GL_ARRAY_BUFFER, morphInfo.morphedVb);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * cpuMorphVertices.size(),
+                  cpuMorphVertices.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Skins vertex range `range` of the SkinnedPrimitive `context`; a
+// gSkinPool job.
+static void SkinRange(void *context, size_t range) {
+  SkinnedPrimitive &skinned = *static_cast<SkinnedPrimitive *>(context);
+  const bool morphed = skinned.morphed;
+  skinned.evaluator.Evaluate(skinned.rangeStarts[range],
+                             skinned.rangeStarts[range + 1],
+                             skinned.vertices.data(),
+                             morphed ? cpuMorphVertices.data() : nullptr,
+                             morphed ? cpuMorph.Stride() : 0);
+}
+
+// Poses the skinned primitives from gScene and uploads them. Large meshes
+// are split into the vertex ranges set up by SetupSkinPool().
+static void UpdateSkins() {
+  gScene.Update();
+  for (size_t i = 0; i < gSkinned.size(); i++) {
+    SkinnedPrimitive &skinned = gSkinned[i];
+    if (!skinned.evaluator.UpdatePalette(gScene)) continue;
+    if (skinned.rangeStarts.empty()) {
+      skinned.evaluator.Evaluate(
+          0, skinned.evaluator.VertexCount(), skinned.vertices.data(),
+          skinned.morphed ? cpuMorphVertices.data() : nullptr,
+          skinned.morphed ? cpuMorph.Stride() : 0);
+    } else {
+      gSkinPool.Run(SkinRange, &skinned, skinned.rangeStarts.size() - 1);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, skinned.vb);
+    glBufferSubData(GL_ARRAY_BUFFER, 0,
+                    sizeof(float) * skinned.vertices.size(),
+                    skinned.vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+}
+
+// Whether to blend morph targets on the CPU instead of sampling the morph
+// texture in the vertex shader.
+static bool UseCpuMorph(const MorphTargetInfo &morphInfo) {
+#ifdef GLVIEW_CPU_MORPH
+  (void)morphInfo;
+  return true;
+#else
+  GLint vertexTextureUnits = 0;
+  GLint maxTextureSize = 0;
+  glGetIntegerv(GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS, &vertexTextureUnits);
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+  return vertexTextureUnits == 0 ||
+         morphInfo.height > static_cast<size_t>(maxTextureSize);
+#endif
+}
+
 MorphTargetInfo morphTargetInfo;
 GLuint MatrixID;
 bool FaceShaderInited = false;
 
+// The model's first animation, looped while the app runs.
+tinygltf::AnimationEvaluator gIdleAnimation;
+bool gHasIdleAnimation = false;
+std::chrono::steady_clock::time_point gIdleAnimationStart;
+
+static void SetupIdleAnimation(const tinygltf::Model &model) {
+  gHasIdleAnimation = false;
+  if (model.animations.empty()) return;
+  std::string err;
+  if (!gIdleAnimation.Init(model, 0, &err)) {
+    std::cerr << "Idle animation: " << err << std::endl;
+    return;
+  }
+  gHasIdleAnimation = gIdleAnimation.Duration() > 0.0f;
+  gIdleAnimationStart = std::chrono::steady_clock::now();
+}
+
+// Poses gScene from the idle animation. Its morph target weights drive the
+// face only until the landmarker delivers a result.
+static void UpdateIdleAnimation(const tinygltf::Model &model,
+                                MorphTargetInfo &morphInfo, bool faceTracked) {
+  if (!gHasIdleAnimation) return;
+  const std::chrono::duration<float> elapsed =
+      std::chrono::steady_clock::now() - gIdleAnimationStart;
+  gIdleAnimation.Evaluate(
+      std::fmod(elapsed.count(), gIdleAnimation.Duration()));
+  gIdleAnimation.Apply(&gScene);
+  if (faceTracked) return;
+  typedef tinygltf::AnimationEvaluator Evaluator;
+  for (size_t c = 0; c < gIdleAnimation.ChannelCount(); c++) {
+    const int node = gIdleAnimation.TargetNode(c);
+    if (gIdleAnimation.TargetPath(c) != Evaluator::kWeights || node < 0 ||
+        model.nodes[node].mesh != morphInfo.meshId) {
+      continue;
+    }
+    const size_t count =
+        std::min(gIdleAnimation.ComponentCount(c), morphInfo.targetCount);
+    std::copy(gIdleAnimation.Output(c), gIdleAnimation.Output(c) + count,
+              morphInfo.influences.begin());
+  }
+}
+
 int InitFace() {
   trackball(curr_quat, 0, 0, 0, 0);
 
   auto morphTargets = findAllMorphTargets(model);
   morphTargetInfo = buildMorphTargetTexture(model, morphTargets);
-  size_t morphTargetCount = 0;
-  if (!morphTargets.empty())
-    morphTargetCount = morphTargets.begin()->second.size();
+  const size_t morphTargetCount = morphTargetInfo.targetCount;
   std::stringstream shaderDefs;
   shaderDefs << "#version 300 es" << std::endl;
   shaderDefs << "#define MORPHTARGETS_COUNT " << morphTargetCount << std::endl;
@@ -1013,8 +1275,15 @@ int InitFace() {
 
   SetupMeshState(model, progId);
   CheckErrors("SetupMeshState");
-  SetupMorphTextures(model, morphTargetInfo, progId);
-  CheckErrors("SetupMorphTextures");
+  SetupMorphUniforms(progId);
+  if (!UseCpuMorph(morphTargetInfo) || !SetupCpuMorph(model, morphTargetInfo)) {
+    SetupMorphTextures(model, morphTargetInfo);
+    CheckErrors("SetupMorphTextures");
+  }
+  CheckErrors("SetupMorph");
+  BuildDrawList(model, morphTargetInfo);
+  CheckErrors("BuildDrawList");
+  SetupIdleAnimation(model);
   // SetupCurvesState(model, progId);
   MatrixID = glGetUniformLocation(progId, "modelViewProjectionMatrix");
 
@@ -1028,7 +1297,6 @@ int UpdateFace() {
     FaceShaderInited = true;
   }
 
-  BlendShapesInfluences shapes;
   glClearColor(0.0f, 0.0f, 0.0f, 0.3f);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -1042,7 +1310,10 @@ int UpdateFace() {
   mat[0][3] = -mat[0][3];
 
   GLfloat  resultMatrix[4][4] = {0};
-  matrixMultiply(FacialTransformationMatrix, mat, resultMatrix);
+  // Latest complete landmarker result; kept until a newer one arrives.
+  faceFrames.Acquire();
+  const FaceFrame &frame = faceFrames.Latest();
+  matrixMultiply(frame.matrix, mat, resultMatrix);
 
   resultMatrix[3][0] = 0.0f;
   resultMatrix[3][1] = 0.0f;
@@ -1050,13 +1321,12 @@ int UpdateFace() {
   resultMatrix[3][3] = 1.0f;
 
   glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &resultMatrix[0][0]);
-  if(BlendShapeKeyList.size() > 0) {
-    for(int i =0; i<BlendShapeKeyList.size(); i++) {
-      shapes.influences[BlendShapeKeyList[i]] = BlendShapesValue[i];
-    }
-  }
-  morphTargetInfo.applyFaceMesh(shapes);
-  DrawModel(model, morphTargetInfo);
+  blendshapeBindings.Acquire();
+  morphTargetInfo.applyFaceFrame(frame, blendshapeBindings.Latest());
+  UpdateIdleAnimation(model, morphTargetInfo, frame.timestampNs != 0);
+  UpdateCpuMorph(morphTargetInfo);
+  UpdateSkins();
+  DrawModel(morphTargetInfo);
   glFlush();
   return 1;
 }
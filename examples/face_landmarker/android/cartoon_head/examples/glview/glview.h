@@ -6,17 +6,37 @@
 #define MP_FACE_LANDMARKER_GLVIEW_H
 
 #include <jni.h>
+#include <chrono>
+#include <mutex>
 #include <vector>
 #include <string>
 #include "tiny_gltf.h"
+#include "blendshape_binding.h"
+#include "face_frame_channel.h"
 #include <android/log.h>
 
 tinygltf::Model model;
+// GLB bytes of the loaded model. `model` borrows its BIN chunk from here
+// (see SetBorrowBinaryChunk), so keep them alive as long as `model` is used.
+// The asset stays open so AAsset_getBuffer() memory remains valid; when the
+// asset can't be mapped, the bytes are read into `modelGlbBytes` instead.
+AAsset *modelAsset = nullptr;
+std::vector<unsigned char> modelGlbBytes;
+// Images are decoded on demand when their texture is uploaded.
+tinygltf::TinyGLTF modelLoader;
 std::map<std::string, float> blendShapeMap;
 
 std::vector<std::string> BlendShapeKeyList(52);
-GLfloat BlendShapesValue[52] = {0.0f};
-GLfloat FacialTransformationMatrix[4][4] = {0.0f};
+// Landmarker results, written on the JNI thread and read on the GL thread.
+FaceFrameChannel faceFrames;
+
+// Resolved by BindBlendshapeKeys() for the GL thread.
+TripleBuffer<BlendshapeBinding> blendshapeBindings;
+// NativeSetBlendshapeKey and NativeSetAssets run on different JNI threads,
+// but blendshapeBindings takes a single producer. Hold this while touching
+// BlendShapeKeyList or `model` there, and around BindBlendshapeKeys().
+std::mutex blendshapeProducerMutex;
+void BindBlendshapeKeys();
 
 #ifdef __cplusplus
 extern "C" {
@@ -42,6 +62,7 @@ Java_com_google_mediapipe_examples_facelandmarker_fragment_FaceBlendshapesResult
 
     jmethodID getMethod = env->GetMethodID(arrayListClass, "get", "(I)Ljava/lang/Object;");
 
+    std::lock_guard<std::mutex> lock(blendshapeProducerMutex);
     BlendShapeKeyList.clear();
     for (int i = 0; i < size; ++i) {
         jstring jString = (jstring)env->CallObjectMethod(stringList, getMethod, i);
@@ -52,6 +73,7 @@ Java_com_google_mediapipe_examples_facelandmarker_fragment_FaceBlendshapesResult
         env->DeleteLocalRef(jString);
     }
     env->DeleteLocalRef(arrayListClass);
+    BindBlendshapeKeys();
     //__android_log_print(ANDROID_LOG_INFO, "AndyTest", "NativeSetBlendshapeKey succeed");
 }
 }  // extern "C"
@@ -59,26 +81,25 @@ Java_com_google_mediapipe_examples_facelandmarker_fragment_FaceBlendshapesResult
 extern "C" {
 JNIEXPORT void JNICALL
 Java_com_google_mediapipe_examples_facelandmarker_fragment_FaceBlendshapesResultAdapter_NativeSetBlendshapeAndMatrixed(JNIEnv *env, jobject thiz, jfloatArray blendShapeArray, jfloatArray matrixArray) {
-    jfloat *blednshapesArrayElements = env->GetFloatArrayElements(blendShapeArray, nullptr);
-    int index = 0;
-    for (int i = 0; i < 52; ++i) {
-        BlendShapesValue[i] = blednshapesArrayElements[index++];
-    }
-
-    env->ReleaseFloatArrayElements(blendShapeArray, blednshapesArrayElements, 0);
+    // Fill a private slot, then publish it in one step so the GL thread never
+    // sees weights and matrix from different results.
+    FaceFrame &frame = faceFrames.BeginWrite();
+    jsize weightCount = env->GetArrayLength(blendShapeArray);
+    if (weightCount > 52) weightCount = 52;
+    env->GetFloatArrayRegion(blendShapeArray, 0, weightCount, frame.weights);
 
     //__android_log_print(ANDROID_LOG_INFO, "AndyTest", "NativeSetBlendshapeValue succeed");
 
-    jfloat *matrixArrayElements = env->GetFloatArrayElements(matrixArray, nullptr);
-    index = 0;
-    for (int col = 0; col < 4; ++col) {
-        for (int row = 0; row < 4; ++row) {
-            FacialTransformationMatrix[col][row] = matrixArrayElements[index++];
-        }
-    }
-    env->ReleaseFloatArrayElements(matrixArray, matrixArrayElements, 0);
+    jsize matrixCount = env->GetArrayLength(matrixArray);
+    if (matrixCount > 16) matrixCount = 16;
+    // Column-major, same layout as frame.matrix[col][row].
+    env->GetFloatArrayRegion(matrixArray, 0, matrixCount, &frame.matrix[0][0]);
     //__android_log_print(ANDROID_LOG_INFO, "AndyTest", "NativeSetBlendshapeMatrix succeed");
 
+    frame.timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    faceFrames.Publish();
+
 }
 }  // extern "C"
 
@@ -87,22 +108,33 @@ JNIEXPORT void JNICALL
 Java_com_google_mediapipe_examples_facelandmarker_OverlayView_NativeSetAssets(JNIEnv *env, jobject thiz, jobject assetManager) {
     AAssetManager *mgr = AAssetManager_fromJava(env, assetManager);
     AAsset *asset = AAssetManager_open(mgr, "raccoon_head.glb", AASSET_MODE_BUFFER);
+    std::lock_guard<std::mutex> lock(blendshapeProducerMutex);
     if (asset != nullptr) {
         __android_log_print(ANDROID_LOG_INFO, "AndyTest", "Read GLB file success");
         int64_t fileSize = AAsset_getLength(asset);
-        std::vector<char> buffer(fileSize);
-        AAsset_read(asset, buffer.data(), fileSize);
-        tinygltf::TinyGLTF loader;
+        // Uncompressed assets are mapped straight from the APK.
+        const unsigned char *glbBytes = reinterpret_cast<const unsigned char *>(AAsset_getBuffer(asset));
+        if (glbBytes == nullptr) {
+            modelGlbBytes.resize(fileSize);
+            AAsset_read(asset, modelGlbBytes.data(), fileSize);
+            glbBytes = modelGlbBytes.data();
+        }
+        modelLoader.SetBorrowBinaryChunk(true);
+        modelLoader.SetLazyImageLoading(true);
         std::string err;
         std::string warn;
 
-        unsigned char* ucharPtr = reinterpret_cast<unsigned char*>(buffer.data());
         bool ret = false;
-        ret = loader.LoadBinaryFromMemory(&model, &err, &warn, ucharPtr, fileSize, "");
+        ret = modelLoader.LoadBinaryFromMemory(&model, &err, &warn, glbBytes, fileSize, "");
         if (!ret) {
             __android_log_print(ANDROID_LOG_ERROR, "AndyTest", "Read GLB file failed");
         }
-        AAsset_close(asset);
+        // Keys may have arrived before the model.
+        BindBlendshapeKeys();
+        if (modelAsset != nullptr) {
+            AAsset_close(modelAsset);
+        }
+        modelAsset = asset;
     } else {
         __android_log_print(ANDROID_LOG_ERROR, "AndyTest", "Read GLB file failed");
     }
@@ -143,12 +175,8 @@ bool LoadShader(GLenum shaderType,  // GL_VERTEX_SHADER or GL_FRAGMENT_SHADER(or
         glDeleteShader(shader);
     }
 
-    std::vector<GLchar> srcbuf(shaderCode.size() + 1);
-    memcpy(&srcbuf[0], shaderCode.c_str(), shaderCode.size());
-    srcbuf[shaderCode.size()] = 0;
-
     const GLchar *srcs[1];
-    srcs[0] = &srcbuf.at(0);
+    srcs[0] = shaderCode.c_str();
 
     shader = glCreateShader(shaderType);
     glShaderSource(shader, 1, srcs, NULL);
@@ -0,0 +1,493 @@
+#include "morph_evaluator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// y[i] += w * x[i] for i in [0, n).
+void Axpy(float w, const float *x, float *y, size_t n) {
+  size_t i = 0;
+#if defined(__AVX__)
+  const __m256 vw = _mm256_set1_ps(w);
+  for (; i + 8 <= n; i += 8) {
+    __m256 vy = _mm256_loadu_ps(y + i);
+    vy = _mm256_add_ps(vy, _mm256_mul_ps(vw, _mm256_loadu_ps(x + i)));
+    _mm256_storeu_ps(y + i, vy);
+  }
+#elif defined(__SSE2__) || defined(_M_X64)
+  const __m128 vw = _mm_set1_ps(w);
+  for (; i + 4 <= n; i += 4) {
+    __m128 vy = _mm_loadu_ps(y + i);
+    vy = _mm_add_ps(vy, _mm_mul_ps(vw, _mm_loadu_ps(x + i)));
+    _mm_storeu_ps(y + i, vy);
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  const float32x4_t vw = vdupq_n_f32(w);
+  for (; i + 4 <= n; i += 4) {
+    vst1q_f32(y + i, vmlaq_f32(vld1q_f32(y + i), vld1q_f32(x + i), vw));
+  }
+#endif
+  for (; i < n; i++) {
+    y[i] += w * x[i];
+  }
+}
+
+uint16_t FloatToHalf(float f) {
+  uint32_t x;
+  memcpy(&x, &f, sizeof(x));
+  const uint32_t sign = (x >> 16) & 0x8000;
+  const uint32_t biased = (x >> 23) & 0xff;
+  uint32_t mant = x & 0x7fffff;
+  if (biased == 0xff) {  // Inf/NaN
+    return uint16_t(sign | 0x7c00 | (mant ? 0x200 : 0));
+  }
+  const int exp = int(biased) - 127 + 15;
+  if (exp >= 31) {  // Overflow
+    return uint16_t(sign | 0x7c00);
+  }
+  uint32_t shift = 13;
+  uint32_t h = (uint32_t(exp) << 10) | (mant >> 13);
+  if (exp <= 0) {  // Subnormal or zero
+    if (exp < -10) return uint16_t(sign);
+    mant |= 0x800000;
+    shift = uint32_t(14 - exp);
+    h = mant >> shift;
+  }
+  // Round to nearest even. A carry into the exponent is still correct.
+  const uint32_t rem = mant & ((1u << shift) - 1);
+  const uint32_t half = 1u << (shift - 1);
+  if (rem > half || (rem == half && (h & 1))) h++;
+  return uint16_t(sign | h);
+}
+
+float HalfToFloat(uint16_t h) {
+  const uint32_t sign = uint32_t(h & 0x8000) << 16;
+  const uint32_t exp = (h >> 10) & 0x1f;
+  const uint32_t mant = h & 0x3ff;
+  uint32_t x;
+  if (exp == 0) {
+    // Zero or subnormal: mant * 2^-24.
+    const float f = float(mant) * (1.0f / 16777216.0f);
+    return sign ? -f : f;
+  } else if (exp == 31) {
+    x = sign | 0x7f800000 | (mant << 13);
+  } else {
+    x = sign | ((exp + 112) << 23) | (mant << 13);
+  }
+  float f;
+  memcpy(&f, &x, sizeof(f));
+  return f;
+}
+
+float Int16ToFloat(uint16_t v) { return float(int16_t(v)); }
+
+#if defined(__AVX2__) && defined(__F16C__)
+// AxpyPacked() converts with single AVX2/F16C instructions.
+#elif defined(__SSE2__) || defined(_M_X64)
+#if !defined(__F16C__)
+// HalfToFloat() of four halves zero-extended to 32 bits: the exponent is
+// rebiased by a multiply, which also normalizes subnormals.
+__m128 HalfToFloat4(__m128i h) {
+  const __m128i sign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)),
+                                      16);
+  const __m128i bits =
+      _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7fff)), 13);
+  const __m128 rebias = _mm_castsi128_ps(_mm_set1_epi32(0x77800000));  // 2^112
+  const __m128 f = _mm_mul_ps(_mm_castsi128_ps(bits), rebias);
+  // Inf/NaN keep an all-ones exponent.
+  const __m128 inf_nan =
+      _mm_castsi128_ps(_mm_cmpgt_epi32(bits, _mm_set1_epi32(0x0f7fffff)));
+  const __m128 special = _mm_castsi128_ps(
+      _mm_or_si128(bits, _mm_set1_epi32(0x7f800000)));
+  return _mm_or_ps(_mm_or_ps(_mm_andnot_ps(inf_nan, f),
+                             _mm_and_ps(inf_nan, special)),
+                   _mm_castsi128_ps(sign));
+}
+#endif
+
+// Eight packed values at `x` as floats.
+void LoadInt16(const uint16_t *x, __m128 *lo, __m128 *hi) {
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x));
+  *lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+  *hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+}
+
+void LoadHalf(const uint16_t *x, __m128 *lo, __m128 *hi) {
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x));
+#if defined(__F16C__)
+  *lo = _mm_cvtph_ps(v);
+  *hi = _mm_cvtph_ps(_mm_unpackhi_epi64(v, v));
+#else
+  *lo = HalfToFloat4(_mm_unpacklo_epi16(v, _mm_setzero_si128()));
+  *hi = HalfToFloat4(_mm_unpackhi_epi16(v, _mm_setzero_si128()));
+#endif
+}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+void LoadInt16(const uint16_t *x, float32x4_t *lo, float32x4_t *hi) {
+  const int16x8_t v = vreinterpretq_s16_u16(vld1q_u16(x));
+  *lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+  *hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+}
+
+#if defined(__aarch64__)
+void LoadHalf(const uint16_t *x, float32x4_t *lo, float32x4_t *hi) {
+  *lo = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(x)));
+  *hi = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(x + 4)));
+}
+#else
+// Same rebiasing multiply as the SSE2 HalfToFloat4().
+float32x4_t HalfToFloat4(uint32x4_t h) {
+  const uint32x4_t sign = vshlq_n_u32(vandq_u32(h, vdupq_n_u32(0x8000)), 16);
+  const uint32x4_t bits = vshlq_n_u32(vandq_u32(h, vdupq_n_u32(0x7fff)), 13);
+  const float32x4_t rebias = vreinterpretq_f32_u32(vdupq_n_u32(0x77800000));
+  const float32x4_t f = vmulq_f32(vreinterpretq_f32_u32(bits), rebias);
+  const uint32x4_t inf_nan = vcgtq_u32(bits, vdupq_n_u32(0x0f7fffff));
+  const uint32x4_t out =
+      vbslq_u32(inf_nan, vorrq_u32(bits, vdupq_n_u32(0x7f800000)),
+                vreinterpretq_u32_f32(f));
+  return vreinterpretq_f32_u32(vorrq_u32(out, sign));
+}
+
+void LoadHalf(const uint16_t *x, float32x4_t *lo, float32x4_t *hi) {
+  const uint16x8_t v = vld1q_u16(x);
+  *lo = HalfToFloat4(vmovl_u16(vget_low_u16(v)));
+  *hi = HalfToFloat4(vmovl_u16(vget_high_u16(v)));
+}
+#endif
+#endif
+
+// y[i] += w * Decode(x[i]) for i in [0, n), or y[i] = w * Decode(x[i]) when
+// not kAdd. Decode is Int16ToFloat or HalfToFloat; Load matches it.
+template <bool kAdd, float (*Decode)(uint16_t)>
+void AxpyPacked(float w, const uint16_t *x, float *y, size_t n) {
+  size_t i = 0;
+#if defined(__AVX2__) && defined(__F16C__)
+  const __m256 vw = _mm256_set1_ps(w);
+  for (; i + 8 <= n; i += 8) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x + i));
+    const __m256 f = Decode == HalfToFloat
+                         ? _mm256_cvtph_ps(v)
+                         : _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(v));
+    __m256 r = _mm256_mul_ps(vw, f);
+    if (kAdd) r = _mm256_add_ps(_mm256_loadu_ps(y + i), r);
+    _mm256_storeu_ps(y + i, r);
+  }
+#elif defined(__SSE2__) || defined(_M_X64)
+  const __m128 vw = _mm_set1_ps(w);
+  for (; i + 8 <= n; i += 8) {
+    __m128 lo, hi;
+    if (Decode == HalfToFloat) {
+      LoadHalf(x + i, &lo, &hi);
+    } else {
+      LoadInt16(x + i, &lo, &hi);
+    }
+    lo = _mm_mul_ps(vw, lo);
+    hi = _mm_mul_ps(vw, hi);
+    if (kAdd) {
+      lo = _mm_add_ps(_mm_loadu_ps(y + i), lo);
+      hi = _mm_add_ps(_mm_loadu_ps(y + i + 4), hi);
+    }
+    _mm_storeu_ps(y + i, lo);
+    _mm_storeu_ps(y + i + 4, hi);
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  const float32x4_t vw = vdupq_n_f32(w);
+  for (; i + 8 <= n; i += 8) {
+    float32x4_t lo, hi;
+    if (Decode == HalfToFloat) {
+      LoadHalf(x + i, &lo, &hi);
+    } else {
+      LoadInt16(x + i, &lo, &hi);
+    }
+    if (kAdd) {
+      vst1q_f32(y + i, vmlaq_f32(vld1q_f32(y + i), lo, vw));
+      vst1q_f32(y + i + 4, vmlaq_f32(vld1q_f32(y + i + 4), hi, vw));
+    } else {
+      vst1q_f32(y + i, vmulq_f32(lo, vw));
+      vst1q_f32(y + i + 4, vmulq_f32(hi, vw));
+    }
+  }
+#endif
+  for (; i < n; i++) {
+    y[i] = kAdd ? y[i] + w * Decode(x[i]) : w * Decode(x[i]);
+  }
+}
+
+// out[indices[k] * stride + c] += w * values[k * stride + c] for the k-th
+// moved vertex.
+void AccumulateSparse(float w, const uint32_t *indices, size_t count,
+                      size_t stride, const float *values, float *out) {
+  for (size_t k = 0; k < count; k++) {
+    float *dst = out + indices[k] * stride;
+    const float *src = values + k * stride;
+    for (size_t c = 0; c < stride; c++) {
+      dst[c] += w * src[c];
+    }
+  }
+}
+
+// Same for packed deltas: blocks of them are decoded with AxpyPacked() on
+// the stack, then added to their vertices.
+template <float (*Decode)(uint16_t)>
+void AccumulateSparsePacked(float w, const uint32_t *indices, size_t count,
+                            size_t stride, const uint16_t *values,
+                            float *out) {
+  const size_t kBlockFloats = 384;  // a multiple of both strides, 3 and 6
+  float block[kBlockFloats];
+  const size_t block_vertices = kBlockFloats / stride;
+  for (size_t k0 = 0; k0 < count; k0 += block_vertices) {
+    const size_t m = std::min(block_vertices, count - k0);
+    AxpyPacked<false, Decode>(w, values + k0 * stride, block, m * stride);
+    AccumulateSparse(1.0f, indices + k0, m, stride, block, out);
+  }
+}
+
+// Float, or 8/16-bit integers as KHR_mesh_quantization allows.
+bool IsMorphComponentType(int type) {
+  return type == TINYGLTF_COMPONENT_TYPE_FLOAT ||
+         type == TINYGLTF_COMPONENT_TYPE_BYTE ||
+         type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE ||
+         type == TINYGLTF_COMPONENT_TYPE_SHORT ||
+         type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+}
+
+// Distance between adjacent values of a quantized accessor after
+// ReadAccessor(): 1 for plain integers, 1 / max for normalized ones. 0 for
+// floats.
+float QuantizationStep(const tinygltf::Accessor &accessor) {
+  if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT) return 0.0f;
+  if (!accessor.normalized) return 1.0f;
+  switch (accessor.componentType) {
+    case TINYGLTF_COMPONENT_TYPE_BYTE:
+      return 1.0f / 127.0f;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+      return 1.0f / 255.0f;
+    case TINYGLTF_COMPONENT_TYPE_SHORT:
+      return 1.0f / 32767.0f;
+    default:
+      return 1.0f / 65535.0f;
+  }
+}
+
+// Copies `count` vec3 elements of an accessor to `dst` as floats, advancing
+// `dstStride` floats per element. Quantized values are converted as
+// `normalized` says, and sparse values are applied.
+bool ReadVec3(const tinygltf::Model &model, int accessorIdx, size_t count,
+              float *dst, size_t dstStride, std::string *err) {
+  if (accessorIdx < 0 || size_t(accessorIdx) >= model.accessors.size()) {
+    if (err) (*err) += "Invalid accessor index.\n";
+    return false;
+  }
+  const tinygltf::Accessor &accessor = model.accessors[size_t(accessorIdx)];
+  if (!IsMorphComponentType(accessor.componentType) ||
+      accessor.type != TINYGLTF_TYPE_VEC3) {
+    if (err) {
+      (*err) += "Morph accessor must be a float or 8/16-bit integer VEC3.\n";
+    }
+    return false;
+  }
+  if (accessor.count != count) {
+    if (err) (*err) += "Morph accessor count mismatch.\n";
+    return false;
+  }
+
+  std::vector<float> values;
+  if (!tinygltf::ReadAccessor(model, accessor, &values, err)) {
+    return false;
+  }
+  if (dstStride == 3) {
+    if (count > 0) memcpy(dst, values.data(), sizeof(float) * 3 * count);
+  } else {
+    for (size_t i = 0; i < count; i++) {
+      memcpy(dst + i * dstStride, values.data() + i * 3, sizeof(float) * 3);
+    }
+  }
+  return true;
+}
+
+int FindAttribute(const std::map<std::string, int> &attributes,
+                  const char *name) {
+  std::map<std::string, int>::const_iterator it = attributes.find(name);
+  return it == attributes.end() ? -1 : it->second;
+}
+
+}  // namespace
+
+bool MorphEvaluator::Init(const tinygltf::Model &model,
+                          const tinygltf::Primitive &primitive,
+                          std::string *err) {
+  vertex_count_ = 0;
+  stride_ = 3;
+  base_.clear();
+  targets_.clear();
+
+  const int position = FindAttribute(primitive.attributes, "POSITION");
+  if (position < 0 || size_t(position) >= model.accessors.size()) {
+    if (err) (*err) += "Primitive has no POSITION attribute.\n";
+    return false;
+  }
+  const size_t count = model.accessors[size_t(position)].count;
+
+  // Morph normals only when both the base and some target have them.
+  const int normal = FindAttribute(primitive.attributes, "NORMAL");
+  bool has_normals = false;
+  if (normal >= 0) {
+    for (size_t i = 0; i < primitive.targets.size(); i++) {
+      if (FindAttribute(primitive.targets[i], "NORMAL") >= 0) {
+        has_normals = true;
+        break;
+      }
+    }
+  }
+  const size_t stride = has_normals ? 6 : 3;
+
+  std::vector<float> base(count * stride);
+  if (!ReadVec3(model, position, count, base.data(), stride, err)) {
+    return false;
+  }
+  if (has_normals &&
+      !ReadVec3(model, normal, count, base.data() + 3, stride, err)) {
+    return false;
+  }
+
+  // Dense deltas are only needed transiently, one target at a time.
+  stride_ = stride;
+  vertex_count_ = count;
+  std::vector<float> deltas;
+  std::vector<Target> targets(primitive.targets.size());
+  for (size_t i = 0; i < primitive.targets.size(); i++) {
+    const std::map<std::string, int> &target = primitive.targets[i];
+    deltas.assign(count * stride, 0.0f);
+    const int dp = FindAttribute(target, "POSITION");
+    if (dp >= 0 && !ReadVec3(model, dp, count, deltas.data(), stride, err)) {
+      vertex_count_ = 0;
+      return false;
+    }
+    const int dn = FindAttribute(target, "NORMAL");
+    if (has_normals && dn >= 0 &&
+        !ReadVec3(model, dn, count, deltas.data() + 3, stride, err)) {
+      vertex_count_ = 0;
+      return false;
+    }
+    // Quantized targets have a common step when all their accessors agree.
+    float step = -1.0f;
+    for (int accessor : {dp, has_normals ? dn : -1}) {
+      if (accessor < 0) continue;
+      const float s = QuantizationStep(model.accessors[size_t(accessor)]);
+      step = (step < 0.0f || step == s) ? s : 0.0f;
+    }
+    BuildTarget(deltas, std::max(step, 0.0f), &targets[i]);
+  }
+
+  base_.swap(base);
+  targets_.swap(targets);
+  return true;
+}
+
+void MorphEvaluator::BuildTarget(const std::vector<float> &deltas,
+                                 float step, Target *target) const {
+  std::vector<uint32_t> moved;
+  for (size_t v = 0; v < vertex_count_; v++) {
+    const float *d = deltas.data() + v * stride_;
+    for (size_t c = 0; c < stride_; c++) {
+      if (std::fabs(d[c]) > delta_threshold_) {
+        moved.push_back(uint32_t(v));
+        break;
+      }
+    }
+  }
+
+  // Index lists stop paying off once most vertices move.
+  target->encoding = encoding_;
+  target->dense = moved.size() * 2 > vertex_count_;
+  std::vector<float> values;
+  if (target->dense) {
+    values = deltas;
+  } else {
+    values.reserve(moved.size() * stride_);
+    for (size_t k = 0; k < moved.size(); k++) {
+      const float *d = deltas.data() + moved[k] * stride_;
+      values.insert(values.end(), d, d + stride_);
+    }
+    target->indices.swap(moved);
+  }
+
+  if (encoding_ == kDeltaFloat32) {
+    target->values.swap(values);
+  } else if (encoding_ == kDeltaFloat16) {
+    target->packed.resize(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+      target->packed[i] = FloatToHalf(values[i]);
+    }
+  } else {
+    float max_abs = 0.0f;
+    for (size_t i = 0; i < values.size(); i++) {
+      max_abs = std::max(max_abs, std::fabs(values[i]));
+    }
+    target->scale = max_abs > 0.0f ? max_abs / 32767.0f : 1.0f;
+    // Quantized deltas keep their exact values when they fit.
+    if (step > 0.0f && max_abs <= step * 32767.0f) target->scale = step;
+    target->packed.resize(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+      const long q = std::lround(values[i] / target->scale);
+      target->packed[i] = uint16_t(int16_t(q));
+    }
+  }
+}
+
+void MorphEvaluator::Evaluate(const float *weights, size_t weightCount,
+                              float *out) const {
+  if (!base_.empty()) {
+    memcpy(out, base_.data(), sizeof(float) * base_.size());
+  }
+  const size_t n = std::min(weightCount, targets_.size());
+  for (size_t i = 0; i < n; i++) {
+    const float w = weights[i];
+    if (w == 0.0f || std::fabs(w) < min_weight_) continue;
+
+    const Target &t = targets_[i];
+    const uint32_t *indices = t.indices.data();
+    const size_t count = t.indices.size();
+    if (t.encoding == kDeltaFloat32) {
+      if (t.dense) {
+        Axpy(w, t.values.data(), out, base_.size());
+      } else {
+        AccumulateSparse(w, indices, count, stride_, t.values.data(), out);
+      }
+    } else if (t.encoding == kDeltaFloat16) {
+      if (t.dense) {
+        AxpyPacked<true, HalfToFloat>(w, t.packed.data(), out, base_.size());
+      } else {
+        AccumulateSparsePacked<HalfToFloat>(w, indices, count, stride_,
+                                            t.packed.data(), out);
+      }
+    } else {
+      if (t.dense) {
+        AxpyPacked<true, Int16ToFloat>(w * t.scale, t.packed.data(), out,
+                                       base_.size());
+      } else {
+        AccumulateSparsePacked<Int16ToFloat>(w * t.scale, indices, count,
+                                             stride_, t.packed.data(), out);
+      }
+    }
+  }
+}
+
+size_t MorphEvaluator::DeltaBytes() const {
+  size_t bytes = 0;
+  for (size_t i = 0; i < targets_.size(); i++) {
+    bytes += targets_[i].indices.size() * sizeof(uint32_t);
+    bytes += targets_[i].values.size() * sizeof(float);
+    bytes += targets_[i].packed.size() * sizeof(uint16_t);
+  }
+  return bytes;
+}
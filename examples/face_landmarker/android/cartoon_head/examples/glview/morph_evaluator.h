@@ -0,0 +1,97 @@
+#ifndef MP_FACE_LANDMARKER_MORPH_EVALUATOR_H
+#define MP_FACE_LANDMARKER_MORPH_EVALUATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tiny_gltf.h"
+
+//
+// CPU evaluation of morph targets (blendshapes).
+//
+// Output is a ready-to-upload vertex buffer of `VertexCount()` vertices,
+// `Stride()` floats each: vec3 position, followed by vec3 normal when the
+// targets morph normals.
+//
+// Each target only keeps the vertices it actually moves (an index list plus
+// packed deltas, optionally quantized), so memory and blend cost scale with
+// the number of moved vertices rather than mesh size x target count.
+// Targets that move most of the mesh are kept dense and blended with a single
+// multiply-add over the whole buffer (SSE/AVX/NEON when available). fp16 and
+// int16 deltas are converted in registers by the same kernels; sparse ones
+// are converted a block at a time, then added to their vertices.
+// Targets whose weight is below `SetMinWeight()` are skipped entirely.
+//
+// Doesn't depend on GL, so it can run headless.
+//
+class MorphEvaluator {
+ public:
+  enum DeltaEncoding {
+    kDeltaFloat32,
+    kDeltaFloat16,
+    kDeltaInt16,  // Scaled by the target's largest delta component, or
+                  // by the quantization step of integer targets.
+  };
+
+  MorphEvaluator() = default;
+
+  ///
+  /// Reads base POSITION/NORMAL and all `primitive.targets` deltas.
+  /// Accessors must be VEC3 of float or, as KHR_mesh_quantization allows, of
+  /// (normalized) 8/16-bit integers, and target counts must match the base
+  /// POSITION count. Returns false and sets `err` otherwise.
+  ///
+  bool Init(const tinygltf::Model &model, const tinygltf::Primitive &primitive,
+            std::string *err);
+
+  ///
+  /// out = base + sum(weights[i] * target[i]).
+  /// `out` must hold `FloatCount()` floats. Weights past `TargetCount()` are
+  /// ignored.
+  ///
+  void Evaluate(const float *weights, size_t weightCount, float *out) const;
+
+  /// How target deltas are stored. Takes effect on the next Init().
+  void SetDeltaEncoding(DeltaEncoding e) { encoding_ = e; }
+
+  /// A vertex counts as moved by a target when any delta component exceeds
+  /// this. Takes effect on the next Init().
+  void SetDeltaThreshold(float t) { delta_threshold_ = t; }
+
+  /// Weights with an absolute value below this are treated as zero.
+  void SetMinWeight(float w) { min_weight_ = w; }
+
+  size_t VertexCount() const { return vertex_count_; }
+  size_t TargetCount() const { return targets_.size(); }
+  bool HasNormals() const { return stride_ == 6; }
+  size_t Stride() const { return stride_; }
+  size_t FloatCount() const { return base_.size(); }
+
+  /// Bytes used by target deltas and their index lists.
+  size_t DeltaBytes() const;
+
+ private:
+  struct Target {
+    DeltaEncoding encoding = kDeltaFloat32;
+    bool dense = false;             // Deltas for every vertex, no indices.
+    std::vector<uint32_t> indices;  // Moved vertices.
+    std::vector<float> values;      // kDeltaFloat32, `stride_` per vertex.
+    std::vector<uint16_t> packed;   // kDeltaFloat16/kDeltaInt16.
+    float scale = 1.0f;             // kDeltaInt16 only.
+  };
+
+  // `step` is the quantization step of integer targets, 0 otherwise.
+  void BuildTarget(const std::vector<float> &deltas, float step,
+                   Target *target) const;
+
+  size_t vertex_count_ = 0;
+  size_t stride_ = 3;
+  DeltaEncoding encoding_ = kDeltaFloat32;
+  float delta_threshold_ = 0.0f;
+  float min_weight_ = 0.0f;
+  std::vector<float> base_;
+  std::vector<Target> targets_;
+};
+
+#endif  // MP_FACE_LANDMARKER_MORPH_EVALUATOR_H
@@ -0,0 +1,486 @@
+#include "skin_evaluator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// One matrix column, or a quaternion.
+#if defined(__SSE2__) || defined(_M_X64)
+typedef __m128 Vec4;
+inline Vec4 Zero4() { return _mm_setzero_ps(); }
+inline Vec4 Load4(const float *p) { return _mm_loadu_ps(p); }
+inline void Store4(float *p, Vec4 v) { _mm_storeu_ps(p, v); }
+// acc + a * s
+inline Vec4 MulAdd4(Vec4 acc, Vec4 a, float s) {
+  return _mm_add_ps(acc, _mm_mul_ps(a, _mm_set1_ps(s)));
+}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+typedef float32x4_t Vec4;
+inline Vec4 Zero4() { return vdupq_n_f32(0.0f); }
+inline Vec4 Load4(const float *p) { return vld1q_f32(p); }
+inline void Store4(float *p, Vec4 v) { vst1q_f32(p, v); }
+inline Vec4 MulAdd4(Vec4 acc, Vec4 a, float s) {
+  return vmlaq_n_f32(acc, a, s);
+}
+#else
+struct Vec4 {
+  float v[4];
+};
+inline Vec4 Zero4() {
+  Vec4 r = {{0.0f, 0.0f, 0.0f, 0.0f}};
+  return r;
+}
+inline Vec4 Load4(const float *p) {
+  Vec4 r;
+  memcpy(r.v, p, sizeof(r.v));
+  return r;
+}
+inline void Store4(float *p, Vec4 v) { memcpy(p, v.v, sizeof(v.v)); }
+inline Vec4 MulAdd4(Vec4 acc, Vec4 a, float s) {
+  for (int k = 0; k < 4; k++) acc.v[k] += a.v[k] * s;
+  return acc;
+}
+#endif
+
+// Factor mapping stored weights to [0, 1].
+template <typename W>
+float WeightScale() {
+  return 1.0f;
+}
+template <>
+float WeightScale<uint8_t>() {
+  return 1.0f / 255.0f;
+}
+template <>
+float WeightScale<uint16_t>() {
+  return 1.0f / 65535.0f;
+}
+
+void Normalize3(float *v) {
+  const float len = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+  if (len > 0.0f) {
+    const float inv = 1.0f / len;
+    v[0] *= inv;
+    v[1] *= inv;
+    v[2] *= inv;
+  }
+}
+
+void Cross(const float *a, const float *b, float *out) {
+  out[0] = a[1] * b[2] - a[2] * b[1];
+  out[1] = a[2] * b[0] - a[0] * b[2];
+  out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+// out = a * b, all column-major 4x4.
+void MultiplyMatrix(const float *a, const float *b, float *out) {
+  for (int c = 0; c < 4; c++) {
+    for (int r = 0; r < 4; r++) {
+      out[c * 4 + r] = a[r] * b[c * 4] + a[4 + r] * b[c * 4 + 1] +
+                       a[8 + r] * b[c * 4 + 2] + a[12 + r] * b[c * 4 + 3];
+    }
+  }
+}
+
+// Unit dual quaternion (real xyzw, dual xyzw) of the rigid part of `m`.
+void MatrixToDualQuaternion(const float *m, float *dq) {
+  float axes[3][3];
+  for (int c = 0; c < 3; c++) {
+    memcpy(axes[c], m + c * 4, sizeof(axes[c]));
+    Normalize3(axes[c]);
+  }
+  float *q = dq;
+  const float trace = axes[0][0] + axes[1][1] + axes[2][2];
+  if (trace > 0.0f) {
+    const float s = 0.5f / std::sqrt(trace + 1.0f);
+    q[3] = 0.25f / s;
+    q[0] = (axes[1][2] - axes[2][1]) * s;
+    q[1] = (axes[2][0] - axes[0][2]) * s;
+    q[2] = (axes[0][1] - axes[1][0]) * s;
+  } else if (axes[0][0] > axes[1][1] && axes[0][0] > axes[2][2]) {
+    const float s = 2.0f * std::sqrt(1.0f + axes[0][0] - axes[1][1] -
+                                     axes[2][2]);
+    q[3] = (axes[1][2] - axes[2][1]) / s;
+    q[0] = 0.25f * s;
+    q[1] = (axes[1][0] + axes[0][1]) / s;
+    q[2] = (axes[2][0] + axes[0][2]) / s;
+  } else if (axes[1][1] > axes[2][2]) {
+    const float s = 2.0f * std::sqrt(1.0f + axes[1][1] - axes[0][0] -
+                                     axes[2][2]);
+    q[3] = (axes[2][0] - axes[0][2]) / s;
+    q[0] = (axes[1][0] + axes[0][1]) / s;
+    q[1] = 0.25f * s;
+    q[2] = (axes[2][1] + axes[1][2]) / s;
+  } else {
+    const float s = 2.0f * std::sqrt(1.0f + axes[2][2] - axes[0][0] -
+                                     axes[1][1]);
+    q[3] = (axes[0][1] - axes[1][0]) / s;
+    q[0] = (axes[2][0] + axes[0][2]) / s;
+    q[1] = (axes[2][1] + axes[1][2]) / s;
+    q[2] = 0.25f * s;
+  }
+  // dual = 0.5 * (t, 0) * real
+  const float *t = m + 12;
+  float *d = dq + 4;
+  d[0] = 0.5f * (t[0] * q[3] + t[1] * q[2] - t[2] * q[1]);
+  d[1] = 0.5f * (-t[0] * q[2] + t[1] * q[3] + t[2] * q[0]);
+  d[2] = 0.5f * (t[0] * q[1] - t[1] * q[0] + t[2] * q[3]);
+  d[3] = -0.5f * (t[0] * q[0] + t[1] * q[1] + t[2] * q[2]);
+}
+
+int FindAttribute(const std::map<std::string, int> &attributes,
+                  const std::string &name) {
+  std::map<std::string, int>::const_iterator it = attributes.find(name);
+  return it == attributes.end() ? -1 : it->second;
+}
+
+const tinygltf::Accessor *GetAccessor(const tinygltf::Model &model,
+                                      int index) {
+  if (index < 0 || size_t(index) >= model.accessors.size()) return nullptr;
+  return &model.accessors[size_t(index)];
+}
+
+// Appends `count` VEC4 elements of `accessor` to the vertices in `dst`,
+// `dstStride` bytes apart, as `type` components of `size` bytes. Copies the
+// stored bytes when the types agree, converts otherwise.
+bool ReadInfluences(const tinygltf::Model &model,
+                    const tinygltf::Accessor &accessor, int type, size_t size,
+                    unsigned char *dst, size_t dstStride, std::string *err) {
+  std::vector<unsigned char> packed;
+  if (accessor.componentType == type) {
+    if (!tinygltf::ResolveSparseAccessor(model, accessor, &packed, err)) {
+      return false;
+    }
+  } else if (type == TINYGLTF_COMPONENT_TYPE_FLOAT) {
+    std::vector<float> values;
+    if (!tinygltf::ReadAccessor(model, accessor, &values, err)) return false;
+    packed.resize(values.size() * sizeof(float));
+    if (!values.empty()) memcpy(packed.data(), values.data(), packed.size());
+  } else {
+    std::vector<uint32_t> values;
+    if (!tinygltf::ReadAccessor(model, accessor, &values, err)) return false;
+    packed.resize(values.size() * sizeof(uint16_t));
+    for (size_t i = 0; i < values.size(); i++) {
+      const uint16_t v = uint16_t(values[i]);
+      memcpy(packed.data() + i * sizeof(v), &v, sizeof(v));
+    }
+  }
+  for (size_t i = 0; i < accessor.count; i++) {
+    memcpy(dst + i * dstStride, packed.data() + i * 4 * size, 4 * size);
+  }
+  return true;
+}
+
+size_t ComponentSize(int type) {
+  return size_t(tinygltf::GetComponentSizeInBytes(uint32_t(type)));
+}
+
+}  // namespace
+
+bool SkinEvaluator::Init(const tinygltf::Model &model,
+                         const tinygltf::Primitive &primitive, int skin,
+                         std::string *err) {
+  vertex_count_ = 0;
+  stride_ = 3;
+  base_.clear();
+  joints_.clear();
+  weights_.clear();
+  joint_nodes_.clear();
+  inverse_bind_.clear();
+  palette_.clear();
+  dual_quats_.clear();
+
+  if (skin < 0 || size_t(skin) >= model.skins.size() ||
+      model.skins[size_t(skin)].joints.empty()) {
+    if (err) (*err) += "Invalid skin or skin without joints.\n";
+    return false;
+  }
+  const tinygltf::Skin &gltfSkin = model.skins[size_t(skin)];
+  const size_t jointCount = gltfSkin.joints.size();
+
+  const tinygltf::Accessor *position =
+      GetAccessor(model, FindAttribute(primitive.attributes, "POSITION"));
+  if (!position || position->type != TINYGLTF_TYPE_VEC3) {
+    if (err) (*err) += "Skinned primitive needs a VEC3 POSITION.\n";
+    return false;
+  }
+  const size_t count = position->count;
+  const tinygltf::Accessor *normal =
+      GetAccessor(model, FindAttribute(primitive.attributes, "NORMAL"));
+  if (normal &&
+      (normal->type != TINYGLTF_TYPE_VEC3 || normal->count != count)) {
+    normal = nullptr;
+  }
+  const size_t stride = normal ? 6 : 3;
+
+  // JOINTS_n/WEIGHTS_n pairs; mixed component types are widened to a common
+  // one.
+  std::vector<const tinygltf::Accessor *> jointSets;
+  std::vector<const tinygltf::Accessor *> weightSets;
+  for (int set = 0;; set++) {
+    const std::string suffix = "_" + std::to_string(set);
+    const tinygltf::Accessor *j = GetAccessor(
+        model, FindAttribute(primitive.attributes, "JOINTS" + suffix));
+    const tinygltf::Accessor *w = GetAccessor(
+        model, FindAttribute(primitive.attributes, "WEIGHTS" + suffix));
+    if (!j || !w) break;
+    const bool jointsOk = j->type == TINYGLTF_TYPE_VEC4 &&
+                          (j->componentType ==
+                               TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE ||
+                           j->componentType ==
+                               TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT);
+    const bool weightsOk =
+        w->type == TINYGLTF_TYPE_VEC4 &&
+        (w->componentType == TINYGLTF_COMPONENT_TYPE_FLOAT ||
+         (w->normalized &&
+          (w->componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE ||
+           w->componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)));
+    if (!jointsOk || !weightsOk || j->count != count || w->count != count) {
+      if (err) {
+        (*err) += "JOINTS" + suffix + "/WEIGHTS" + suffix +
+                  " must be VEC4 of 8/16-bit joints and float or normalized "
+                  "8/16-bit weights, one per vertex.\n";
+      }
+      return false;
+    }
+    if (set == 0) {
+      joint_type_ = j->componentType;
+      weight_type_ = w->componentType;
+    }
+    if (j->componentType != joint_type_) {
+      joint_type_ = TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+    }
+    if (w->componentType != weight_type_) {
+      weight_type_ = TINYGLTF_COMPONENT_TYPE_FLOAT;
+    }
+    jointSets.push_back(j);
+    weightSets.push_back(w);
+  }
+  if (jointSets.empty()) {
+    if (err) (*err) += "Skinned primitive has no JOINTS_0/WEIGHTS_0.\n";
+    return false;
+  }
+
+  std::vector<float> values;
+  std::vector<float> base(count * stride);
+  if (!tinygltf::ReadAccessor(model, *position, &values, err)) return false;
+  for (size_t v = 0; v < count; v++) {
+    memcpy(&base[v * stride], &values[v * 3], sizeof(float) * 3);
+  }
+  if (normal) {
+    if (!tinygltf::ReadAccessor(model, *normal, &values, err)) return false;
+    for (size_t v = 0; v < count; v++) {
+      memcpy(&base[v * stride + 3], &values[v * 3], sizeof(float) * 3);
+    }
+  }
+
+  const size_t influences = 4 * jointSets.size();
+  const size_t jointSize = ComponentSize(joint_type_);
+  const size_t weightSize = ComponentSize(weight_type_);
+  std::vector<unsigned char> joints(count * influences * jointSize);
+  std::vector<unsigned char> weights(count * influences * weightSize);
+  for (size_t set = 0; set < jointSets.size(); set++) {
+    if (!ReadInfluences(model, *jointSets[set], joint_type_, jointSize,
+                        joints.data() + set * 4 * jointSize,
+                        influences * jointSize, err) ||
+        !ReadInfluences(model, *weightSets[set], weight_type_, weightSize,
+                        weights.data() + set * 4 * weightSize,
+                        influences * weightSize, err)) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < count * influences; i++) {
+    uint16_t joint = joints[i];
+    if (jointSize == 2) memcpy(&joint, &joints[i * 2], sizeof(joint));
+    if (joint >= jointCount) {
+      if (err) (*err) += "Joint index out of range of the skin.\n";
+      return false;
+    }
+  }
+
+  std::vector<float> inverseBind(jointCount * 16, 0.0f);
+  for (size_t j = 0; j < jointCount; j++) {
+    for (int k = 0; k < 4; k++) inverseBind[j * 16 + k * 5] = 1.0f;
+  }
+  if (gltfSkin.inverseBindMatrices >= 0) {
+    const tinygltf::Accessor *ibm =
+        GetAccessor(model, gltfSkin.inverseBindMatrices);
+    if (!ibm || ibm->type != TINYGLTF_TYPE_MAT4 || ibm->count < jointCount ||
+        !tinygltf::ReadAccessor(model, *ibm, &values, err)) {
+      if (err) (*err) += "Invalid inverseBindMatrices.\n";
+      return false;
+    }
+    memcpy(inverseBind.data(), values.data(), sizeof(float) * 16 * jointCount);
+  }
+
+  vertex_count_ = count;
+  stride_ = stride;
+  influences_ = influences;
+  base_.swap(base);
+  joints_.swap(joints);
+  weights_.swap(weights);
+  joint_nodes_ = gltfSkin.joints;
+  inverse_bind_.swap(inverseBind);
+  palette_ = inverse_bind_;
+  dual_quats_.assign(jointCount * 8, 0.0f);
+  for (size_t j = 0; j < jointCount; j++) {
+    MatrixToDualQuaternion(&palette_[j * 16], &dual_quats_[j * 8]);
+  }
+  return true;
+}
+
+bool SkinEvaluator::UpdatePalette(const tinygltf::FlatScene &scene) {
+  for (size_t j = 0; j < joint_nodes_.size(); j++) {
+    const int node = scene.Find(joint_nodes_[j]);
+    if (node < 0) return false;
+    MultiplyMatrix(scene.WorldMatrix(size_t(node)), &inverse_bind_[j * 16],
+                   &palette_[j * 16]);
+    if (method_ == kDualQuaternion) {
+      MatrixToDualQuaternion(&palette_[j * 16], &dual_quats_[j * 8]);
+    }
+  }
+  return true;
+}
+
+void SkinEvaluator::Evaluate(size_t begin, size_t end, float *out,
+                             const float *in, size_t inStride) const {
+  end = std::min(end, vertex_count_);
+  if (begin >= end) return;
+  const bool shortJoints =
+      joint_type_ == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+  if (weight_type_ == TINYGLTF_COMPONENT_TYPE_FLOAT) {
+    if (shortJoints) {
+      EvaluateAs<uint16_t, float>(begin, end, out, in, inStride);
+    } else {
+      EvaluateAs<uint8_t, float>(begin, end, out, in, inStride);
+    }
+  } else if (weight_type_ == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
+    if (shortJoints) {
+      EvaluateAs<uint16_t, uint16_t>(begin, end, out, in, inStride);
+    } else {
+      EvaluateAs<uint8_t, uint16_t>(begin, end, out, in, inStride);
+    }
+  } else {
+    if (shortJoints) {
+      EvaluateAs<uint16_t, uint8_t>(begin, end, out, in, inStride);
+    } else {
+      EvaluateAs<uint8_t, uint8_t>(begin, end, out, in, inStride);
+    }
+  }
+}
+
+template <typename J, typename W>
+void SkinEvaluator::EvaluateAs(size_t begin, size_t end, float *out,
+                               const float *in, size_t inStride) const {
+  if (!in) {
+    in = base_.data();
+    inStride = stride_;
+  }
+  if (method_ == kDualQuaternion) {
+    BlendDualQuaternions<J, W>(begin, end, out, in, inStride);
+  } else {
+    BlendMatrices<J, W>(begin, end, out, in, inStride);
+  }
+}
+
+template <typename J, typename W>
+void SkinEvaluator::BlendMatrices(size_t begin, size_t end, float *out,
+                                  const float *in, size_t inStride) const {
+  const J *joints = reinterpret_cast<const J *>(joints_.data());
+  const W *weights = reinterpret_cast<const W *>(weights_.data());
+  const float scale = WeightScale<W>();
+  const bool inNormals = inStride >= 6;
+  for (size_t v = begin; v < end; v++) {
+    // Weighted sum of the joint matrices, a column at a time.
+    Vec4 c0 = Zero4(), c1 = Zero4(), c2 = Zero4(), c3 = Zero4();
+    // Zero weights are blended too; skipping them mispredicts too often.
+    for (size_t k = v * influences_; k < (v + 1) * influences_; k++) {
+      const float w = float(weights[k]) * scale;
+      const float *m = &palette_[size_t(joints[k]) * 16];
+      c0 = MulAdd4(c0, Load4(m), w);
+      c1 = MulAdd4(c1, Load4(m + 4), w);
+      c2 = MulAdd4(c2, Load4(m + 8), w);
+      c3 = MulAdd4(c3, Load4(m + 12), w);
+    }
+    const float *p = in + v * inStride;
+    float result[4];
+    Store4(result, MulAdd4(MulAdd4(MulAdd4(c3, c0, p[0]), c1, p[1]), c2, p[2]));
+    float *dst = out + v * stride_;
+    memcpy(dst, result, sizeof(float) * 3);
+    if (stride_ == 6) {
+      const float *n = inNormals ? p + 3 : &base_[v * 6 + 3];
+      Store4(result,
+             MulAdd4(MulAdd4(MulAdd4(Zero4(), c0, n[0]), c1, n[1]), c2, n[2]));
+      Normalize3(result);
+      memcpy(dst + 3, result, sizeof(float) * 3);
+    }
+  }
+}
+
+template <typename J, typename W>
+void SkinEvaluator::BlendDualQuaternions(size_t begin, size_t end, float *out,
+                                         const float *in,
+                                         size_t inStride) const {
+  const J *joints = reinterpret_cast<const J *>(joints_.data());
+  const W *weights = reinterpret_cast<const W *>(weights_.data());
+  const float scale = WeightScale<W>();
+  const bool inNormals = inStride >= 6;
+  for (size_t v = begin; v < end; v++) {
+    Vec4 real = Zero4(), dual = Zero4();
+    const float *pivot = nullptr;
+    for (size_t k = v * influences_; k < (v + 1) * influences_; k++) {
+      if (weights[k] == 0) continue;
+      float w = float(weights[k]) * scale;
+      const float *dq = &dual_quats_[size_t(joints[k]) * 8];
+      // Blend in the hemisphere of the first joint.
+      if (!pivot) pivot = dq;
+      if (dq[0] * pivot[0] + dq[1] * pivot[1] + dq[2] * pivot[2] +
+              dq[3] * pivot[3] <
+          0.0f) {
+        w = -w;
+      }
+      real = MulAdd4(real, Load4(dq), w);
+      dual = MulAdd4(dual, Load4(dq + 4), w);
+    }
+    float r[4], d[4];
+    Store4(r, real);
+    Store4(d, dual);
+    const float len =
+        std::sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3]);
+    const float inv = len > 0.0f ? 1.0f / len : 0.0f;
+    for (int k = 0; k < 4; k++) {
+      r[k] *= inv;
+      d[k] *= inv;
+    }
+
+    // p' = rotate(r, p) + 2 * (r.w * d.xyz - d.w * r.xyz + r.xyz x d.xyz)
+    const float *p = in + v * inStride;
+    float *dst = out + v * stride_;
+    float t[3], u[3];
+    Cross(r, p, t);
+    for (int k = 0; k < 3; k++) t[k] += r[3] * p[k];
+    Cross(r, t, u);
+    float rd[3];
+    Cross(r, d, rd);
+    for (int k = 0; k < 3; k++) {
+      dst[k] = p[k] + 2.0f * u[k] +
+               2.0f * (r[3] * d[k] - d[3] * r[k] + rd[k]);
+    }
+    if (stride_ == 6) {
+      const float *n = inNormals ? p + 3 : &base_[v * 6 + 3];
+      Cross(r, n, t);
+      for (int k = 0; k < 3; k++) t[k] += r[3] * n[k];
+      Cross(r, t, u);
+      for (int k = 0; k < 3; k++) dst[3 + k] = n[k] + 2.0f * u[k];
+    }
+  }
+}
@@ -0,0 +1,93 @@
+#ifndef MP_FACE_LANDMARKER_SKIN_EVALUATOR_H
+#define MP_FACE_LANDMARKER_SKIN_EVALUATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tiny_gltf.h"
+
+//
+// CPU skinning of one primitive by a glTF Skin.
+//
+// Output is a ready-to-upload vertex buffer of `VertexCount()` vertices,
+// `Stride()` floats each: vec3 position, followed by vec3 normal when the
+// primitive has normals. Positions end up in the space of the scene root,
+// so they are drawn without the mesh node's transform.
+//
+// JOINTS_n/WEIGHTS_n are kept as stored (8/16-bit joints, float or
+// normalized 8/16-bit weights) and converted in registers while blending
+// (SSE/NEON when available). Evaluate() only reads shared state, so
+// disjoint vertex ranges can be skinned on several threads.
+//
+// Doesn't depend on GL, so it can run headless.
+//
+class SkinEvaluator {
+ public:
+  enum Method {
+    kLinearBlend,
+    kDualQuaternion,  // No candy-wrapper twist; ignores joint scale.
+  };
+
+  SkinEvaluator() = default;
+
+  ///
+  /// Reads base POSITION/NORMAL, JOINTS_0/WEIGHTS_0 (and _1) of
+  /// `primitive` and the inverse bind matrices of `model.skins[skin]`.
+  /// Returns false and sets `err` when attributes are missing, of an
+  /// unsupported type, or a joint index is out of range.
+  ///
+  bool Init(const tinygltf::Model &model, const tinygltf::Primitive &primitive,
+            int skin, std::string *err);
+
+  ///
+  /// Joint matrices from the world transforms of `scene`, as of its last
+  /// Update(). Returns false when a joint is not part of the scene.
+  ///
+  bool UpdatePalette(const tinygltf::FlatScene &scene);
+
+  ///
+  /// Skins vertices [begin, end) into `out`, which holds `FloatCount()`
+  /// floats. `in` replaces the base vertices when given, e.g. with
+  /// MorphEvaluator output: `inStride` floats per vertex, normals at offset 3
+  /// when `inStride` >= 6 (base normals otherwise).
+  ///
+  void Evaluate(size_t begin, size_t end, float *out,
+                const float *in = nullptr, size_t inStride = 0) const;
+
+  void SetMethod(Method m) { method_ = m; }
+
+  size_t VertexCount() const { return vertex_count_; }
+  size_t JointCount() const { return joint_nodes_.size(); }
+  bool HasNormals() const { return stride_ == 6; }
+  size_t Stride() const { return stride_; }
+  size_t FloatCount() const { return vertex_count_ * stride_; }
+
+ private:
+  template <typename J, typename W>
+  void EvaluateAs(size_t begin, size_t end, float *out, const float *in,
+                  size_t inStride) const;
+  template <typename J, typename W>
+  void BlendMatrices(size_t begin, size_t end, float *out, const float *in,
+                     size_t inStride) const;
+  template <typename J, typename W>
+  void BlendDualQuaternions(size_t begin, size_t end, float *out,
+                            const float *in, size_t inStride) const;
+
+  size_t vertex_count_ = 0;
+  size_t stride_ = 3;
+  size_t influences_ = 4;  // per vertex, 4 per JOINTS_n/WEIGHTS_n set
+  int joint_type_ = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+  int weight_type_ = TINYGLTF_COMPONENT_TYPE_FLOAT;
+  Method method_ = kLinearBlend;
+  std::vector<float> base_;
+  // `influences_` joints and weights per vertex, in their glTF types.
+  std::vector<unsigned char> joints_;
+  std::vector<unsigned char> weights_;
+  std::vector<int> joint_nodes_;
+  std::vector<float> inverse_bind_;  // 16 per joint, column-major
+  std::vector<float> palette_;       // 16 per joint, column-major
+  std::vector<float> dual_quats_;    // 8 per joint: real xyzw, dual xyzw
+};
+
+#endif  // MP_FACE_LANDMARKER_SKIN_EVALUATOR_H
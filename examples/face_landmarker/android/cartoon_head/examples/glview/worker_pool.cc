@@ -0,0 +1,57 @@
+#include "worker_pool.h"
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_.notify_all();
+  for (size_t t = 0; t < threads_.size(); t++) threads_[t].join();
+}
+
+void WorkerPool::Start(size_t threads) {
+  if (!threads_.empty()) return;
+  threads_.reserve(threads);
+  for (size_t t = 0; t < threads; t++) {
+    threads_.emplace_back(&WorkerPool::WorkerLoop, this);
+  }
+}
+
+void WorkerPool::Run(JobFunction job, void *context, size_t count) {
+  if (threads_.empty() || count <= 1) {
+    for (size_t j = 0; j < count; j++) job(context, j);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = job;
+    context_ = context;
+    count_ = count;
+    next_ = 0;
+    busy_ = threads_.size();
+    generation_++;
+  }
+  start_.notify_all();
+  RunJobs();
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return busy_ == 0; });
+}
+
+void WorkerPool::RunJobs() {
+  for (size_t j = next_++; j < count_; j = next_++) job_(context_, j);
+}
+
+void WorkerPool::WorkerLoop() {
+  uint64_t seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_.wait(lock, [this, seen] { return stop_ || generation_ != seen; });
+      if (stop_) return;
+      seen = generation_;
+    }
+    RunJobs();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--busy_ == 0) done_.notify_one();
+  }
+}
@@ -0,0 +1,65 @@
+#ifndef MP_FACE_LANDMARKER_WORKER_POOL_H
+#define MP_FACE_LANDMARKER_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// A fixed set of threads, started once, that runs one batch of jobs at a
+// time on behalf of the render thread.
+//
+// Run() only signals the sleeping workers and joins in itself, so a frame
+// costs no thread creation and no allocation. Jobs are a function pointer
+// and a context rather than std::function for the same reason.
+//
+// Doesn't depend on GL, so it can run headless.
+//
+class WorkerPool {
+ public:
+  typedef void (*JobFunction)(void *context, size_t job);
+
+  WorkerPool() = default;
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  ///
+  /// Starts `threads` workers besides the calling thread. Does nothing when
+  /// already started.
+  ///
+  void Start(size_t threads);
+
+  ///
+  /// Runs `job(context, j)` for each j in [0, count) on the workers and the
+  /// calling thread, and returns once all are done. Runs inline when no
+  /// workers were started. Not reentrant: call from one thread at a time.
+  ///
+  void Run(JobFunction job, void *context, size_t count);
+
+  /// Workers besides the calling thread.
+  size_t ThreadCount() const { return threads_.size(); }
+
+ private:
+  void WorkerLoop();
+  void RunJobs();
+
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  JobFunction job_ = nullptr;
+  void *context_ = nullptr;
+  size_t count_ = 0;
+  std::atomic<size_t> next_{0};
+  size_t busy_ = 0;         // workers still in the current batch
+  uint64_t generation_ = 0;  // bumped by every Run()
+  bool stop_ = false;
+};
+
+#endif  // MP_FACE_LANDMARKER_WORKER_POOL_H
@@ -0,0 +1,278 @@
+//
+// AccessorView and ReadAccessor: every component type and element type, with
+// packed and strided elements, matches a plain per-component conversion.
+// Counts are chosen so both the SIMD kernels and their scalar tails run.
+//
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "tiny_gltf.h"
+#include "test_util.h"
+
+namespace {
+
+const int kComponentTypes[] = {TINYGLTF_COMPONENT_TYPE_BYTE,
+                                TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE,
+                                TINYGLTF_COMPONENT_TYPE_SHORT,
+                                TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT,
+                                TINYGLTF_COMPONENT_TYPE_INT,
+                                TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT,
+                                TINYGLTF_COMPONENT_TYPE_FLOAT,
+                                TINYGLTF_COMPONENT_TYPE_DOUBLE};
+const int kTypes[] = {TINYGLTF_TYPE_SCALAR, TINYGLTF_TYPE_VEC2,
+                      TINYGLTF_TYPE_VEC3,   TINYGLTF_TYPE_VEC4,
+                      TINYGLTF_TYPE_MAT2,   TINYGLTF_TYPE_MAT3,
+                      TINYGLTF_TYPE_MAT4};
+const size_t kCounts[] = {1, 7, 37, 100};
+
+uint32_t Random(uint32_t *state) {
+  (*state) = (*state) * 1664525u + 1013904223u;
+  return (*state) >> 8;
+}
+
+size_t ComponentSize(int component_type) {
+  return size_t(
+      tinygltf::GetComponentSizeInBytes(uint32_t(component_type)));
+}
+
+size_t Components(int type) {
+  return size_t(tinygltf::GetNumComponentsInType(uint32_t(type)));
+}
+
+size_t Columns(int type) {
+  return size_t(tinygltf::GetNumColumnsInType(uint32_t(type)));
+}
+
+// Columns of 1- and 2-byte MAT2/MAT3 start on 4-byte boundaries(glTF 2.0
+// spec 3.6.2.4).
+size_t ColumnStride(int component_type, int type) {
+  const size_t bytes =
+      Components(type) / Columns(type) * ComponentSize(component_type);
+  if (type == TINYGLTF_TYPE_MAT2 || type == TINYGLTF_TYPE_MAT3) {
+    return (bytes + 3) & ~size_t(3);
+  }
+  return bytes;
+}
+
+// Byte offset of component `c` within an element.
+size_t ComponentOffset(int component_type, int type, size_t c) {
+  const size_t rows = Components(type) / Columns(type);
+  return (c / rows) * ColumnStride(component_type, type) +
+         (c % rows) * ComponentSize(component_type);
+}
+
+// One accessor over random bytes; float components hold finite values.
+// `stride` 0 leaves byteStride unset(packed elements).
+tinygltf::Model MakeModel(int component_type, int type, size_t count,
+                          size_t stride, bool normalized, uint32_t seed) {
+  const size_t element_size =
+      ColumnStride(component_type, type) * Columns(type);
+  const size_t step = stride ? stride : element_size;
+  tinygltf::Model model;
+  model.buffers.resize(1);
+  std::vector<unsigned char> &data = model.buffers[0].data;
+  data.resize(8 + step * count);  // at a byteOffset of 8
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<unsigned char>(Random(&seed));
+  }
+  for (size_t i = 0; i < count; i++) {
+    for (size_t c = 0; c < Components(type); c++) {
+      unsigned char *p =
+          &data[8 + i * step + ComponentOffset(component_type, type, c)];
+      const float f = float(int(Random(&seed) % 2001) - 1000) * 0.125f;
+      if (component_type == TINYGLTF_COMPONENT_TYPE_FLOAT) {
+        memcpy(p, &f, sizeof(f));
+      } else if (component_type == TINYGLTF_COMPONENT_TYPE_DOUBLE) {
+        const double d = double(f) / 3.0;
+        memcpy(p, &d, sizeof(d));
+      }
+    }
+  }
+  tinygltf::BufferView view;
+  view.buffer = 0;
+  view.byteOffset = 8;
+  view.byteLength = step * count;
+  view.byteStride = stride;
+  model.bufferViews.push_back(view);
+  tinygltf::Accessor accessor;
+  accessor.bufferView = 0;
+  accessor.componentType = component_type;
+  accessor.type = type;
+  accessor.count = count;
+  accessor.normalized = normalized;
+  model.accessors.push_back(accessor);
+  return model;
+}
+
+template <typename S>
+S Load(const unsigned char *p) {
+  S v;
+  memcpy(&v, p, sizeof(S));
+  return v;
+}
+
+// Component `c` of element `i` as stored, and converted to float with the
+// glTF 2.0 normalized-integer mapping.
+template <typename S>
+void Reference(const tinygltf::Model &model, size_t i, size_t c, S *raw,
+               float *converted) {
+  const tinygltf::Accessor &accessor = model.accessors[0];
+  const tinygltf::BufferView &view = model.bufferViews[0];
+  const size_t stride = size_t(accessor.ByteStride(view));
+  (*raw) = Load<S>(model.buffers[0].data.data() + view.byteOffset +
+                   i * stride +
+                   ComponentOffset(accessor.componentType, accessor.type, c));
+  (*converted) = static_cast<float>(*raw);
+  if (accessor.normalized && std::numeric_limits<S>::is_integer) {
+    (*converted) = float(*raw) / float((std::numeric_limits<S>::max)());
+    if ((*converted) < -1.0f) (*converted) = -1.0f;
+  }
+}
+
+template <typename S>
+void CheckAccessor(const tinygltf::Model &model) {
+  const tinygltf::Accessor &accessor = model.accessors[0];
+  const size_t components = Components(accessor.type);
+
+  tinygltf::AccessorView<S> view(model, accessor);
+  CHECK(view.Valid());
+  CHECK(view.Count() == accessor.count);
+  CHECK(view.NumComponents() == components);
+
+  std::vector<float> floats;
+  std::string err;
+  CHECK(tinygltf::ReadAccessor(model, accessor, &floats, &err));
+  CHECK(err.empty());
+  CHECK(floats.size() == accessor.count * components);
+  std::vector<uint32_t> ints;
+  const bool is_integer = std::numeric_limits<S>::is_integer;
+  CHECK(tinygltf::ReadAccessor(model, accessor, &ints) == is_integer);
+  if (floats.size() != accessor.count * components ||
+      (is_integer && ints.size() != floats.size())) {
+    return;
+  }
+
+  int mismatches = 0;
+  for (size_t i = 0; i < accessor.count; i++) {
+    for (size_t c = 0; c < components; c++) {
+      S raw;
+      float expected;
+      Reference(model, i, c, &raw, &expected);
+      const float got = floats[i * components + c];
+      // Normalized values may be scaled by the reciprocal of the maximum.
+      const float tolerance = accessor.normalized ? 1e-6f : 0.0f;
+      if (!(view.Get(i, c) == raw) ||
+          !(std::fabs(got - expected) <= tolerance) ||
+          (is_integer &&
+           ints[i * components + c] != static_cast<uint32_t>(raw))) {
+        mismatches++;
+      }
+    }
+  }
+  CHECK(mismatches == 0);
+  if (mismatches > 0) {
+    fprintf(stderr,
+            "  componentType %d, type %d, count %zu, stride %zu, "
+            "normalized %d\n",
+            accessor.componentType, accessor.type, accessor.count,
+            size_t(accessor.ByteStride(model.bufferViews[0])),
+            int(accessor.normalized));
+  }
+}
+
+void Check(const tinygltf::Model &model) {
+  switch (model.accessors[0].componentType) {
+    case TINYGLTF_COMPONENT_TYPE_BYTE:
+      CheckAccessor<int8_t>(model);
+      break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+      CheckAccessor<uint8_t>(model);
+      break;
+    case TINYGLTF_COMPONENT_TYPE_SHORT:
+      CheckAccessor<int16_t>(model);
+      break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+      CheckAccessor<uint16_t>(model);
+      break;
+    case TINYGLTF_COMPONENT_TYPE_INT:
+      CheckAccessor<int32_t>(model);
+      break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+      CheckAccessor<uint32_t>(model);
+      break;
+    case TINYGLTF_COMPONENT_TYPE_FLOAT:
+      CheckAccessor<float>(model);
+      break;
+    case TINYGLTF_COMPONENT_TYPE_DOUBLE:
+      CheckAccessor<double>(model);
+      break;
+  }
+}
+
+// Every combination, with packed elements and with a byteStride 8 or 16
+// bytes larger than the element(still a multiple of the component size).
+void TestConversions() {
+  uint32_t seed = 1;
+  for (int component_type : kComponentTypes) {
+    for (int type : kTypes) {
+      const size_t element_size =
+          ColumnStride(component_type, type) * Columns(type);
+      for (size_t count : kCounts) {
+        for (size_t pad = 0; pad <= 16; pad += 8) {
+          const size_t stride = pad ? element_size + pad : 0;
+          const bool is_float =
+              component_type == TINYGLTF_COMPONENT_TYPE_FLOAT ||
+              component_type == TINYGLTF_COMPONENT_TYPE_DOUBLE;
+          Check(MakeModel(component_type, type, count, stride, false, seed++));
+          if (!is_float && ComponentSize(component_type) < 4) {
+            Check(
+                MakeModel(component_type, type, count, stride, true, seed++));
+          }
+        }
+      }
+    }
+  }
+}
+
+// Normalized extremes: the signed minimum clamps to -1 and the maximum maps
+// to exactly 1, in both the SIMD body and the tail.
+void TestNormalizedRange() {
+  tinygltf::Model model = MakeModel(TINYGLTF_COMPONENT_TYPE_SHORT,
+                                    TINYGLTF_TYPE_SCALAR, 19, 0, true, 7);
+  std::vector<unsigned char> &data = model.buffers[0].data;
+  for (size_t i = 0; i < 19; i++) {
+    const int16_t v = (i % 2) ? int16_t(-32768) : int16_t(32767);
+    memcpy(&data[8 + i * 2], &v, 2);
+  }
+  std::vector<float> out;
+  CHECK(tinygltf::ReadAccessor(model, model.accessors[0], &out));
+  CHECK(out.size() == 19);
+  for (size_t i = 0; i < out.size(); i++) {
+    CHECK(out[i] == ((i % 2) ? -1.0f : 1.0f));
+  }
+}
+
+// A view must match the accessor's component type.
+void TestViewTypeMismatch() {
+  const tinygltf::Model model = MakeModel(
+      TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, TINYGLTF_TYPE_VEC2, 4, 0, false,
+      3);
+  tinygltf::AccessorView<float> view;
+  std::string err;
+  CHECK(!view.Reset(model, model.accessors[0], &err));
+  CHECK(!view.Valid());
+  CHECK(!err.empty());
+}
+
+}  // namespace
+
+int main() {
+  TestConversions();
+  TestNormalizedRange();
+  TestViewTypeMismatch();
+  return TestResult();
+}
@@ -0,0 +1,300 @@
+//
+// tinygltf::AnimationEvaluator against hand-computed values: STEP, LINEAR
+// with quaternion slerp, CUBICSPLINE tangents and weights channels, the
+// keyframe cursor after seeking back and forth, and Apply() on a
+// FlatScene.
+//
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "tiny_gltf.h"
+#include "test_util.h"
+
+namespace {
+
+// Appends `values` to buffer 0 as a float accessor of `type` and returns
+// its index.
+int AddAccessor(tinygltf::Model *model, const std::vector<float> &values,
+                int type) {
+  if (model->buffers.empty()) model->buffers.resize(1);
+  std::vector<unsigned char> &data = model->buffers[0].data;
+  tinygltf::BufferView view;
+  view.buffer = 0;
+  view.byteOffset = data.size();
+  view.byteLength = values.size() * sizeof(float);
+  data.resize(data.size() + view.byteLength);
+  memcpy(&data[view.byteOffset], values.data(), view.byteLength);
+  model->bufferViews.push_back(view);
+
+  tinygltf::Accessor accessor;
+  accessor.bufferView = int(model->bufferViews.size() - 1);
+  accessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+  accessor.type = type;
+  accessor.count =
+      values.size() / size_t(tinygltf::GetNumComponentsInType(uint32_t(type)));
+  model->accessors.push_back(accessor);
+  return int(model->accessors.size() - 1);
+}
+
+// Adds a sampler and a channel driving `path` of `node` to animation 0.
+void AddChannel(tinygltf::Model *model, int node, const std::string &path,
+                const std::string &interpolation,
+                const std::vector<float> &times,
+                const std::vector<float> &values, int type) {
+  if (model->animations.empty()) model->animations.resize(1);
+  tinygltf::Animation &animation = model->animations[0];
+  tinygltf::AnimationSampler sampler;
+  sampler.input = AddAccessor(model, times, TINYGLTF_TYPE_SCALAR);
+  sampler.output = AddAccessor(model, values, type);
+  sampler.interpolation = interpolation;
+  animation.samplers.push_back(sampler);
+  tinygltf::AnimationChannel channel;
+  channel.sampler = int(animation.samplers.size() - 1);
+  channel.target_node = node;
+  channel.target_path = path;
+  animation.channels.push_back(channel);
+}
+
+bool Near(const float *actual, const std::vector<float> &expected,
+          float tolerance = 1e-5f) {
+  for (size_t k = 0; k < expected.size(); k++) {
+    if (!(std::fabs(actual[k] - expected[k]) <= tolerance)) return false;
+  }
+  return true;
+}
+
+// Holds each key until the next, and the first and last keys outside.
+void TestStep() {
+  tinygltf::Model model;
+  AddChannel(&model, 0, "translation", "STEP", {1, 2, 3},
+             {0, 0, 0, 1, 2, 3, 4, 5, 6}, TINYGLTF_TYPE_VEC3);
+  tinygltf::AnimationEvaluator eval;
+  std::string err;
+  CHECK(eval.Init(model, 0, &err));
+  CHECK(err.empty());
+  CHECK(eval.ChannelCount() == 1);
+  CHECK(eval.TargetNode(0) == 0);
+  CHECK(eval.TargetPath(0) == tinygltf::AnimationEvaluator::kTranslation);
+  CHECK(eval.ComponentCount(0) == 3);
+  CHECK(eval.Duration() == 3.0f);
+
+  const struct {
+    float time;
+    std::vector<float> value;
+  } cases[] = {{0.0f, {0, 0, 0}}, {1.5f, {0, 0, 0}}, {2.0f, {1, 2, 3}},
+               {2.99f, {1, 2, 3}}, {3.0f, {4, 5, 6}}, {10.0f, {4, 5, 6}},
+               {1.0f, {0, 0, 0}}};
+  for (const auto &c : cases) {
+    eval.Evaluate(c.time);
+    CHECK(Near(eval.Output(0), c.value, 0.0f));
+  }
+}
+
+// Translation and weights interpolate per component; rotations slerp on
+// the shortest arc.
+void TestLinear() {
+  const float s45 = std::sqrt(0.5f);
+  tinygltf::Model model;
+  AddChannel(&model, 0, "translation", "LINEAR", {0, 2},
+             {0, 0, 0, 4, 8, -4}, TINYGLTF_TYPE_VEC3);
+  // Identity to 90 degrees about z.
+  AddChannel(&model, 0, "rotation", "LINEAR", {0, 1},
+             {0, 0, 0, 1, 0, 0, s45, s45}, TINYGLTF_TYPE_VEC4);
+  // The same rotation with the second key negated.
+  AddChannel(&model, 1, "rotation", "LINEAR", {0, 1},
+             {0, 0, 0, 1, 0, 0, -s45, -s45}, TINYGLTF_TYPE_VEC4);
+  // 3 morph targets.
+  AddChannel(&model, 0, "weights", "LINEAR", {0, 1},
+             {0, 0.5f, 1, 1, 0.5f, 0}, TINYGLTF_TYPE_SCALAR);
+  // An empty interpolation is LINEAR.
+  AddChannel(&model, 1, "scale", "", {0, 1}, {1, 1, 1, 3, 5, 7},
+             TINYGLTF_TYPE_VEC3);
+  tinygltf::AnimationEvaluator eval;
+  CHECK(eval.Init(model, 0));
+  CHECK(eval.ChannelCount() == 5);
+  CHECK(eval.ComponentCount(3) == 3);
+  CHECK(eval.TargetPath(3) == tinygltf::AnimationEvaluator::kWeights);
+
+  eval.Evaluate(0.25f);
+  CHECK(Near(eval.Output(0), {0.5f, 1.0f, -0.5f}));
+  // 22.5 degrees, where slerp and nlerp differ.
+  const std::vector<float> q22 = {0.0f, 0.0f, std::sin(0.19634954f),
+                                  std::cos(0.19634954f)};
+  CHECK(Near(eval.Output(1), q22));
+  CHECK(Near(eval.Output(2), q22));
+  CHECK(Near(eval.Output(3), {0.25f, 0.5f, 0.75f}));
+  CHECK(Near(eval.Output(4), {1.5f, 2.0f, 2.5f}));
+
+  eval.Evaluate(0.5f);
+  const std::vector<float> q45 = {0.0f, 0.0f, std::sin(0.39269908f),
+                                  std::cos(0.39269908f)};
+  CHECK(Near(eval.Output(1), q45));
+  CHECK(Near(eval.Output(2), q45));
+
+  // Past the end of the shorter channels, they hold their last key.
+  eval.Evaluate(1.5f);
+  CHECK(Near(eval.Output(0), {3.0f, 6.0f, -3.0f}));
+  CHECK(Near(eval.Output(1), {0, 0, s45, s45}));
+  CHECK(Near(eval.Output(3), {1, 0.5f, 0}));
+}
+
+// Hermite spline with the tangents scaled by the key interval. Keys hold
+// in-tangent, value and out-tangent; the in-tangent of the first key and
+// the out-tangent of the last are never used.
+void TestCubicSpline() {
+  tinygltf::Model model;
+  AddChannel(&model, 0, "translation", "CUBICSPLINE", {0, 2},
+             {99, 99, 99,  // a0
+              1, 2, 3,     // v0
+              1, 0, 0,     // b0
+              0, 0, 3,     // a1
+              1, 1, 0,     // v1
+              99, 99, 99}, // b1
+             TINYGLTF_TYPE_VEC3);
+  // One morph target.
+  AddChannel(&model, 0, "weights", "CUBICSPLINE", {0, 1},
+             {99, 0, 2, -2, 1, 99}, TINYGLTF_TYPE_SCALAR);
+  tinygltf::AnimationEvaluator eval;
+  CHECK(eval.Init(model, 0));
+  CHECK(eval.ComponentCount(1) == 1);
+
+  eval.Evaluate(0.0f);
+  CHECK(Near(eval.Output(0), {1, 2, 3}));
+  CHECK(Near(eval.Output(1), {0}));
+  // u = 0.5, dt = 2: h00 = 0.5, h10 = 0.25, h01 = 0.5, h11 = -0.25.
+  eval.Evaluate(1.0f);
+  CHECK(Near(eval.Output(0), {1.25f, 1.5f, 0.75f}));
+  // u = 1, dt = 1 for the weights: the second value.
+  CHECK(Near(eval.Output(1), {1}));
+  // u = 0.25, dt = 1: h00 = 0.84375, h10 = 0.140625, h01 = 0.15625,
+  // h11 = -0.046875.
+  eval.Evaluate(0.25f);
+  CHECK(Near(eval.Output(1), {0.140625f * 2 + 0.15625f + 0.046875f * 2}));
+  eval.Evaluate(2.0f);
+  CHECK(Near(eval.Output(0), {1, 1, 0}));
+}
+
+// Seeking back finds the right interval and later steps forward continue
+// from it.
+void TestCursor() {
+  tinygltf::Model model;
+  std::vector<float> times;
+  std::vector<float> values;
+  for (int k = 0; k <= 20; k++) {
+    times.push_back(float(k));
+    // Quadratic, so a wrong interval gives a wrong value.
+    values.push_back(float(k * k));
+  }
+  AddChannel(&model, 0, "weights", "LINEAR", times, values,
+             TINYGLTF_TYPE_SCALAR);
+  tinygltf::AnimationEvaluator eval;
+  CHECK(eval.Init(model, 0));
+
+  const float sequence[] = {0.5f, 1.5f, 2.25f, 17.5f, 3.5f, 3.75f, 4.5f,
+                            0.25f, 19.5f, 19.0f, 12.5f, 12.5f, 13.5f, 11.0f,
+                            20.0f, 5.5f, -1.0f, 6.5f};
+  for (float t : sequence) {
+    eval.Evaluate(t);
+    float expected;
+    if (t <= 0.0f) {
+      expected = 0.0f;
+    } else if (t >= 20.0f) {
+      expected = 400.0f;
+    } else {
+      const float k = std::floor(t);
+      expected = k * k + (t - k) * (2.0f * k + 1.0f);
+    }
+    CHECK(Near(eval.Output(0), {expected}, 1e-3f));
+  }
+}
+
+// Channels write into the FlatScene nodes they target; weights and nodes
+// outside of the scene are skipped.
+void TestApply() {
+  const float s45 = std::sqrt(0.5f);
+  tinygltf::Model model;
+  model.nodes.resize(3);
+  model.nodes[0].children = {1};
+  model.nodes[1].translation = {9.0, 9.0, 9.0};
+  model.scenes.resize(1);
+  model.scenes[0].nodes = {0};  // node 2 is not in the scene
+  AddChannel(&model, 0, "rotation", "LINEAR", {0, 1},
+             {0, 0, 0, 1, 0, 0, s45, s45}, TINYGLTF_TYPE_VEC4);
+  AddChannel(&model, 1, "translation", "LINEAR", {0, 1},
+             {0, 0, 0, 2, 0, 0}, TINYGLTF_TYPE_VEC3);
+  AddChannel(&model, 1, "scale", "STEP", {0}, {2, 2, 2},
+             TINYGLTF_TYPE_VEC3);
+  AddChannel(&model, 0, "weights", "LINEAR", {0, 1}, {0, 1},
+             TINYGLTF_TYPE_SCALAR);
+  AddChannel(&model, 2, "translation", "LINEAR", {0, 1},
+             {0, 0, 0, 1, 1, 1}, TINYGLTF_TYPE_VEC3);
+
+  tinygltf::FlatScene scene;
+  CHECK(scene.Build(model, 0));
+  tinygltf::AnimationEvaluator eval;
+  CHECK(eval.Init(model, 0));
+
+  eval.Evaluate(1.0f);
+  eval.Apply(&scene);
+  scene.Update();
+  // Node 0 turns 90 degrees about z, so node 1's x translation of 2 ends
+  // up on y, and x maps to y, y to -x.
+  const float expected[16] = {0, 2, 0, 0, -2, 0, 0, 0, 0, 0, 2, 0, 0, 2, 0, 1};
+  bool near = true;
+  for (int k = 0; k < 16; k++) {
+    near &= std::fabs(scene.WorldMatrix(1)[k] - expected[k]) < 1e-5f;
+  }
+  CHECK(near);
+  CHECK(scene.Find(2) == -1);
+}
+
+void TestInitErrors() {
+  tinygltf::Model model;
+  AddChannel(&model, 0, "translation", "LINEAR", {0, 1}, {0, 0, 0, 1, 1, 1},
+             TINYGLTF_TYPE_VEC3);
+  tinygltf::AnimationEvaluator eval;
+  std::string err;
+  CHECK(!eval.Init(model, 1, &err));
+  CHECK(!err.empty());
+
+  tinygltf::Model bad = model;
+  bad.animations[0].samplers[0].interpolation = "BEZIER";
+  err.clear();
+  CHECK(!eval.Init(bad, 0, &err));
+  CHECK(err.find("BEZIER") != std::string::npos);
+
+  // A rotation channel needs VEC4 output.
+  bad = model;
+  bad.animations[0].channels[0].target_path = "rotation";
+  err.clear();
+  CHECK(!eval.Init(bad, 0, &err));
+  CHECK(!err.empty());
+
+  // Fewer output keys than input keys.
+  bad = model;
+  bad.accessors[size_t(bad.animations[0].samplers[0].output)].count = 1;
+  err.clear();
+  CHECK(!eval.Init(bad, 0, &err));
+  CHECK(!err.empty());
+
+  // Unknown paths are kept but not sampled.
+  bad = model;
+  bad.animations[0].channels[0].target_path = "pointer";
+  CHECK(eval.Init(bad, 0));
+  CHECK(eval.TargetPath(0) == tinygltf::AnimationEvaluator::kOther);
+  CHECK(eval.ComponentCount(0) == 0);
+}
+
+}  // namespace
+
+int main() {
+  TestStep();
+  TestLinear();
+  TestCubicSpline();
+  TestCursor();
+  TestApply();
+  TestInitErrors();
+  return TestResult();
+}
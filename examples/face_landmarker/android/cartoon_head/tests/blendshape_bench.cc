@@ -0,0 +1,103 @@
+//
+// Per-frame cost of turning a landmarker result into morph target
+// influences(examples/glview), before and after BindBlendshapes():
+//
+//   before: rebuild a name -> weight std::map every frame, then look every
+//           name up in the target name map.
+//   after:  acquire the bound slot table and gather into the influences.
+//
+// Usage: blendshape_bench [frames]
+//
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "blendshape_binding.h"
+#include "face_frame_channel.h"
+
+namespace {
+
+// MediaPipe face landmarker categories, in result order.
+const char *const kCategories[52] = {
+    "_neutral",         "browDownLeft",       "browDownRight",
+    "browInnerUp",      "browOuterUpLeft",    "browOuterUpRight",
+    "cheekPuff",        "cheekSquintLeft",    "cheekSquintRight",
+    "eyeBlinkLeft",     "eyeBlinkRight",      "eyeLookDownLeft",
+    "eyeLookDownRight", "eyeLookInLeft",      "eyeLookInRight",
+    "eyeLookOutLeft",   "eyeLookOutRight",    "eyeLookUpLeft",
+    "eyeLookUpRight",   "eyeSquintLeft",      "eyeSquintRight",
+    "eyeWideLeft",      "eyeWideRight",       "jawForward",
+    "jawLeft",          "jawOpen",            "jawRight",
+    "mouthClose",       "mouthDimpleLeft",    "mouthDimpleRight",
+    "mouthFrownLeft",   "mouthFrownRight",    "mouthFunnel",
+    "mouthLeft",        "mouthLowerDownLeft", "mouthLowerDownRight",
+    "mouthPressLeft",   "mouthPressRight",    "mouthPucker",
+    "mouthRight",       "mouthRollLower",     "mouthRollUpper",
+    "mouthShrugLower",  "mouthShrugUpper",    "mouthSmileLeft",
+    "mouthSmileRight",  "mouthStretchLeft",   "mouthStretchRight",
+    "mouthUpperUpLeft", "mouthUpperUpRight",  "noseSneerLeft",
+    "noseSneerRight"};
+
+// Keeps the compiler from dropping the measured work.
+volatile float sink;
+
+template <typename Fn>
+double NanosPerFrame(int frames, Fn fn) {
+  const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (int f = 0; f < frames; f++) fn(f);
+  const std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / frames;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const int frames = argc > 1 ? atoi(argv[1]) : 200000;
+
+  std::vector<std::string> keys(kCategories, kCategories + 52);
+  // The model names every category but "_neutral".
+  std::map<std::string, int> targetNames;
+  for (int i = 1; i < 52; i++) targetNames[kCategories[i]] = i - 1;
+  const size_t targetCount = targetNames.size();
+  std::vector<float> influences(targetCount + 1);
+
+  FaceFrameChannel frames_channel;
+  FaceFrame &frame = frames_channel.BeginWrite();
+  for (int i = 0; i < 52; i++) frame.weights[i] = 0.01f * float(i);
+  frames_channel.Publish();
+  frames_channel.Acquire();
+  const FaceFrame &latest = frames_channel.Latest();
+
+  const double before = NanosPerFrame(frames, [&](int) {
+    std::map<std::string, float> shapes;
+    for (size_t i = 0; i < keys.size(); i++) {
+      shapes[keys[i]] = latest.weights[i];
+    }
+    std::fill(influences.begin(), influences.end(), 0.0f);
+    for (const auto &it : shapes) {
+      std::map<std::string, int>::const_iterator target =
+          targetNames.find(it.first);
+      if (target != targetNames.end()) influences[target->second] = it.second;
+    }
+    sink = influences[0];
+  });
+
+  TripleBuffer<BlendshapeBinding> bindings;
+  BindBlendshapes(keys, targetNames, targetCount, &bindings.BeginWrite());
+  bindings.Publish();
+  const double after = NanosPerFrame(frames, [&](int) {
+    bindings.Acquire();
+    ApplyBlendshapes(latest.weights, bindings.Latest(), influences.data(),
+                     targetCount);
+    sink = influences[0];
+  });
+
+  printf("blendshapes per frame: before %.1f ns, after %.1f ns\n", before,
+         after);
+  return 0;
+}
@@ -0,0 +1,49 @@
+//
+// BindBlendshapes()/ApplyBlendshapes() from examples/glview.
+//
+#include <map>
+#include <string>
+#include <vector>
+
+#include "blendshape_binding.h"
+#include "test_util.h"
+
+int main() {
+  // Four targets, of which only three are named; the last one is named.
+  std::map<std::string, int> targetNames;
+  targetNames["jawOpen"] = 0;
+  targetNames["eyeBlinkLeft"] = 2;
+  targetNames["mouthSmileLeft"] = 3;
+  targetNames["beyondTargets"] = 4;
+  const size_t targetCount = 4;
+
+  std::vector<std::string> keys;
+  keys.push_back("mouthSmileLeft");
+  keys.push_back("unknown");
+  keys.push_back("jawOpen");
+  keys.push_back("beyondTargets");
+  keys.push_back("eyeBlinkLeft");
+
+  BlendshapeBinding binding;
+  BindBlendshapes(keys, targetNames, targetCount, &binding);
+  CHECK(binding.count == 5);
+  CHECK(binding.slots[0] == 3);  // the last target is bound, not dropped
+  CHECK(binding.slots[1] == 4);  // scratch
+  CHECK(binding.slots[2] == 0);
+  CHECK(binding.slots[3] == 4);  // named, but no such target
+  CHECK(binding.slots[4] == 2);
+
+  const float weights[5] = {0.5f, 0.9f, 0.25f, 0.8f, 1.0f};
+  std::vector<float> influences(targetCount + 1, 7.0f);
+  ApplyBlendshapes(weights, binding, influences.data(), targetCount);
+  CHECK(influences[0] == 0.25f);
+  CHECK(influences[1] == 0.0f);
+  CHECK(influences[2] == 1.0f);
+  CHECK(influences[3] == 0.5f);
+
+  // More keys than a result holds.
+  std::vector<std::string> many(60, "jawOpen");
+  BindBlendshapes(many, targetNames, targetCount, &binding);
+  CHECK(binding.count == 52);
+  return TestResult();
+}
@@ -0,0 +1,158 @@
+//
+// Generated KHR_draco_mesh_compression assets for the Draco test and
+// benchmark. Needs the Draco encoder, so it is only built with
+// TINYGLTF_ENABLE_DRACO.
+//
+#ifndef TINYGLTF_DRACO_ASSET_H_
+#define TINYGLTF_DRACO_ASSET_H_
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "draco/compression/encode.h"
+#include "draco/mesh/triangle_soup_mesh_builder.h"
+#include "tiny_gltf.h"
+
+// Corner `k` of triangle `face` of a `grid` x `grid` height field, offset by
+// `primitive`: position in `pos`, texcoord in `uv`.
+inline void DracoGridCorner(int primitive, int grid, int face, int k,
+                            float pos[3], float uv[2]) {
+  static const int kQuadCorners[2][3][2] = {{{0, 0}, {1, 0}, {1, 1}},
+                                            {{0, 0}, {1, 1}, {0, 1}}};
+  const int quad = face / 2;
+  const int x = quad % grid + kQuadCorners[face % 2][k][0];
+  const int y = quad / grid + kQuadCorners[face % 2][k][1];
+  uv[0] = float(x) / float(grid);
+  uv[1] = float(y) / float(grid);
+  pos[0] = uv[0] + float(primitive);
+  pos[1] = uv[1];
+  pos[2] = 0.25f * std::sin(float(x + primitive) * 0.7f) *
+           std::cos(float(y) * 0.3f);
+}
+
+// Appends one Draco-compressed grid primitive to `model`: its bufferView in
+// buffer 0, and indices, POSITION and TEXCOORD_0 accessors without
+// bufferViews. Odd primitives get uint32_t indices, even ones uint16_t.
+inline bool AddDracoPrimitive(tinygltf::Model *model, int primitive, int grid,
+                              tinygltf::Mesh *mesh) {
+  const int faces = 2 * grid * grid;
+  draco::TriangleSoupMeshBuilder builder;
+  builder.Start(faces);
+  const int pos_att = builder.AddAttribute(draco::GeometryAttribute::POSITION,
+                                           3, draco::DT_FLOAT32);
+  const int uv_att = builder.AddAttribute(
+      draco::GeometryAttribute::TEX_COORD, 2, draco::DT_FLOAT32);
+  for (int f = 0; f < faces; f++) {
+    float pos[3][3];
+    float uv[3][2];
+    for (int k = 0; k < 3; k++) {
+      DracoGridCorner(primitive, grid, f, k, pos[k], uv[k]);
+    }
+    builder.SetAttributeValuesForFace(pos_att, draco::FaceIndex(f), pos[0],
+                                      pos[1], pos[2]);
+    builder.SetAttributeValuesForFace(uv_att, draco::FaceIndex(f), uv[0],
+                                      uv[1], uv[2]);
+  }
+  std::unique_ptr<draco::Mesh> draco_mesh = builder.Finalize();
+  if (!draco_mesh) return false;
+
+  // Sequential encoding keeps the face order, so the test can compare
+  // against the source triangles.
+  draco::Encoder encoder;
+  encoder.SetEncodingMethod(draco::MESH_SEQUENTIAL_ENCODING);
+  encoder.SetAttributeQuantization(draco::GeometryAttribute::POSITION, 16);
+  encoder.SetAttributeQuantization(draco::GeometryAttribute::TEX_COORD, 14);
+  draco::EncoderBuffer encoded;
+  if (!encoder.EncodeMeshToBuffer(*draco_mesh, &encoded).ok()) return false;
+
+  std::vector<unsigned char> &data = model->buffers[0].data;
+  tinygltf::BufferView view;
+  view.buffer = 0;
+  view.byteOffset = data.size();
+  view.byteLength = encoded.size();
+  data.insert(data.end(), encoded.data(), encoded.data() + encoded.size());
+  data.resize((data.size() + 3) & ~size_t(3));
+  model->bufferViews.push_back(view);
+
+  const size_t points = size_t(draco_mesh->num_points());
+  tinygltf::Accessor indices;
+  indices.componentType = (primitive % 2)
+                              ? TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT
+                              : TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+  indices.type = TINYGLTF_TYPE_SCALAR;
+  indices.count = size_t(faces) * 3;
+  tinygltf::Accessor position;
+  position.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+  position.type = TINYGLTF_TYPE_VEC3;
+  position.count = points;
+  position.minValues = {double(primitive), 0.0, -0.25};
+  position.maxValues = {double(primitive) + 1.0, 1.0, 0.25};
+  tinygltf::Accessor texcoord;
+  texcoord.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+  texcoord.type = TINYGLTF_TYPE_VEC2;
+  texcoord.count = points;
+
+  tinygltf::Primitive prim;
+  prim.mode = TINYGLTF_MODE_TRIANGLES;
+  prim.indices = int(model->accessors.size());
+  model->accessors.push_back(indices);
+  prim.attributes["POSITION"] = int(model->accessors.size());
+  model->accessors.push_back(position);
+  prim.attributes["TEXCOORD_0"] = int(model->accessors.size());
+  model->accessors.push_back(texcoord);
+
+  tinygltf::Value::Object attributes;
+  attributes["POSITION"] = tinygltf::Value(
+      int(draco_mesh->attribute(pos_att)->unique_id()));
+  attributes["TEXCOORD_0"] = tinygltf::Value(
+      int(draco_mesh->attribute(uv_att)->unique_id()));
+  tinygltf::Value::Object extension;
+  extension["bufferView"] = tinygltf::Value(int(model->bufferViews.size() - 1));
+  extension["attributes"] = tinygltf::Value(attributes);
+  prim.extensions["KHR_draco_mesh_compression"] = tinygltf::Value(extension);
+  mesh->primitives.push_back(prim);
+  return true;
+}
+
+// A GLB with `meshes` meshes of `primitives_per_mesh` Draco grid primitives
+// each. Primitive `i` overall is offset by `i` along x.
+inline bool MakeDracoGlb(int meshes, int primitives_per_mesh, int grid,
+                         std::vector<unsigned char> *glb) {
+  tinygltf::Model model;
+  model.asset.version = "2.0";
+  model.extensionsUsed.push_back("KHR_draco_mesh_compression");
+  model.extensionsRequired.push_back("KHR_draco_mesh_compression");
+  model.buffers.resize(1);
+  tinygltf::Scene scene;
+  for (int m = 0; m < meshes; m++) {
+    tinygltf::Mesh mesh;
+    for (int p = 0; p < primitives_per_mesh; p++) {
+      if (!AddDracoPrimitive(&model, m * primitives_per_mesh + p, grid,
+                             &mesh)) {
+        return false;
+      }
+    }
+    model.meshes.push_back(mesh);
+    tinygltf::Node node;
+    node.mesh = m;
+    scene.nodes.push_back(int(model.nodes.size()));
+    model.nodes.push_back(node);
+  }
+  model.scenes.push_back(scene);
+  model.defaultScene = 0;
+
+  tinygltf::TinyGLTF writer;
+  std::stringstream stream;
+  if (!writer.WriteGltfSceneToStream(&model, stream, false, true)) {
+    return false;
+  }
+  const std::string bytes = stream.str();
+  glb->assign(bytes.begin(), bytes.end());
+  return true;
+}
+
+#endif  // TINYGLTF_DRACO_ASSET_H_
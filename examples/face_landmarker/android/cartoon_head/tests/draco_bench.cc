@@ -0,0 +1,58 @@
+//
+// Load time of a GLB with many KHR_draco_mesh_compression primitives
+// (LoadBinaryFromMemory) with Draco decoding on 1 thread against several
+// (TinyGLTF::SetDracoDecodingThreads).
+//
+// Usage: draco_bench [primitives] [grid] [runs]
+//
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "draco_asset.h"
+
+int main(int argc, char **argv) {
+  const int primitives = argc > 1 ? atoi(argv[1]) : 64;
+  const int grid = argc > 2 ? atoi(argv[2]) : 64;
+  const int runs = argc > 3 ? atoi(argv[3]) : 5;
+
+  std::vector<unsigned char> glb;
+  if (!MakeDracoGlb(primitives, 1, grid, &glb)) {
+    fprintf(stderr, "failed to encode the asset\n");
+    return EXIT_FAILURE;
+  }
+  printf("%d primitives of %d triangles, %.1f MB GLB, %u hardware threads\n",
+         primitives, 2 * grid * grid, double(glb.size()) / (1024.0 * 1024.0),
+         std::thread::hardware_concurrency());
+
+  const int thread_counts[] = {1, 2, 4, 8};
+  double serial_ms = 0.0;
+  printf("%8s %10s %8s\n", "threads", "best ms", "speedup");
+  for (int threads : thread_counts) {
+    double best = 1e30;
+    for (int r = 0; r < runs; r++) {
+      tinygltf::TinyGLTF loader;
+      loader.SetDracoDecodingThreads(threads);
+      tinygltf::Model model;
+      std::string err;
+      std::string warn;
+      const std::chrono::steady_clock::time_point start =
+          std::chrono::steady_clock::now();
+      if (!loader.LoadBinaryFromMemory(&model, &err, &warn, glb.data(),
+                                       static_cast<unsigned int>(glb.size()))) {
+        fprintf(stderr, "load failed: %s\n", err.c_str());
+        return EXIT_FAILURE;
+      }
+      const std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+      best = std::min(best, elapsed.count());
+    }
+    if (threads == 1) serial_ms = best;
+    printf("%8d %10.1f %7.2fx\n", threads, best, serial_ms / best);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+//
+// KHR_draco_mesh_compression decoding(TinyGLTF::SetDracoDecodingThreads):
+// a multi-mesh, multi-primitive asset decodes to the same Model on 1 and on
+// several threads, and matches the triangles it was encoded from.
+//
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "draco_asset.h"
+#include "test_util.h"
+
+namespace {
+
+const int kMeshes = 6;
+const int kPrimitivesPerMesh = 3;
+const int kGrid = 24;
+
+bool Load(const std::vector<unsigned char> &glb, int threads,
+          tinygltf::Model *model) {
+  tinygltf::TinyGLTF loader;
+  loader.SetDracoDecodingThreads(threads);
+  std::string err;
+  std::string warn;
+  const bool ok = loader.LoadBinaryFromMemory(
+      model, &err, &warn, glb.data(), static_cast<unsigned int>(glb.size()));
+  CHECK(err.empty());
+  CHECK(warn.empty());
+  return ok;
+}
+
+// Every primitive's triangles, read through its accessors, against the
+// source grid. Positions are quantized to 16 bits over a range of at most
+// kMeshes * kPrimitivesPerMesh.
+void CheckGeometry(const tinygltf::Model &model) {
+  CHECK(model.meshes.size() == size_t(kMeshes));
+  const float tolerance =
+      float(kMeshes * kPrimitivesPerMesh + 1) / float(1 << 15);
+  int bad_corners = 0;
+  for (size_t m = 0; m < model.meshes.size(); m++) {
+    CHECK(model.meshes[m].primitives.size() == size_t(kPrimitivesPerMesh));
+    for (size_t p = 0; p < model.meshes[m].primitives.size(); p++) {
+      const tinygltf::Primitive &prim = model.meshes[m].primitives[p];
+      std::vector<uint32_t> indices;
+      std::vector<float> positions;
+      std::vector<float> texcoords;
+      CHECK(tinygltf::ReadAccessor(model, model.accessors[prim.indices],
+                                   &indices));
+      CHECK(tinygltf::ReadAccessor(
+          model, model.accessors[prim.attributes.at("POSITION")], &positions));
+      CHECK(tinygltf::ReadAccessor(
+          model, model.accessors[prim.attributes.at("TEXCOORD_0")],
+          &texcoords));
+      const int primitive = int(m) * kPrimitivesPerMesh + int(p);
+      const size_t faces = size_t(2 * kGrid * kGrid);
+      CHECK(indices.size() == faces * 3);
+      if (indices.size() != faces * 3) continue;
+      for (size_t f = 0; f < faces; f++) {
+        for (int k = 0; k < 3; k++) {
+          const uint32_t index = indices[f * 3 + size_t(k)];
+          float pos[3];
+          float uv[2];
+          DracoGridCorner(primitive, kGrid, int(f), k, pos, uv);
+          if (size_t(index) * 3 + 2 >= positions.size() ||
+              size_t(index) * 2 + 1 >= texcoords.size() ||
+              std::fabs(positions[index * 3] - pos[0]) > tolerance ||
+              std::fabs(positions[index * 3 + 1] - pos[1]) > tolerance ||
+              std::fabs(positions[index * 3 + 2] - pos[2]) > tolerance ||
+              std::fabs(texcoords[index * 2] - uv[0]) > 1e-3f ||
+              std::fabs(texcoords[index * 2 + 1] - uv[1]) > 1e-3f) {
+            bad_corners++;
+          }
+        }
+      }
+    }
+  }
+  CHECK(bad_corners == 0);
+}
+
+}  // namespace
+
+int main() {
+  std::vector<unsigned char> glb;
+  CHECK(MakeDracoGlb(kMeshes, kPrimitivesPerMesh, kGrid, &glb));
+
+  tinygltf::Model serial;
+  CHECK(Load(glb, 1, &serial));
+  CheckGeometry(serial);
+
+  // Decoding and filling the output regions in parallel gives the same
+  // buffers, bufferViews and accessors, whatever order tasks finish in.
+  const int thread_counts[] = {2, 3, 8};
+  for (int threads : thread_counts) {
+    for (int run = 0; run < 5; run++) {
+      tinygltf::Model parallel;
+      CHECK(Load(glb, threads, &parallel));
+      CHECK(parallel == serial);
+    }
+  }
+  return TestResult();
+}
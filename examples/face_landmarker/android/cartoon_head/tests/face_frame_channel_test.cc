@@ -0,0 +1,99 @@
+//
+// FaceFrameChannel from examples/glview: a producer at 120 Hz and a consumer
+// at 60 Hz, then both unpaced. Every frame the consumer sees comes from one
+// Publish() as a whole, and frames never go back in time.
+//
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "face_frame_channel.h"
+#include "test_util.h"
+
+namespace {
+
+// Every field is derived from the frame's sequence number `n`.
+void FillFrame(FaceFrame *frame, int n, int64_t period_ns) {
+  for (int i = 0; i < 52; i++) frame->weights[i] = float(n + i);
+  for (int r = 0; r < 4; r++) {
+    for (int c = 0; c < 4; c++) frame->matrix[r][c] = float(n - r * 4 - c);
+  }
+  frame->timestampNs = int64_t(n) * period_ns;
+}
+
+bool IsConsistent(const FaceFrame &frame, int64_t period_ns) {
+  const int n = int(frame.weights[0]);
+  for (int i = 0; i < 52; i++) {
+    if (frame.weights[i] != float(n + i)) return false;
+  }
+  for (int r = 0; r < 4; r++) {
+    for (int c = 0; c < 4; c++) {
+      if (frame.matrix[r][c] != float(n - r * 4 - c)) return false;
+    }
+  }
+  return frame.timestampNs == int64_t(n) * period_ns;
+}
+
+// Publishes frames 1..`frames`, `producer_hz` times a second(0 = unpaced),
+// while this thread consumes at `consumer_hz`. Returns the frames consumed.
+int Run(int frames, int producer_hz, int consumer_hz) {
+  typedef std::chrono::steady_clock Clock;
+  const int64_t period_ns = 1000;  // timestamps only need to be ordered
+  FaceFrameChannel channel;
+  CHECK(!channel.Acquire());  // nothing published yet
+
+  std::atomic<bool> done{false};
+  std::thread producer([&]() {
+    const Clock::time_point start = Clock::now();
+    for (int n = 1; n <= frames; n++) {
+      if (producer_hz > 0) {
+        std::this_thread::sleep_until(
+            start + std::chrono::microseconds(1000000 * n / producer_hz));
+      }
+      FillFrame(&channel.BeginWrite(), n, period_ns);
+      channel.Publish();
+    }
+    done = true;
+  });
+
+  const Clock::time_point start = Clock::now();
+  int consumed = 0;
+  int64_t last_timestamp = 0;
+  for (int tick = 1;; tick++) {
+    const bool finished = done;
+    if (channel.Acquire()) {
+      const FaceFrame &frame = channel.Latest();
+      CHECK(IsConsistent(frame, period_ns));
+      CHECK(frame.timestampNs > last_timestamp);
+      last_timestamp = frame.timestampNs;
+      consumed++;
+    }
+    // Latest() stays the same until the next Acquire().
+    CHECK(last_timestamp == 0 ||
+          channel.Latest().timestampNs == last_timestamp);
+    if (finished) break;
+    if (consumer_hz > 0) {
+      std::this_thread::sleep_until(
+          start + std::chrono::microseconds(1000000 * tick / consumer_hz));
+    }
+  }
+  producer.join();
+  // The last frame published is the one left for the consumer.
+  CHECK(last_timestamp == int64_t(frames) * period_ns);
+  CHECK(!channel.Acquire());
+  return consumed;
+}
+
+}  // namespace
+
+int main() {
+  // Half a second of camera frames: the consumer skips about every other
+  // one, and never sees more than were published.
+  const int paced = Run(60, 120, 60);
+  CHECK(paced >= 1 && paced <= 60);
+
+  // No pacing, to give the two threads as many interleavings as possible.
+  const int unpaced = Run(200000, 0, 0);
+  CHECK(unpaced >= 1 && unpaced <= 200000);
+  return TestResult();
+}
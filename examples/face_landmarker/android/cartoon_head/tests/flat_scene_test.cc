@@ -0,0 +1,421 @@
+//
+// tinygltf::FlatScene: flattening order and parents, nodes built from a
+// matrix or from translation/rotation/scale, and world matrices after
+// Update() against a recursive double precision reference, including that
+// changing one subtree leaves the rest of the scene untouched.
+//
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "tiny_gltf.h"
+#include "test_util.h"
+
+namespace {
+
+uint32_t Random(uint32_t *state) {
+  (*state) = (*state) * 1664525u + 1013904223u;
+  return (*state) >> 8;
+}
+
+// In [lo, hi).
+float RandomFloat(uint32_t *state, float lo, float hi) {
+  return lo + (hi - lo) * float(Random(state) & 0xffff) / 65536.0f;
+}
+
+// Column-major 4x4.
+struct Mat4 {
+  double m[16];
+};
+
+Mat4 Multiply(const Mat4 &a, const Mat4 &b) {
+  Mat4 r;
+  for (int c = 0; c < 4; c++) {
+    for (int row = 0; row < 4; row++) {
+      double sum = 0.0;
+      for (int k = 0; k < 4; k++) sum += a.m[k * 4 + row] * b.m[c * 4 + k];
+      r.m[c * 4 + row] = sum;
+    }
+  }
+  return r;
+}
+
+// T * R * S of `node`, or its matrix; the identity for what is unset.
+Mat4 LocalMatrix(const tinygltf::Node &node) {
+  Mat4 r = {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+  if (node.matrix.size() == 16) {
+    for (int k = 0; k < 16; k++) r.m[k] = node.matrix[size_t(k)];
+    return r;
+  }
+  double x = 0, y = 0, z = 0, w = 1;
+  if (node.rotation.size() == 4) {
+    x = node.rotation[0];
+    y = node.rotation[1];
+    z = node.rotation[2];
+    w = node.rotation[3];
+  }
+  const double s[3] = {node.scale.size() == 3 ? node.scale[0] : 1.0,
+                       node.scale.size() == 3 ? node.scale[1] : 1.0,
+                       node.scale.size() == 3 ? node.scale[2] : 1.0};
+  const double rot[9] = {1 - 2 * (y * y + z * z), 2 * (x * y + w * z),
+                         2 * (x * z - w * y),     2 * (x * y - w * z),
+                         1 - 2 * (x * x + z * z), 2 * (y * z + w * x),
+                         2 * (x * z + w * y),     2 * (y * z - w * x),
+                         1 - 2 * (x * x + y * y)};
+  for (int c = 0; c < 3; c++) {
+    for (int row = 0; row < 3; row++) {
+      r.m[c * 4 + row] = rot[c * 3 + row] * s[c];
+    }
+  }
+  if (node.translation.size() == 3) {
+    for (int k = 0; k < 3; k++) r.m[12 + k] = node.translation[size_t(k)];
+  }
+  return r;
+}
+
+// World matrices of `node` and its descendants, by recursion.
+void ReferenceWorld(const tinygltf::Model &model, int node,
+                    const Mat4 &parent, std::vector<Mat4> *world) {
+  (*world)[size_t(node)] =
+      Multiply(parent, LocalMatrix(model.nodes[size_t(node)]));
+  for (int child : model.nodes[size_t(node)].children) {
+    ReferenceWorld(model, child, (*world)[size_t(node)], world);
+  }
+}
+
+// Every node of the scene against the reference.
+bool MatchesReference(const tinygltf::Model &model,
+                      const tinygltf::FlatScene &scene) {
+  const Mat4 identity = {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+  std::vector<Mat4> world(model.nodes.size());
+  for (int root : model.scenes[0].nodes) {
+    ReferenceWorld(model, root, identity, &world);
+  }
+  for (size_t i = 0; i < scene.NodeCount(); i++) {
+    const float *m = scene.WorldMatrix(i);
+    const Mat4 &ref = world[size_t(scene.ModelNode(i))];
+    for (int k = 0; k < 16; k++) {
+      if (std::fabs(double(m[k]) - ref.m[k]) >
+          1e-4 * (1.0 + std::fabs(ref.m[k]))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void Descendants(const tinygltf::Model &model, int node,
+                 std::vector<bool> *in_subtree) {
+  (*in_subtree)[size_t(node)] = true;
+  for (int child : model.nodes[size_t(node)].children) {
+    Descendants(model, child, in_subtree);
+  }
+}
+
+std::vector<double> RandomRotation(uint32_t *seed) {
+  std::vector<double> q(4);
+  double len = 0.0;
+  for (size_t k = 0; k < 4; k++) {
+    q[k] = RandomFloat(seed, -1.0f, 1.0f);
+    len += q[k] * q[k];
+  }
+  len = std::sqrt(len) + 1e-6;
+  for (size_t k = 0; k < 4; k++) q[k] = double(float(q[k] / len));
+  return q;
+}
+
+std::vector<double> RandomVec3(uint32_t *seed, float lo, float hi) {
+  return {RandomFloat(seed, lo, hi), RandomFloat(seed, lo, hi),
+          RandomFloat(seed, lo, hi)};
+}
+
+// An affine matrix with some shear, which TRS cannot express.
+std::vector<double> RandomMatrix(uint32_t *seed) {
+  std::vector<double> m(16, 0.0);
+  for (int c = 0; c < 3; c++) {
+    for (int row = 0; row < 3; row++) {
+      m[size_t(c * 4 + row)] =
+          (c == row ? 1.0 : 0.0) + RandomFloat(seed, -0.2f, 0.2f);
+    }
+  }
+  for (int k = 0; k < 3; k++) m[size_t(12 + k)] = RandomFloat(seed, -1, 1);
+  m[15] = 1.0;
+  return m;
+}
+
+// `count` nodes in one scene with two roots, each node the child of an
+// earlier one, and model indices shuffled against the flattened order. A
+// quarter of the nodes use a matrix and some have no transform at all.
+tinygltf::Model RandomModel(size_t count, uint32_t seed) {
+  std::vector<int> ids(count);
+  for (size_t i = 0; i < count; i++) ids[i] = int(i);
+  for (size_t i = count; i > 1; i--) {
+    std::swap(ids[i - 1], ids[Random(&seed) % i]);
+  }
+  tinygltf::Model model;
+  model.nodes.resize(count);
+  model.scenes.resize(1);
+  for (size_t i = 0; i < count; i++) {
+    tinygltf::Node &node = model.nodes[size_t(ids[i])];
+    switch (Random(&seed) % 4) {
+      case 0:
+        node.matrix = RandomMatrix(&seed);
+        break;
+      case 1:
+        break;
+      default:
+        node.translation = RandomVec3(&seed, -1.0f, 1.0f);
+        node.rotation = RandomRotation(&seed);
+        if (Random(&seed) % 2) node.scale = RandomVec3(&seed, 0.8f, 1.25f);
+        break;
+    }
+    if (i < 2) {
+      model.scenes[0].nodes.push_back(ids[i]);
+    } else {
+      model.nodes[size_t(ids[Random(&seed) % i])].children.push_back(ids[i]);
+    }
+  }
+  return model;
+}
+
+// Depth first from the scene roots, in the order children are listed.
+void TestBuildOrder() {
+  tinygltf::Model model;
+  model.nodes.resize(6);
+  model.nodes[0].children = {1, 2};
+  model.nodes[1].children = {4};
+  model.scenes.resize(1);
+  model.scenes[0].nodes = {0, 3};  // node 5 is not in the scene
+
+  tinygltf::FlatScene scene;
+  std::string err;
+  CHECK(scene.Build(model, 0, &err));
+  CHECK(err.empty());
+  const int expected_nodes[] = {0, 1, 4, 2, 3};
+  const int expected_parents[] = {-1, 0, 1, 0, -1};
+  CHECK(scene.NodeCount() == 5);
+  for (size_t i = 0; i < scene.NodeCount() && i < 5; i++) {
+    CHECK(scene.ModelNode(i) == expected_nodes[i]);
+    CHECK(scene.Parent(i) == expected_parents[i]);
+    CHECK(scene.Find(expected_nodes[i]) == int(i));
+  }
+  CHECK(scene.Find(5) == -1);
+  CHECK(scene.Find(-1) == -1);
+  CHECK(scene.Find(6) == -1);
+}
+
+void TestBuildErrors() {
+  tinygltf::Model model;
+  model.nodes.resize(3);
+  model.scenes.resize(1);
+  model.scenes[0].nodes = {0};
+  tinygltf::FlatScene scene;
+  std::string err;
+
+  CHECK(!scene.Build(model, 1, &err));
+  CHECK(!err.empty());
+
+  // Reachable twice.
+  model.nodes[0].children = {1, 2};
+  model.nodes[1].children = {2};
+  err.clear();
+  CHECK(!scene.Build(model, 0, &err));
+  CHECK(!err.empty());
+  CHECK(scene.NodeCount() == 0);
+
+  // A cycle.
+  model.nodes[1].children = {0};
+  model.nodes[0].children = {1};
+  err.clear();
+  CHECK(!scene.Build(model, 0, &err));
+
+  // Out of range.
+  model.nodes[0].children = {3};
+  model.nodes[1].children.clear();
+  err.clear();
+  CHECK(!scene.Build(model, 0, &err));
+  CHECK(scene.NodeCount() == 0);
+
+  // A failed Build leaves nothing behind for the next one.
+  model.nodes[0].children = {1, 2};
+  CHECK(scene.Build(model, 0));
+  CHECK(scene.NodeCount() == 3);
+}
+
+// A matrix root with a TRS child and a child without a transform; a
+// matrix node switching to TRS starts from the identity.
+void TestMatrixAndTRS() {
+  tinygltf::Model model;
+  model.nodes.resize(3);
+  model.scenes.resize(1);
+  model.scenes[0].nodes = {0};
+  model.nodes[0].matrix = {1.0, 0.2, 0.0, 0.0, 0.0, 2.0, 0.0, 0.0,
+                           0.0, 0.0, 0.5, 0.0, 3.0, -1.0, 4.0, 1.0};
+  model.nodes[0].children = {1, 2};
+  model.nodes[1].translation = {1.0, 2.0, 3.0};
+  model.nodes[1].rotation = {0.0, 0.0, std::sqrt(0.5), std::sqrt(0.5)};
+  model.nodes[1].scale = {2.0, 1.0, 0.5};
+
+  tinygltf::FlatScene scene;
+  CHECK(scene.Build(model, 0));
+  CHECK(MatchesReference(model, scene));
+
+  // The world of node 2 is the matrix of node 0.
+  for (int k = 0; k < 16; k++) {
+    CHECK(scene.WorldMatrix(2)[k] == float(model.nodes[0].matrix[size_t(k)]));
+  }
+
+  scene.SetTranslation(0, 5.0f, 6.0f, 7.0f);
+  scene.Update();
+  model.nodes[0].matrix.clear();
+  model.nodes[0].translation = {5.0, 6.0, 7.0};
+  CHECK(MatchesReference(model, scene));
+
+  const float m[16] = {0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 1, 1, 1, 1};
+  scene.SetMatrix(1, m);
+  scene.Update();
+  model.nodes[1].matrix.assign(m, m + 16);
+  CHECK(MatchesReference(model, scene));
+}
+
+// Changes take effect on Update(), recompute the changed node's subtree and
+// leave every other world matrix as it was.
+void TestDirtySubtree() {
+  tinygltf::Model model = RandomModel(60, 11);
+  tinygltf::FlatScene scene;
+  CHECK(scene.Build(model, 0));
+  CHECK(MatchesReference(model, scene));
+  const size_t n = scene.NodeCount();
+  CHECK(n == 60);
+
+  uint32_t seed = 5;
+  for (int round = 0; round < 20; round++) {
+    std::vector<float> before(n * 16);
+    for (size_t i = 0; i < n; i++) {
+      memcpy(&before[i * 16], scene.WorldMatrix(i), 16 * sizeof(float));
+    }
+    // A node with a parent, so it has an untouched part of the scene
+    // around it.
+    const size_t i = 1 + Random(&seed) % (n - 1);
+    const int node = scene.ModelNode(i);
+    tinygltf::Node &model_node = model.nodes[size_t(node)];
+    if (round % 2) {
+      const std::vector<double> m = RandomMatrix(&seed);
+      float mf[16];
+      for (int k = 0; k < 16; k++) mf[k] = float(m[size_t(k)]);
+      scene.SetMatrix(i, mf);
+      model_node.matrix = m;
+    } else {
+      const std::vector<double> t = RandomVec3(&seed, -1.0f, 1.0f);
+      scene.SetTranslation(i, float(t[0]), float(t[1]), float(t[2]));
+      if (!model_node.matrix.empty()) {
+        // Leaving the matrix starts from the identity.
+        model_node.matrix.clear();
+        model_node.rotation.clear();
+        model_node.scale.clear();
+      }
+      model_node.translation = t;
+    }
+
+    // Nothing moves before Update().
+    bool unchanged = true;
+    for (size_t j = 0; j < n; j++) {
+      unchanged &=
+          memcmp(&before[j * 16], scene.WorldMatrix(j), 16 * sizeof(float)) ==
+          0;
+    }
+    CHECK(unchanged);
+
+    scene.Update();
+    CHECK(MatchesReference(model, scene));
+    std::vector<bool> in_subtree(model.nodes.size(), false);
+    Descendants(model, node, &in_subtree);
+    bool outside_unchanged = true;
+    for (size_t j = 0; j < n; j++) {
+      if (in_subtree[size_t(scene.ModelNode(j))]) continue;
+      outside_unchanged &=
+          memcmp(&before[j * 16], scene.WorldMatrix(j), 16 * sizeof(float)) ==
+          0;
+    }
+    CHECK(outside_unchanged);
+    CHECK(memcmp(&before[i * 16], scene.WorldMatrix(i), 16 * sizeof(float)) !=
+          0);
+  }
+
+  // Update() without changes keeps everything.
+  std::vector<float> before(n * 16);
+  for (size_t i = 0; i < n; i++) {
+    memcpy(&before[i * 16], scene.WorldMatrix(i), 16 * sizeof(float));
+  }
+  scene.Update();
+  bool unchanged = true;
+  for (size_t i = 0; i < n; i++) {
+    unchanged &=
+        memcmp(&before[i * 16], scene.WorldMatrix(i), 16 * sizeof(float)) == 0;
+  }
+  CHECK(unchanged);
+}
+
+// Several changes per Update(), across blocks of 4 nodes and in any order,
+// against the reference after each Update().
+void TestRandomEdits() {
+  tinygltf::Model model = RandomModel(203, 3);
+  tinygltf::FlatScene scene;
+  CHECK(scene.Build(model, 0));
+  CHECK(MatchesReference(model, scene));
+
+  uint32_t seed = 9;
+  int mismatches = 0;
+  for (int round = 0; round < 100; round++) {
+    const int edits = 1 + int(Random(&seed) % 8);
+    for (int e = 0; e < edits; e++) {
+      const size_t i = Random(&seed) % scene.NodeCount();
+      tinygltf::Node &node = model.nodes[size_t(scene.ModelNode(i))];
+      const uint32_t what = Random(&seed) % 4;
+      if (what == 3) {
+        const std::vector<double> m = RandomMatrix(&seed);
+        float mf[16];
+        for (int k = 0; k < 16; k++) mf[k] = float(m[size_t(k)]);
+        scene.SetMatrix(i, mf);
+        node.matrix = m;
+        continue;
+      }
+      if (!node.matrix.empty()) {
+        node.matrix.clear();
+        node.translation.clear();
+        node.rotation.clear();
+        node.scale.clear();
+      }
+      if (what == 0) {
+        node.translation = RandomVec3(&seed, -1.0f, 1.0f);
+        scene.SetTranslation(i, float(node.translation[0]),
+                             float(node.translation[1]),
+                             float(node.translation[2]));
+      } else if (what == 1) {
+        node.rotation = RandomRotation(&seed);
+        scene.SetRotation(i, float(node.rotation[0]), float(node.rotation[1]),
+                          float(node.rotation[2]), float(node.rotation[3]));
+      } else {
+        node.scale = RandomVec3(&seed, 0.8f, 1.25f);
+        scene.SetScale(i, float(node.scale[0]), float(node.scale[1]),
+                       float(node.scale[2]));
+      }
+    }
+    scene.Update();
+    mismatches += MatchesReference(model, scene) ? 0 : 1;
+  }
+  CHECK(mismatches == 0);
+}
+
+}  // namespace
+
+int main() {
+  TestBuildOrder();
+  TestBuildErrors();
+  TestMatrixAndTRS();
+  TestDirtySubtree();
+  TestRandomEdits();
+  return TestResult();
+}
@@ -0,0 +1,225 @@
+//
+// Frames of examples/glview, run headless against glview_stubs.cc, must not
+// allocate once the first frame has set everything up. Counts every
+// operator new, on the render thread and on the skinning workers, across
+// idle-animated and face-tracked UpdateFace() calls. The skinned face is
+// large enough to be split across gSkinPool on machines with several cores.
+//
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "tiny_gltf.h"
+#include "face_frame_channel.h"
+#include "test_util.h"
+
+// Defined by glview.h.
+extern tinygltf::Model model;
+extern std::vector<std::string> BlendShapeKeyList;
+extern FaceFrameChannel faceFrames;
+extern std::mutex blendshapeProducerMutex;
+void BindBlendshapeKeys();
+extern "C" int UpdateFace();
+
+namespace {
+
+std::atomic<bool> counting(false);
+std::atomic<int> allocations(0);
+
+void *CountedAlloc(size_t size) {
+  if (counting.load(std::memory_order_relaxed)) allocations++;
+  void *p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+}  // namespace
+
+void *operator new(size_t size) { return CountedAlloc(size); }
+void *operator new[](size_t size) { return CountedAlloc(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+
+namespace {
+
+const size_t kVertices = 2 * 16384 + 1000;  // two kSkinVerticesPerThread
+const size_t kTargets = 3;
+const int kFrames = 120;
+
+int AddAccessor(tinygltf::Model *m, const void *data, size_t bytes,
+                int componentType, int type, size_t count, int target) {
+  tinygltf::Buffer &buffer = m->buffers[0];
+  const size_t offset = buffer.data.size();
+  buffer.data.resize(offset + bytes);
+  memcpy(&buffer.data[offset], data, bytes);
+  tinygltf::BufferView view;
+  view.buffer = 0;
+  view.byteOffset = offset;
+  view.byteLength = bytes;
+  view.target = target;
+  m->bufferViews.push_back(view);
+  tinygltf::Accessor accessor;
+  accessor.bufferView = int(m->bufferViews.size() - 1);
+  accessor.componentType = componentType;
+  accessor.type = type;
+  accessor.count = count;
+  m->accessors.push_back(accessor);
+  return int(m->accessors.size() - 1);
+}
+
+int AddFloats(tinygltf::Model *m, const std::vector<float> &values, int type,
+              int target) {
+  const size_t components = size_t(tinygltf::GetNumComponentsInType(type));
+  return AddAccessor(m, values.data(), values.size() * sizeof(float),
+                     TINYGLTF_COMPONENT_TYPE_FLOAT, type,
+                     values.size() / components, target);
+}
+
+// A skinned, morphed face with a looping idle animation on its jaw joint
+// and on its blendshape weights.
+tinygltf::Model MakeFace() {
+  tinygltf::Model m;
+  m.asset.version = "2.0";
+  m.buffers.resize(1);
+
+  std::vector<float> positions(kVertices * 3);
+  std::vector<float> normals(kVertices * 3);
+  std::vector<unsigned char> joints(kVertices * 4, 0);
+  std::vector<float> weights(kVertices * 4, 0.0f);
+  for (size_t v = 0; v < kVertices; v++) {
+    positions[v * 3 + 0] = float(v % 181) * 0.01f;
+    positions[v * 3 + 1] = float(v / 181) * 0.01f;
+    normals[v * 3 + 2] = 1.0f;
+    joints[v * 4 + 1] = 1;
+    weights[v * 4 + 0] = 0.5f;
+    weights[v * 4 + 1] = 0.5f;
+  }
+  std::vector<unsigned> indices;
+  for (unsigned i = 0; i + 2 < 300; i++) {
+    indices.push_back(i);
+    indices.push_back(i + 1);
+    indices.push_back(i + 2);
+  }
+
+  tinygltf::Primitive primitive;
+  primitive.mode = TINYGLTF_MODE_TRIANGLES;
+  primitive.attributes["POSITION"] = AddFloats(
+      &m, positions, TINYGLTF_TYPE_VEC3, TINYGLTF_TARGET_ARRAY_BUFFER);
+  primitive.attributes["NORMAL"] = AddFloats(&m, normals, TINYGLTF_TYPE_VEC3,
+                                             TINYGLTF_TARGET_ARRAY_BUFFER);
+  primitive.attributes["JOINTS_0"] = AddAccessor(
+      &m, joints.data(), joints.size(), TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE,
+      TINYGLTF_TYPE_VEC4, kVertices, TINYGLTF_TARGET_ARRAY_BUFFER);
+  primitive.attributes["WEIGHTS_0"] = AddFloats(
+      &m, weights, TINYGLTF_TYPE_VEC4, TINYGLTF_TARGET_ARRAY_BUFFER);
+  primitive.indices = AddAccessor(
+      &m, indices.data(), indices.size() * sizeof(unsigned),
+      TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT, TINYGLTF_TYPE_SCALAR,
+      indices.size(), TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER);
+  const char *names[kTargets] = {"jawOpen", "eyeBlinkLeft", "mouthSmileLeft"};
+  tinygltf::Value::Array targetNames;
+  for (size_t t = 0; t < kTargets; t++) {
+    std::vector<float> deltas(kVertices * 3);
+    for (size_t i = 0; i < deltas.size(); i++) {
+      deltas[i] = 0.001f * float(int((i * 7 + t) % 21) - 10);
+    }
+    std::map<std::string, int> target;
+    target["POSITION"] = AddFloats(&m, deltas, TINYGLTF_TYPE_VEC3, 0);
+    primitive.targets.push_back(target);
+    targetNames.push_back(tinygltf::Value(std::string(names[t])));
+  }
+  tinygltf::Mesh mesh;
+  mesh.name = "face";
+  mesh.primitives.push_back(primitive);
+  tinygltf::Value::Object extras;
+  extras["targetNames"] = tinygltf::Value(targetNames);
+  mesh.extras = tinygltf::Value(extras);
+  m.meshes.push_back(mesh);
+
+  // 0: the face, 1: head joint, 2: jaw joint.
+  m.nodes.resize(3);
+  m.nodes[0].mesh = 0;
+  m.nodes[0].skin = 0;
+  m.nodes[1].children = {2};
+  m.nodes[2].translation = {0.0, -0.5, 0.0};
+  tinygltf::Skin skin;
+  skin.joints = {1, 2};
+  m.skins.push_back(skin);
+  tinygltf::Scene scene;
+  scene.nodes = {0, 1};
+  m.scenes.push_back(scene);
+  m.defaultScene = 0;
+
+  const int times =
+      AddFloats(&m, {0.0f, 1.0f}, TINYGLTF_TYPE_SCALAR, 0);
+  m.accessors[times].minValues = {0.0};
+  m.accessors[times].maxValues = {1.0};
+  tinygltf::Animation animation;
+  tinygltf::AnimationSampler rotation;
+  rotation.input = times;
+  rotation.output = AddFloats(&m, {0, 0, 0, 1, 0.38268f, 0, 0, 0.92388f},
+                              TINYGLTF_TYPE_VEC4, 0);
+  animation.samplers.push_back(rotation);
+  tinygltf::AnimationSampler morph;
+  morph.input = times;
+  morph.output =
+      AddFloats(&m, {0, 0, 0, 1, 0.5f, 0.25f}, TINYGLTF_TYPE_SCALAR, 0);
+  animation.samplers.push_back(morph);
+  tinygltf::AnimationChannel channel;
+  channel.sampler = 0;
+  channel.target_node = 2;
+  channel.target_path = "rotation";
+  animation.channels.push_back(channel);
+  channel.sampler = 1;
+  channel.target_node = 0;
+  channel.target_path = "weights";
+  animation.channels.push_back(channel);
+  m.animations.push_back(animation);
+  return m;
+}
+
+void PublishFace(int frame) {
+  FaceFrame &face = faceFrames.BeginWrite();
+  for (int i = 0; i < 52; i++) {
+    face.weights[i] = float((frame + i) % 10) * 0.1f;
+  }
+  for (int i = 0; i < 4; i++) face.matrix[i][i] = 1.0f;
+  face.timestampNs = frame + 1;
+  faceFrames.Publish();
+}
+
+}  // namespace
+
+int main() {
+  model = MakeFace();
+  {
+    std::lock_guard<std::mutex> lock(blendshapeProducerMutex);
+    BlendShapeKeyList = {"_neutral", "eyeBlinkLeft", "jawOpen",
+                         "mouthSmileLeft"};
+    BindBlendshapeKeys();
+  }
+
+  // The first frame sets up GL state, the morph and skin evaluators and
+  // the worker pool; a couple more let lazily sized state settle.
+  for (int i = 0; i < 3; i++) UpdateFace();
+
+  counting = true;
+  for (int i = 0; i < kFrames / 2; i++) UpdateFace();  // idle animation
+  for (int i = 0; i < kFrames / 2; i++) {
+    if (i % 2 == 0) PublishFace(i);  // not every frame has a new result
+    UpdateFace();
+  }
+  counting = false;
+
+  if (allocations != 0) {
+    fprintf(stderr, "%d allocations in %d frames\n", allocations.load(),
+            kFrames);
+  }
+  CHECK(allocations == 0);
+  return TestResult();
+}
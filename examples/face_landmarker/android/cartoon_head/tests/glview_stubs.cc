@@ -0,0 +1,124 @@
+//
+// No-op GLES 3, EGL and NDK entry points so examples/glview runs headless.
+// Object names are handed out from one counter, compiles and links always
+// succeed, and there are no vertex texture units, which selects the CPU
+// morph path.
+//
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+
+#include <android/asset_manager_jni.h>
+#include <android/log.h>
+#include <jni.h>
+
+namespace {
+
+GLuint next_name = 1;
+
+void GenNames(GLsizei n, GLuint *names) {
+  for (GLsizei i = 0; i < n; i++) names[i] = next_name++;
+}
+
+}  // namespace
+
+void GL_APIENTRY glActiveTexture(GLenum) {}
+void GL_APIENTRY glAttachShader(GLuint, GLuint) {}
+void GL_APIENTRY glBindBuffer(GLenum, GLuint) {}
+void GL_APIENTRY glBindTexture(GLenum, GLuint) {}
+void GL_APIENTRY glBindVertexArray(GLuint) {}
+void GL_APIENTRY glBufferData(GLenum, GLsizeiptr, const void *, GLenum) {}
+void GL_APIENTRY glBufferSubData(GLenum, GLintptr, GLsizeiptr, const void *) {
+}
+void GL_APIENTRY glClear(GLbitfield) {}
+void GL_APIENTRY glClearColor(GLfloat, GLfloat, GLfloat, GLfloat) {}
+void GL_APIENTRY glCompileShader(GLuint) {}
+GLuint GL_APIENTRY glCreateProgram(void) { return next_name++; }
+GLuint GL_APIENTRY glCreateShader(GLenum) { return next_name++; }
+void GL_APIENTRY glDeleteProgram(GLuint) {}
+void GL_APIENTRY glDeleteShader(GLuint) {}
+void GL_APIENTRY glDisableVertexAttribArray(GLuint) {}
+void GL_APIENTRY glDrawArrays(GLenum, GLint, GLsizei) {}
+void GL_APIENTRY glDrawElements(GLenum, GLsizei, GLenum, const void *) {}
+void GL_APIENTRY glEnable(GLenum) {}
+void GL_APIENTRY glEnableVertexAttribArray(GLuint) {}
+void GL_APIENTRY glFlush(void) {}
+void GL_APIENTRY glGenBuffers(GLsizei n, GLuint *buffers) {
+  GenNames(n, buffers);
+}
+void GL_APIENTRY glGenTextures(GLsizei n, GLuint *textures) {
+  GenNames(n, textures);
+}
+void GL_APIENTRY glGenVertexArrays(GLsizei n, GLuint *arrays) {
+  GenNames(n, arrays);
+}
+void GL_APIENTRY glGenerateMipmap(GLenum) {}
+GLint GL_APIENTRY glGetAttribLocation(GLuint, const GLchar *) { return 0; }
+GLenum GL_APIENTRY glGetError(void) { return GL_NO_ERROR; }
+void GL_APIENTRY glGetIntegerv(GLenum pname, GLint *data) {
+  *data = pname == GL_MAX_TEXTURE_SIZE ? 4096 : 0;
+}
+void GL_APIENTRY glGetProgramiv(GLuint, GLenum, GLint *params) {
+  *params = GL_TRUE;
+}
+void GL_APIENTRY glGetShaderInfoLog(GLuint, GLsizei, GLsizei *length,
+                                    GLchar *infoLog) {
+  *length = 0;
+  infoLog[0] = '\0';
+}
+void GL_APIENTRY glGetShaderiv(GLuint, GLenum, GLint *params) {
+  *params = GL_TRUE;
+}
+GLint GL_APIENTRY glGetUniformLocation(GLuint, const GLchar *) { return 0; }
+void GL_APIENTRY glLinkProgram(GLuint) {}
+void GL_APIENTRY glPixelStorei(GLenum, GLint) {}
+void GL_APIENTRY glShaderSource(GLuint, GLsizei, const GLchar *const *,
+                                const GLint *) {}
+void GL_APIENTRY glTexImage2D(GLenum, GLint, GLint, GLsizei, GLsizei, GLint,
+                              GLenum, GLenum, const void *) {}
+void GL_APIENTRY glTexParameterf(GLenum, GLenum, GLfloat) {}
+void GL_APIENTRY glTexStorage3D(GLenum, GLsizei, GLenum, GLsizei, GLsizei,
+                                GLsizei) {}
+void GL_APIENTRY glTexSubImage3D(GLenum, GLint, GLint, GLint, GLint, GLsizei,
+                                 GLsizei, GLsizei, GLenum, GLenum,
+                                 const void *) {}
+void GL_APIENTRY glUniform1f(GLint, GLfloat) {}
+void GL_APIENTRY glUniform1fv(GLint, GLsizei, const GLfloat *) {}
+void GL_APIENTRY glUniform1i(GLint, GLint) {}
+void GL_APIENTRY glUniform2i(GLint, GLint, GLint) {}
+void GL_APIENTRY glUniformMatrix3fv(GLint, GLsizei, GLboolean,
+                                   const GLfloat *) {}
+void GL_APIENTRY glUniformMatrix4fv(GLint, GLsizei, GLboolean,
+                                   const GLfloat *) {}
+void GL_APIENTRY glUseProgram(GLuint) {}
+void GL_APIENTRY glVertexAttribPointer(GLuint, GLint, GLenum, GLboolean,
+                                       GLsizei, const void *) {}
+void GL_APIENTRY glViewport(GLint, GLint, GLsizei, GLsizei) {}
+
+EGLContext EGLAPIENTRY eglGetCurrentContext(void) { return EGL_NO_CONTEXT; }
+EGLDisplay EGLAPIENTRY eglGetDisplay(EGLNativeDisplayType) {
+  return EGL_NO_DISPLAY;
+}
+
+// The JNI and asset entry points of glview.h are never called by the tests.
+jclass JNIEnv::GetObjectClass(jobject) { return nullptr; }
+jmethodID JNIEnv::GetMethodID(jclass, const char *, const char *) {
+  return nullptr;
+}
+jint JNIEnv::CallIntMethod(jobject, jmethodID, ...) { return 0; }
+jobject JNIEnv::CallObjectMethod(jobject, jmethodID, ...) { return nullptr; }
+const char *JNIEnv::GetStringUTFChars(jstring, void *) { return ""; }
+void JNIEnv::ReleaseStringUTFChars(jstring, const char *) {}
+void JNIEnv::DeleteLocalRef(jobject) {}
+jsize JNIEnv::GetArrayLength(jobject) { return 0; }
+void JNIEnv::GetFloatArrayRegion(jfloatArray, jsize, jsize, jfloat *) {}
+
+AAssetManager *AAssetManager_fromJava(JNIEnv *, jobject) { return nullptr; }
+AAsset *AAssetManager_open(AAssetManager *, const char *, int) {
+  return nullptr;
+}
+off_t AAsset_getLength(AAsset *) { return 0; }
+int AAsset_read(AAsset *, void *, size_t) { return 0; }
+const void *AAsset_getBuffer(AAsset *) { return nullptr; }
+void AAsset_close(AAsset *) {}
+
+int __android_log_print(int, const char *, const char *, ...) { return 0; }
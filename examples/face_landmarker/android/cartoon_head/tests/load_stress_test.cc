@@ -0,0 +1,188 @@
+//
+// Hundreds of concurrent loads through LoadFromFiles() and through the
+// single-file API on one shared TinyGLTF. Meant to run under TSan as well
+// (-DTINYGLTF_TEST_SANITIZER=thread).
+//
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tiny_gltf.h"
+#include "test_util.h"
+
+namespace {
+
+const int kThreads = 8;
+const int kLoads = 240;
+
+// A mesh and an embedded PNG, varied by `seed`.
+tinygltf::Model MakeModel(int seed) {
+  tinygltf::Model model;
+  model.asset.version = "2.0";
+
+  std::vector<float> positions(size_t(300 * seed) * 3);
+  for (size_t i = 0; i < positions.size(); i++) {
+    positions[i] = float(int(i) * seed % 97);
+  }
+  tinygltf::Buffer buffer;
+  buffer.data.resize(positions.size() * sizeof(float));
+  memcpy(buffer.data.data(), positions.data(), buffer.data.size());
+  model.buffers.push_back(buffer);
+
+  tinygltf::BufferView view;
+  view.buffer = 0;
+  view.byteLength = buffer.data.size();
+  model.bufferViews.push_back(view);
+
+  tinygltf::Accessor accessor;
+  accessor.bufferView = 0;
+  accessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+  accessor.type = TINYGLTF_TYPE_VEC3;
+  accessor.count = positions.size() / 3;
+  accessor.minValues = {0, 0, 0};
+  accessor.maxValues = {96, 96, 96};
+  model.accessors.push_back(accessor);
+
+  tinygltf::Primitive primitive;
+  primitive.attributes["POSITION"] = 0;
+  tinygltf::Mesh mesh;
+  mesh.name = "mesh" + std::to_string(seed);
+  mesh.primitives.push_back(primitive);
+  model.meshes.push_back(mesh);
+
+  tinygltf::Node node;
+  node.mesh = 0;
+  model.nodes.push_back(node);
+  tinygltf::Scene scene;
+  scene.nodes = {0};
+  model.scenes.push_back(scene);
+  model.defaultScene = 0;
+
+  tinygltf::Image image;
+  image.width = 8;
+  image.height = 8;
+  image.component = 4;
+  image.bits = 8;
+  image.pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+  image.mimeType = "image/png";
+  image.image.resize(8 * 8 * 4);
+  for (size_t i = 0; i < image.image.size(); i++) {
+    image.image[i] = static_cast<unsigned char>(int(i) * seed);
+  }
+  model.images.push_back(image);
+  tinygltf::Texture texture;
+  texture.source = 0;
+  model.textures.push_back(texture);
+  return model;
+}
+
+// Wraps the default image loader to record how many decodes overlap.
+struct ImageDecodeCounter {
+  std::atomic<int> in_flight{0};
+  std::atomic<int> max_in_flight{0};
+};
+
+bool CountingImageLoader(tinygltf::Image *image, const int image_idx,
+                         std::string *err, std::string *warn, int req_width,
+                         int req_height, const unsigned char *bytes, int size,
+                         void *user_data) {
+  ImageDecodeCounter *counter = static_cast<ImageDecodeCounter *>(user_data);
+  const int now = ++counter->in_flight;
+  int seen = counter->max_in_flight.load();
+  while (now > seen &&
+         !counter->max_in_flight.compare_exchange_weak(seen, now)) {
+  }
+  const bool ok = tinygltf::LoadImageData(image, image_idx, err, warn,
+                                          req_width, req_height, bytes, size,
+                                          nullptr);
+  counter->in_flight--;
+  return ok;
+}
+
+bool LoadOne(const tinygltf::TinyGLTF &loader, const std::string &filename,
+             tinygltf::Model *model) {
+  std::string err;
+  std::string warn;
+  if (filename.find(".glb") != std::string::npos) {
+    return loader.LoadBinaryFromFile(model, &err, &warn, filename);
+  }
+  return loader.LoadASCIIFromFile(model, &err, &warn, filename);
+}
+
+}  // namespace
+
+int main() {
+  // Alternating .gltf and .glb sources, plus one missing file.
+  std::vector<std::string> files;
+  tinygltf::TinyGLTF writer;
+  for (int k = 0; k < 4; k++) {
+    tinygltf::Model model = MakeModel(k + 1);
+    const bool binary = (k % 2) != 0;
+    const std::string filename =
+        "load_stress_" + std::to_string(k) + (binary ? ".glb" : ".gltf");
+    CHECK(writer.WriteGltfSceneToFile(&model, filename, true, true, false,
+                                      binary));
+    files.push_back(filename);
+  }
+  files.push_back("load_stress_missing.gltf");
+
+  ImageDecodeCounter counter;
+  tinygltf::TinyGLTF loader;
+  loader.SetImageLoader(CountingImageLoader, &counter);
+  // Ignored by LoadFromFiles with more than one thread.
+  loader.SetImageLoadingThreads(4);
+
+  std::vector<tinygltf::Model> expected(files.size());
+  std::vector<bool> expected_ok(files.size());
+  for (size_t k = 0; k < files.size(); k++) {
+    expected_ok[k] = LoadOne(loader, files[k], &expected[k]);
+  }
+  CHECK(std::count(expected_ok.begin(), expected_ok.end(), true) == 4);
+
+  std::vector<std::string> many;
+  for (int i = 0; i < kLoads; i++) {
+    many.push_back(files[size_t(i) % files.size()]);
+  }
+  counter.max_in_flight = 0;
+  std::vector<tinygltf::LoadResult> results;
+  CHECK(!loader.LoadFromFiles(many, kThreads, &results));  // one is missing
+  CHECK(results.size() == many.size());
+  for (size_t i = 0; i < results.size(); i++) {
+    const size_t k = i % files.size();
+    CHECK(results[i].ok == expected_ok[k]);
+    if (expected_ok[k]) {
+      CHECK(results[i].model == expected[k]);
+    } else {
+      CHECK(!results[i].err.empty());
+    }
+  }
+  // Images decode on their file's thread rather than a nested set.
+  CHECK(counter.max_in_flight <= kThreads);
+
+  // Single-file loads from several threads on the shared loader.
+  std::atomic<int> mismatches(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < kLoads / kThreads; i++) {
+        const size_t k = size_t(i + t) % 4;
+        tinygltf::Model model;
+        if (!LoadOne(loader, files[k], &model) || !(model == expected[k])) {
+          mismatches++;
+        }
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  CHECK(mismatches == 0);
+
+  for (size_t k = 0; k < 4; k++) {
+    remove(files[k].c_str());
+  }
+  return TestResult();
+}
@@ -0,0 +1,365 @@
+//
+// EXT_meshopt_compression decoding: known-answer bitstreams for the
+// ATTRIBUTES and TRIANGLES codecs and the OCTAHEDRAL, QUATERNION and
+// EXPONENTIAL filters, an ATTRIBUTES stream spanning several blocks,
+// snapshot round trips of decoded bufferViews and rejection of malformed
+// ranges.
+//
+// The known answers were derived by hand from the extension's bitstream
+// description(the filters in float arithmetic), not produced by
+// meshoptimizer's encoders.
+//
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "tiny_gltf.h"
+#include "test_util.h"
+
+namespace {
+
+std::string Base64(const std::vector<unsigned char> &bytes) {
+  static const char kChars[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  for (size_t i = 0; i < bytes.size(); i += 3) {
+    const size_t n = bytes.size() - i < 3 ? bytes.size() - i : 3;
+    unsigned v = unsigned(bytes[i]) << 16;
+    if (n > 1) v |= unsigned(bytes[i + 1]) << 8;
+    if (n > 2) v |= unsigned(bytes[i + 2]);
+    out += kChars[(v >> 18) & 63];
+    out += kChars[(v >> 12) & 63];
+    out += n > 1 ? kChars[(v >> 6) & 63] : '=';
+    out += n > 2 ? kChars[v & 63] : '=';
+  }
+  return out;
+}
+
+template <typename T>
+std::vector<unsigned char> Bytes(const std::vector<T> &values) {
+  std::vector<unsigned char> bytes(values.size() * sizeof(T));
+  if (!bytes.empty()) memcpy(bytes.data(), values.data(), bytes.size());
+  return bytes;
+}
+
+template <typename T>
+std::vector<T> As(const std::vector<unsigned char> &bytes) {
+  std::vector<T> values(bytes.size() / sizeof(T));
+  if (!values.empty()) memcpy(values.data(), bytes.data(), bytes.size());
+  return values;
+}
+
+// Encodes `indices` as an EXT_meshopt_compression "INDICES" stream.
+std::vector<unsigned char> EncodeIndexSequence(
+    const std::vector<unsigned> &indices) {
+  std::vector<unsigned char> out(1, 0xd0);
+  unsigned last = 0;
+  for (unsigned index : indices) {
+    const int delta = int(index - last);
+    last = index;
+    // Zigzag delta from baseline 0, shifted past the baseline bit.
+    unsigned v = ((unsigned(delta) << 1) ^ unsigned(delta >> 31)) << 1;
+    while (v >= 128) {
+      out.push_back(static_cast<unsigned char>((v & 127) | 128));
+      v >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(v));
+  }
+  out.insert(out.end(), 4, 0);  // tail
+  return out;
+}
+
+// Encodes `vertices` of `stride` bytes as an "ATTRIBUTES" stream that stores
+// every group of byte deltas raw, from a zero baseline vertex.
+std::vector<unsigned char> EncodeVertexBufferRaw(
+    const std::vector<unsigned char> &vertices, size_t stride) {
+  const size_t count = vertices.size() / stride;
+  const size_t block_size =
+      std::min<size_t>((8192 / stride) & ~size_t(15), 256);
+  std::vector<unsigned char> out(1, 0xa0);
+  std::vector<unsigned char> last(stride, 0);
+  for (size_t offset = 0; offset < count; offset += block_size) {
+    const size_t n = std::min(block_size, count - offset);
+    const size_t n_aligned = (n + 15) & ~size_t(15);
+    for (size_t k = 0; k < stride; k++) {
+      out.insert(out.end(), (n_aligned / 16 + 3) / 4, 0xff);  // all raw
+      for (size_t j = 0; j < n_aligned; j++) {
+        if (j >= n) {
+          out.push_back(0);
+          continue;
+        }
+        const unsigned char v = vertices[(offset + j) * stride + k];
+        const unsigned char delta = static_cast<unsigned char>(v - last[k]);
+        out.push_back(static_cast<unsigned char>((delta << 1) ^
+                                                 (delta & 0x80 ? 0xff : 0)));
+        last[k] = v;
+      }
+    }
+  }
+  // The tail ends with the baseline vertex.
+  out.insert(out.end(), std::max<size_t>(stride, 32), 0);
+  return out;
+}
+
+// A glTF whose bufferView 0 is `view_length` bytes in a fallback buffer,
+// decoded from `stream`. `ext_fields` gives the ranges, mode and filter of
+// the extension object.
+std::string MeshoptGltf(const std::vector<unsigned char> &stream,
+                        size_t view_length, const std::string &ext_fields) {
+  const std::string size = std::to_string(view_length);
+  return R"({"asset": {"version": "2.0"},
+    "extensionsUsed": ["EXT_meshopt_compression"],
+    "extensionsRequired": ["EXT_meshopt_compression"],
+    "buffers": [
+      {"byteLength": )" + std::to_string(stream.size()) +
+         R"(, "uri": "data:application/octet-stream;base64,)" +
+         Base64(stream) + R"("},
+      {"byteLength": )" + size +
+         R"(, "extensions": {"EXT_meshopt_compression": {"fallback": true}}}
+    ],
+    "bufferViews": [{"buffer": 1, "byteLength": )" + size +
+         R"(, "extensions": {"EXT_meshopt_compression": {"buffer": 0, )" +
+         ext_fields + R"(}}}]})";
+}
+
+// The fields for all of `stream` as `count` elements of `byte_stride`.
+std::string MeshoptFields(const std::vector<unsigned char> &stream,
+                          size_t count, size_t byte_stride,
+                          const std::string &mode,
+                          const std::string &filter = "NONE") {
+  return R"("byteLength": )" + std::to_string(stream.size()) +
+         R"(, "byteStride": )" + std::to_string(byte_stride) +
+         R"(, "count": )" + std::to_string(count) + R"(, "mode": ")" + mode +
+         R"(", "filter": ")" + filter + "\"";
+}
+
+bool Load(const std::string &json, tinygltf::Model *model, std::string *err) {
+  tinygltf::TinyGLTF loader;
+  std::string warn;
+  return loader.LoadASCIIFromString(model, err, &warn, json.c_str(),
+                                    static_cast<unsigned int>(json.size()),
+                                    "");
+}
+
+std::vector<unsigned char> ViewBytes(const tinygltf::Model &model) {
+  const tinygltf::BufferView &view = model.bufferViews[0];
+  const unsigned char *data =
+      model.buffers[size_t(view.buffer)].Data() + view.byteOffset;
+  return std::vector<unsigned char>(data, data + view.byteLength);
+}
+
+// Loads `stream` as `count` elements of `byte_stride` bytes and returns the
+// decoded bufferView, or nothing when loading fails.
+std::vector<unsigned char> Decode(const std::vector<unsigned char> &stream,
+                                  size_t count, size_t byte_stride,
+                                  const std::string &mode,
+                                  const std::string &filter = "NONE") {
+  tinygltf::Model model;
+  std::string err;
+  const bool ok = Load(
+      MeshoptGltf(stream, count * byte_stride,
+                  MeshoptFields(stream, count, byte_stride, mode, filter)),
+      &model, &err);
+  CHECK(ok);
+  CHECK(err.empty());
+  return ok ? ViewBytes(model) : std::vector<unsigned char>();
+}
+
+// 4 vertices of 4 bytes from the baseline {1, 0, 0, 0}: byte 0 in a 4-bit
+// group with an escape, byte 1 in a zero group, byte 2 in a 2-bit group with
+// escapes and byte 3 in a raw group.
+void TestAttributesKnownAnswer() {
+  std::vector<unsigned char> stream = {
+      0xa0,
+      // Byte 0: 10 12 11 11, deltas +9 +2 -1 0, zigzag 18 4 1 0.
+      0x02, 0xf4, 0x10, 0, 0, 0, 0, 0, 0, 0x12,
+      // Byte 1: all 0.
+      0x00,
+      // Byte 2: 5 3 4 250, deltas +5 -2 +1 -10, zigzag 10 3 2 19.
+      0x01, 0xfb, 0, 0, 0, 0x0a, 0x03, 0x13,
+      // Byte 3: 200 200 100 101, deltas -56 0 -100 +1, zigzag 111 0 199 2.
+      0x03, 0x6f, 0x00, 0xc7, 0x02, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  stream.insert(stream.end(), 28, 0);
+  const unsigned char baseline[] = {1, 0, 0, 0};
+  stream.insert(stream.end(), baseline, baseline + 4);
+
+  const std::vector<unsigned char> expected = {10, 0, 5,   200,  //
+                                               12, 0, 3,   200,  //
+                                               11, 0, 4,   100,  //
+                                               11, 0, 250, 101};
+  CHECK(Decode(stream, 4, 4, "ATTRIBUTES") == expected);
+}
+
+// Enough vertices for several blocks and the SIMD delta path, with a
+// stride that is not a multiple of 16.
+void TestAttributesBlocks() {
+  const size_t stride = 12;
+  const size_t count = 700;
+  std::vector<unsigned char> vertices(count * stride);
+  uint32_t state = 7;
+  for (size_t i = 0; i < vertices.size(); i++) {
+    state = state * 1664525u + 1013904223u;
+    vertices[i] = static_cast<unsigned char>(state >> 24);
+  }
+  CHECK(Decode(EncodeVertexBufferRaw(vertices, stride), count, stride,
+               "ATTRIBUTES") == vertices);
+}
+
+// 5 triangles, version 1: all new vertices from codeaux table entry 0, a
+// fifo edge and a new vertex, a fifo edge and a cached vertex, an escaped
+// triangle with a free index, and a fifo edge with last + 1.
+void TestTrianglesKnownAnswer() {
+  std::vector<unsigned char> stream = {
+      0xe1,
+      // Triangle codes.
+      0xf0, 0x10, 0x13, 0xff, 0x0e,
+      // Escaped triangle: codeaux 0x01(new, cached at fifo 1), then the free
+      // index 100 as zigzag 200 in two bytes.
+      0x01, 0xc8, 0x01};
+  // The codeaux table; only entry 0(three new vertices) is used.
+  stream.insert(stream.end(), 16, 0);
+
+  const std::vector<uint32_t> expected = {0,   1, 2,    //
+                                          2,   1, 3,    //
+                                          3,   1, 0,    //
+                                          100, 4, 3,    //
+                                          100, 3, 101};
+  CHECK(As<uint32_t>(Decode(stream, 15, 4, "TRIANGLES")) == expected);
+  CHECK(As<uint16_t>(Decode(stream, 15, 2, "TRIANGLES")) ==
+        std::vector<uint16_t>(expected.begin(), expected.end()));
+}
+
+// 5 vectors each, so both the 4-wide and the scalar paths run. The last
+// component passes through, except for the quaternion filter.
+void TestFiltersKnownAnswer() {
+  const std::vector<int8_t> oct8 = {0,    0,  127, 9,   //
+                                    127,  0,  127, -3,  //
+                                    -100, 50, 127, 0,   // folded, z < 0
+                                    5,    5,  127, 1,   //
+                                    100, -20, 127, 2};
+  const std::vector<int8_t> oct8_expected = {0,    0,   127, 9,   //
+                                             127,  0,   0,   -3,  //
+                                             -115, 40,  -34, 0,   //
+                                             5,    5,   127, 1,   //
+                                             124,  -25, 9,   2};
+  CHECK(As<int8_t>(Decode(EncodeVertexBufferRaw(Bytes(oct8), 4), 5, 4,
+                          "ATTRIBUTES", "OCTAHEDRAL")) == oct8_expected);
+
+  const std::vector<int16_t> oct16 = {0,      0,     32767, 7,  //
+                                      -32767, 0,     32767, 0,  //
+                                      -16000, 20000, 32767, 0,  // folded
+                                      12000,  -3000, 32767, 0,  //
+                                      -1000,  -500,  2047,  0};
+  const std::vector<int16_t> oct16_expected = {0,      0,      32767, 7,  //
+                                               -32767, 0,      0,     0,  //
+                                               -19621, 25768,  -4969, 0,  //
+                                               18163,  -4541,  26892, 0,  //
+                                               -26326, -13163, 14400, 0};
+  CHECK(As<int16_t>(Decode(EncodeVertexBufferRaw(Bytes(oct16), 8), 5, 8,
+                           "ATTRIBUTES", "OCTAHEDRAL")) == oct16_expected);
+
+  // The low 2 bits of the last component pick where w goes.
+  const std::vector<int16_t> quat = {0,      0,     0,    32767,  // w at 3
+                                     0,      0,     0,    32764,  // w at 0
+                                     -23170, 0,     0,    32765,  //
+                                     8000,   -8000, 8000, 32766,  //
+                                     16000,  -4000, 2000, 32764};
+  const std::vector<int16_t> quat_expected = {0,     0,     0,      32767,  //
+                                              32767, 0,     0,      0,      //
+                                              0,     28377, -16384, 0,      //
+                                              -5657, 5657,  31268,  5657,   //
+                                              30589, 11314, -2828,  1414};
+  CHECK(As<int16_t>(Decode(EncodeVertexBufferRaw(Bytes(quat), 8), 5, 8,
+                           "ATTRIBUTES", "QUATERNION")) == quat_expected);
+
+  // 24-bit signed mantissa, 8-bit signed exponent.
+  const std::vector<uint32_t> exp = {0xff000003u, 0x02fffffbu, 0x00000000u,
+                                     0x00000001u, 0xfd000007u, 0x0a000001u};
+  const std::vector<float> exp_expected = {1.5f, -20.0f, 0.0f,
+                                           1.0f, 0.875f, 1024.0f};
+  CHECK(As<float>(Decode(EncodeVertexBufferRaw(Bytes(exp), 8), 3, 8,
+                         "ATTRIBUTES", "EXPONENTIAL")) == exp_expected);
+}
+
+void TestMeshoptSnapshotRoundTrip() {
+  const std::vector<unsigned> indices = {0, 1, 2, 2, 1, 3, 70000, 5};
+  const std::vector<unsigned char> stream = EncodeIndexSequence(indices);
+  const std::string json =
+      MeshoptGltf(stream, indices.size() * 4,
+                  MeshoptFields(stream, indices.size(), 4, "INDICES"));
+
+  tinygltf::Model model;
+  std::string err;
+  CHECK(Load(json, &model, &err));
+  CHECK(err.empty());
+  CHECK(As<uint32_t>(ViewBytes(model)) ==
+        std::vector<uint32_t>(indices.begin(), indices.end()));
+
+  tinygltf::TinyGLTF loader;
+  std::vector<unsigned char> snapshot;
+  CHECK(loader.WriteSnapshotToMemory(&model, 42, &snapshot, &err));
+
+  tinygltf::Model restored;
+  std::string warn;
+  CHECK(loader.LoadSnapshotFromMemory(&restored, &err, &warn,
+                                      snapshot.data(), snapshot.size(), 42));
+  CHECK(err.empty());
+  CHECK(restored == model);
+  CHECK(As<uint32_t>(ViewBytes(restored)) ==
+        std::vector<uint32_t>(indices.begin(), indices.end()));
+
+  // A stale snapshot is rejected and leaves the model untouched.
+  tinygltf::Model stale;
+  CHECK(!loader.LoadSnapshotFromMemory(&stale, &err, &warn, snapshot.data(),
+                                       snapshot.size(), 43));
+  CHECK(stale.bufferViews.empty());
+}
+
+void TestMeshoptRejectsBadRanges() {
+  const std::vector<unsigned> indices = {0, 1, 2, 3};
+  const std::vector<unsigned char> stream = EncodeIndexSequence(indices);
+  const std::string length = std::to_string(stream.size());
+  const std::string bad[] = {
+      // Zero stride.
+      R"("byteLength": )" + length + R"(, "byteStride": 0, "count": 4)",
+      // Negative offset.
+      R"("byteOffset": -1, "byteLength": )" + length +
+          R"(, "byteStride": 4, "count": 4)",
+      // Offset and length wrapping around size_t.
+      R"("byteOffset": 4, "byteLength": 18446744073709549568, )"
+      R"("byteStride": 4, "count": 4)",
+      // Not integral.
+      R"("byteLength": )" + length + R"(, "byteStride": 4, "count": 3.5)",
+      // Beyond any size_t.
+      R"("byteLength": 1e300, "byteStride": 4, "count": 4)",
+      // count * byteStride wrapping around to fit the bufferView.
+      R"("byteLength": )" + length +
+          R"(, "byteStride": 4, "count": 4611686018427387905)",
+      // More elements than the bufferView holds.
+      R"("byteLength": )" + length + R"(, "byteStride": 4, "count": 5)",
+      // Missing count.
+      R"("byteLength": )" + length + R"(, "byteStride": 4)",
+  };
+  for (const std::string &fields : bad) {
+    tinygltf::Model model;
+    std::string err;
+    CHECK(!Load(MeshoptGltf(stream, indices.size() * 4,
+                            fields + R"(, "mode": "INDICES")"),
+                &model, &err));
+    CHECK(err.find("EXT_meshopt_compression") != std::string::npos);
+  }
+}
+
+}  // namespace
+
+int main() {
+  TestAttributesKnownAnswer();
+  TestAttributesBlocks();
+  TestTrianglesKnownAnswer();
+  TestFiltersKnownAnswer();
+  TestMeshoptSnapshotRoundTrip();
+  TestMeshoptRejectsBadRanges();
+  return TestResult();
+}
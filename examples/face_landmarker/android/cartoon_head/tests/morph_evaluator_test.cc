@@ -0,0 +1,97 @@
+//
+// MorphEvaluator from examples/glview: every delta encoding, dense and
+// sparse targets, matches a plain float blend.
+//
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "morph_evaluator.h"
+#include "test_util.h"
+
+namespace {
+
+const size_t kVertices = 1001;  // not a multiple of any SIMD width
+const size_t kTargets = 6;
+
+int AddVec3(tinygltf::Model *model, const std::vector<float> &values) {
+  tinygltf::Buffer &buffer = model->buffers[0];
+  const size_t offset = buffer.data.size();
+  buffer.data.resize(offset + values.size() * sizeof(float));
+  memcpy(&buffer.data[offset], values.data(), values.size() * sizeof(float));
+  tinygltf::BufferView view;
+  view.buffer = 0;
+  view.byteOffset = offset;
+  view.byteLength = values.size() * sizeof(float);
+  model->bufferViews.push_back(view);
+  tinygltf::Accessor accessor;
+  accessor.bufferView = int(model->bufferViews.size() - 1);
+  accessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+  accessor.type = TINYGLTF_TYPE_VEC3;
+  accessor.count = values.size() / 3;
+  model->accessors.push_back(accessor);
+  return int(model->accessors.size() - 1);
+}
+
+// Even targets move every vertex(dense), odd ones every 7th(sparse).
+float Delta(size_t target, size_t vertex, size_t c) {
+  if (target % 2 == 1 && vertex % 7 != 0) return 0.0f;
+  return 0.01f * float(int((vertex * 13 + target * 5 + c * 3) % 41) - 20);
+}
+
+}  // namespace
+
+int main() {
+  tinygltf::Model model;
+  model.buffers.resize(1);
+  std::vector<float> base(kVertices * 3);
+  for (size_t i = 0; i < base.size(); i++) base[i] = float(i % 17) * 0.1f;
+  tinygltf::Primitive primitive;
+  primitive.attributes["POSITION"] = AddVec3(&model, base);
+  primitive.attributes["NORMAL"] = AddVec3(&model, base);
+  for (size_t t = 0; t < kTargets; t++) {
+    std::vector<float> deltas(kVertices * 3);
+    for (size_t v = 0; v < kVertices; v++) {
+      for (size_t c = 0; c < 3; c++) deltas[v * 3 + c] = Delta(t, v, c);
+    }
+    std::map<std::string, int> target;
+    target["POSITION"] = AddVec3(&model, deltas);
+    target["NORMAL"] = AddVec3(&model, deltas);
+    primitive.targets.push_back(target);
+  }
+
+  const float weights[kTargets] = {0.5f, -1.0f, 0.25f, 0.75f, 0.0f, 1.0f};
+  std::vector<float> expected(kVertices * 6);
+  for (size_t v = 0; v < kVertices; v++) {
+    for (size_t c = 0; c < 6; c++) {
+      float sum = base[v * 3 + c % 3];
+      for (size_t t = 0; t < kTargets; t++) {
+        sum += weights[t] * Delta(t, v, c % 3);
+      }
+      expected[v * 6 + c] = sum;
+    }
+  }
+
+  const MorphEvaluator::DeltaEncoding encodings[] = {
+      MorphEvaluator::kDeltaFloat32, MorphEvaluator::kDeltaFloat16,
+      MorphEvaluator::kDeltaInt16};
+  // Largest delta 0.2: fp16 keeps 11 bits, int16 steps by 0.2 / 32767.
+  const float tolerances[] = {1e-5f, 1e-3f, 1e-4f};
+  for (int e = 0; e < 3; e++) {
+    MorphEvaluator evaluator;
+    evaluator.SetDeltaEncoding(encodings[e]);
+    std::string err;
+    CHECK(evaluator.Init(model, primitive, &err));
+    CHECK(evaluator.Stride() == 6);
+    std::vector<float> out(evaluator.FloatCount());
+    evaluator.Evaluate(weights, kTargets, out.data());
+    float max_error = 0.0f;
+    for (size_t i = 0; i < out.size(); i++) {
+      max_error = std::max(max_error, std::fabs(out[i] - expected[i]));
+    }
+    CHECK(max_error < tolerances[e]);
+  }
+  return TestResult();
+}
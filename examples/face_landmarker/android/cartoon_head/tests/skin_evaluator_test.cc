@@ -0,0 +1,519 @@
+//
+// SkinEvaluator(examples/glview) against a scalar double precision
+// reference, for linear blend and dual quaternion skinning: 8/16-bit
+// JOINTS, float and normalized 8/16-bit WEIGHTS, a second JOINTS_1/WEIGHTS_1
+// set(also of other types than the first), with and without normals, an
+// odd vertex count, replaced input vertices, and split-range Evaluate() calls
+// matching a single one.
+//
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "skin_evaluator.h"
+#include "test_util.h"
+#include "tiny_gltf.h"
+
+namespace {
+
+const size_t kVertices = 37;
+const double kTolerance = 1e-5;
+
+uint32_t Random(uint32_t *state) {
+  (*state) = (*state) * 1664525u + 1013904223u;
+  return (*state) >> 8;
+}
+
+// In [lo, hi), rounded to float so the model and the reference agree.
+double RandomValue(uint32_t *state, double lo, double hi) {
+  return double(float(lo + (hi - lo) * double(Random(state) & 0xffff) /
+                                65536.0));
+}
+
+struct Quat {
+  double x, y, z, w;
+};
+
+Quat Multiply(const Quat &a, const Quat &b) {
+  Quat r;
+  r.x = a.w * b.x + b.w * a.x + a.y * b.z - a.z * b.y;
+  r.y = a.w * b.y + b.w * a.y + a.z * b.x - a.x * b.z;
+  r.z = a.w * b.z + b.w * a.z + a.x * b.y - a.y * b.x;
+  r.w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z;
+  return r;
+}
+
+Quat Conjugate(const Quat &q) {
+  Quat r = {-q.x, -q.y, -q.z, q.w};
+  return r;
+}
+
+Quat RandomRotation(uint32_t *state) {
+  Quat q = {RandomValue(state, -1, 1), RandomValue(state, -1, 1),
+            RandomValue(state, -1, 1), RandomValue(state, -1, 1)};
+  const double len =
+      std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w) + 1e-9;
+  Quat r = {double(float(q.x / len)), double(float(q.y / len)),
+            double(float(q.z / len)), double(float(q.w / len))};
+  return r;
+}
+
+// Rotation, uniform scale and translation.
+struct Transform {
+  Quat q;
+  double s;
+  double t[3];
+};
+
+// Column-major 4x4.
+struct Mat4 {
+  double m[16];
+};
+
+Mat4 ToMatrix(const Transform &x) {
+  const Quat &q = x.q;
+  const double r[9] = {1 - 2 * (q.y * q.y + q.z * q.z),
+                       2 * (q.x * q.y + q.w * q.z),
+                       2 * (q.x * q.z - q.w * q.y),
+                       2 * (q.x * q.y - q.w * q.z),
+                       1 - 2 * (q.x * q.x + q.z * q.z),
+                       2 * (q.y * q.z + q.w * q.x),
+                       2 * (q.x * q.z + q.w * q.y),
+                       2 * (q.y * q.z - q.w * q.x),
+                       1 - 2 * (q.x * q.x + q.y * q.y)};
+  Mat4 out = {{0}};
+  for (int c = 0; c < 3; c++) {
+    for (int row = 0; row < 3; row++) {
+      out.m[c * 4 + row] = r[c * 3 + row] * x.s;
+    }
+    out.m[12 + c] = x.t[c];
+  }
+  out.m[15] = 1.0;
+  return out;
+}
+
+Mat4 Multiply(const Mat4 &a, const Mat4 &b) {
+  Mat4 r;
+  for (int c = 0; c < 4; c++) {
+    for (int row = 0; row < 4; row++) {
+      double sum = 0.0;
+      for (int k = 0; k < 4; k++) sum += a.m[k * 4 + row] * b.m[c * 4 + k];
+      r.m[c * 4 + row] = sum;
+    }
+  }
+  return r;
+}
+
+struct SkinCase {
+  const char *name;
+  int joint_types[2];   // JOINTS_0, JOINTS_1; 0 for no second set
+  int weight_types[2];  // WEIGHTS_0, WEIGHTS_1
+  size_t joints;
+  bool normals;
+  bool scaled;  // a scaled joint; linear blend only
+};
+
+// The skinned primitive and its skeleton, and what the reference needs.
+struct SkinAsset {
+  tinygltf::Model model;
+  std::vector<double> positions;
+  std::vector<double> normals;
+  size_t influences;
+  std::vector<uint32_t> joints;  // `influences` per vertex
+  std::vector<double> weights;   // as stored, mapped to [0, 1]
+  std::vector<Mat4> palette;     // world * inverse bind, per joint
+  std::vector<Quat> rotations;   // rotation of the palette, rigid joints
+};
+
+int AddAccessor(tinygltf::Model *model, const std::vector<unsigned char> &bytes,
+                int component_type, int type, size_t count,
+                bool normalized = false) {
+  std::vector<unsigned char> &data = model->buffers[0].data;
+  data.resize((data.size() + 3) & ~size_t(3));
+  tinygltf::BufferView view;
+  view.buffer = 0;
+  view.byteOffset = data.size();
+  view.byteLength = bytes.size();
+  data.insert(data.end(), bytes.begin(), bytes.end());
+  model->bufferViews.push_back(view);
+  tinygltf::Accessor accessor;
+  accessor.bufferView = int(model->bufferViews.size() - 1);
+  accessor.componentType = component_type;
+  accessor.type = type;
+  accessor.count = count;
+  accessor.normalized = normalized;
+  model->accessors.push_back(accessor);
+  return int(model->accessors.size() - 1);
+}
+
+template <typename T>
+void Append(std::vector<unsigned char> *bytes, T value) {
+  const size_t at = bytes->size();
+  bytes->resize(at + sizeof(T));
+  memcpy(&(*bytes)[at], &value, sizeof(T));
+}
+
+// Node 0 is the root, nodes 1..joints its children and the skin's joints.
+SkinAsset MakeAsset(const SkinCase &test, uint32_t seed) {
+  SkinAsset asset;
+  tinygltf::Model &model = asset.model;
+  model.buffers.resize(1);
+  model.scenes.resize(1);
+  model.scenes[0].nodes = {0};
+  model.nodes.resize(test.joints + 1);
+  model.skins.resize(1);
+
+  Transform root = {RandomRotation(&seed), 1.0, {0.5, -1.0, 2.0}};
+  model.nodes[0].rotation = {root.q.x, root.q.y, root.q.z, root.q.w};
+  model.nodes[0].translation = {root.t[0], root.t[1], root.t[2]};
+  std::vector<unsigned char> ibm_bytes;
+  for (size_t j = 0; j < test.joints; j++) {
+    Transform local = {RandomRotation(&seed),
+                       test.scaled && j == 1 ? 1.5 : 1.0,
+                       {RandomValue(&seed, -1, 1), RandomValue(&seed, -1, 1),
+                        RandomValue(&seed, -1, 1)}};
+    tinygltf::Node &node = model.nodes[j + 1];
+    node.rotation = {local.q.x, local.q.y, local.q.z, local.q.w};
+    node.translation = {local.t[0], local.t[1], local.t[2]};
+    if (local.s != 1.0) node.scale = {local.s, local.s, local.s};
+    model.nodes[0].children.push_back(int(j + 1));
+    model.skins[0].joints.push_back(int(j + 1));
+
+    const Transform bind = {RandomRotation(&seed), 1.0,
+                            {RandomValue(&seed, -1, 1),
+                             RandomValue(&seed, -1, 1),
+                             RandomValue(&seed, -1, 1)}};
+    Mat4 ibm = ToMatrix(bind);
+    for (int k = 0; k < 16; k++) {
+      ibm.m[k] = double(float(ibm.m[k]));
+      Append(&ibm_bytes, float(ibm.m[k]));
+    }
+    asset.palette.push_back(
+        Multiply(Multiply(ToMatrix(root), ToMatrix(local)), ibm));
+    asset.rotations.push_back(Multiply(Multiply(root.q, local.q), bind.q));
+  }
+  model.skins[0].inverseBindMatrices =
+      AddAccessor(&model, ibm_bytes, TINYGLTF_COMPONENT_TYPE_FLOAT,
+                  TINYGLTF_TYPE_MAT4, test.joints);
+
+  tinygltf::Primitive prim;
+  std::vector<unsigned char> position_bytes;
+  std::vector<unsigned char> normal_bytes;
+  for (size_t v = 0; v < kVertices; v++) {
+    double n[3];
+    double len = 0.0;
+    for (int k = 0; k < 3; k++) {
+      asset.positions.push_back(RandomValue(&seed, -1, 1));
+      Append(&position_bytes, float(asset.positions.back()));
+      n[k] = RandomValue(&seed, -1, 1);
+      len += n[k] * n[k];
+    }
+    for (int k = 0; k < 3; k++) {
+      asset.normals.push_back(double(float(n[k] / (std::sqrt(len) + 1e-9))));
+      Append(&normal_bytes, float(asset.normals.back()));
+    }
+  }
+  prim.attributes["POSITION"] =
+      AddAccessor(&model, position_bytes, TINYGLTF_COMPONENT_TYPE_FLOAT,
+                  TINYGLTF_TYPE_VEC3, kVertices);
+  if (test.normals) {
+    prim.attributes["NORMAL"] =
+        AddAccessor(&model, normal_bytes, TINYGLTF_COMPONENT_TYPE_FLOAT,
+                    TINYGLTF_TYPE_VEC3, kVertices);
+  }
+
+  const size_t sets = test.joint_types[1] ? 2 : 1;
+  asset.influences = 4 * sets;
+  asset.joints.resize(kVertices * asset.influences);
+  asset.weights.resize(kVertices * asset.influences);
+  std::vector<unsigned char> joint_bytes[2];
+  std::vector<unsigned char> weight_bytes[2];
+  for (size_t v = 0; v < kVertices; v++) {
+    // Random weights summing to 1, about a quarter of them zero.
+    double w[8];
+    double sum = 0.0;
+    for (size_t k = 0; k < asset.influences; k++) {
+      w[k] = Random(&seed) % 4 == 0 ? 0.0 : RandomValue(&seed, 0.05, 1.0);
+      sum += w[k];
+    }
+    if (sum == 0.0) {
+      w[asset.influences - 1] = 1.0;
+      sum = 1.0;
+    }
+    for (size_t k = 0; k < asset.influences; k++) {
+      const size_t set = k / 4;
+      const size_t i = v * asset.influences + k;
+      const bool short_joints =
+          test.joint_types[set] == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+      const size_t limit =
+          short_joints || test.joints <= 256 ? test.joints : 256;
+      asset.joints[i] = Random(&seed) % uint32_t(limit);
+      if (short_joints) {
+        Append(&joint_bytes[set], uint16_t(asset.joints[i]));
+      } else {
+        Append(&joint_bytes[set], uint8_t(asset.joints[i]));
+      }
+      const double weight = w[k] / sum;
+      switch (test.weight_types[set]) {
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
+          const uint8_t q = uint8_t(std::floor(weight * 255.0 + 0.5));
+          Append(&weight_bytes[set], q);
+          asset.weights[i] = double(q) / 255.0;
+          break;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+          const uint16_t q = uint16_t(std::floor(weight * 65535.0 + 0.5));
+          Append(&weight_bytes[set], q);
+          asset.weights[i] = double(q) / 65535.0;
+          break;
+        }
+        default:
+          Append(&weight_bytes[set], float(weight));
+          asset.weights[i] = double(float(weight));
+          break;
+      }
+    }
+  }
+  for (size_t set = 0; set < sets; set++) {
+    const std::string suffix = "_" + std::to_string(set);
+    prim.attributes["JOINTS" + suffix] =
+        AddAccessor(&model, joint_bytes[set], test.joint_types[set],
+                    TINYGLTF_TYPE_VEC4, kVertices);
+    prim.attributes["WEIGHTS" + suffix] = AddAccessor(
+        &model, weight_bytes[set], test.weight_types[set], TINYGLTF_TYPE_VEC4,
+        kVertices,
+        test.weight_types[set] != TINYGLTF_COMPONENT_TYPE_FLOAT);
+  }
+  model.meshes.resize(1);
+  model.meshes[0].primitives.push_back(prim);
+  return asset;
+}
+
+// Linear blend of vertex `v` at `p` with normal `n`.
+void ReferenceLinear(const SkinAsset &asset, size_t v, const double *p,
+                     const double *n, double *out_p, double *out_n) {
+  Mat4 m = {{0}};
+  for (size_t k = 0; k < asset.influences; k++) {
+    const size_t i = v * asset.influences + k;
+    for (int e = 0; e < 16; e++) {
+      m.m[e] += asset.weights[i] * asset.palette[asset.joints[i]].m[e];
+    }
+  }
+  double len = 0.0;
+  for (int row = 0; row < 3; row++) {
+    out_p[row] = m.m[12 + row];
+    out_n[row] = 0.0;
+    for (int c = 0; c < 3; c++) {
+      out_p[row] += m.m[c * 4 + row] * p[c];
+      out_n[row] += m.m[c * 4 + row] * n[c];
+    }
+    len += out_n[row] * out_n[row];
+  }
+  for (int row = 0; row < 3; row++) out_n[row] /= std::sqrt(len);
+}
+
+// Dual quaternion blend of vertex `v`: rotations aligned with the first
+// joint of non-zero weight, summed with their translations as dual parts,
+// normalized, then applied.
+void ReferenceDualQuaternion(const SkinAsset &asset, size_t v,
+                             const double *p, const double *n, double *out_p,
+                             double *out_n) {
+  Quat real = {0, 0, 0, 0};
+  Quat dual = {0, 0, 0, 0};
+  const Quat *pivot = nullptr;
+  for (size_t k = 0; k < asset.influences; k++) {
+    const size_t i = v * asset.influences + k;
+    if (asset.weights[i] == 0.0) continue;
+    const Quat &q = asset.rotations[asset.joints[i]];
+    const double *t = &asset.palette[asset.joints[i]].m[12];
+    const Quat tq = {t[0], t[1], t[2], 0.0};
+    Quat d = Multiply(tq, q);
+    double w = asset.weights[i];
+    if (!pivot) pivot = &q;
+    if (q.x * pivot->x + q.y * pivot->y + q.z * pivot->z + q.w * pivot->w <
+        0.0) {
+      w = -w;
+    }
+    real.x += w * q.x;
+    real.y += w * q.y;
+    real.z += w * q.z;
+    real.w += w * q.w;
+    dual.x += w * 0.5 * d.x;
+    dual.y += w * 0.5 * d.y;
+    dual.z += w * 0.5 * d.z;
+    dual.w += w * 0.5 * d.w;
+  }
+  const double len = std::sqrt(real.x * real.x + real.y * real.y +
+                               real.z * real.z + real.w * real.w);
+  real = {real.x / len, real.y / len, real.z / len, real.w / len};
+  dual = {dual.x / len, dual.y / len, dual.z / len, dual.w / len};
+  const Quat t = Multiply(dual, Conjugate(real));
+  const Quat pq = {p[0], p[1], p[2], 0.0};
+  const Quat nq = {n[0], n[1], n[2], 0.0};
+  const Quat rp = Multiply(Multiply(real, pq), Conjugate(real));
+  const Quat rn = Multiply(Multiply(real, nq), Conjugate(real));
+  out_p[0] = rp.x + 2.0 * t.x;
+  out_p[1] = rp.y + 2.0 * t.y;
+  out_p[2] = rp.z + 2.0 * t.z;
+  out_n[0] = rn.x;
+  out_n[1] = rn.y;
+  out_n[2] = rn.z;
+}
+
+// `out` against the reference, for input vertices `in`(base vertices when
+// null) of `in_stride` floats.
+bool MatchesReference(const SkinAsset &asset, const SkinEvaluator &skin,
+                      SkinEvaluator::Method method,
+                      const std::vector<float> &out, const float *in,
+                      size_t in_stride) {
+  const size_t stride = skin.Stride();
+  int bad = 0;
+  for (size_t v = 0; v < kVertices; v++) {
+    double p[3];
+    double n[3];
+    for (int k = 0; k < 3; k++) {
+      p[k] = in ? in[v * in_stride + size_t(k)] : asset.positions[v * 3 + k];
+      n[k] = in && in_stride >= 6 ? in[v * in_stride + 3 + size_t(k)]
+                                  : asset.normals[v * 3 + k];
+    }
+    double ref_p[3];
+    double ref_n[3];
+    if (method == SkinEvaluator::kLinearBlend) {
+      ReferenceLinear(asset, v, p, n, ref_p, ref_n);
+    } else {
+      ReferenceDualQuaternion(asset, v, p, n, ref_p, ref_n);
+    }
+    for (size_t k = 0; k < 3; k++) {
+      bad += std::fabs(out[v * stride + k] - ref_p[k]) > kTolerance;
+      if (stride == 6) {
+        bad += std::fabs(out[v * stride + 3 + k] - ref_n[k]) > kTolerance;
+      }
+    }
+  }
+  return bad == 0;
+}
+
+void CheckCase(const SkinCase &test, uint32_t seed) {
+  fprintf(stderr, "%s\n", test.name);
+  const SkinAsset asset = MakeAsset(test, seed);
+  tinygltf::FlatScene scene;
+  CHECK(scene.Build(asset.model, 0));
+
+  const SkinEvaluator::Method methods[] = {SkinEvaluator::kLinearBlend,
+                                           SkinEvaluator::kDualQuaternion};
+  for (SkinEvaluator::Method method : methods) {
+    if (test.scaled && method == SkinEvaluator::kDualQuaternion) continue;
+    SkinEvaluator skin;
+    std::string err;
+    CHECK(skin.Init(asset.model, asset.model.meshes[0].primitives[0], 0,
+                    &err));
+    CHECK(err.empty());
+    CHECK(skin.VertexCount() == kVertices);
+    CHECK(skin.JointCount() == test.joints);
+    CHECK(skin.HasNormals() == test.normals);
+    skin.SetMethod(method);
+    CHECK(skin.UpdatePalette(scene));
+
+    std::vector<float> whole(skin.FloatCount(), -1.0f);
+    skin.Evaluate(0, kVertices, whole.data());
+    CHECK(MatchesReference(asset, skin, method, whole, nullptr, 0));
+
+    // Uneven ranges, an empty one and one past the end give the same result.
+    std::vector<float> split(skin.FloatCount(), -1.0f);
+    skin.Evaluate(0, 5, split.data());
+    skin.Evaluate(5, 5, split.data());
+    skin.Evaluate(5, 18, split.data());
+    skin.Evaluate(18, 19, split.data());
+    skin.Evaluate(19, kVertices + 10, split.data());
+    CHECK(split == whole);
+
+    // Input vertices replaced, e.g. by morph targets: positions only, and
+    // positions with normals.
+    const size_t in_strides[] = {3, 6};
+    for (size_t in_stride : in_strides) {
+      std::vector<float> in(kVertices * in_stride);
+      for (size_t v = 0; v < kVertices; v++) {
+        for (size_t k = 0; k < 3; k++) {
+          in[v * in_stride + k] =
+              float(asset.positions[v * 3 + k]) + 0.1f * float(k + 1);
+          if (in_stride == 6) {
+            in[v * in_stride + 3 + k] =
+                float(asset.normals[v * 3 + (k + 1) % 3]);
+          }
+        }
+      }
+      std::vector<float> out(skin.FloatCount());
+      skin.Evaluate(0, kVertices, out.data(), in.data(), in_stride);
+      CHECK(MatchesReference(asset, skin, method, out, in.data(), in_stride));
+    }
+  }
+}
+
+void TestInitErrors() {
+  const SkinCase test = {"errors",
+                         {TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, 0},
+                         {TINYGLTF_COMPONENT_TYPE_FLOAT, 0},
+                         4,
+                         false,
+                         false};
+  const SkinAsset asset = MakeAsset(test, 1);
+  const tinygltf::Primitive &prim = asset.model.meshes[0].primitives[0];
+  SkinEvaluator skin;
+  std::string err;
+  CHECK(!skin.Init(asset.model, prim, 1, &err));
+  CHECK(!err.empty());
+
+  // Joint indices beyond the skin.
+  tinygltf::Model model = asset.model;
+  model.skins[0].joints.resize(2);
+  err.clear();
+  CHECK(!skin.Init(model, prim, 0, &err));
+  CHECK(err.find("out of range") != std::string::npos);
+
+  // Non-normalized integer weights.
+  model = asset.model;
+  model.accessors[size_t(prim.attributes.at("WEIGHTS_0"))].componentType =
+      TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+  err.clear();
+  CHECK(!skin.Init(model, prim, 0, &err));
+  CHECK(!err.empty());
+
+  // A joint outside of the scene.
+  err.clear();
+  CHECK(skin.Init(asset.model, prim, 0, &err));
+  model = asset.model;
+  model.nodes.push_back(tinygltf::Node());
+  model.scenes[0].nodes = {int(model.nodes.size() - 1)};
+  tinygltf::FlatScene scene;
+  CHECK(scene.Build(model, 0));
+  CHECK(!skin.UpdatePalette(scene));
+}
+
+}  // namespace
+
+int main() {
+  const int kU8 = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+  const int kU16 = TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+  const int kFloat = TINYGLTF_COMPONENT_TYPE_FLOAT;
+  const SkinCase cases[] = {
+      {"u8 joints, float weights", {kU8, 0}, {kFloat, 0}, 6, true, false},
+      {"u8 joints, u8 weights", {kU8, 0}, {kU8, 0}, 6, false, false},
+      {"u8 joints, u16 weights", {kU8, 0}, {kU16, 0}, 6, true, false},
+      {"u16 joints, float weights", {kU16, 0}, {kFloat, 0}, 300, true, false},
+      {"u16 joints, u8 weights", {kU16, 0}, {kU8, 0}, 300, true, false},
+      {"u16 joints, u16 weights", {kU16, 0}, {kU16, 0}, 300, false, false},
+      {"two sets", {kU8, kU8}, {kFloat, kFloat}, 9, true, false},
+      {"two sets, u16 weights", {kU16, kU16}, {kU16, kU16}, 300, true, false},
+      {"two sets of mixed types", {kU8, kU16}, {kU8, kFloat}, 300, true,
+       false},
+      {"scaled joint", {kU8, 0}, {kFloat, 0}, 6, true, true},
+  };
+  uint32_t seed = 1;
+  for (const SkinCase &test : cases) {
+    CheckCase(test, seed++);
+  }
+  TestInitErrors();
+  return TestResult();
+}
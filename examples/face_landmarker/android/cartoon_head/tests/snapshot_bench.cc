@@ -0,0 +1,182 @@
+//
+// Load time of a face-sized GLB(two 1024x1024 PNG textures, 4 MiB of
+// vertex data, extras-heavy mesh and nodes) parsed cold with
+// LoadBinaryFromMemory() against the same Model restored from its
+// snapshot with LoadSnapshotFromMemory(), copying and borrowing buffers.
+//
+// Usage: snapshot_bench [texture size] [runs]
+//
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tiny_gltf.h"
+
+namespace {
+
+tinygltf::Model MakeHead(int texture_size) {
+  tinygltf::Model model;
+  model.asset.version = "2.0";
+
+  tinygltf::Buffer buffer;
+  buffer.data.resize(4 << 20);
+  for (size_t i = 0; i < buffer.data.size(); i++) {
+    buffer.data[i] = static_cast<unsigned char>(i * 2654435761u >> 13);
+  }
+  model.buffers.push_back(buffer);
+  tinygltf::BufferView view;
+  view.buffer = 0;
+  view.byteLength = buffer.data.size();
+  model.bufferViews.push_back(view);
+
+  tinygltf::Value::Array names;
+  for (int t = 0; t < 52; t++) {
+    names.push_back(tinygltf::Value("blendshape" + std::to_string(t)));
+  }
+  tinygltf::Mesh mesh;
+  mesh.name = "head";
+  for (int t = 0; t < 52; t++) {
+    tinygltf::Accessor accessor;
+    accessor.bufferView = 0;
+    accessor.byteOffset = size_t(t) * 65536;
+    accessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+    accessor.type = TINYGLTF_TYPE_VEC3;
+    accessor.count = 4096;
+    accessor.minValues = {-1, -1, -1};
+    accessor.maxValues = {1, 1, 1};
+    model.accessors.push_back(accessor);
+  }
+  tinygltf::Primitive primitive;
+  primitive.attributes["POSITION"] = 0;
+  for (int t = 1; t < 52; t++) {
+    std::map<std::string, int> target;
+    target["POSITION"] = t;
+    primitive.targets.push_back(target);
+  }
+  mesh.primitives.push_back(primitive);
+  mesh.weights.assign(51, 0.0);
+  tinygltf::Value::Object extras;
+  extras["targetNames"] = tinygltf::Value(names);
+  mesh.extras = tinygltf::Value(extras);
+  model.meshes.push_back(mesh);
+
+  tinygltf::Scene scene;
+  for (int n = 0; n < 200; n++) {
+    tinygltf::Node node;
+    node.name = "joint" + std::to_string(n);
+    node.translation = {0.0, 0.01 * n, 0.0};
+    tinygltf::Value::Object node_extras;
+    node_extras["rig"] = tinygltf::Value(names);
+    node.extras = tinygltf::Value(node_extras);
+    model.nodes.push_back(node);
+    scene.nodes.push_back(n);
+  }
+  model.nodes[0].mesh = 0;
+  model.scenes.push_back(scene);
+  model.defaultScene = 0;
+
+  for (int t = 0; t < 2; t++) {
+    tinygltf::Image image;
+    image.name = "texture" + std::to_string(t);
+    image.width = texture_size;
+    image.height = texture_size;
+    image.component = 4;
+    image.bits = 8;
+    image.pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+    image.mimeType = "image/png";
+    image.image.resize(size_t(texture_size) * size_t(texture_size) * 4);
+    for (size_t i = 0; i < image.image.size(); i++) {
+      image.image[i] = static_cast<unsigned char>((i / 4) % 251 + t * (i % 3));
+    }
+    model.images.push_back(image);
+    tinygltf::Texture texture;
+    texture.source = t;
+    model.textures.push_back(texture);
+  }
+  return model;
+}
+
+template <typename Fn>
+double BestMillis(int runs, Fn fn) {
+  double best = 1e30;
+  for (int r = 0; r < runs; r++) {
+    const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    if (!fn()) {
+      fprintf(stderr, "load failed\n");
+      exit(EXIT_FAILURE);
+    }
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const int texture_size = argc > 1 ? atoi(argv[1]) : 1024;
+  const int runs = argc > 2 ? atoi(argv[2]) : 5;
+
+  tinygltf::TinyGLTF loader;
+  std::string glb;
+  {
+    tinygltf::Model head = MakeHead(texture_size);
+    std::ostringstream out;
+    loader.WriteGltfSceneToStream(&head, out, false, true);
+    glb = out.str();
+  }
+  const unsigned char *glb_bytes =
+      reinterpret_cast<const unsigned char *>(glb.data());
+  const unsigned int glb_size = static_cast<unsigned int>(glb.size());
+
+  std::string err;
+  std::string warn;
+  tinygltf::Model cold;
+  if (!loader.LoadBinaryFromMemory(&cold, &err, &warn, glb_bytes, glb_size)) {
+    fprintf(stderr, "%s\n", err.c_str());
+    return EXIT_FAILURE;
+  }
+  std::vector<unsigned char> snapshot;
+  if (!loader.WriteSnapshotToMemory(&cold, 1, &snapshot, &err)) {
+    fprintf(stderr, "%s\n", err.c_str());
+    return EXIT_FAILURE;
+  }
+
+  tinygltf::Model restored;
+  if (!loader.LoadSnapshotFromMemory(&restored, &err, &warn, snapshot.data(),
+                                     snapshot.size(), 1) ||
+      !(restored == cold)) {
+    fprintf(stderr, "snapshot does not restore the model\n%s\n", err.c_str());
+    return EXIT_FAILURE;
+  }
+
+  const double cold_ms = BestMillis(runs, [&]() {
+    tinygltf::Model model;
+    return loader.LoadBinaryFromMemory(&model, &err, &warn, glb_bytes,
+                                       glb_size);
+  });
+  const double copy_ms = BestMillis(runs, [&]() {
+    tinygltf::Model model;
+    return loader.LoadSnapshotFromMemory(&model, &err, &warn, snapshot.data(),
+                                         snapshot.size(), 1);
+  });
+  loader.SetBorrowBinaryChunk(true);
+  const double borrow_ms = BestMillis(runs, [&]() {
+    tinygltf::Model model;
+    return loader.LoadSnapshotFromMemory(&model, &err, &warn, snapshot.data(),
+                                         snapshot.size(), 1);
+  });
+
+  printf("GLB %zu bytes, snapshot %zu bytes, best of %d\n", glb.size(),
+         snapshot.size(), runs);
+  printf("cold LoadBinaryFromMemory:    %8.2f ms\n", cold_ms);
+  printf("LoadSnapshotFromMemory:       %8.2f ms\n", copy_ms);
+  printf("  with borrowed buffers:      %8.2f ms\n", borrow_ms);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,288 @@
+//
+// Snapshot round trips of every Model field, rejection of corrupt snapshots,
+// and buffers borrowing the files they were loaded from. Snapshots of
+// EXT_meshopt_compression bufferViews are in meshopt_test.cc.
+//
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tiny_gltf.h"
+#include "test_util.h"
+
+namespace {
+
+std::string Base64(const std::vector<unsigned char> &bytes) {
+  static const char kChars[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  for (size_t i = 0; i < bytes.size(); i += 3) {
+    const size_t n = bytes.size() - i < 3 ? bytes.size() - i : 3;
+    unsigned v = unsigned(bytes[i]) << 16;
+    if (n > 1) v |= unsigned(bytes[i + 1]) << 8;
+    if (n > 2) v |= unsigned(bytes[i + 2]);
+    out += kChars[(v >> 18) & 63];
+    out += kChars[(v >> 12) & 63];
+    out += n > 1 ? kChars[(v >> 6) & 63] : '=';
+    out += n > 2 ? kChars[v & 63] : '=';
+  }
+  return out;
+}
+
+bool Load(const std::string &json, tinygltf::Model *model, std::string *err,
+          bool store_json = false) {
+  tinygltf::TinyGLTF loader;
+  loader.SetStoreOriginalJSONForExtrasAndExtensions(store_json);
+  std::string warn;
+  return loader.LoadASCIIFromString(model, err, &warn, json.c_str(),
+                                    static_cast<unsigned int>(json.size()),
+                                    "");
+}
+
+// Model::operator== skips some fields(sparse accessors, light intensity,
+// ...), so round trips also compare the written glTF.
+std::string ToGltf(const tinygltf::Model &model) {
+  tinygltf::TinyGLTF writer;
+  std::ostringstream out;
+  writer.WriteGltfSceneToStream(&model, out, false, false);
+  return out.str();
+}
+
+// Uses most of what a glTF can hold, with nested extras of every type.
+std::string FullGltf() {
+  const std::vector<unsigned char> zeros(64, 0);
+  return R"({
+    "asset": {"version": "2.0", "generator": "snapshot_test",
+              "copyright": "c", "extras": {"a": 1}},
+    "extensionsUsed": ["KHR_lights_punctual",
+                       "KHR_materials_emissive_strength"],
+    "extras": {"int": 1, "real": 0.5, "bool": true, "str": "s",
+               "arr": [1, "x", [2.5, false], {"k": null}],
+               "obj": {"z": 1, "a": {"b": []}}},
+    "buffers": [{"byteLength": 64,
+      "uri": "data:application/octet-stream;base64,)" +
+         Base64(zeros) + R"("}],
+    "bufferViews": [
+      {"buffer": 0, "byteLength": 48, "byteStride": 12, "target": 34962,
+       "name": "bv"},
+      {"buffer": 0, "byteOffset": 48, "byteLength": 16}],
+    "accessors": [
+      {"bufferView": 0, "componentType": 5126, "count": 4, "type": "VEC3",
+       "min": [0, 0, 0], "max": [1, 1, 1], "name": "pos"},
+      {"bufferView": 0, "componentType": 5126, "count": 4, "type": "VEC3",
+       "sparse": {"count": 1, "extras": {"s": 1},
+                  "indices": {"bufferView": 1, "componentType": 5125},
+                  "values": {"bufferView": 1, "byteOffset": 4}}},
+      {"bufferView": 1, "componentType": 5126, "count": 2,
+       "type": "SCALAR", "min": [0], "max": [1]}],
+    "animations": [{"name": "idle",
+      "samplers": [{"input": 2, "output": 2, "interpolation": "STEP"}],
+      "channels": [{"sampler": 0, "target": {"node": 0, "path": "weights",
+                                             "extras": {"t": 2}}}]}],
+    "materials": [{"name": "m",
+      "pbrMetallicRoughness": {"baseColorFactor": [0.5, 0.5, 0.5, 1],
+                               "baseColorTexture": {"index": 0,
+                                                    "texCoord": 1},
+                               "metallicFactor": 0.25},
+      "normalTexture": {"index": 0, "scale": 2},
+      "occlusionTexture": {"index": 0, "strength": 0.5},
+      "emissiveTexture": {"index": 0}, "emissiveFactor": [1, 0, 0],
+      "alphaMode": "MASK", "alphaCutoff": 0.25, "doubleSided": true,
+      "extensions": {"KHR_materials_emissive_strength":
+                         {"emissiveStrength": 2}}}],
+    "meshes": [{"name": "face", "weights": [0.5],
+      "extras": {"targetNames": ["jawOpen"]},
+      "primitives": [{"attributes": {"POSITION": 0},
+                      "targets": [{"POSITION": 1}], "material": 0,
+                      "mode": 4}]}],
+    "nodes": [
+      {"name": "n0", "mesh": 0, "skin": 0, "translation": [1, 2, 3],
+       "rotation": [0, 0, 0, 1], "weights": [0.25], "children": [1]},
+      {"name": "n1", "camera": 0,
+       "matrix": [1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1],
+       "extensions": {"KHR_lights_punctual": {"light": 0}}},
+      {"camera": 1}],
+    "skins": [{"name": "s", "joints": [1], "skeleton": 1,
+               "inverseBindMatrices": 0}],
+    "samplers": [{"magFilter": 9729, "minFilter": 9987, "wrapS": 33071}],
+    "textures": [{"sampler": 0, "source": 0}],
+    "cameras": [
+      {"type": "perspective",
+       "perspective": {"yfov": 0.8, "znear": 0.1, "zfar": 100,
+                       "aspectRatio": 1.5}},
+      {"type": "orthographic", "name": "ortho",
+       "orthographic": {"xmag": 1, "ymag": 2, "znear": 0.1, "zfar": 10}}],
+    "extensions": {"KHR_lights_punctual": {"lights": [
+      {"type": "spot", "color": [1, 0.5, 0], "intensity": 3, "range": 10,
+       "spot": {"innerConeAngle": 0.1, "outerConeAngle": 0.5}}]}},
+    "scenes": [{"name": "sc", "nodes": [0, 2]}],
+    "scene": 0})";
+}
+
+void TestFullSnapshotRoundTrip() {
+  tinygltf::Model model;
+  std::string err;
+  CHECK(Load(FullGltf(), &model, &err, true));
+  CHECK(err.empty());
+  CHECK(model.accessors[1].sparse.isSparse && model.lights.size() == 1);
+  // One decoded image and one still encoded(lazily loaded).
+  tinygltf::Image decoded;
+  decoded.name = "decoded";
+  decoded.width = 2;
+  decoded.height = 1;
+  decoded.component = 4;
+  decoded.bits = 8;
+  decoded.pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+  decoded.image = {1, 2, 3, 4, 5, 6, 7, 8};
+  model.images.push_back(decoded);
+  tinygltf::Image encoded;
+  encoded.mimeType = "image/png";
+  encoded.bufferView = 1;
+  encoded.encoded = {0x89, 'P', 'N', 'G'};
+  model.images.push_back(encoded);
+
+  tinygltf::TinyGLTF loader;
+  std::vector<unsigned char> snapshot;
+  CHECK(loader.WriteSnapshotToMemory(&model, 7, &snapshot, &err));
+
+  tinygltf::Model restored;
+  std::string warn;
+  CHECK(loader.LoadSnapshotFromMemory(&restored, &err, &warn, snapshot.data(),
+                                      snapshot.size(), 7));
+  CHECK(err.empty());
+  CHECK(restored == model);
+  CHECK(ToGltf(restored) == ToGltf(model));
+  CHECK(restored.extras_json_string == model.extras_json_string);
+  CHECK(!restored.extras_json_string.empty());
+  CHECK(restored.images[1].encoded == model.images[1].encoded);
+  CHECK(!restored.images[1].IsDecoded());
+
+  // Buffers borrow from the snapshot, at 4 KiB aligned offsets.
+  loader.SetBorrowBinaryChunk(true);
+  tinygltf::Model borrowed;
+  CHECK(loader.LoadSnapshotFromMemory(&borrowed, &err, &warn, snapshot.data(),
+                                      snapshot.size(), 7));
+  CHECK(borrowed.buffers[0].IsBorrowed());
+  CHECK((borrowed.buffers[0].Data() - snapshot.data()) % 4096 == 0);
+  CHECK(borrowed == model);
+}
+
+// Corrupt snapshots fail without touching the output or reading outside
+// the snapshot(checked under ASan).
+void TestCorruptSnapshots() {
+  tinygltf::Model model;
+  std::string err;
+  CHECK(Load(FullGltf(), &model, &err));
+  tinygltf::TinyGLTF loader;
+  std::vector<unsigned char> snapshot;
+  CHECK(loader.WriteSnapshotToMemory(&model, 7, &snapshot, &err));
+
+  std::string warn;
+  tinygltf::Model out;
+  CHECK(!loader.LoadSnapshotFromMemory(&out, &err, &warn, snapshot.data(),
+                                       snapshot.size() - 1, 7));
+  // Tables cut short. SnapshotHeader::tables_offset and tables_size are at
+  // bytes 32 and 40.
+  uint64_t tables_offset = 0;
+  uint64_t tables_size = 0;
+  memcpy(&tables_offset, &snapshot[32], sizeof(tables_offset));
+  memcpy(&tables_size, &snapshot[40], sizeof(tables_size));
+  std::vector<unsigned char> bad = snapshot;
+  const uint64_t short_size = tables_size / 2;
+  memcpy(&bad[40], &short_size, sizeof(short_size));
+  CHECK(!loader.LoadSnapshotFromMemory(&out, &err, &warn, bad.data(),
+                                       bad.size(), 7));
+  CHECK(out.accessors.empty());
+
+  // Every byte of the tables flipped in turn: loads fail or give some
+  // Model, but never read out of bounds.
+  for (size_t i = size_t(tables_offset);
+       i < size_t(tables_offset + tables_size); i++) {
+    bad = snapshot;
+    bad[i] ^= 0xff;
+    tinygltf::Model m;
+    loader.LoadSnapshotFromMemory(&m, &err, &warn, bad.data(), bad.size(), 7);
+  }
+}
+
+// LoadFromFileCached and LoadSnapshotFromFile with borrowing on: buffers
+// point into the GLB or snapshot file they were read from, which stays
+// mapped for as long as any Buffer, or copy of one, uses it(checked under
+// ASan), even after the loader is gone.
+void TestFileBorrowing() {
+  tinygltf::Model model;
+  model.buffers.resize(1);
+  model.buffers[0].data.resize(10000);
+  for (size_t i = 0; i < model.buffers[0].data.size(); i++) {
+    model.buffers[0].data[i] = static_cast<unsigned char>(i * 7);
+  }
+  tinygltf::BufferView view;
+  view.buffer = 0;
+  view.byteLength = model.buffers[0].data.size();
+  model.bufferViews.push_back(view);
+  const std::string glb = "snapshot_test_borrow.glb";
+  const std::string snapshot = "snapshot_test_borrow.snapshot";
+  remove(snapshot.c_str());
+  {
+    tinygltf::TinyGLTF writer;
+    CHECK(writer.WriteGltfSceneToFile(&model, glb, false, true, false, true));
+  }
+
+  std::string err;
+  std::string warn;
+  tinygltf::Model from_glb;
+  tinygltf::Model from_snapshot;
+  {
+    tinygltf::TinyGLTF loader;
+    loader.SetBorrowBinaryChunk(true);
+    // No snapshot yet: the GLB is loaded and the snapshot written.
+    CHECK(loader.LoadFromFileCached(&from_glb, &err, &warn, glb, snapshot));
+    CHECK(loader.LoadFromFileCached(&from_snapshot, &err, &warn, glb,
+                                    snapshot));
+  }
+  CHECK(err.empty());
+  CHECK(from_glb.buffers.size() == 1 && from_glb.buffers[0].IsBorrowed() &&
+        from_glb.buffers[0].borrowed_owner);
+  CHECK(from_snapshot.buffers.size() == 1 &&
+        from_snapshot.buffers[0].IsBorrowed() &&
+        from_snapshot.buffers[0].borrowed_owner);
+  CHECK(from_glb.buffers[0].borrowed_owner !=
+        from_snapshot.buffers[0].borrowed_owner);
+
+  // A copy outlives the Model it was taken from.
+  tinygltf::Model copy = from_snapshot;
+  from_snapshot = tinygltf::Model();
+  CHECK(copy.buffers.size() == 1 && copy.buffers[0] == model.buffers[0]);
+  CHECK(from_glb.buffers.size() == 1 &&
+        from_glb.buffers[0] == model.buffers[0]);
+
+  // MakeOwned() lets go of the file.
+  from_glb.buffers[0].MakeOwned();
+  CHECK(!from_glb.buffers[0].IsBorrowed() &&
+        !from_glb.buffers[0].borrowed_owner);
+  CHECK(from_glb.buffers[0] == model.buffers[0]);
+
+  // Without borrowing the bytes are copied.
+  std::vector<unsigned char> glb_bytes;
+  CHECK(tinygltf::ReadWholeFile(&glb_bytes, &err, glb, nullptr));
+  tinygltf::TinyGLTF loader;
+  tinygltf::Model copied;
+  CHECK(loader.LoadSnapshotFromFile(
+      &copied, &err, &warn, snapshot,
+      tinygltf::HashBytes(glb_bytes.data(), glb_bytes.size())));
+  CHECK(copied.buffers.size() == 1 && !copied.buffers[0].IsBorrowed() &&
+        copied.buffers[0] == model.buffers[0]);
+  remove(glb.c_str());
+  remove(snapshot.c_str());
+}
+
+}  // namespace
+
+int main() {
+  TestFullSnapshotRoundTrip();
+  TestCorruptSnapshots();
+  TestFileBorrowing();
+  return TestResult();
+}
@@ -0,0 +1,268 @@
+//
+// ResolveSparseAccessor, ReadAccessor and SparseAccessorCache on sparse
+// accessors: with and without a base bufferView, every index type and the
+// element sizes that have their own scatter kernels.
+//
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "tiny_gltf.h"
+#include "test_util.h"
+
+namespace {
+
+uint32_t Random(uint32_t *state) {
+  (*state) = (*state) * 1664525u + 1013904223u;
+  return (*state) >> 8;
+}
+
+// Appends `bytes` to buffer 0 as a new bufferView and returns its index.
+int AddView(tinygltf::Model *model, const std::vector<unsigned char> &bytes,
+            size_t byte_stride = 0) {
+  if (model->buffers.empty()) model->buffers.resize(1);
+  std::vector<unsigned char> &data = model->buffers[0].data;
+  // Keep every view 4-byte aligned, as glTF requires.
+  data.resize((data.size() + 3) & ~size_t(3));
+  tinygltf::BufferView view;
+  view.buffer = 0;
+  view.byteOffset = data.size();
+  view.byteLength = bytes.size();
+  view.byteStride = byte_stride;
+  data.insert(data.end(), bytes.begin(), bytes.end());
+  model->bufferViews.push_back(view);
+  return int(model->bufferViews.size() - 1);
+}
+
+std::vector<unsigned char> RandomBytes(size_t size, uint32_t *seed) {
+  std::vector<unsigned char> bytes(size);
+  for (size_t i = 0; i < size; i++) {
+    bytes[i] = static_cast<unsigned char>(Random(seed));
+  }
+  return bytes;
+}
+
+// Every third element, as `index_type` values.
+std::vector<unsigned char> SparseIndices(size_t sparse_count,
+                                         int index_type) {
+  const size_t size =
+      size_t(tinygltf::GetComponentSizeInBytes(uint32_t(index_type)));
+  std::vector<unsigned char> bytes(sparse_count * size);
+  for (size_t k = 0; k < sparse_count; k++) {
+    const uint32_t index = uint32_t(k * 3 + 1);
+    if (size == 1) {
+      bytes[k] = static_cast<unsigned char>(index);
+    } else if (size == 2) {
+      const uint16_t v = uint16_t(index);
+      memcpy(&bytes[k * 2], &v, 2);
+    } else {
+      memcpy(&bytes[k * 4], &index, 4);
+    }
+  }
+  return bytes;
+}
+
+struct SparseCase {
+  int component_type;
+  int type;
+  int index_type;
+  bool has_base;   // false: the base values are implicit zeros
+  size_t stride;   // byteStride of the base view; 0 for packed
+};
+
+// Resolves one sparse accessor and compares it with a plain copy of the base
+// elements patched with the sparse values.
+void CheckResolve(const SparseCase &test, uint32_t seed) {
+  const size_t count = 77;
+  const size_t sparse_count = 25;  // every third element
+  const size_t element_size = size_t(tinygltf::GetElementSizeInBytes(
+      uint32_t(test.component_type), uint32_t(test.type)));
+  const size_t step = test.stride ? test.stride : element_size;
+
+  tinygltf::Model model;
+  tinygltf::Accessor accessor;
+  accessor.componentType = test.component_type;
+  accessor.type = test.type;
+  accessor.count = count;
+  std::vector<unsigned char> expected(count * element_size, 0);
+  if (test.has_base) {
+    const std::vector<unsigned char> base = RandomBytes(count * step, &seed);
+    accessor.bufferView = AddView(&model, base, test.stride);
+    for (size_t i = 0; i < count; i++) {
+      memcpy(&expected[i * element_size], &base[i * step], element_size);
+    }
+  }
+  const std::vector<unsigned char> values =
+      RandomBytes(sparse_count * element_size, &seed);
+  for (size_t k = 0; k < sparse_count; k++) {
+    memcpy(&expected[(k * 3 + 1) * element_size], &values[k * element_size],
+           element_size);
+  }
+  accessor.sparse.isSparse = true;
+  // Accessor() leaves the sparse byteOffsets uninitialized.
+  accessor.sparse.indices.byteOffset = 0;
+  accessor.sparse.values.byteOffset = 0;
+  accessor.sparse.count = int(sparse_count);
+  accessor.sparse.indices.componentType = test.index_type;
+  accessor.sparse.indices.bufferView =
+      AddView(&model, SparseIndices(sparse_count, test.index_type));
+  accessor.sparse.values.bufferView = AddView(&model, values);
+  model.accessors.push_back(accessor);
+
+  std::vector<unsigned char> dense;
+  std::string err;
+  CHECK(tinygltf::ResolveSparseAccessor(model, accessor, &dense, &err));
+  CHECK(err.empty());
+  CHECK(dense == expected);
+
+  // The cache hands out the same copy on every call.
+  tinygltf::SparseAccessorCache cache(model);
+  const std::vector<unsigned char> *first = cache.Get(0, &err);
+  CHECK(first != nullptr && *first == expected);
+  CHECK(cache.Get(0) == first);
+  cache.Clear();
+  const std::vector<unsigned char> *again = cache.Get(0);
+  CHECK(again != nullptr && *again == expected);
+}
+
+// ResolveSparseAccessor for float accessors of 4 to 16 byte elements, with
+// and without a base bufferView, a strided base and the other element sizes.
+void TestResolve() {
+  const SparseCase cases[] = {
+      {TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_SCALAR,
+       TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, true, 0},
+      {TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC2,
+       TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, true, 0},
+      {TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3,
+       TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT, true, 0},
+      {TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3,
+       TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, true, 20},
+      {TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC4,
+       TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, true, 0},
+      {TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3,
+       TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, false, 0},
+      {TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC4,
+       TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT, false, 0},
+      {TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, TINYGLTF_TYPE_SCALAR,
+       TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, true, 0},
+      {TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, TINYGLTF_TYPE_MAT3,
+       TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, true, 0},
+      {TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_MAT4,
+       TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, false, 0},
+  };
+  uint32_t seed = 1;
+  for (const SparseCase &test : cases) {
+    CheckResolve(test, seed++);
+  }
+}
+
+// A morph-target style accessor: no bufferView, so ReadAccessor starts from
+// zeros and only the sparse elements are set.
+void TestReadImplicitZeros() {
+  tinygltf::Model model;
+  const float values[] = {1.0f, 2.0f, 3.0f, -4.0f, -5.0f, -6.0f};
+  std::vector<unsigned char> value_bytes(sizeof(values));
+  memcpy(value_bytes.data(), values, sizeof(values));
+  const unsigned char indices[] = {2, 5};
+  tinygltf::Accessor accessor;
+  accessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+  accessor.type = TINYGLTF_TYPE_VEC3;
+  accessor.count = 6;
+  accessor.sparse.isSparse = true;
+  accessor.sparse.indices.byteOffset = 0;
+  accessor.sparse.values.byteOffset = 0;
+  accessor.sparse.count = 2;
+  accessor.sparse.indices.componentType =
+      TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+  accessor.sparse.indices.bufferView = AddView(
+      &model, std::vector<unsigned char>(indices, indices + 2));
+  accessor.sparse.values.bufferView = AddView(&model, value_bytes);
+  model.accessors.push_back(accessor);
+
+  std::vector<float> out;
+  std::string err;
+  CHECK(tinygltf::ReadAccessor(model, accessor, &out, &err));
+  std::vector<float> expected(18, 0.0f);
+  for (size_t c = 0; c < 3; c++) {
+    expected[2 * 3 + c] = values[c];
+    expected[5 * 3 + c] = values[3 + c];
+  }
+  CHECK(out == expected);
+
+  std::vector<unsigned char> dense;
+  CHECK(tinygltf::ResolveSparseAccessor(model, accessor, &dense, &err));
+  CHECK(dense.size() == sizeof(float) * 18 &&
+        memcmp(dense.data(), expected.data(), dense.size()) == 0);
+  CHECK(err.empty());
+}
+
+// Malformed sparse data fails with an error instead of writing out of range.
+void TestErrors() {
+  tinygltf::Model model;
+  const unsigned char indices[] = {1, 9};  // 9 >= count
+  const std::vector<unsigned char> values(8, 0);
+  tinygltf::Accessor accessor;
+  accessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+  accessor.type = TINYGLTF_TYPE_SCALAR;
+  accessor.count = 4;
+  accessor.sparse.isSparse = true;
+  accessor.sparse.indices.byteOffset = 0;
+  accessor.sparse.values.byteOffset = 0;
+  accessor.sparse.count = 2;
+  accessor.sparse.indices.componentType =
+      TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+  accessor.sparse.indices.bufferView = AddView(
+      &model, std::vector<unsigned char>(indices, indices + 2));
+  accessor.sparse.values.bufferView = AddView(&model, values);
+  model.accessors.push_back(accessor);
+
+  std::vector<unsigned char> dense;
+  std::string err;
+  CHECK(!tinygltf::ResolveSparseAccessor(model, accessor, &dense, &err));
+  CHECK(err.find("out of range") != std::string::npos);
+
+  tinygltf::Accessor bad = accessor;
+  bad.sparse.indices.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+  err.clear();
+  CHECK(!tinygltf::ResolveSparseAccessor(model, bad, &dense, &err));
+  CHECK(!err.empty());
+
+  bad = accessor;
+  bad.sparse.count = 5;  // more than accessor.count
+  err.clear();
+  CHECK(!tinygltf::ResolveSparseAccessor(model, bad, &dense, &err));
+  CHECK(!err.empty());
+
+  bad = accessor;
+  bad.sparse.values.byteOffset = 4;  // runs past the values bufferView
+  err.clear();
+  CHECK(!tinygltf::ResolveSparseAccessor(model, bad, &dense, &err));
+  CHECK(err.find("exceeds") != std::string::npos);
+
+  bad = accessor;
+  bad.sparse.values.bufferView = 7;
+  err.clear();
+  std::vector<float> floats;
+  CHECK(!tinygltf::ReadAccessor(model, bad, &floats, &err));
+  CHECK(!err.empty());
+
+  // The cache reports errors for each call and keeps nothing.
+  tinygltf::SparseAccessorCache cache(model);
+  err.clear();
+  CHECK(cache.Get(0, &err) == nullptr);
+  CHECK(!err.empty());
+  err.clear();
+  CHECK(cache.Get(1, &err) == nullptr);
+  CHECK(err.find("Invalid accessor index") != std::string::npos);
+  CHECK(cache.Get(-1) == nullptr);
+}
+
+}  // namespace
+
+int main() {
+  TestResolve();
+  TestReadImplicitZeros();
+  TestErrors();
+  return TestResult();
+}
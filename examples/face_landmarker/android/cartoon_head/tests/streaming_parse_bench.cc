@@ -0,0 +1,201 @@
+//
+// Peak RSS and wall time of LoadASCIIFromString() from the whole JSON DOM
+// against a streaming parse(TinyGLTF::SetStreamingParse), on generated
+// .gltf files:
+//
+//   nodes:     many nodes with names, transforms and extras.
+//   accessors: many accessors with min/max and their bufferViews.
+//   embedded:  one large buffer in a base64 data URI.
+//
+// Each load runs in a fresh process(re-exec of this binary), so ru_maxrss
+// is that load's peak. "read" only reads the file, as the baseline.
+//
+// Usage: streaming_parse_bench [scale] [runs]
+//
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "tiny_gltf.h"
+
+namespace {
+
+std::string Base64(size_t size) {
+  static const char kChars[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  out.reserve((size + 2) / 3 * 4);
+  for (size_t i = 0; i < size; i += 3) {
+    const unsigned v = unsigned(i * 2654435761u) & 0xffffff;
+    out += kChars[(v >> 18) & 63];
+    out += kChars[(v >> 12) & 63];
+    out += kChars[(v >> 6) & 63];
+    out += kChars[v & 63];
+  }
+  return out;
+}
+
+std::string NodesGltf(int scale) {
+  std::string json = R"({"asset": {"version": "2.0"}, "nodes": [)";
+  const int count = 20000 * scale;
+  for (int i = 0; i < count; i++) {
+    if (i) json += ",";
+    json += R"({"name": "joint)" + std::to_string(i) +
+            R"(", "translation": [0.5, )" + std::to_string(i) +
+            R"(, 0.25], "rotation": [0, 0, 0, 1], "extras": {"id": )" +
+            std::to_string(i) +
+            R"(, "tags": ["rig", "face"], "weight": 0.75}})";
+  }
+  json += R"(], "scenes": [{"nodes": [0]}]})";
+  return json;
+}
+
+std::string AccessorsGltf(int scale) {
+  const int count = 10000 * scale;
+  std::string json = R"({"asset": {"version": "2.0"},)";
+  json += R"("buffers": [{"byteLength": )" + std::to_string(count * 12) +
+          R"(, "uri": "data:application/octet-stream;base64,)" +
+          Base64(size_t(count) * 12) + R"("}], "bufferViews": [)";
+  for (int i = 0; i < count; i++) {
+    if (i) json += ",";
+    json += R"({"buffer": 0, "byteOffset": )" + std::to_string(i * 12) +
+            R"(, "byteLength": 12})";
+  }
+  json += R"(], "accessors": [)";
+  for (int i = 0; i < count; i++) {
+    if (i) json += ",";
+    json += R"({"bufferView": )" + std::to_string(i) +
+            R"(, "componentType": 5126, "count": 1, "type": "VEC3",)"
+            R"( "min": [-1.5, -2.5, -3.5], "max": [1.5, 2.5, 3.5]})";
+  }
+  json += "]}";
+  return json;
+}
+
+std::string EmbeddedGltf(int scale) {
+  const size_t size = size_t(4) * 1024 * 1024 * size_t(scale) / 3 * 3;
+  return R"({"asset": {"version": "2.0"}, "buffers": [{"byteLength": )" +
+         std::to_string(size) +
+         R"(, "uri": "data:application/octet-stream;base64,)" + Base64(size) +
+         R"("}]})";
+}
+
+// Child: loads `path` in `mode` and prints the load time in ms.
+int RunChild(const char *mode, const char *path) {
+  std::ifstream file(path, std::ios::binary);
+  const std::string json((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+  double ms = 0.0;
+  if (strcmp(mode, "read") != 0) {
+    tinygltf::TinyGLTF loader;
+    loader.SetStreamingParse(strcmp(mode, "stream") == 0);
+    tinygltf::Model model;
+    std::string err;
+    std::string warn;
+    const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    if (!loader.LoadASCIIFromString(&model, &err, &warn, json.c_str(),
+                                    static_cast<unsigned int>(json.size()),
+                                    "")) {
+      fprintf(stderr, "%s: %s\n", path, err.c_str());
+      return EXIT_FAILURE;
+    }
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    ms = elapsed.count();
+  }
+  printf("%f\n", ms);
+  return EXIT_SUCCESS;
+}
+
+struct Measurement {
+  double ms;
+  double peak_mb;
+};
+
+bool Measure(const char *self, const char *mode, const std::string &path,
+             Measurement *m) {
+  int fds[2];
+  if (pipe(fds) != 0) return false;
+  const pid_t pid = fork();
+  if (pid == 0) {
+    dup2(fds[1], STDOUT_FILENO);
+    close(fds[0]);
+    close(fds[1]);
+    execl(self, self, "--child", mode, path.c_str(),
+          static_cast<char *>(nullptr));
+    _exit(127);
+  }
+  close(fds[1]);
+  char out[64] = {};
+  const ssize_t n = read(fds[0], out, sizeof(out) - 1);
+  close(fds[0]);
+  int status = 0;
+  struct rusage usage;
+  if (pid < 0 || wait4(pid, &status, 0, &usage) != pid || n <= 0 ||
+      !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    return false;
+  }
+  m->ms = atof(out);
+  m->peak_mb = double(usage.ru_maxrss) / 1024.0;  // KiB on Linux
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc == 4 && strcmp(argv[1], "--child") == 0) {
+    return RunChild(argv[2], argv[3]);
+  }
+  const int scale = argc > 1 ? atoi(argv[1]) : 10;
+  const int runs = argc > 2 ? atoi(argv[2]) : 3;
+
+  struct Asset {
+    const char *name;
+    std::string (*make)(int);
+  };
+  const Asset assets[] = {{"nodes", NodesGltf},
+                          {"accessors", AccessorsGltf},
+                          {"embedded", EmbeddedGltf}};
+  const char *const modes[] = {"read", "dom", "stream"};
+
+  printf("%-10s %8s %-7s %10s %12s\n", "asset", "MB", "mode", "best ms",
+         "peak RSS MB");
+  for (const Asset &asset : assets) {
+    const std::string path =
+        std::string("streaming_parse_bench_") + asset.name + ".gltf";
+    size_t size = 0;
+    {
+      const std::string json = asset.make(scale);
+      size = json.size();
+      std::ofstream(path, std::ios::binary) << json;
+    }
+    for (const char *mode : modes) {
+      Measurement best = {1e30, 0.0};
+      for (int r = 0; r < runs; r++) {
+        Measurement m;
+        if (!Measure(argv[0], mode, path, &m)) {
+          fprintf(stderr, "%s %s failed\n", asset.name, mode);
+          return EXIT_FAILURE;
+        }
+        best.ms = std::min(best.ms, m.ms);
+        best.peak_mb = std::max(best.peak_mb, m.peak_mb);
+      }
+      printf("%-10s %8.1f %-7s %10.1f %12.1f\n", asset.name,
+             double(size) / (1024.0 * 1024.0), mode, best.ms, best.peak_mb);
+    }
+    remove(path.c_str());
+  }
+  return EXIT_SUCCESS;
+}
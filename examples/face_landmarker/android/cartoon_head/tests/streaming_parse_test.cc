@@ -0,0 +1,250 @@
+//
+// Loads with a streaming parse(TinyGLTF::SetStreamingParse) give the same
+// Model as loads from the whole JSON DOM, whatever the order of the
+// top-level members, and fail on the same input.
+//
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tiny_gltf.h"
+#include "test_util.h"
+
+namespace {
+
+// "images" come before "bufferViews" and "buffers", and "scenes" after
+// "meshes" and "skins". The buffer holds bytes 0..63.
+const char kReversedGltf[] = R"({
+  "images": [
+    {"bufferView": 1, "mimeType": "image/png", "name": "in_buffer"},
+    {"uri": "data:image/png;base64,YWJjZA==", "extras": {"k": [1, 2]}}],
+  "textures": [{"source": 0, "sampler": 0}, {"source": 1}],
+  "materials": [{"name": "skin",
+    "pbrMetallicRoughness": {"baseColorTexture": {"index": 1}}}],
+  "meshes": [
+    {"name": "face", "primitives": [{"attributes": {"POSITION": 0},
+                                     "indices": 1, "material": 0}]},
+    {"name": "unused", "primitives": [{"attributes": {"POSITION": 0}}]}],
+  "skins": [{"joints": [1], "inverseBindMatrices": 2}],
+  "animations": [{"samplers": [{"input": 2, "output": 2}],
+                  "channels": [{"sampler": 0,
+                                "target": {"node": 1, "path": "scale"}}]}],
+  "accessors": [
+    {"bufferView": 0, "componentType": 5126, "count": 2, "type": "VEC3",
+     "min": [0, 0, 0], "max": [1, 1, 1]},
+    {"bufferView": 0, "componentType": 5123, "count": 3, "type": "SCALAR"},
+    {"bufferView": 0, "componentType": 5126, "count": 1, "type": "MAT4"}],
+  "bufferViews": [{"buffer": 0, "byteLength": 48},
+                  {"buffer": 0, "byteOffset": 48, "byteLength": 16}],
+  "buffers": [{"byteLength": 64,
+    "uri": "data:application/octet-stream;base64,AAECAwQFBgcICQoLDA0ODxAREhMUFRYXGBkaGxwdHh8gISIjJCUmJygpKissLS4vMDEyMzQ1Njc4OTo7PD0+Pw=="}],
+  "samplers": [{"magFilter": 9728}],
+  "cameras": [{"type": "perspective",
+               "perspective": {"yfov": 1, "znear": 0.1}}],
+  "nodes": [{"mesh": 0, "skin": 0, "children": [1]}, {"camera": 0},
+            {"mesh": 1}],
+  "scenes": [{"nodes": [0]}, {"nodes": [2]}],
+  "scene": 0,
+  "extensions": {"KHR_lights_punctual": {"lights": [{"type": "point"}]}},
+  "extras": {"exporter": {"version": [1, 0]}},
+  "asset": {"version": "2.0"}
+})";
+
+// Keeps the encoded bytes as a 1 x size image, so no PNG is needed.
+bool CopyImageLoader(tinygltf::Image *image, const int, std::string *,
+                     std::string *, int, int, const unsigned char *bytes,
+                     int size, void *) {
+  image->width = size;
+  image->height = 1;
+  image->component = 1;
+  image->bits = 8;
+  image->pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+  image->image.assign(bytes, bytes + size);
+  return true;
+}
+
+std::string ToGltf(const tinygltf::Model &model) {
+  tinygltf::TinyGLTF writer;
+  std::ostringstream out;
+  writer.WriteGltfSceneToStream(&model, out, false, false);
+  return out.str();
+}
+
+struct Result {
+  bool ok = false;
+  std::string err;
+  tinygltf::Model model;
+};
+
+Result Load(tinygltf::TinyGLTF *loader, bool streaming,
+            const std::string &json) {
+  loader->SetStreamingParse(streaming);
+  Result result;
+  std::string warn;
+  result.ok = loader->LoadASCIIFromString(
+      &result.model, &result.err, &warn, json.c_str(),
+      static_cast<unsigned int>(json.size()), "",
+      tinygltf::REQUIRE_VERSION | tinygltf::REQUIRE_SCENES |
+          tinygltf::REQUIRE_ACCESSORS | tinygltf::REQUIRE_BUFFERS);
+  return result;
+}
+
+// Loads `json` both ways and checks that they agree. Returns the streamed
+// result.
+Result LoadBothWays(tinygltf::TinyGLTF *loader, const std::string &json) {
+  Result dom = Load(loader, false, json);
+  Result streamed = Load(loader, true, json);
+  CHECK(streamed.ok == dom.ok);
+  CHECK(streamed.err.empty() == dom.err.empty());
+  if (dom.ok) {
+    CHECK(streamed.model == dom.model);
+    CHECK(ToGltf(streamed.model) == ToGltf(dom.model));
+  }
+  return streamed;
+}
+
+void TestReversedMembers() {
+  tinygltf::TinyGLTF loader;
+  loader.SetImageLoader(CopyImageLoader, nullptr);
+  loader.SetStoreOriginalJSONForExtrasAndExtensions(true);
+  Result r = LoadBothWays(&loader, kReversedGltf);
+  CHECK(r.ok);
+  CHECK(r.model.buffers.size() == 1 && r.model.buffers[0].data.size() == 64);
+  CHECK(r.model.images.size() == 2);
+  // Decoded from the bufferView even though "images" came first.
+  const std::vector<unsigned char> in_buffer = {48, 49, 50, 51, 52, 53,
+                                                54, 55, 56, 57, 58, 59,
+                                                60, 61, 62, 63};
+  CHECK(r.model.images[0].image == in_buffer);
+  CHECK(r.model.images[1].image ==
+        std::vector<unsigned char>({'a', 'b', 'c', 'd'}));
+  CHECK(r.model.bufferViews[0].target == TINYGLTF_TARGET_ARRAY_BUFFER);
+  CHECK(r.model.lights.size() == 1 && r.model.cameras.size() == 1);
+  CHECK(r.model.extras.Has("exporter"));
+  CHECK(!r.model.images[1].extras_json_string.empty());
+
+  // Deferred image decoding, and a scene filter, under which meshes and
+  // skins are converted from the DOM.
+  loader.SetImageLoadingThreads(4);
+  tinygltf::LoadFilter filter;
+  filter.scene = 0;
+  loader.SetLoadFilter(filter);
+  r = LoadBothWays(&loader, kReversedGltf);
+  CHECK(r.ok);
+  CHECK(r.model.images[0].image == in_buffer);
+  CHECK(r.model.meshes[0].primitives.size() == 1);
+  CHECK(r.model.meshes[1].primitives.empty());
+}
+
+// Elements with a data URI of 1 MiB or more are converted after parsing,
+// along with the rest of their section.
+void TestLargeDataUri() {
+  const std::string large(2 * 1024 * 1024, 'A');  // base64 of zeros
+  const std::string json =
+      R"({"asset": {"version": "2.0"}, "buffers": [
+        {"byteLength": 3, "uri": "data:application/octet-stream;base64,YWJj"},
+        {"byteLength": )" +
+      std::to_string(large.size() / 4 * 3) +
+      R"(, "uri": "data:application/octet-stream;base64,)" + large + R"("},
+        {"byteLength": 1, "uri": "data:application/octet-stream;base64,eg=="}],
+      "bufferViews": [{"buffer": 2, "byteLength": 1}]})";
+  tinygltf::TinyGLTF loader;
+  loader.SetStreamingParse(true);
+  tinygltf::Model model;
+  std::string err;
+  std::string warn;
+  CHECK(loader.LoadASCIIFromString(&model, &err, &warn, json.c_str(),
+                                   static_cast<unsigned int>(json.size()),
+                                   ""));
+  CHECK(model.buffers.size() == 3);
+  CHECK(model.buffers[0].data == std::vector<unsigned char>({'a', 'b', 'c'}));
+  CHECK(model.buffers[1].data.size() == large.size() / 4 * 3);
+  CHECK(model.buffers[2].data == std::vector<unsigned char>({'z'}));
+  loader.SetStreamingParse(false);
+  tinygltf::Model dom;
+  CHECK(loader.LoadASCIIFromString(&dom, &err, &warn, json.c_str(),
+                                   static_cast<unsigned int>(json.size()),
+                                   ""));
+  CHECK(model == dom);
+}
+
+void TestGlb() {
+  tinygltf::TinyGLTF loader;
+  tinygltf::Model model;
+  model.asset.version = "2.0";
+  tinygltf::Buffer buffer;
+  buffer.data.assign(256, 7);
+  model.buffers.push_back(buffer);
+  tinygltf::BufferView view;
+  view.buffer = 0;
+  view.byteLength = 256;
+  model.bufferViews.push_back(view);
+  tinygltf::Image image;
+  image.width = 4;
+  image.height = 4;
+  image.component = 4;
+  image.bits = 8;
+  image.pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+  image.mimeType = "image/png";
+  image.image.assign(64, 200);
+  model.images.push_back(image);
+  tinygltf::Accessor accessor;
+  accessor.bufferView = 0;
+  accessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+  accessor.type = TINYGLTF_TYPE_SCALAR;
+  accessor.count = 64;
+  model.accessors.push_back(accessor);
+  model.nodes.resize(1);
+  model.nodes[0].name = "root";
+  tinygltf::Scene scene;
+  scene.nodes = {0};
+  model.scenes.push_back(scene);
+  std::ostringstream out;
+  CHECK(loader.WriteGltfSceneToStream(&model, out, false, true));
+  const std::string glb = out.str();
+
+  tinygltf::Model loaded[2];
+  std::string err;
+  std::string warn;
+  for (int streaming = 0; streaming < 2; streaming++) {
+    loader.SetStreamingParse(streaming != 0);
+    CHECK(loader.LoadBinaryFromMemory(
+        &loaded[streaming], &err, &warn,
+        reinterpret_cast<const unsigned char *>(glb.data()),
+        static_cast<unsigned int>(glb.size())));
+  }
+  CHECK(loaded[0] == loaded[1]);
+  CHECK(loaded[1].images.size() == 1 &&
+        loaded[1].images[0].image == image.image);
+}
+
+void TestBadInput() {
+  tinygltf::TinyGLTF loader;
+  const std::string asset = R"("asset": {"version": "2.0"}, "scenes": [{}])";
+  // Elements that are not objects, in streamed sections.
+  CHECK(!LoadBothWays(&loader, "{" + asset + R"(, "accessors": [1]})").ok);
+  CHECK(!LoadBothWays(&loader, "{" + asset + R"(, "nodes": [{}, []]})").ok);
+  // Sections that are not arrays are ignored, then fail REQUIRE_BUFFERS.
+  Result r = LoadBothWays(
+      &loader, "{" + asset + R"(, "accessors": [], "buffers": {}})");
+  CHECK(!r.ok && r.err.find("buffers") != std::string::npos);
+  // Malformed JSON, inside a streamed element and elsewhere.
+  CHECK(!LoadBothWays(&loader, "{" + asset + R"(, "buffers": [{]})").ok);
+  CHECK(!LoadBothWays(&loader, "{" + asset + R"(, "buffers": [], })").ok);
+  CHECK(!LoadBothWays(&loader, "{" + asset + R"(, "buffers": []} x)").ok);
+  CHECK(!LoadBothWays(&loader, R"([{"buffers": []}])").ok);
+  // Streamed sections count as present for REQUIRE_*.
+  r = LoadBothWays(&loader, "{" + asset +
+                                R"(, "buffers": [], "accessors": []})");
+  CHECK(r.ok);
+}
+
+}  // namespace
+
+int main() {
+  TestReversedMembers();
+  TestLargeDataUri();
+  TestGlb();
+  TestBadInput();
+  return TestResult();
+}
@@ -0,0 +1,27 @@
+//
+// Just enough of the NDK's <android/asset_manager.h> for examples/glview.
+//
+#ifndef TINYGLTF_TEST_STUBS_ASSET_MANAGER_H_
+#define TINYGLTF_TEST_STUBS_ASSET_MANAGER_H_
+
+#include <cstddef>
+#include <sys/types.h>
+
+struct AAssetManager;
+struct AAsset;
+
+enum {
+  AASSET_MODE_UNKNOWN,
+  AASSET_MODE_RANDOM,
+  AASSET_MODE_STREAMING,
+  AASSET_MODE_BUFFER
+};
+
+AAsset *AAssetManager_open(AAssetManager *mgr, const char *filename,
+                           int mode);
+off_t AAsset_getLength(AAsset *asset);
+int AAsset_read(AAsset *asset, void *buf, size_t count);
+const void *AAsset_getBuffer(AAsset *asset);
+void AAsset_close(AAsset *asset);
+
+#endif  // TINYGLTF_TEST_STUBS_ASSET_MANAGER_H_
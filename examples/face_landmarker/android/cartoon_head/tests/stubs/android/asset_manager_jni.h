@@ -0,0 +1,12 @@
+//
+// Just enough of the NDK's <android/asset_manager_jni.h> for examples/glview.
+//
+#ifndef TINYGLTF_TEST_STUBS_ASSET_MANAGER_JNI_H_
+#define TINYGLTF_TEST_STUBS_ASSET_MANAGER_JNI_H_
+
+#include <jni.h>
+#include <android/asset_manager.h>
+
+AAssetManager *AAssetManager_fromJava(JNIEnv *env, jobject asset_manager);
+
+#endif  // TINYGLTF_TEST_STUBS_ASSET_MANAGER_JNI_H_
@@ -0,0 +1,11 @@
+//
+// Just enough of the NDK's <android/log.h> for examples/glview.
+//
+#ifndef TINYGLTF_TEST_STUBS_LOG_H_
+#define TINYGLTF_TEST_STUBS_LOG_H_
+
+enum { ANDROID_LOG_INFO = 4, ANDROID_LOG_WARN, ANDROID_LOG_ERROR };
+
+int __android_log_print(int prio, const char *tag, const char *fmt, ...);
+
+#endif  // TINYGLTF_TEST_STUBS_LOG_H_
@@ -0,0 +1,36 @@
+//
+// Just enough of the NDK's <jni.h> to compile examples/glview on a host.
+// The JNIEnv methods are defined in glview_stubs.cc.
+//
+#ifndef TINYGLTF_TEST_STUBS_JNI_H_
+#define TINYGLTF_TEST_STUBS_JNI_H_
+
+#define JNIEXPORT
+#define JNICALL
+
+typedef int jint;
+typedef jint jsize;
+typedef float jfloat;
+typedef long long jlong;
+
+struct _jobject {};
+typedef _jobject *jobject;
+typedef jobject jclass;
+typedef jobject jstring;
+typedef jobject jfloatArray;
+typedef void *jmethodID;
+
+struct JNIEnv {
+  jclass GetObjectClass(jobject obj);
+  jmethodID GetMethodID(jclass clazz, const char *name, const char *sig);
+  jint CallIntMethod(jobject obj, jmethodID method, ...);
+  jobject CallObjectMethod(jobject obj, jmethodID method, ...);
+  const char *GetStringUTFChars(jstring str, void *is_copy);
+  void ReleaseStringUTFChars(jstring str, const char *chars);
+  void DeleteLocalRef(jobject obj);
+  jsize GetArrayLength(jobject array);
+  void GetFloatArrayRegion(jfloatArray array, jsize start, jsize len,
+                           jfloat *buf);
+};
+
+#endif  // TINYGLTF_TEST_STUBS_JNI_H_
@@ -0,0 +1,30 @@
+//
+// Minimal helpers shared by the host tests.
+//
+#ifndef TINYGLTF_TEST_UTIL_H_
+#define TINYGLTF_TEST_UTIL_H_
+
+#include <cstdio>
+
+static int test_failures = 0;
+
+// Records a failure and keeps going, so one run reports every failed check.
+#define CHECK(cond)                                                 \
+  do {                                                              \
+    if (!(cond)) {                                                  \
+      fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, \
+              #cond);                                               \
+      test_failures++;                                              \
+    }                                                               \
+  } while (0)
+
+// Value for main() to return.
+static inline int TestResult() {
+  if (test_failures > 0) {
+    fprintf(stderr, "%d check(s) failed.\n", test_failures);
+    return 1;
+  }
+  return 0;
+}
+
+#endif  // TINYGLTF_TEST_UTIL_H_
@@ -0,0 +1,103 @@
+//
+// Heap kept by a loaded Model whose meshes carry extras-heavy tinygltf::Value
+// trees: every mesh has the 52 ARKit-style blendshape names in
+// extras.targetNames, and every node a small extras object. Reports the heap
+// in use after LoadASCIIFromString(), minus the heap before it, so the JSON
+// text itself is not counted.
+//
+// Values use the standard allocator. A per-Model arena is out of scope: the
+// Model's members are std containers with the default allocator.
+//
+// Usage: value_memory_bench [meshes] [runs]
+//
+#include <malloc.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "tiny_gltf.h"
+
+namespace {
+
+// Bytes handed out by malloc and not yet freed, or -1 when unknown.
+double HeapInUse() {
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  return double(mallinfo2().uordblks);
+#else
+  return -1.0;
+#endif
+}
+
+std::string MakeGltf(int meshes) {
+  std::string names;
+  for (int t = 0; t < 52; t++) {
+    if (t) names += ", ";
+    names += "\"blendshape" + std::to_string(t) + "\"";
+  }
+  std::string json = R"({"asset": {"version": "2.0"},)"
+                     R"( "accessors": [{"componentType": 5126, "count": 1,)"
+                     R"( "type": "VEC3"}], "meshes": [)";
+  for (int i = 0; i < meshes; i++) {
+    if (i) json += ",";
+    json += R"({"name": "mesh)" + std::to_string(i) +
+            R"(", "primitives": [{"attributes": {"POSITION": 0}}],)"
+            R"( "extras": {"targetNames": [)" +
+            names + "]}}";
+  }
+  json += R"(], "nodes": [)";
+  for (int i = 0; i < meshes; i++) {
+    if (i) json += ",";
+    json += R"({"mesh": )" + std::to_string(i) +
+            R"(, "extras": {"id": )" + std::to_string(i) +
+            R"(, "rig": {"side": "left", "weight": 0.5}}})";
+  }
+  json += "]}";
+  return json;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const int meshes = argc > 1 ? atoi(argv[1]) : 20000;
+  const int runs = argc > 2 ? atoi(argv[2]) : 3;
+
+  const std::string json = MakeGltf(meshes);
+  double best_ms = 1e30;
+  double retained = 0.0;
+  for (int r = 0; r < runs; r++) {
+    tinygltf::TinyGLTF loader;
+    std::string err;
+    std::string warn;
+    const double before = HeapInUse();
+    const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    tinygltf::Model model;
+    if (!loader.LoadASCIIFromString(&model, &err, &warn, json.c_str(),
+                                    static_cast<unsigned int>(json.size()),
+                                    "")) {
+      fprintf(stderr, "load failed: %s\n", err.c_str());
+      return EXIT_FAILURE;
+    }
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best_ms = std::min(best_ms, elapsed.count());
+    retained = HeapInUse() - before;
+  }
+
+  printf("sizeof(Value)      %zu bytes\n", sizeof(tinygltf::Value));
+  printf("meshes             %d\n", meshes);
+  printf("JSON               %.1f MB\n",
+         double(json.size()) / (1024.0 * 1024.0));
+  printf("best load          %.1f ms\n", best_ms);
+  if (HeapInUse() >= 0.0) {
+    printf("retained heap      %.1f MB(%.0f bytes per mesh and node)\n",
+           retained / (1024.0 * 1024.0), retained / double(meshes));
+  } else {
+    printf("retained heap      n/a(needs glibc 2.33+)\n");
+  }
+  return EXIT_SUCCESS;
+}
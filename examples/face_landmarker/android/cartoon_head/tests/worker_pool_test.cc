@@ -0,0 +1,51 @@
+//
+// WorkerPool from examples/glview: every job of every batch runs exactly
+// once, and batches don't overlap.
+//
+#include <atomic>
+#include <vector>
+
+#include "worker_pool.h"
+#include "test_util.h"
+
+namespace {
+
+struct Batch {
+  std::vector<std::atomic<int> > runs;
+  std::atomic<int> total{0};
+  explicit Batch(size_t count) : runs(count) {
+    for (size_t j = 0; j < count; j++) runs[j] = 0;
+  }
+};
+
+void CountJob(void *context, size_t job) {
+  Batch *batch = static_cast<Batch *>(context);
+  batch->runs[job]++;
+  batch->total++;
+}
+
+}  // namespace
+
+int main() {
+  // Inline before Start().
+  WorkerPool pool;
+  Batch inline_batch(5);
+  pool.Run(CountJob, &inline_batch, 5);
+  CHECK(inline_batch.total == 5);
+
+  pool.Start(3);
+  CHECK(pool.ThreadCount() == 3);
+  pool.Start(8);  // already started
+  CHECK(pool.ThreadCount() == 3);
+
+  const size_t counts[] = {0, 1, 2, 3, 4, 7, 64};
+  for (int frame = 0; frame < 2000; frame++) {
+    const size_t count = counts[size_t(frame) % 7];
+    Batch batch(count);
+    pool.Run(CountJob, &batch, count);
+    // Run() returns only after every job finished.
+    CHECK(batch.total == int(count));
+    for (size_t j = 0; j < count; j++) CHECK(batch.runs[j] == 1);
+  }
+  return TestResult();
+}
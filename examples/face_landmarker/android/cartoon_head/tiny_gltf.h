@@ -37,15 +37,20 @@
 #ifndef TINY_GLTF_H_
 #define TINY_GLTF_H_
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cmath>  // std::fabs
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <initializer_list>
 #include <limits>
 #include <map>
+#include <memory>
+#include <new>
 #include <string>
+#include <utility>
 #include <vector>
 
 // Auto-detect C++14 standard version
@@ -244,6 +249,45 @@ static inline int32_t GetNumComponentsInType(uint32_t ty) {
   }
 }
 
+// Number of columns of a matrix type; 1 for scalars and vectors.
+static inline int32_t GetNumColumnsInType(uint32_t ty) {
+  if (ty == TINYGLTF_TYPE_MAT2) {
+    return 2;
+  } else if (ty == TINYGLTF_TYPE_MAT3) {
+    return 3;
+  } else if (ty == TINYGLTF_TYPE_MAT4) {
+    return 4;
+  } else {
+    return 1;
+  }
+}
+
+// Bytes from one matrix column to the next. glTF starts every column on a
+// 4-byte boundary, so MAT2/MAT3 of 1-byte and MAT3 of 2-byte components are
+// padded. For scalars and vectors this is the size of the element.
+// Returns -1 for an unknown type or componentType.
+static inline int32_t GetColumnStrideInBytes(uint32_t componentType,
+                                             uint32_t ty) {
+  const int32_t component_size = GetComponentSizeInBytes(componentType);
+  const int32_t components = GetNumComponentsInType(ty);
+  if (component_size <= 0 || components <= 0) {
+    return -1;
+  }
+  const int32_t rows = components / GetNumColumnsInType(ty);
+  const int32_t bytes = rows * component_size;
+  return (ty == TINYGLTF_TYPE_MAT2 || ty == TINYGLTF_TYPE_MAT3)
+             ? (bytes + 3) & ~3
+             : bytes;
+}
+
+// Size of one element including matrix column padding.
+// Returns -1 for an unknown type or componentType.
+static inline int32_t GetElementSizeInBytes(uint32_t componentType,
+                                            uint32_t ty) {
+  const int32_t column_stride = GetColumnStrideInBytes(componentType, ty);
+  return column_stride <= 0 ? -1 : column_stride * GetNumColumnsInType(ty);
+}
+
 // TODO(syoyo): Move these functions to TinyGLTF class
 bool IsDataURI(const std::string &in);
 bool DecodeDataURI(std::vector<unsigned char> *out, std::string &mime_type,
@@ -257,41 +301,158 @@ bool DecodeDataURI(std::vector<unsigned char> *out, std::string &mime_type,
 #endif
 
 // Simple class to represent JSON object
+//
+// Only the member matching Type() is alive, so a Value is as large as its
+// largest alternative rather than all of them together. Objects are a vector
+// sorted by key, which is one allocation per object instead of one per
+// member.
 class Value {
  public:
   typedef std::vector<Value> Array;
-  typedef std::map<std::string, Value> Object;
 
-  Value() = default;
+  // (key, Value) pairs sorted by key. Provides the std::map subset tinygltf
+  // users rely on (find/count/operator[]/emplace/erase, iteration in key
+  // order). Iterators are invalidated by insertion and erasure.
+  class Object {
+   public:
+    typedef std::string key_type;
+    typedef Value mapped_type;
+    typedef std::pair<std::string, Value> value_type;
+    typedef std::vector<value_type>::iterator iterator;
+    typedef std::vector<value_type>::const_iterator const_iterator;
+    typedef size_t size_type;
+
+    Object() = default;
+    Object(std::initializer_list<value_type> items) {
+      items_.reserve(items.size());
+      for (const value_type &v : items) insert(v);
+    }
+    template <typename InputIt>
+    Object(InputIt first, InputIt last) {
+      for (; first != last; ++first) insert(*first);
+    }
+    DEFAULT_METHODS(Object)
+
+    iterator begin() { return items_.begin(); }
+    iterator end() { return items_.end(); }
+    const_iterator begin() const { return items_.begin(); }
+    const_iterator end() const { return items_.end(); }
+    const_iterator cbegin() const { return items_.begin(); }
+    const_iterator cend() const { return items_.end(); }
+
+    size_t size() const { return items_.size(); }
+    bool empty() const { return items_.empty(); }
+    void clear() { items_.clear(); }
+    void reserve(size_t n) { items_.reserve(n); }
+
+    iterator find(const std::string &key) {
+      iterator it = LowerBound(key);
+      return (it != items_.end() && it->first == key) ? it : items_.end();
+    }
+    const_iterator find(const std::string &key) const {
+      const_iterator it = LowerBound(key);
+      return (it != items_.end() && it->first == key) ? it : items_.end();
+    }
+    size_t count(const std::string &key) const {
+      return (find(key) != end()) ? 1 : 0;
+    }
+
+    // Does nothing when `key` exists. Keys arriving in sorted order (as
+    // nlohmann::json delivers them) are appended in O(1).
+    std::pair<iterator, bool> emplace(std::string key, Value value) {
+      iterator it = (items_.empty() || items_.back().first < key)
+                        ? items_.end()
+                        : LowerBound(key);
+      if (it != items_.end() && it->first == key) {
+        return std::make_pair(it, false);
+      }
+      it = items_.insert(it, value_type(std::move(key), std::move(value)));
+      return std::make_pair(it, true);
+    }
+    std::pair<iterator, bool> insert(const value_type &v) {
+      return emplace(v.first, v.second);
+    }
+
+    Value &operator[](const std::string &key) {
+      iterator it = find(key);
+      return (it != items_.end()) ? it->second
+                                  : emplace(key, Value()).first->second;
+    }
+
+    size_t erase(const std::string &key) {
+      iterator it = find(key);
+      if (it == items_.end()) return 0;
+      items_.erase(it);
+      return 1;
+    }
+    iterator erase(const_iterator it) {
+      return items_.erase(items_.begin() + (it - items_.cbegin()));
+    }
+
+   private:
+    static bool KeyLess(const value_type &a, const std::string &key) {
+      return a.first < key;
+    }
+    iterator LowerBound(const std::string &key) {
+      return std::lower_bound(items_.begin(), items_.end(), key, KeyLess);
+    }
+    const_iterator LowerBound(const std::string &key) const {
+      return std::lower_bound(items_.begin(), items_.end(), key, KeyLess);
+    }
 
-  explicit Value(bool b) : type_(BOOL_TYPE) { boolean_value_ = b; }
+    std::vector<value_type> items_;
+  };
+
+  Value() : type_(NULL_TYPE) {}
+
+  explicit Value(bool b) : type_(BOOL_TYPE), boolean_value_(b) {}
   explicit Value(int i) : type_(INT_TYPE) {
-    int_value_ = i;
-    real_value_ = i;
+    number_.int_value = i;
+    number_.real_value = i;
   }
-  explicit Value(double n) : type_(REAL_TYPE) { real_value_ = n; }
-  explicit Value(const std::string &s) : type_(STRING_TYPE) {
-    string_value_ = s;
+  explicit Value(double n) : type_(REAL_TYPE) {
+    number_.int_value = 0;
+    number_.real_value = n;
   }
+  explicit Value(const std::string &s) : type_(STRING_TYPE), string_value_(s) {}
   explicit Value(std::string &&s)
       : type_(STRING_TYPE), string_value_(std::move(s)) {}
-  explicit Value(const char *s) : type_(STRING_TYPE) { string_value_ = s; }
-  explicit Value(const unsigned char *p, size_t n) : type_(BINARY_TYPE) {
-    binary_value_.resize(n);
-    memcpy(binary_value_.data(), p, n);
-  }
+  explicit Value(const char *s) : type_(STRING_TYPE), string_value_(s) {}
+  explicit Value(const unsigned char *p, size_t n)
+      : type_(BINARY_TYPE), binary_value_(p, p + n) {}
   explicit Value(std::vector<unsigned char> &&v) noexcept
       : type_(BINARY_TYPE),
         binary_value_(std::move(v)) {}
-  explicit Value(const Array &a) : type_(ARRAY_TYPE) { array_value_ = a; }
+  explicit Value(const Array &a) : type_(ARRAY_TYPE), array_value_(a) {}
   explicit Value(Array &&a) noexcept : type_(ARRAY_TYPE),
                                        array_value_(std::move(a)) {}
 
-  explicit Value(const Object &o) : type_(OBJECT_TYPE) { object_value_ = o; }
+  explicit Value(const Object &o) : type_(OBJECT_TYPE), object_value_(o) {}
   explicit Value(Object &&o) noexcept : type_(OBJECT_TYPE),
                                         object_value_(std::move(o)) {}
 
-  DEFAULT_METHODS(Value)
+  ~Value() { Reset(); }
+  Value(const Value &other) : type_(NULL_TYPE) { CopyFrom(other); }
+  Value(Value &&other) TINYGLTF_NOEXCEPT : type_(NULL_TYPE) {
+    MoveFrom(std::move(other));
+  }
+  // Goes through a temporary, since `other` may live inside this Value.
+  Value &operator=(const Value &other) {
+    if (this != &other) {
+      Value tmp(other);
+      Reset();
+      MoveFrom(std::move(tmp));
+    }
+    return *this;
+  }
+  Value &operator=(Value &&other) TINYGLTF_NOEXCEPT {
+    if (this != &other) {
+      Value tmp(std::move(other));
+      Reset();
+      MoveFrom(std::move(tmp));
+    }
+    return *this;
+  }
 
   char Type() const { return static_cast<char>(type_); }
 
@@ -314,20 +475,22 @@ class Value {
   // Use this function if you want to have number value as double.
   double GetNumberAsDouble() const {
     if (type_ == INT_TYPE) {
-      return double(int_value_);
-    } else {
-      return real_value_;
+      return double(number_.int_value);
+    } else if (type_ == REAL_TYPE) {
+      return number_.real_value;
     }
+    return 0.0;
   }
 
   // Use this function if you want to have number value as int.
   // TODO(syoyo): Support int value larger than 32 bits
   int GetNumberAsInt() const {
     if (type_ == REAL_TYPE) {
-      return int(real_value_);
-    } else {
-      return int_value_;
+      return int(number_.real_value);
+    } else if (type_ == INT_TYPE) {
+      return number_.int_value;
     }
+    return 0;
   }
   
   std::string GetStringVal() const {
@@ -338,6 +501,10 @@ class Value {
   }
 
   // Accessor
+  // Get<double>() and Get<int>() accept either number type. For a Value of
+  // another type, the const Get<T>() returns a default-constructed T. The
+  // non-const one asserts; in NDEBUG builds it first turns this Value into a
+  // default T, so the returned reference always points into this Value.
   template <typename T>
   const T &Get() const;
   template <typename T>
@@ -348,7 +515,7 @@ class Value {
     static Value null_value;
     assert(IsArray());
     assert(idx >= 0);
-    return (static_cast<size_t>(idx) < array_value_.size())
+    return (IsArray() && static_cast<size_t>(idx) < array_value_.size())
                ? array_value_[static_cast<size_t>(idx)]
                : null_value;
   }
@@ -357,6 +524,7 @@ class Value {
   const Value &Get(const std::string &key) const {
     static Value null_value;
     assert(IsObject());
+    if (!IsObject()) return null_value;
     Object::const_iterator it = object_value_.find(key);
     return (it != object_value_.end()) ? it->second : null_value;
   }
@@ -378,6 +546,7 @@ class Value {
     std::vector<std::string> keys;
     if (!IsObject()) return keys;  // empty
 
+    keys.reserve(object_value_.size());
     for (Object::const_iterator it = object_value_.begin();
          it != object_value_.end(); ++it) {
       keys.push_back(it->first);
@@ -386,42 +555,130 @@ class Value {
     return keys;
   }
 
-  size_t Size() const { return (IsArray() ? ArrayLen() : Keys().size()); }
+  size_t Size() const {
+    return IsArray() ? ArrayLen() : (IsObject() ? object_value_.size() : 0);
+  }
 
   bool operator==(const tinygltf::Value &other) const;
 
  protected:
-  int type_ = NULL_TYPE;
-
-  int int_value_ = 0;
-  double real_value_ = 0.0;
-  std::string string_value_;
-  std::vector<unsigned char> binary_value_;
-  Array array_value_;
-  Object object_value_;
-  bool boolean_value_ = false;
+  struct Number {
+    double real_value;
+    int int_value;
+  };
+
+  template <typename T>
+  static const T &NullValue() {
+    static const T null_value{};
+    return null_value;
+  }
+  template <typename T>
+  static void Destroy(T &v) {
+    v.~T();
+  }
+
+  void Reset() {
+    switch (type_) {
+      case STRING_TYPE:
+        Destroy(string_value_);
+        break;
+      case BINARY_TYPE:
+        Destroy(binary_value_);
+        break;
+      case ARRAY_TYPE:
+        Destroy(array_value_);
+        break;
+      case OBJECT_TYPE:
+        Destroy(object_value_);
+        break;
+      default:
+        break;
+    }
+    type_ = NULL_TYPE;
+  }
+
+  // Both expect this Value to be NULL_TYPE.
+  void CopyFrom(const Value &other) {
+    switch (other.type_) {
+      case STRING_TYPE:
+        new (&string_value_) std::string(other.string_value_);
+        break;
+      case BINARY_TYPE:
+        new (&binary_value_) std::vector<unsigned char>(other.binary_value_);
+        break;
+      case ARRAY_TYPE:
+        new (&array_value_) Array(other.array_value_);
+        break;
+      case OBJECT_TYPE:
+        new (&object_value_) Object(other.object_value_);
+        break;
+      case BOOL_TYPE:
+        boolean_value_ = other.boolean_value_;
+        break;
+      case INT_TYPE:
+      case REAL_TYPE:
+        number_ = other.number_;
+        break;
+      default:
+        break;
+    }
+    type_ = other.type_;
+  }
+  void MoveFrom(Value &&other) {
+    switch (other.type_) {
+      case STRING_TYPE:
+        new (&string_value_) std::string(std::move(other.string_value_));
+        break;
+      case BINARY_TYPE:
+        new (&binary_value_)
+            std::vector<unsigned char>(std::move(other.binary_value_));
+        break;
+      case ARRAY_TYPE:
+        new (&array_value_) Array(std::move(other.array_value_));
+        break;
+      case OBJECT_TYPE:
+        new (&object_value_) Object(std::move(other.object_value_));
+        break;
+      default:
+        CopyFrom(other);
+        break;
+    }
+    type_ = other.type_;
+  }
+
+  int type_;
+  union {
+    bool boolean_value_;
+    Number number_;
+    std::string string_value_;
+    std::vector<unsigned char> binary_value_;
+    Array array_value_;
+    Object object_value_;
+  };
 };
 
 #ifdef __clang__
 #pragma clang diagnostic pop
 #endif
 
-#define TINYGLTF_VALUE_GET(ctype, var)            \
-  template <>                                     \
-  inline const ctype &Value::Get<ctype>() const { \
-    return var;                                   \
-  }                                               \
-  template <>                                     \
-  inline ctype &Value::Get<ctype>() {             \
-    return var;                                   \
-  }
-TINYGLTF_VALUE_GET(bool, boolean_value_)
-TINYGLTF_VALUE_GET(double, real_value_)
-TINYGLTF_VALUE_GET(int, int_value_)
-TINYGLTF_VALUE_GET(std::string, string_value_)
-TINYGLTF_VALUE_GET(std::vector<unsigned char>, binary_value_)
-TINYGLTF_VALUE_GET(Value::Array, array_value_)
-TINYGLTF_VALUE_GET(Value::Object, object_value_)
+#define TINYGLTF_VALUE_GET(ctype, is_type, var)              \
+  template <>                                                \
+  inline const ctype &Value::Get<ctype>() const {            \
+    return is_type() ? var : NullValue<ctype>();             \
+  }                                                          \
+  template <>                                                \
+  inline ctype &Value::Get<ctype>() {                        \
+    assert(is_type());                                       \
+    if (!is_type()) *this = Value(ctype());                  \
+    return var;                                              \
+  }
+TINYGLTF_VALUE_GET(bool, IsBool, boolean_value_)
+TINYGLTF_VALUE_GET(double, IsNumber, number_.real_value)
+TINYGLTF_VALUE_GET(int, IsNumber, number_.int_value)
+TINYGLTF_VALUE_GET(std::string, IsString, string_value_)
+TINYGLTF_VALUE_GET(std::vector<unsigned char>, IsBinary, binary_value_)
+TINYGLTF_VALUE_GET(Value::Array, IsArray, array_value_)
+TINYGLTF_VALUE_GET(Value::Object, IsObject, object_value_)
 #undef TINYGLTF_VALUE_GET
 
 #ifdef __clang__
@@ -660,6 +917,23 @@ struct Image {
   // function)
   bool as_is{false};
 
+  // Encoded(e.g. png/jpeg) bytes of a data URI or external file image, kept
+  // when lazy image loading is enabled(TinyGLTF::SetLazyImageLoading).
+  // `bufferView` images reference their buffer instead and leave this empty.
+  std::vector<unsigned char> encoded;
+
+  ///
+  /// Returns true when `image` holds decoded pixels.
+  ///
+  bool IsDecoded() const { return !image.empty(); }
+
+  ///
+  /// Free decoded pixels(e.g. after uploading them to the GPU). The image can
+  /// be decoded again with TinyGLTF::DecodeImage while its encoded bytes are
+  /// available.
+  ///
+  void ReleaseDecoded() { std::vector<unsigned char>().swap(image); }
+
   Image() = default;
   DEFAULT_METHODS(Image)
 
@@ -874,19 +1148,9 @@ struct Accessor {
   ///
   int ByteStride(const BufferView &bufferViewObject) const {
     if (bufferViewObject.byteStride == 0) {
-      // Assume data is tightly packed.
-      int componentSizeInBytes =
-          GetComponentSizeInBytes(static_cast<uint32_t>(componentType));
-      if (componentSizeInBytes <= 0) {
-        return -1;
-      }
-
-      int numComponents = GetNumComponentsInType(static_cast<uint32_t>(type));
-      if (numComponents <= 0) {
-        return -1;
-      }
-
-      return componentSizeInBytes * numComponents;
+      // Assume data is tightly packed, with matrix columns 4-byte aligned.
+      return GetElementSizeInBytes(static_cast<uint32_t>(componentType),
+                                   static_cast<uint32_t>(type));
     } else {
       // Check if byteStride is a multiple of the size of the accessor's
       // component type.
@@ -1053,6 +1317,43 @@ struct Buffer {
   std::string extras_json_string;
   std::string extensions_json_string;
 
+  // Non-owning view of the buffer bytes. Set instead of `data` when the GLB
+  // BIN chunk is borrowed(see TinyGLTF::SetBorrowBinaryChunk). The memory is
+  // owned by the caller and must outlive this Buffer(and its copies), unless
+  // `borrowed_owner` keeps it alive.
+  const unsigned char *borrowed_data = nullptr;
+  size_t borrowed_size = 0;
+
+  // Set when the loader owns the memory behind `borrowed_data`(e.g. a
+  // snapshot file mapped by LoadSnapshotFromFile). Shared by copies of the
+  // Buffer; the memory is released with the last of them.
+  std::shared_ptr<const void> borrowed_owner;
+
+  ///
+  /// Returns a pointer to the buffer bytes, either owned(`data`) or borrowed.
+  /// Use this(and `Size()`) instead of `data` to read buffer contents.
+  ///
+  const unsigned char *Data() const {
+    if (borrowed_data) return borrowed_data;
+    return data.empty() ? nullptr : data.data();
+  }
+
+  size_t Size() const { return borrowed_data ? borrowed_size : data.size(); }
+
+  bool IsBorrowed() const { return borrowed_data != nullptr; }
+
+  ///
+  /// Copy borrowed bytes into `data` so the Buffer no longer depends on the
+  /// caller-owned memory. No-op for an owning Buffer.
+  ///
+  void MakeOwned() {
+    if (!borrowed_data) return;
+    data.assign(borrowed_data, borrowed_data + borrowed_size);
+    borrowed_data = nullptr;
+    borrowed_size = 0;
+    borrowed_owner.reset();
+  }
+
   Buffer() = default;
   DEFAULT_METHODS(Buffer)
   bool operator==(const Buffer &) const;
@@ -1250,6 +1551,319 @@ class Model {
   std::string extensions_json_string;
 };
 
+///
+/// Maps a C++ type to its TINYGLTF_COMPONENT_TYPE_*** value.
+///
+template <typename T>
+struct ComponentTypeOf;
+template <>
+struct ComponentTypeOf<int8_t> {
+  static const int value = TINYGLTF_COMPONENT_TYPE_BYTE;
+};
+template <>
+struct ComponentTypeOf<uint8_t> {
+  static const int value = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+};
+template <>
+struct ComponentTypeOf<int16_t> {
+  static const int value = TINYGLTF_COMPONENT_TYPE_SHORT;
+};
+template <>
+struct ComponentTypeOf<uint16_t> {
+  static const int value = TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+};
+template <>
+struct ComponentTypeOf<int32_t> {
+  static const int value = TINYGLTF_COMPONENT_TYPE_INT;
+};
+template <>
+struct ComponentTypeOf<uint32_t> {
+  static const int value = TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
+};
+template <>
+struct ComponentTypeOf<float> {
+  static const int value = TINYGLTF_COMPONENT_TYPE_FLOAT;
+};
+template <>
+struct ComponentTypeOf<double> {
+  static const int value = TINYGLTF_COMPONENT_TYPE_DOUBLE;
+};
+
+///
+/// Locates the bytes of `accessor` and validates them against its bufferView
+/// and buffer. On success `*data` points at the first element, and elements
+/// are `*byte_stride` bytes apart. Returns false for an accessor without a
+/// bufferView.
+///
+bool GetAccessorData(const Model &model, const Accessor &accessor,
+                     const unsigned char **data, size_t *byte_stride,
+                     std::string *err = nullptr);
+
+///
+/// Read-only, strided view of the elements of an accessor as stored.
+/// `T` must match the accessor's component type, e.g. `float` for
+/// TINYGLTF_COMPONENT_TYPE_FLOAT or `uint16_t` for
+/// TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT. Neither `normalized` nor sparse
+/// values are applied; use ReadAccessor() for converted values.
+///
+template <typename T>
+class AccessorView {
+ public:
+  AccessorView() = default;
+  AccessorView(const Model &model, const Accessor &accessor) {
+    Reset(model, accessor);
+  }
+
+  /// Returns false and leaves the view empty if the accessor has no
+  /// bufferView, a component type other than `T`, or is out of range.
+  bool Reset(const Model &model, const Accessor &accessor,
+             std::string *err = nullptr) {
+    data_ = nullptr;
+    count_ = components_ = rows_ = column_stride_ = stride_ = 0;
+    if (accessor.componentType != ComponentTypeOf<T>::value) {
+      if (err) {
+        (*err) += "Accessor component type does not match the view type.\n";
+      }
+      return false;
+    }
+    const unsigned char *data = nullptr;
+    size_t stride = 0;
+    if (!GetAccessorData(model, accessor, &data, &stride, err)) {
+      return false;
+    }
+    const uint32_t type = static_cast<uint32_t>(accessor.type);
+    data_ = data;
+    stride_ = stride;
+    count_ = accessor.count;
+    components_ = size_t(GetNumComponentsInType(type));
+    rows_ = components_ / size_t(GetNumColumnsInType(type));
+    column_stride_ = size_t(GetColumnStrideInBytes(
+        static_cast<uint32_t>(accessor.componentType), type));
+    return true;
+  }
+
+  bool Valid() const { return data_ != nullptr; }
+  size_t Count() const { return count_; }
+  size_t NumComponents() const { return components_; }
+  size_t ByteStride() const { return stride_; }
+
+  /// Component `c` of element `i`; matrices are column-major, with the
+  /// column padding skipped. Buffer data need not be aligned.
+  T Get(size_t i, size_t c = 0) const {
+    size_t offset = c * sizeof(T);
+    if (c >= rows_) {
+      offset = (c / rows_) * column_stride_ + (c % rows_) * sizeof(T);
+    }
+    T v;
+    memcpy(&v, data_ + i * stride_ + offset, sizeof(T));
+    return v;
+  }
+
+ private:
+  const unsigned char *data_ = nullptr;
+  size_t count_ = 0;
+  size_t components_ = 0;
+  size_t rows_ = 0;
+  size_t column_stride_ = 0;
+  size_t stride_ = 0;
+};
+
+///
+/// Reads all elements of `accessor` into `out` as tightly packed floats
+/// (`count * components` values), honoring byteStride, byteOffset and
+/// `normalized`(integers are then mapped to [0, 1] or [-1, 1]).
+/// An accessor without a bufferView reads as zeros, and sparse values are
+/// substituted. Tightly packed 8/16-bit data is converted with SSE2/NEON
+/// kernels unless TINYGLTF_NO_SIMD is defined.
+///
+bool ReadAccessor(const Model &model, const Accessor &accessor,
+                  std::vector<float> *out, std::string *err = nullptr);
+
+///
+/// Same as above, but widens integer components to uint32_t, e.g. for
+/// indices or joints. Fails for float/double accessors.
+///
+bool ReadAccessor(const Model &model, const Accessor &accessor,
+                  std::vector<uint32_t> *out, std::string *err = nullptr);
+
+///
+/// Materializes `accessor` as tightly packed elements of its own component
+/// type(`count * element size` bytes), with sparse values substituted. Matrix
+/// columns keep their 4-byte alignment, as in the buffer. An accessor without
+/// a bufferView starts out as zeros. Suitable for uploading sparse accessors
+/// to the GPU.
+///
+bool ResolveSparseAccessor(const Model &model, const Accessor &accessor,
+                           std::vector<unsigned char> *out,
+                           std::string *err = nullptr);
+
+///
+/// Resolves accessors of one Model with ResolveSparseAccessor() on first use
+/// and hands out the same dense copy afterwards. The Model must outlive the
+/// cache and must not change while it is in use.
+///
+class SparseAccessorCache {
+ public:
+  explicit SparseAccessorCache(const Model &model) : model_(&model) {}
+
+  /// Dense bytes of `model.accessors[accessor_idx]`, or nullptr on error.
+  const std::vector<unsigned char> *Get(int accessor_idx,
+                                        std::string *err = nullptr);
+  void Clear() { resolved_.clear(); }
+
+ private:
+  const Model *model_;
+  std::map<int, std::vector<unsigned char> > resolved_;
+};
+
+///
+/// The node hierarchy of one Scene flattened into arrays, parents before
+/// children, with cached world matrices.
+///
+/// Local transforms are kept as translation/rotation/scale arrays(struct of
+/// arrays) plus column-major local matrices, and world matrices are updated
+/// in one linear sweep; only nodes whose local transform changed since the
+/// last Update(), and their descendants, are recomputed.
+///
+class FlatScene {
+ public:
+  ///
+  /// Flattens `model.scenes[scene]` and computes all world matrices.
+  /// Returns false for an invalid scene or node index, or a node reachable
+  /// twice, and leaves the FlatScene empty.
+  ///
+  bool Build(const Model &model, int scene, std::string *err = nullptr);
+
+  size_t NodeCount() const { return nodes_.size(); }
+
+  /// Index into `model.nodes` of flattened node `i`.
+  int ModelNode(size_t i) const { return nodes_[i]; }
+
+  /// Flattened index of the parent of node `i`, -1 for scene roots. Always
+  /// less than `i`.
+  int Parent(size_t i) const { return parents_[i]; }
+
+  /// Flattened index of `model.nodes[node]`, -1 when not in the scene.
+  int Find(int node) const {
+    return (node >= 0 && size_t(node) < flat_index_.size())
+               ? flat_index_[size_t(node)]
+               : -1;
+  }
+
+  ///
+  /// Change the local transform of node `i`; takes effect on Update().
+  /// A node built from `Node::matrix` switches to translation/rotation/scale
+  /// with its matrix dropped.
+  ///
+  void SetTranslation(size_t i, float x, float y, float z);
+  void SetRotation(size_t i, float x, float y, float z, float w);
+  void SetScale(size_t i, float x, float y, float z);
+
+  /// Column-major local matrix of node `i`. Takes effect on Update().
+  void SetMatrix(size_t i, const float m[16]);
+
+  /// Recomputes the world matrices of changed nodes and their descendants.
+  void Update();
+
+  /// Column-major world matrix of node `i` as of the last Update().
+  const float *WorldMatrix(size_t i) const { return &world_[i * 16]; }
+
+ private:
+  void Clear();
+  void MarkDirty(size_t i);
+  void UseTRS(size_t i);
+  void UpdateLocal(size_t begin);
+  void UpdateWorld(size_t i);
+
+  std::vector<int> nodes_;
+  std::vector<int> parents_;
+  std::vector<int> subtree_end_;  // one past the last descendant
+  std::vector<int> flat_index_;
+  // Local TRS, padded to a multiple of 4 nodes.
+  std::vector<float> t_[3];
+  std::vector<float> r_[4];
+  std::vector<float> s_[3];
+  // Local matrices, element k of node i at local_[k][i].
+  std::vector<float> local_[16];
+  std::vector<float> world_;
+  std::vector<unsigned char> from_trs_;
+  // Nodes whose local transform changed since the last Update().
+  std::vector<int> dirty_;
+  std::vector<unsigned char> queued_;
+};
+
+///
+/// Samples the channels of one Animation.
+///
+/// Keyframes are read once, with normalized integer outputs dequantized,
+/// and every channel keeps the keyframe interval it was last sampled in, so
+/// advancing time costs O(1) per channel; going back does a binary search.
+/// Outputs of all channels are packed in one float array.
+///
+class AnimationEvaluator {
+ public:
+  enum Path { kTranslation, kRotation, kScale, kWeights, kOther };
+
+  ///
+  /// Reads the samplers of `model.animations[animation]`. Returns false
+  /// when an index, accessor type or interpolation is invalid. Channels with
+  /// a path other than the four standard ones are kept as kOther and not
+  /// sampled.
+  ///
+  bool Init(const Model &model, int animation, std::string *err = nullptr);
+
+  size_t ChannelCount() const { return channels_.size(); }
+  int TargetNode(size_t c) const { return channels_[c].node; }
+  Path TargetPath(size_t c) const { return channels_[c].path; }
+
+  /// Floats in the output of channel `c`: 3, 4 (x, y, z, w), or one per
+  /// morph target.
+  size_t ComponentCount(size_t c) const { return channels_[c].components; }
+
+  /// Time of the last keyframe over all channels, in seconds.
+  float Duration() const { return duration_; }
+
+  /// Samples every channel at `time` seconds, holding the first and last
+  /// keyframe values outside of their range.
+  void Evaluate(float time);
+
+  /// Output of channel `c` from the last Evaluate().
+  const float *Output(size_t c) const {
+    return outputs_.data() + channels_[c].offset;
+  }
+
+  /// Sets the translation, rotation and scale outputs on the nodes of
+  /// `scene`; weights and nodes outside of it are skipped.
+  void Apply(FlatScene *scene) const;
+
+ private:
+  enum Interpolation { kStep, kLinear, kCubicSpline };
+
+  struct Sampler {
+    Interpolation interpolation;
+    std::vector<float> times;
+    // For cubic splines each key holds in-tangent, value, out-tangent.
+    std::vector<float> values;
+  };
+
+  struct Channel {
+    size_t sampler;
+    int node;
+    Path path;
+    size_t components;
+    size_t offset;
+    size_t key;  // last interval, times[key] <= t < times[key + 1]
+  };
+
+  size_t FindKey(const std::vector<float> &times, float time,
+                 size_t key) const;
+
+  std::vector<Sampler> samplers_;
+  std::vector<Channel> channels_;
+  std::vector<float> outputs_;
+  float duration_ = 0.0f;
+};
+
 enum SectionCheck {
   NO_REQUIRE = 0x00,
   REQUIRE_VERSION = 0x01,
@@ -1262,6 +1876,48 @@ enum SectionCheck {
   REQUIRE_ALL = 0x7f
 };
 
+///
+/// Sections left out of a load(see LoadFilter).
+///
+enum SectionSkip {
+  SKIP_NONE = 0x00,
+  SKIP_IMAGES = 0x01,  // Images are neither fetched nor decoded.
+  SKIP_ANIMATIONS = 0x02,
+  SKIP_SKINS = 0x04,
+  SKIP_MESHES = 0x08,   // Primitives are not parsed(nor Draco decoded).
+  SKIP_BUFFERS = 0x10,  // Buffer data(GLB BIN chunk, .bin, data URI).
+};
+
+///
+/// MeshFilterFunction type. Returns true to load the mesh named `mesh_name`.
+///
+typedef bool (*MeshFilterFunction)(const std::string &mesh_name,
+                                   void *user_data);
+
+///
+/// Narrows what a load converts, for tools that only need part of an asset
+/// (metadata scans, thumbnails). A filtered out object keeps its slot in its
+/// array, so indices into the array stay valid, but only its name is loaded
+/// (skipped images and buffers also keep an external `uri`). Nothing a
+/// skipped object refers to is fetched or decoded on its behalf.
+///
+struct LoadFilter {
+  unsigned int skip_sections = SKIP_NONE;  // SectionSkip bits
+
+  ///
+  /// Load only this scene, the nodes it reaches(plus the joints of their
+  /// skins) and the meshes and skins of those nodes. -1 loads every scene;
+  /// kDefaultScene picks the asset's `scene`(0 when absent).
+  /// Images, materials, accessors and buffers are not narrowed by scene.
+  ///
+  int scene = -1;
+  static const int kDefaultScene = -2;
+
+  /// Load only meshes for which this returns true. nullptr loads all.
+  MeshFilterFunction mesh_filter = nullptr;
+  void *mesh_filter_user_data = nullptr;
+};
+
 ///
 /// URIEncodeFunction type. Signature for custom URI encoding of external
 /// resources such as .bin and image files. Used by tinygltf to re-encode the
@@ -1360,6 +2016,21 @@ typedef bool (*GetFileSizeFunction)(size_t *filesize_out, std::string *err,
                                     const std::string &abs_filename,
                                     void *userdata);
 
+///
+/// MapFileFunction type. Signature for custom filesystem callbacks.
+/// Exposes the whole file as read-only bytes(`*data`, `*size`) without
+/// copying it(e.g. mmap). `*handle` is an opaque token for UnmapFileFunction.
+///
+typedef bool (*MapFileFunction)(const unsigned char **data, size_t *size,
+                                void **handle, std::string *err,
+                                const std::string &abs_filename, void *);
+
+///
+/// UnmapFileFunction type. Releases bytes obtained by MapFileFunction.
+///
+typedef void (*UnmapFileFunction)(const unsigned char *data, size_t size,
+                                  void *handle, void *);
+
 ///
 /// A structure containing all required filesystem callbacks and a pointer to
 /// their user data.
@@ -1373,6 +2044,11 @@ struct FsCallbacks {
                                            // add `InBytes` suffix.
 
   void *user_data;  // An argument that is passed to all fs callbacks
+
+  // Optional. When both are set, files are read through a read-only mapping
+  // instead of `ReadWholeFile`.
+  MapFileFunction MapFile;
+  UnmapFileFunction UnmapFile;
 };
 
 #ifndef TINYGLTF_NO_FS
@@ -1397,11 +2073,43 @@ bool WriteWholeFile(std::string *err, const std::string &filepath,
 
 bool GetFileSizeInBytes(size_t *filesize_out, std::string *err,
                         const std::string &filepath, void *);
+
+///
+/// Map a whole file read-only(mmap on posix, MapViewOfFile on Windows,
+/// AAsset_getBuffer when TINYGLTF_ANDROID_LOAD_FROM_ASSETS is defined).
+/// The bytes stay valid until `UnmapFile` is called, so e.g. a mapped .glb
+/// can be passed to `LoadBinaryFromMemory` with `SetBorrowBinaryChunk(true)`.
+///
+bool MapFile(const unsigned char **data, size_t *size, void **handle,
+             std::string *err, const std::string &filepath, void *);
+
+void UnmapFile(const unsigned char *data, size_t size, void *handle, void *);
 #endif
 
+///
+/// 64-bit non-cryptographic hash of `size` bytes. Used to tell whether a
+/// snapshot(see TinyGLTF::WriteSnapshotToMemory) matches its source file.
+///
+uint64_t HashBytes(const unsigned char *data, size_t size);
+
+///
+/// Outcome of loading one file with TinyGLTF::LoadFromFiles().
+///
+struct LoadResult {
+  Model model;
+  bool ok = false;
+  std::string err;
+  std::string warn;
+};
+
 ///
 /// glTF Parser/Serializer context.
 ///
+/// Loading doesn't modify the TinyGLTF, so once configured one instance can
+/// load on several threads at once, provided its callbacks(FsCallbacks,
+/// URICallbacks, LoadImageData) are thread-safe, as the default ones are.
+/// Setters must not be called while loads run.
+///
 class TinyGLTF {
  public:
 #ifdef __clang__
@@ -1424,7 +2132,7 @@ class TinyGLTF {
   ///
   bool LoadASCIIFromFile(Model *model, std::string *err, std::string *warn,
                          const std::string &filename,
-                         unsigned int check_sections = REQUIRE_VERSION);
+                         unsigned int check_sections = REQUIRE_VERSION) const;
 
   ///
   /// Loads glTF ASCII asset from string(memory).
@@ -1437,7 +2145,7 @@ class TinyGLTF {
   bool LoadASCIIFromString(Model *model, std::string *err, std::string *warn,
                            const char *str, const unsigned int length,
                            const std::string &base_dir,
-                           unsigned int check_sections = REQUIRE_VERSION);
+                           unsigned int check_sections = REQUIRE_VERSION) const;
 
   ///
   /// Loads glTF binary asset from a file.
@@ -1446,7 +2154,7 @@ class TinyGLTF {
   ///
   bool LoadBinaryFromFile(Model *model, std::string *err, std::string *warn,
                           const std::string &filename,
-                          unsigned int check_sections = REQUIRE_VERSION);
+                          unsigned int check_sections = REQUIRE_VERSION) const;
 
   ///
   /// Loads glTF binary asset from memory.
@@ -1460,7 +2168,25 @@ class TinyGLTF {
                             const unsigned char *bytes,
                             const unsigned int length,
                             const std::string &base_dir = "",
-                            unsigned int check_sections = REQUIRE_VERSION);
+                            unsigned int check_sections =
+                                REQUIRE_VERSION) const;
+
+  ///
+  /// Loads each of `filenames`(.glb or .gltf, told apart by the GLB magic)
+  /// into the matching element of `results` on up to `num_threads` threads.
+  /// Files are loaded independently: one failing leaves the others intact.
+  /// At most `num_threads` threads(the calling one included) take the files
+  /// in turn; with `num_threads` <= 1 they are loaded one after the other on
+  /// the calling thread. When `num_threads` is greater than 1, each file
+  /// decodes its images on the thread loading it(SetImageLoadingThreads() is
+  /// ignored); otherwise SetImageLoadingThreads() applies as for a single
+  /// load. A file's bytes are released once it has loaded, so GLB buffers
+  /// are always copied out of the BIN chunk, whatever
+  /// SetBorrowBinaryChunk() says. Returns true when every file loaded.
+  ///
+  bool LoadFromFiles(const std::vector<std::string> &filenames,
+                     int num_threads, std::vector<LoadResult> *results,
+                     unsigned int check_sections = REQUIRE_VERSION) const;
 
   ///
   /// Write glTF to stream, buffers and images will be embedded
@@ -1475,6 +2201,63 @@ class TinyGLTF {
                             bool embedImages, bool embedBuffers,
                             bool prettyPrint, bool writeBinary);
 
+  ///
+  /// Write `model` as a binary snapshot, for reloading it without parsing
+  /// the original asset again or decoding its images.
+  /// A snapshot holds binary tables of every Model field, then buffer bytes
+  /// and decoded pixels(encoded bytes for images that aren't decoded) at
+  /// 4 KiB aligned offsets. Offsets are relative to the start of the
+  /// snapshot, so it can be loaded from anywhere in memory.
+  /// It is only valid for the `source_hash` it was written with(typically
+  /// HashBytes() of the source file), the same snapshot format version and
+  /// byte order.
+  ///
+  bool WriteSnapshotToMemory(const Model *model, uint64_t source_hash,
+                             std::vector<unsigned char> *out,
+                             std::string *err) const;
+
+  bool WriteSnapshotToFile(const Model *model, uint64_t source_hash,
+                           const std::string &filename,
+                           std::string *err) const;
+
+  ///
+  /// Loads a snapshot written by WriteSnapshotToMemory/File. Fails, leaving
+  /// `model` untouched, when the snapshot is stale(`source_hash` differs),
+  /// from another format version or corrupt.
+  /// With SetBorrowBinaryChunk(true), buffers borrow their bytes from
+  /// `bytes`(e.g. a file mapped with MapFile), which must then outlive the
+  /// Model. Otherwise they are copied.
+  ///
+  bool LoadSnapshotFromMemory(Model *model, std::string *err,
+                              std::string *warn, const unsigned char *bytes,
+                              size_t size, uint64_t source_hash) const;
+
+  ///
+  /// Loads a snapshot file(mapped when FsCallbacks provide MapFile).
+  /// With SetBorrowBinaryChunk(true), buffers borrow the file's bytes instead
+  /// of copying them, and `Buffer::borrowed_owner` keeps the mapping alive
+  /// until the last Buffer(or copy) referencing it is destroyed.
+  /// LoadSnapshotFromMemory() over caller-mapped bytes is the alternative
+  /// when the caller wants to manage the mapping.
+  ///
+  bool LoadSnapshotFromFile(Model *model, std::string *err, std::string *warn,
+                            const std::string &filename,
+                            uint64_t source_hash) const;
+
+  ///
+  /// Loads the .gltf/.glb `filename` through the snapshot
+  /// `snapshot_filename`: a snapshot of the file's current contents is used
+  /// when present, otherwise the file is loaded and the snapshot is
+  /// (re)written. Failing to write the snapshot only adds a warning.
+  /// With SetBorrowBinaryChunk(true), buffers borrow the snapshot's bytes, or
+  /// the GLB BIN chunk when the file itself is loaded, as in
+  /// LoadSnapshotFromFile().
+  ///
+  bool LoadFromFileCached(Model *model, std::string *err, std::string *warn,
+                          const std::string &filename,
+                          const std::string &snapshot_filename,
+                          unsigned int check_sections = REQUIRE_VERSION) const;
+
   ///
   /// Sets the parsing strictness.
   ///
@@ -1554,37 +2337,152 @@ class TinyGLTF {
 
   bool GetPreserveImageChannels() const { return preserve_image_channels_; }
 
- private:
   ///
-  /// Loads glTF asset from string(memory).
-  /// `length` = strlen(str);
-  /// Set warning message to `warn` for example it fails to load asserts
-  /// Returns false and set error string to `err` if there's an error.
+  /// Borrow the GLB BIN chunk instead of copying it(default = false).
+  /// When true, `LoadBinaryFromMemory` sets `Buffer::borrowed_data` to point
+  /// into the `bytes` passed by the caller and leaves `Buffer::data` empty,
+  /// so the caller must keep `bytes` alive as long as the Model is used.
+  /// Read buffer contents through `Buffer::Data()`/`Buffer::Size()`.
+  /// Ignored by `LoadBinaryFromFile`, which owns its temporary file bytes.
+  /// `LoadSnapshotFromFile` and `LoadFromFileCached` borrow from the file
+  /// they read and keep it alive through `Buffer::borrowed_owner`.
   ///
-  bool LoadFromString(Model *model, std::string *err, std::string *warn,
-                      const char *str, const unsigned int length,
-                      const std::string &base_dir, unsigned int check_sections);
+  void SetBorrowBinaryChunk(bool onoff) { borrow_binary_chunk_ = onoff; }
 
-  const unsigned char *bin_data_ = nullptr;
-  size_t bin_size_ = 0;
-  bool is_binary_ = false;
-
-  ParseStrictness strictness_ = ParseStrictness::Strict;
+  bool GetBorrowBinaryChunk() const { return borrow_binary_chunk_; }
 
-  bool serialize_default_values_ = false;  ///< Serialize default values?
+  ///
+  /// Convert the elements of the top-level arrays(buffers, accessors,
+  /// nodes, ...) while the JSON is parsed instead of from a DOM of the
+  /// whole document(default = false). Peak memory is then about the Model
+  /// plus one element's DOM rather than the DOM plus the Model.
+  /// The parse is driven by nlohmann::json's SAX interface and builds the
+  /// elements with its internal json_sax_dom_parser, so it is opt-in.
+  /// Ignored with TINYGLTF_USE_RAPIDJSON: the document is then parsed into
+  /// a full DOM as usual, since there is no rapidjson::Reader handler.
+  ///
+  void SetStreamingParse(bool onoff) { streaming_parse_ = onoff; }
 
-  bool store_original_json_for_extras_and_extensions_ = false;
+  bool GetStreamingParse() const { return streaming_parse_; }
+
+  ///
+  /// Restrict loads to part of the asset(default = load everything).
+  /// Not applied to snapshots: `LoadSnapshotFrom*` and `LoadFromFileCached`
+  /// always load the whole asset, so a cached snapshot is never partial.
+  ///
+  void SetLoadFilter(const LoadFilter &filter) { load_filter_ = filter; }
+
+  const LoadFilter &GetLoadFilter() const { return load_filter_; }
+
+  ///
+  /// Set the number of threads used to decode images(default = 1).
+  /// When greater than 1, all images are parsed(and their data URI/external
+  /// file bytes fetched) first, then decoded concurrently. Results are stored
+  /// in the same order as the sequential path, and err/warn messages are
+  /// appended in image order. A user supplied LoadImageData callback must be
+  /// thread-safe when this is enabled.
+  ///
+  void SetImageLoadingThreads(int num_threads) {
+    image_loading_threads_ = (num_threads > 1) ? num_threads : 1;
+  }
+
+  int GetImageLoadingThreads() const { return image_loading_threads_; }
+
+  ///
+  /// Set the number of threads used to decode KHR_draco_mesh_compression
+  /// primitives(default = 1). Only has an effect with TINYGLTF_ENABLE_DRACO.
+  /// Decoded indices and attributes go to one new Buffer either way.
+  ///
+  void SetDracoDecodingThreads(int num_threads) {
+    draco_decoding_threads_ = (num_threads > 1) ? num_threads : 1;
+  }
+
+  int GetDracoDecodingThreads() const { return draco_decoding_threads_; }
+
+  ///
+  /// Defer image decoding(default = false).
+  /// When true, loading only records where each image's encoded bytes are:
+  /// `Image::bufferView`, or `Image::encoded` for data URI/external files.
+  /// `Image::image` stays empty until `DecodeImage` is called for it.
+  ///
+  void SetLazyImageLoading(bool onoff) { lazy_image_loading_ = onoff; }
+
+  bool GetLazyImageLoading() const { return lazy_image_loading_; }
+
+  ///
+  /// Decode `model->images[image_idx]` into `Image::image` using the
+  /// configured LoadImageData callback. No-op if the image is already
+  /// decoded. Buffers referenced by bufferView images must still be
+  /// available(e.g. not released, or the borrowed GLB bytes alive).
+  /// Returns false and set error string to `err` if there's an error.
+  ///
+  bool DecodeImage(Model *model, int image_idx, std::string *err,
+                   std::string *warn) const;
+
+ private:
+  ///
+  /// State of one load, kept out of the TinyGLTF so loads can run
+  /// concurrently.
+  ///
+  struct LoadContext {
+    const unsigned char *bin_data = nullptr;  // GLB BIN chunk
+    size_t bin_size = 0;
+    bool is_binary = false;
+    bool borrow_binary_chunk = false;
+    int image_threads = 1;  // threads decoding this load's images
+    LoadFilter filter;
+  };
+
+  /// Context of a load with the configured settings.
+  LoadContext NewLoadContext() const;
+
+  ///
+  /// Loads glTF asset from string(memory).
+  /// `length` = strlen(str);
+  /// Set warning message to `warn` for example it fails to load asserts
+  /// Returns false and set error string to `err` if there's an error.
+  ///
+  bool LoadFromString(Model *model, std::string *err, std::string *warn,
+                      const char *str, const unsigned int length,
+                      const std::string &base_dir, unsigned int check_sections,
+                      const LoadContext &ctx) const;
+
+  /// Loads a GLB held in memory; fills in the BIN chunk of `ctx`.
+  bool LoadBinary(Model *model, std::string *err, std::string *warn,
+                  const unsigned char *bytes, unsigned int size,
+                  const std::string &base_dir, unsigned int check_sections,
+                  LoadContext ctx) const;
+
+  /// Loads .glb or .gltf file contents, told apart by the GLB magic.
+  bool LoadFromBytes(Model *model, std::string *err, std::string *warn,
+                     const unsigned char *bytes, size_t size,
+                     const std::string &base_dir, unsigned int check_sections,
+                     const LoadContext &ctx) const;
+
+  bool LoadSnapshot(Model *model, std::string *err, std::string *warn,
+                    const unsigned char *bytes, size_t size,
+                    uint64_t source_hash, const LoadContext &ctx) const;
+
+  bool borrow_binary_chunk_ = false;
+  bool streaming_parse_ = false;
+  LoadFilter load_filter_;
+
+  ParseStrictness strictness_ = ParseStrictness::Strict;
+
+  bool serialize_default_values_ = false;  ///< Serialize default values?
+
+  bool store_original_json_for_extras_and_extensions_ = false;
 
   bool preserve_image_channels_ = false;  /// Default false(expand channels to
                                           /// RGBA) for backward compatibility.
 
+  int image_loading_threads_ = 1;
+  int draco_decoding_threads_ = 1;
+  bool lazy_image_loading_ = false;
+
   size_t max_external_file_size_{
       size_t((std::numeric_limits<int32_t>::max)())};  // Default 2GB
 
-  // Warning & error messages
-  std::string warn_;
-  std::string err_;
-
   FsCallbacks fs = {
 #ifndef TINYGLTF_NO_FS
       &tinygltf::FileExists,
@@ -1593,11 +2491,16 @@ class TinyGLTF {
       &tinygltf::WriteWholeFile,
       &tinygltf::GetFileSizeInBytes,
 
-      nullptr  // Fs callback user data
+      nullptr,  // Fs callback user data
+
+      &tinygltf::MapFile,
+      &tinygltf::UnmapFile
 #else
       nullptr, nullptr, nullptr, nullptr, nullptr,
 
-      nullptr  // Fs callback user data
+      nullptr,  // Fs callback user data
+
+      nullptr, nullptr
 #endif
   };
 
@@ -1638,14 +2541,23 @@ class TinyGLTF {
 
 #if defined(TINYGLTF_IMPLEMENTATION) || defined(__INTELLISENSE__)
 #include <algorithm>
+#include <atomic>
 // #include <cassert>
 #ifndef TINYGLTF_NO_FS
 #include <sys/stat.h>  // for is_directory check
 
 #include <cstdio>
 #include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>  // for MapFile
+#include <unistd.h>
 #endif
+#endif
+#include <functional>
 #include <sstream>
+#include <thread>
 
 #ifdef __clang__
 // Disable some warnings for external files.
@@ -1787,6 +2699,17 @@ class TinyGLTF {
 // #include <wordexp.h>
 #endif
 
+#ifndef TINYGLTF_NO_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TINYGLTF_INTERNAL_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define TINYGLTF_INTERNAL_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
 #if defined(__sparcv9) || defined(__powerpc__)
 // Big endian
 #else
@@ -1919,8 +2842,8 @@ static bool Equals(const tinygltf::Value &one, const tinygltf::Value &other) {
     case INT_TYPE:
       return one.Get<int>() == other.Get<int>();
     case OBJECT_TYPE: {
-      auto oneObj = one.Get<tinygltf::Value::Object>();
-      auto otherObj = other.Get<tinygltf::Value::Object>();
+      const auto &oneObj = one.Get<tinygltf::Value::Object>();
+      const auto &otherObj = other.Get<tinygltf::Value::Object>();
       if (oneObj.size() != otherObj.size()) return false;
       for (auto &it : oneObj) {
         auto otherIt = otherObj.find(it.first);
@@ -1992,7 +2915,10 @@ bool Asset::operator==(const Asset &other) const {
          this->minVersion == other.minVersion && this->version == other.version;
 }
 bool Buffer::operator==(const Buffer &other) const {
-  return this->data == other.data && this->extensions == other.extensions &&
+  const size_t size = this->Size();
+  if (size != other.Size()) return false;
+  if (size && memcmp(this->Data(), other.Data(), size) != 0) return false;
+  return this->extensions == other.extensions &&
          this->extras == other.extras && this->name == other.name &&
          this->uri == other.uri;
 }
@@ -2015,8 +2941,9 @@ bool Image::operator==(const Image &other) const {
          this->component == other.component &&
          this->extensions == other.extensions && this->extras == other.extras &&
          this->height == other.height && this->image == other.image &&
-         this->mimeType == other.mimeType && this->name == other.name &&
-         this->uri == other.uri && this->width == other.width;
+         this->encoded == other.encoded && this->mimeType == other.mimeType &&
+         this->name == other.name && this->uri == other.uri &&
+         this->width == other.width;
 }
 bool Light::operator==(const Light &other) const {
   return Equals(this->color, other.color) && this->name == other.name &&
@@ -2214,7 +3141,8 @@ static std::string JoinPath(const std::string &path0,
 }
 
 static std::string FindFile(const std::vector<std::string> &paths,
-                            const std::string &filepath, FsCallbacks *fs) {
+                            const std::string &filepath,
+                            const FsCallbacks *fs) {
   if (fs == nullptr || fs->ExpandFilePath == nullptr ||
       fs->FileExists == nullptr) {
     // Error, fs callback[s] missing
@@ -2289,6 +3217,9 @@ std::string base64_decode(std::string const &s);
 
    René Nyffenegger rene.nyffenegger@adp-gmbh.ch
 
+   Altered for tinygltf: encoding and decoding are rewritten around
+   table-driven and SSE2/NEON kernels that work on caller-owned memory.
+
 */
 
 #ifdef __clang__
@@ -2297,103 +3228,252 @@ std::string base64_decode(std::string const &s);
 #pragma clang diagnostic ignored "-Wconversion"
 #endif
 
-static inline bool is_base64(unsigned char c) {
-  return (isalnum(c) || (c == '+') || (c == '/'));
-}
+namespace detail {
 
-std::string base64_encode(unsigned char const *bytes_to_encode,
-                          unsigned int in_len) {
-  std::string ret;
-  int i = 0;
-  int j = 0;
-  unsigned char char_array_3[3];
-  unsigned char char_array_4[4];
+const char kBase64Chars[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+    "abcdefghijklmnopqrstuvwxyz"
+    "0123456789+/";
 
-  const char *base64_chars =
-      "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-      "abcdefghijklmnopqrstuvwxyz"
-      "0123456789+/";
+size_t Base64Size(size_t n) { return 4 * ((n + 2) / 3); }
 
-  while (in_len--) {
-    char_array_3[i++] = *(bytes_to_encode++);
-    if (i == 3) {
-      char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-      char_array_4[1] =
-          ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-      char_array_4[2] =
-          ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-      char_array_4[3] = char_array_3[2] & 0x3f;
+struct Base64Table {
+  unsigned char sextet[256];  // 0xff for anything but a base64 digit
 
-      for (i = 0; (i < 4); i++) ret += base64_chars[char_array_4[i]];
-      i = 0;
+  Base64Table() {
+    memset(sextet, 0xff, sizeof(sextet));
+    for (unsigned char i = 0; i < 64; i++) {
+      sextet[static_cast<unsigned char>(kBase64Chars[i])] = i;
     }
   }
+};
 
-  if (i) {
-    for (j = i; j < 3; j++) char_array_3[j] = '\0';
-
-    char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-    char_array_4[1] =
-        ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-    char_array_4[2] =
-        ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
+#if defined(TINYGLTF_INTERNAL_SSE2)
+// Sextets (0-63) to base64 digits.
+static inline __m128i Base64Digits(__m128i i) {
+  const __m128i upper = _mm_set1_epi8(65);
+  const __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(i, _mm_set1_epi8(25)),
+                                      _mm_set1_epi8(6));
+  const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(i, _mm_set1_epi8(51)),
+                                      _mm_set1_epi8(-75));
+  const __m128i plus = _mm_and_si128(_mm_cmpeq_epi8(i, _mm_set1_epi8(62)),
+                                     _mm_set1_epi8(-15));
+  const __m128i slash = _mm_and_si128(_mm_cmpeq_epi8(i, _mm_set1_epi8(63)),
+                                      _mm_set1_epi8(-12));
+  return _mm_add_epi8(
+      _mm_add_epi8(_mm_add_epi8(i, upper), _mm_add_epi8(lower, digit)),
+      _mm_add_epi8(plus, slash));
+}
+
+// Base64 digits to sextets. Sets `invalid` lanes for anything else.
+static inline __m128i Base64Sextets(__m128i c, __m128i *invalid) {
+  const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8(64)),
+                                      _mm_cmplt_epi8(c, _mm_set1_epi8(91)));
+  const __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8(96)),
+                                      _mm_cmplt_epi8(c, _mm_set1_epi8(123)));
+  const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8(47)),
+                                      _mm_cmplt_epi8(c, _mm_set1_epi8(58)));
+  const __m128i plus = _mm_cmpeq_epi8(c, _mm_set1_epi8(43));
+  const __m128i slash = _mm_cmpeq_epi8(c, _mm_set1_epi8(47));
+  *invalid = _mm_or_si128(
+      *invalid,
+      _mm_cmpeq_epi8(_mm_or_si128(_mm_or_si128(upper, lower),
+                                  _mm_or_si128(digit, _mm_or_si128(plus,
+                                                                   slash))),
+                     _mm_setzero_si128()));
+  const __m128i delta = _mm_or_si128(
+      _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-65)),
+                   _mm_and_si128(lower, _mm_set1_epi8(-71))),
+      _mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(4)),
+                   _mm_or_si128(_mm_and_si128(plus, _mm_set1_epi8(19)),
+                                _mm_and_si128(slash, _mm_set1_epi8(16)))));
+  return _mm_add_epi8(c, delta);
+}
+#elif defined(TINYGLTF_INTERNAL_NEON)
+static inline uint8x16_t Base64Digits(uint8x16_t i) {
+  uint8x16_t c = vaddq_u8(i, vdupq_n_u8(65));
+  c = vaddq_u8(c, vandq_u8(vcgtq_u8(i, vdupq_n_u8(25)), vdupq_n_u8(6)));
+  c = vsubq_u8(c, vandq_u8(vcgtq_u8(i, vdupq_n_u8(51)), vdupq_n_u8(75)));
+  c = vsubq_u8(c, vandq_u8(vceqq_u8(i, vdupq_n_u8(62)), vdupq_n_u8(15)));
+  return vsubq_u8(c, vandq_u8(vceqq_u8(i, vdupq_n_u8(63)), vdupq_n_u8(12)));
+}
+
+static inline uint8x16_t Base64Sextets(uint8x16_t c, uint8x16_t *invalid) {
+  const uint8x16_t upper = vsubq_u8(c, vdupq_n_u8(65));
+  const uint8x16_t lower = vsubq_u8(c, vdupq_n_u8(71));
+  const uint8x16_t digit = vaddq_u8(c, vdupq_n_u8(4));
+  const uint8x16_t is_upper = vcltq_u8(upper, vdupq_n_u8(26));
+  const uint8x16_t is_lower = vcltq_u8(vsubq_u8(c, vdupq_n_u8(97)),
+                                       vdupq_n_u8(26));
+  const uint8x16_t is_digit = vcltq_u8(vsubq_u8(c, vdupq_n_u8(48)),
+                                       vdupq_n_u8(10));
+  const uint8x16_t is_plus = vceqq_u8(c, vdupq_n_u8(43));
+  const uint8x16_t is_slash = vceqq_u8(c, vdupq_n_u8(47));
+  uint8x16_t s = vandq_u8(is_upper, upper);
+  s = vorrq_u8(s, vandq_u8(is_lower, lower));
+  s = vorrq_u8(s, vandq_u8(is_digit, digit));
+  s = vorrq_u8(s, vandq_u8(is_plus, vdupq_n_u8(62)));
+  s = vorrq_u8(s, vandq_u8(is_slash, vdupq_n_u8(63)));
+  const uint8x16_t valid = vorrq_u8(vorrq_u8(is_upper, is_lower),
+                                    vorrq_u8(is_digit,
+                                             vorrq_u8(is_plus, is_slash)));
+  *invalid = vorrq_u8(*invalid, vmvnq_u8(valid));
+  return s;
+}
 
-    for (j = 0; (j < i + 1); j++) ret += base64_chars[char_array_4[j]];
+static inline bool AnyLane(uint8x16_t v) {
+  const uint64x2_t v64 = vreinterpretq_u64_u8(v);
+  return (vgetq_lane_u64(v64, 0) | vgetq_lane_u64(v64, 1)) != 0;
+}
+#endif
 
-    while ((i++ < 3)) ret += '=';
+///
+/// Writes the base64 encoding of `data`, `Base64Size(size)` characters, to
+/// `out`, padded with '='.
+///
+void Base64Encode(const unsigned char *data, size_t size, char *out) {
+  size_t i = 0;
+#if defined(TINYGLTF_INTERNAL_SSE2)
+  // 12 bytes to 16 digits. Reads 3-byte groups as big endian 24-bit ints.
+  for (; i + 12 <= size; i += 12, out += 16) {
+    const unsigned char *p = data + i;
+    const __m128i v = _mm_set_epi32(
+        (p[9] << 16) | (p[10] << 8) | p[11], (p[6] << 16) | (p[7] << 8) | p[8],
+        (p[3] << 16) | (p[4] << 8) | p[5], (p[0] << 16) | (p[1] << 8) | p[2]);
+    const __m128i mask = _mm_set1_epi32(63);
+    const __m128i sextets = _mm_or_si128(
+        _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 18), mask),
+                     _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(v, 12), mask),
+                                    8)),
+        _mm_or_si128(
+            _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(v, 6), mask), 16),
+            _mm_slli_epi32(_mm_and_si128(v, mask), 24)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), Base64Digits(sextets));
+  }
+#elif defined(TINYGLTF_INTERNAL_NEON)
+  // 48 bytes to 64 digits.
+  for (; i + 48 <= size; i += 48, out += 64) {
+    const uint8x16x3_t v = vld3q_u8(data + i);
+    const uint8x16_t mask = vdupq_n_u8(63);
+    uint8x16x4_t c;
+    c.val[0] = Base64Digits(vshrq_n_u8(v.val[0], 2));
+    c.val[1] = Base64Digits(vandq_u8(
+        vorrq_u8(vshlq_n_u8(v.val[0], 4), vshrq_n_u8(v.val[1], 4)), mask));
+    c.val[2] = Base64Digits(vandq_u8(
+        vorrq_u8(vshlq_n_u8(v.val[1], 2), vshrq_n_u8(v.val[2], 6)), mask));
+    c.val[3] = Base64Digits(vandq_u8(v.val[2], mask));
+    vst4q_u8(reinterpret_cast<uint8_t *>(out), c);
+  }
+#endif
+  for (; i + 3 <= size; i += 3, out += 4) {
+    const uint32_t v = (uint32_t(data[i]) << 16) |
+                       (uint32_t(data[i + 1]) << 8) | data[i + 2];
+    out[0] = kBase64Chars[v >> 18];
+    out[1] = kBase64Chars[(v >> 12) & 63];
+    out[2] = kBase64Chars[(v >> 6) & 63];
+    out[3] = kBase64Chars[v & 63];
+  }
+  if (i < size) {
+    const uint32_t v = (uint32_t(data[i]) << 16) |
+                       (i + 1 < size ? uint32_t(data[i + 1]) << 8 : 0);
+    out[0] = kBase64Chars[v >> 18];
+    out[1] = kBase64Chars[(v >> 12) & 63];
+    out[2] = i + 1 < size ? kBase64Chars[(v >> 6) & 63] : '=';
+    out[3] = '=';
   }
-
-  return ret;
 }
 
-std::string base64_decode(std::string const &encoded_string) {
-  int in_len = static_cast<int>(encoded_string.size());
-  int i = 0;
-  int j = 0;
-  int in_ = 0;
-  unsigned char char_array_4[4], char_array_3[3];
-  std::string ret;
-
-  const std::string base64_chars =
-      "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-      "abcdefghijklmnopqrstuvwxyz"
-      "0123456789+/";
-
-  while (in_len-- && (encoded_string[in_] != '=') &&
-         is_base64(encoded_string[in_])) {
-    char_array_4[i++] = encoded_string[in_];
-    in_++;
-    if (i == 4) {
-      for (i = 0; i < 4; i++)
-        char_array_4[i] =
-            static_cast<unsigned char>(base64_chars.find(char_array_4[i]));
-
-      char_array_3[0] =
-          (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-      char_array_3[1] =
-          ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-      char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-
-      for (i = 0; (i < 3); i++) ret += char_array_3[i];
-      i = 0;
-    }
+///
+/// Decodes base64 `in` up to its first '=' or other non base64 character
+/// into `out`, which must hold `3 * ((size + 3) / 4)` bytes. Returns the
+/// number of bytes written.
+///
+size_t Base64Decode(const char *in, size_t size, unsigned char *out) {
+  const unsigned char *p = reinterpret_cast<const unsigned char *>(in);
+  unsigned char *const begin = out;
+  size_t i = 0;
+#if defined(TINYGLTF_INTERNAL_SSE2)
+  // 16 digits to 12 bytes, until a block holds something else. Writes a
+  // 13th byte, so only while more digits (and room for them) follow.
+  const __m128i lo_byte = _mm_set1_epi32(0xff);
+  for (; i + 16 < size; i += 16, out += 12) {
+    __m128i invalid = _mm_setzero_si128();
+    const __m128i s = Base64Sextets(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i)), &invalid);
+    if (_mm_movemask_epi8(invalid)) break;
+    // Pairs of sextets to 12 bits, then pairs of those to 24.
+    const __m128i pairs =
+        _mm_or_si128(_mm_slli_epi16(_mm_and_si128(s, _mm_set1_epi16(0xff)), 6),
+                     _mm_srli_epi16(s, 8));
+    const __m128i v = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    // Big endian 24-bit to byte order.
+    const __m128i bytes = _mm_or_si128(
+        _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 16), lo_byte),
+                     _mm_and_si128(v, _mm_set1_epi32(0xff00))),
+        _mm_slli_epi32(_mm_and_si128(v, lo_byte), 16));
+    uint32_t w[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(w), bytes);
+    memcpy(out, &w[0], 4);
+    memcpy(out + 3, &w[1], 4);
+    memcpy(out + 6, &w[2], 4);
+    memcpy(out + 9, &w[3], 4);
+  }
+#elif defined(TINYGLTF_INTERNAL_NEON)
+  // 64 digits to 48 bytes, until a block holds something else.
+  for (; i + 64 <= size; i += 64, out += 48) {
+    const uint8x16x4_t c = vld4q_u8(p + i);
+    uint8x16_t invalid = vdupq_n_u8(0);
+    const uint8x16_t s0 = Base64Sextets(c.val[0], &invalid);
+    const uint8x16_t s1 = Base64Sextets(c.val[1], &invalid);
+    const uint8x16_t s2 = Base64Sextets(c.val[2], &invalid);
+    const uint8x16_t s3 = Base64Sextets(c.val[3], &invalid);
+    if (AnyLane(invalid)) break;
+    uint8x16x3_t v;
+    v.val[0] = vorrq_u8(vshlq_n_u8(s0, 2), vshrq_n_u8(s1, 4));
+    v.val[1] = vorrq_u8(vshlq_n_u8(s1, 4), vshrq_n_u8(s2, 2));
+    v.val[2] = vorrq_u8(vshlq_n_u8(s2, 6), s3);
+    vst3q_u8(out, v);
   }
+#endif
+  static const Base64Table table;
+  const unsigned char *sextet = table.sextet;
+  for (; i + 4 <= size; i += 4, out += 3) {
+    const unsigned a = sextet[p[i]], b = sextet[p[i + 1]],
+                   c = sextet[p[i + 2]], d = sextet[p[i + 3]];
+    if ((a | b | c | d) & 0x80) break;
+    const unsigned v = (a << 18) | (b << 12) | (c << 6) | d;
+    out[0] = static_cast<unsigned char>(v >> 16);
+    out[1] = static_cast<unsigned char>(v >> 8);
+    out[2] = static_cast<unsigned char>(v);
+  }
+  // Up to three more digits before the end or the first non digit.
+  unsigned v = 0;
+  size_t n = 0;
+  for (; n < 3 && i + n < size && !(sextet[p[i + n]] & 0x80); n++) {
+    v |= unsigned(sextet[p[i + n]]) << (18 - 6 * n);
+  }
+  for (size_t k = 0; k + 1 < n; k++) {
+    *out++ = static_cast<unsigned char>(v >> (16 - 8 * k));
+  }
+  return size_t(out - begin);
+}
 
-  if (i) {
-    for (j = i; j < 4; j++) char_array_4[j] = 0;
-
-    for (j = 0; j < 4; j++)
-      char_array_4[j] =
-          static_cast<unsigned char>(base64_chars.find(char_array_4[j]));
+}  // namespace detail
 
-    char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-    char_array_3[1] =
-        ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-    char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+std::string base64_encode(unsigned char const *bytes_to_encode,
+                          unsigned int in_len) {
+  std::string ret(detail::Base64Size(in_len), '\0');
+  if (in_len) detail::Base64Encode(bytes_to_encode, in_len, &ret[0]);
+  return ret;
+}
 
-    for (j = 0; (j < i - 1); j++) ret += char_array_3[j];
+std::string base64_decode(std::string const &encoded_string) {
+  std::string ret(3 * ((encoded_string.size() + 3) / 4), '\0');
+  if (!ret.empty()) {
+    ret.resize(detail::Base64Decode(
+        encoded_string.data(), encoded_string.size(),
+        reinterpret_cast<unsigned char *>(&ret[0])));
   }
-
   return ret;
 }
 #ifdef __clang__
@@ -2477,11 +3557,114 @@ bool URIDecode(const std::string &in_uri, std::string *out_uri,
   return true;
 }
 
+namespace detail {
+
+///
+/// Read-only bytes of a whole file. Mapped when `fs` provides MapFile and
+/// UnmapFile, otherwise(or when mapping fails, e.g. a compressed Android
+/// asset or a file system without mmap) read into `copy` with ReadWholeFile.
+///
+struct FileBytes {
+  const unsigned char *data = nullptr;
+  size_t size = 0;
+
+  FileBytes() = default;
+  FileBytes(const FileBytes &) = delete;
+  FileBytes &operator=(const FileBytes &) = delete;
+  ~FileBytes() {
+    if (handle_) unmap_(data, size, handle_, user_data_);
+  }
+
+  bool Read(std::string *err, const std::string &filepath,
+            const FsCallbacks *fs) {
+    if (fs->MapFile && fs->UnmapFile) {
+      void *handle = nullptr;
+      // A failed mapping is not an error by itself; ReadWholeFile reports
+      // why the file can't be read.
+      std::string map_err;
+      if (fs->MapFile(&data, &size, &handle, &map_err, filepath,
+                      fs->user_data)) {
+        handle_ = handle;
+        unmap_ = fs->UnmapFile;
+        user_data_ = fs->user_data;
+        return true;
+      }
+      data = nullptr;
+      size = 0;
+    }
+
+    if (fs->ReadWholeFile == nullptr) {
+      if (err) {
+        (*err) += "ReadWholeFile callback not set : " + filepath + "\n";
+      }
+      return false;
+    }
+    if (!fs->ReadWholeFile(&copy, err, filepath, fs->user_data)) {
+      return false;
+    }
+    data = copy.empty() ? nullptr : copy.data();
+    size = copy.size();
+    return true;
+  }
+
+  std::vector<unsigned char> copy;
+
+ private:
+  // Copied rather than pointing at the FsCallbacks, since a FileBytes may
+  // outlive the TinyGLTF that read it(see Buffer::borrowed_owner).
+  void *handle_ = nullptr;
+  UnmapFileFunction unmap_ = nullptr;
+  void *user_data_ = nullptr;
+};
+
+// Makes the borrowed buffers of `model` keep `owner` alive.
+static void SetBorrowedOwner(Model *model,
+                             const std::shared_ptr<const void> &owner) {
+  for (Buffer &buffer : model->buffers) {
+    if (buffer.IsBorrowed()) buffer.borrowed_owner = owner;
+  }
+}
+
+///
+/// Run `fn(i)` for each i in [0, count) on up to `num_threads` threads
+/// (including the calling thread). Runs inline when num_threads <= 1.
+///
+template <typename Fn>
+static void ParallelFor(size_t count, int num_threads, const Fn &fn) {
+  size_t num_workers =
+      (std::min)(count, size_t(num_threads > 1 ? num_threads : 1));
+  if (num_workers <= 1) {
+    for (size_t i = 0; i < count; i++) {
+      fn(i);
+    }
+    return;
+  }
+
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i = next++; i < count; i = next++) {
+      fn(i);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_workers - 1);
+  for (size_t t = 1; t < num_workers; t++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto &t : threads) {
+    t.join();
+  }
+}
+
+}  // namespace detail
+
 static bool LoadExternalFile(std::vector<unsigned char> *out, std::string *err,
                              std::string *warn, const std::string &filename,
                              const std::string &basedir, bool required,
                              size_t reqBytes, bool checkSize,
-                             size_t maxFileSize, FsCallbacks *fs) {
+                             size_t maxFileSize, const FsCallbacks *fs) {
   if (fs == nullptr || fs->FileExists == nullptr ||
       fs->ExpandFilePath == nullptr || fs->ReadWholeFile == nullptr) {
     // This is a developer error, assert() ?
@@ -2533,10 +3716,9 @@ static bool LoadExternalFile(std::vector<unsigned char> *out, std::string *err,
     }
   }
 
-  std::vector<unsigned char> buf;
+  detail::FileBytes buf;
   std::string fileReadErr;
-  bool fileRead =
-      fs->ReadWholeFile(&buf, &fileReadErr, filepath, fs->user_data);
+  bool fileRead = buf.Read(&fileReadErr, filepath, fs);
   if (!fileRead) {
     if (failMsgOut) {
       (*failMsgOut) +=
@@ -2545,7 +3727,7 @@ static bool LoadExternalFile(std::vector<unsigned char> *out, std::string *err,
     return false;
   }
 
-  size_t sz = buf.size();
+  size_t sz = buf.size;
   if (sz == 0) {
     if (failMsgOut) {
       (*failMsgOut) += "File is empty : " + filepath + "\n";
@@ -2553,22 +3735,22 @@ static bool LoadExternalFile(std::vector<unsigned char> *out, std::string *err,
     return false;
   }
 
-  if (checkSize) {
-    if (reqBytes == sz) {
-      out->swap(buf);
-      return true;
-    } else {
-      std::stringstream ss;
-      ss << "File size mismatch : " << filepath << ", requestedBytes "
-         << reqBytes << ", but got " << sz << std::endl;
-      if (failMsgOut) {
-        (*failMsgOut) += ss.str();
-      }
-      return false;
+  if (checkSize && (reqBytes != sz)) {
+    std::stringstream ss;
+    ss << "File size mismatch : " << filepath << ", requestedBytes "
+       << reqBytes << ", but got " << sz << std::endl;
+    if (failMsgOut) {
+      (*failMsgOut) += ss.str();
     }
+    return false;
   }
 
-  out->swap(buf);
+  if (buf.data == buf.copy.data()) {
+    out->swap(buf.copy);
+  } else {
+    // Single pass from the mapping, no zero-fill of `out`.
+    out->assign(buf.data, buf.data + sz);
+  }
   return true;
 }
 
@@ -3151,6 +4333,133 @@ bool ReadWholeFile(std::vector<unsigned char> *out, std::string *err,
 #endif
 }
 
+bool MapFile(const unsigned char **data, size_t *size, void **handle,
+             std::string *err, const std::string &filepath, void *) {
+#ifdef TINYGLTF_ANDROID_LOAD_FROM_ASSETS
+  if (asset_manager) {
+    // AASSET_MODE_BUFFER lets uncompressed assets be mapped straight from the
+    // APK.
+    AAsset *asset = AAssetManager_open(asset_manager, filepath.c_str(),
+                                       AASSET_MODE_BUFFER);
+    if (!asset) {
+      if (err) {
+        (*err) += "File open error : " + filepath + "\n";
+      }
+      return false;
+    }
+    size_t sz = size_t(AAsset_getLength(asset));
+    const void *buf = AAsset_getBuffer(asset);
+    if ((sz == 0) || (buf == nullptr)) {
+      AAsset_close(asset);
+      if (err) {
+        (*err) += "Failed to map asset : " + filepath + "\n";
+      }
+      return false;
+    }
+    (*data) = reinterpret_cast<const unsigned char *>(buf);
+    (*size) = sz;
+    (*handle) = asset;
+    return true;
+  } else {
+    if (err) {
+      (*err) += "No asset manager specified : " + filepath + "\n";
+    }
+    return false;
+  }
+#elif defined(_WIN32)
+  HANDLE file = CreateFileW(UTF8ToWchar(filepath).c_str(), GENERIC_READ,
+                            FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    if (err) {
+      (*err) += "File open error : " + filepath + "\n";
+    }
+    return false;
+  }
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) || (file_size.QuadPart <= 0)) {
+    CloseHandle(file);
+    if (err) {
+      (*err) += "File is empty : " + filepath + "\n";
+    }
+    return false;
+  }
+
+  HANDLE mapping =
+      CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (mapping == nullptr) {
+    if (err) {
+      (*err) += "File mapping error : " + filepath + "\n";
+    }
+    return false;
+  }
+
+  void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);  // The view keeps the mapping alive.
+  if (view == nullptr) {
+    if (err) {
+      (*err) += "File mapping error : " + filepath + "\n";
+    }
+    return false;
+  }
+
+  (*data) = reinterpret_cast<const unsigned char *>(view);
+  (*size) = size_t(file_size.QuadPart);
+  (*handle) = view;
+  return true;
+#else
+  int fd = open(filepath.c_str(), O_RDONLY);
+  if (fd < 0) {
+    if (err) {
+      (*err) += "File open error : " + filepath + "\n";
+    }
+    return false;
+  }
+
+  struct stat sb;
+  if (fstat(fd, &sb) || S_ISDIR(sb.st_mode) || (sb.st_size <= 0)) {
+    close(fd);
+    if (err) {
+      (*err) += "File read error. Maybe empty file or invalid file : " +
+                filepath + "\n";
+    }
+    return false;
+  }
+
+  size_t sz = size_t(sb.st_size);
+  void *addr = mmap(nullptr, sz, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);  // The mapping stays valid after close.
+  if (addr == MAP_FAILED) {
+    if (err) {
+      (*err) += "File mapping error : " + filepath + "\n";
+    }
+    return false;
+  }
+
+  (*data) = reinterpret_cast<const unsigned char *>(addr);
+  (*size) = sz;
+  (*handle) = addr;
+  return true;
+#endif
+}
+
+void UnmapFile(const unsigned char *data, size_t size, void *handle, void *) {
+#ifdef TINYGLTF_ANDROID_LOAD_FROM_ASSETS
+  (void)data;
+  (void)size;
+  AAsset_close(reinterpret_cast<AAsset *>(handle));
+#elif defined(_WIN32)
+  (void)data;
+  (void)size;
+  UnmapViewOfFile(handle);
+#else
+  (void)data;
+  munmap(handle, size);
+#endif
+}
+
 bool WriteWholeFile(std::string *err, const std::string &filepath,
                     const std::vector<unsigned char> &contents, void *) {
 #ifdef _WIN32
@@ -3247,6 +4556,13 @@ static bool UpdateImageObject(const Image &image, std::string &baseDir,
   // Use the original uri if the image was not written.
   if (!imageWritten) {
     *out_uri = image.uri;
+
+    // Not decoded yet(lazy image loading): embed the encoded bytes as-is.
+    if (out_uri->empty() && image.image.empty() && !image.encoded.empty()) {
+      *out_uri = "data:" + image.mimeType + ";base64," +
+                 base64_encode(image.encoded.data(),
+                               static_cast<unsigned int>(image.encoded.size()));
+    }
   }
 
   return true;
@@ -3293,2588 +4609,5319 @@ bool IsDataURI(const std::string &in) {
 
 bool DecodeDataURI(std::vector<unsigned char> *out, std::string &mime_type,
                    const std::string &in, size_t reqBytes, bool checkSize) {
-  std::string header = "data:application/octet-stream;base64,";
-  std::string data;
-  if (in.find(header) == 0) {
-    data = base64_decode(in.substr(header.size()));  // cut mime string.
-  }
+  // Header, and the mime type it sets.
+  static const char *const kHeaders[][2] = {
+      {"data:application/octet-stream;base64,", nullptr},
+      {"data:image/jpeg;base64,", "image/jpeg"},
+      {"data:image/png;base64,", "image/png"},
+      {"data:image/bmp;base64,", "image/bmp"},
+      {"data:image/gif;base64,", "image/gif"},
+      {"data:text/plain;base64,", "text/plain"},
+      {"data:application/gltf-buffer;base64,", nullptr},
+  };
 
-  if (data.empty()) {
-    header = "data:image/jpeg;base64,";
-    if (in.find(header) == 0) {
-      mime_type = "image/jpeg";
-      data = base64_decode(in.substr(header.size()));  // cut mime string.
+  for (const auto &header : kHeaders) {
+    const size_t header_size = strlen(header[0]);
+    if (in.compare(0, header_size, header[0]) != 0) continue;
+
+    // Decoded straight into `out`, no intermediate strings.
+    const size_t size = in.size() - header_size;
+    out->resize(3 * ((size + 3) / 4));
+    out->resize(detail::Base64Decode(in.data() + header_size, size,
+                                     out->data()));
+    // TODO(syoyo): Allow empty buffer? #229
+    if (out->empty() || (checkSize && out->size() != reqBytes)) {
+      out->clear();
+      return false;
     }
+    if (header[1]) mime_type = header[1];
+    return true;
   }
+  return false;
+}
 
-  if (data.empty()) {
-    header = "data:image/png;base64,";
-    if (in.find(header) == 0) {
-      mime_type = "image/png";
-      data = base64_decode(in.substr(header.size()));  // cut mime string.
+bool GetAccessorData(const Model &model, const Accessor &accessor,
+                     const unsigned char **data, size_t *byte_stride,
+                     std::string *err) {
+  if (accessor.bufferView < 0 ||
+      size_t(accessor.bufferView) >= model.bufferViews.size()) {
+    if (err) {
+      (*err) += "Accessor has no valid bufferView.\n";
     }
+    return false;
   }
-
-  if (data.empty()) {
-    header = "data:image/bmp;base64,";
-    if (in.find(header) == 0) {
-      mime_type = "image/bmp";
-      data = base64_decode(in.substr(header.size()));  // cut mime string.
+  const BufferView &view = model.bufferViews[size_t(accessor.bufferView)];
+  if (view.buffer < 0 || size_t(view.buffer) >= model.buffers.size()) {
+    if (err) {
+      (*err) += "BufferView has no valid buffer.\n";
     }
+    return false;
   }
+  const Buffer &buffer = model.buffers[size_t(view.buffer)];
 
-  if (data.empty()) {
-    header = "data:image/gif;base64,";
-    if (in.find(header) == 0) {
-      mime_type = "image/gif";
-      data = base64_decode(in.substr(header.size()));  // cut mime string.
+  const int stride = accessor.ByteStride(view);
+  const int element_bytes =
+      GetElementSizeInBytes(static_cast<uint32_t>(accessor.componentType),
+                            static_cast<uint32_t>(accessor.type));
+  if (stride <= 0 || element_bytes <= 0) {
+    if (err) {
+      (*err) += "Invalid accessor type, componentType or byteStride.\n";
     }
+    return false;
   }
 
-  if (data.empty()) {
-    header = "data:text/plain;base64,";
-    if (in.find(header) == 0) {
-      mime_type = "text/plain";
-      data = base64_decode(in.substr(header.size()));
-    }
+  // The last element must fit in both the bufferView and the buffer.
+  const size_t element_size = size_t(element_bytes);
+  size_t end = accessor.byteOffset;
+  if (accessor.count > 0) {
+    end += size_t(stride) * (accessor.count - 1) + element_size;
   }
-
-  if (data.empty()) {
-    header = "data:application/gltf-buffer;base64,";
-    if (in.find(header) == 0) {
-      data = base64_decode(in.substr(header.size()));
+  if (end > view.byteLength ||
+      view.byteOffset + view.byteLength > buffer.Size()) {
+    if (err) {
+      (*err) += "Accessor exceeds its bufferView or buffer.\n";
     }
-  }
-
-  // TODO(syoyo): Allow empty buffer? #229
-  if (data.empty()) {
     return false;
   }
 
-  if (checkSize) {
-    if (data.size() != reqBytes) {
-      return false;
-    }
-    out->resize(reqBytes);
-  } else {
-    out->resize(data.size());
-  }
-  std::copy(data.begin(), data.end(), out->begin());
+  (*data) = buffer.Data() + view.byteOffset + accessor.byteOffset;
+  (*byte_stride) = size_t(stride);
   return true;
 }
 
 namespace detail {
-bool GetInt(const detail::json &o, int &val) {
-#ifdef TINYGLTF_USE_RAPIDJSON
-  if (!o.IsDouble()) {
-    if (o.IsInt()) {
-      val = o.GetInt();
-      return true;
-    } else if (o.IsUint()) {
-      val = static_cast<int>(o.GetUint());
-      return true;
-    } else if (o.IsInt64()) {
-      val = static_cast<int>(o.GetInt64());
-      return true;
-    } else if (o.IsUint64()) {
-      val = static_cast<int>(o.GetUint64());
-      return true;
-    }
-  }
 
-  return false;
-#else
-  auto type = o.type();
-
-  if ((type == detail::json::value_t::number_integer) ||
-      (type == detail::json::value_t::number_unsigned)) {
-    val = static_cast<int>(o.get<int64_t>());
-    return true;
-  }
-
-  return false;
-#endif
+// Converts the first n values of tightly packed `src` with SIMD and returns
+// how many were converted; the caller handles the rest. Values become
+// max(v * scale, lo).
+template <typename S, typename D>
+size_t ConvertPacked(const unsigned char *, size_t, float, float, D *) {
+  return 0;
 }
 
-#ifdef TINYGLTF_USE_RAPIDJSON
-bool GetDouble(const detail::json &o, double &val) {
-  if (o.IsDouble()) {
-    val = o.GetDouble();
-    return true;
-  }
-
-  return false;
+#if defined(TINYGLTF_INTERNAL_SSE2)
+static inline void StoreScaled(__m128i v, __m128 scale, __m128 lo, float *dst) {
+  _mm_storeu_ps(dst, _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(v), scale), lo));
+}
+#elif defined(TINYGLTF_INTERNAL_NEON)
+static inline void StoreScaled(int32x4_t v, float32x4_t scale,
+                               float32x4_t lo, float *dst) {
+  vst1q_f32(dst, vmaxq_f32(vmulq_f32(vcvtq_f32_s32(v), scale), lo));
 }
 #endif
 
-bool GetNumber(const detail::json &o, double &val) {
-#ifdef TINYGLTF_USE_RAPIDJSON
-  if (o.IsNumber()) {
-    val = o.GetDouble();
-    return true;
+template <>
+inline size_t ConvertPacked<uint8_t, float>(const unsigned char *src,
+                                            size_t n, float scale, float lo,
+                                            float *dst) {
+  size_t i = 0;
+#if defined(TINYGLTF_INTERNAL_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 vs = _mm_set1_ps(scale);
+  const __m128 vlo = _mm_set1_ps(lo);
+  for (; i + 16 <= n; i += 16) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    const __m128i a = _mm_unpacklo_epi8(v, zero);
+    const __m128i b = _mm_unpackhi_epi8(v, zero);
+    StoreScaled(_mm_unpacklo_epi16(a, zero), vs, vlo, dst + i);
+    StoreScaled(_mm_unpackhi_epi16(a, zero), vs, vlo, dst + i + 4);
+    StoreScaled(_mm_unpacklo_epi16(b, zero), vs, vlo, dst + i + 8);
+    StoreScaled(_mm_unpackhi_epi16(b, zero), vs, vlo, dst + i + 12);
+  }
+#elif defined(TINYGLTF_INTERNAL_NEON)
+  const float32x4_t vs = vdupq_n_f32(scale);
+  const float32x4_t vlo = vdupq_n_f32(lo);
+  for (; i + 16 <= n; i += 16) {
+    const uint8x16_t v = vld1q_u8(src + i);
+    const uint16x8_t a = vmovl_u8(vget_low_u8(v));
+    const uint16x8_t b = vmovl_u8(vget_high_u8(v));
+    StoreScaled(vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(a))), vs, vlo,
+                dst + i);
+    StoreScaled(vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(a))), vs, vlo,
+                dst + i + 4);
+    StoreScaled(vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(b))), vs, vlo,
+                dst + i + 8);
+    StoreScaled(vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(b))), vs, vlo,
+                dst + i + 12);
   }
-
-  return false;
 #else
-  if (o.is_number()) {
-    val = o.get<double>();
-    return true;
-  }
-
-  return false;
+  (void)src;
+  (void)n;
+  (void)scale;
+  (void)lo;
+  (void)dst;
 #endif
+  return i;
 }
 
-bool GetString(const detail::json &o, std::string &val) {
-#ifdef TINYGLTF_USE_RAPIDJSON
-  if (o.IsString()) {
-    val = o.GetString();
-    return true;
+template <>
+inline size_t ConvertPacked<uint16_t, float>(const unsigned char *src,
+                                             size_t n, float scale, float lo,
+                                             float *dst) {
+  size_t i = 0;
+#if defined(TINYGLTF_INTERNAL_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 vs = _mm_set1_ps(scale);
+  const __m128 vlo = _mm_set1_ps(lo);
+  for (; i + 8 <= n; i += 8) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2));
+    StoreScaled(_mm_unpacklo_epi16(v, zero), vs, vlo, dst + i);
+    StoreScaled(_mm_unpackhi_epi16(v, zero), vs, vlo, dst + i + 4);
+  }
+#elif defined(TINYGLTF_INTERNAL_NEON)
+  const float32x4_t vs = vdupq_n_f32(scale);
+  const float32x4_t vlo = vdupq_n_f32(lo);
+  for (; i + 8 <= n; i += 8) {
+    const uint16x8_t v = vreinterpretq_u16_u8(vld1q_u8(src + i * 2));
+    StoreScaled(vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(v))), vs, vlo,
+                dst + i);
+    StoreScaled(vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(v))), vs, vlo,
+                dst + i + 4);
   }
-
-  return false;
 #else
-  if (o.type() == detail::json::value_t::string) {
-    val = o.get<std::string>();
-    return true;
-  }
-
-  return false;
+  (void)src;
+  (void)n;
+  (void)scale;
+  (void)lo;
+  (void)dst;
 #endif
+  return i;
 }
 
-bool IsArray(const detail::json &o) {
-#ifdef TINYGLTF_USE_RAPIDJSON
-  return o.IsArray();
+template <>
+inline size_t ConvertPacked<int16_t, float>(const unsigned char *src,
+                                            size_t n, float scale, float lo,
+                                            float *dst) {
+  size_t i = 0;
+#if defined(TINYGLTF_INTERNAL_SSE2)
+  const __m128 vs = _mm_set1_ps(scale);
+  const __m128 vlo = _mm_set1_ps(lo);
+  for (; i + 8 <= n; i += 8) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2));
+    // Sign-extend by placing each value in the upper half, then shifting.
+    StoreScaled(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16), vs, vlo,
+                dst + i);
+    StoreScaled(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16), vs, vlo,
+                dst + i + 4);
+  }
+#elif defined(TINYGLTF_INTERNAL_NEON)
+  const float32x4_t vs = vdupq_n_f32(scale);
+  const float32x4_t vlo = vdupq_n_f32(lo);
+  for (; i + 8 <= n; i += 8) {
+    const int16x8_t v = vreinterpretq_s16_u8(vld1q_u8(src + i * 2));
+    StoreScaled(vmovl_s16(vget_low_s16(v)), vs, vlo, dst + i);
+    StoreScaled(vmovl_s16(vget_high_s16(v)), vs, vlo, dst + i + 4);
+  }
 #else
-  return o.is_array();
+  (void)src;
+  (void)n;
+  (void)scale;
+  (void)lo;
+  (void)dst;
 #endif
+  return i;
 }
 
-detail::json_const_array_iterator ArrayBegin(const detail::json &o) {
-#ifdef TINYGLTF_USE_RAPIDJSON
-  return o.Begin();
+template <>
+inline size_t ConvertPacked<uint8_t, uint32_t>(const unsigned char *src,
+                                               size_t n, float, float,
+                                               uint32_t *dst) {
+  size_t i = 0;
+#if defined(TINYGLTF_INTERNAL_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= n; i += 16) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    const __m128i a = _mm_unpacklo_epi8(v, zero);
+    const __m128i b = _mm_unpackhi_epi8(v, zero);
+    __m128i *d = reinterpret_cast<__m128i *>(dst + i);
+    _mm_storeu_si128(d, _mm_unpacklo_epi16(a, zero));
+    _mm_storeu_si128(d + 1, _mm_unpackhi_epi16(a, zero));
+    _mm_storeu_si128(d + 2, _mm_unpacklo_epi16(b, zero));
+    _mm_storeu_si128(d + 3, _mm_unpackhi_epi16(b, zero));
+  }
+#elif defined(TINYGLTF_INTERNAL_NEON)
+  for (; i + 16 <= n; i += 16) {
+    const uint8x16_t v = vld1q_u8(src + i);
+    const uint16x8_t a = vmovl_u8(vget_low_u8(v));
+    const uint16x8_t b = vmovl_u8(vget_high_u8(v));
+    vst1q_u32(dst + i, vmovl_u16(vget_low_u16(a)));
+    vst1q_u32(dst + i + 4, vmovl_u16(vget_high_u16(a)));
+    vst1q_u32(dst + i + 8, vmovl_u16(vget_low_u16(b)));
+    vst1q_u32(dst + i + 12, vmovl_u16(vget_high_u16(b)));
+  }
 #else
-  return o.begin();
+  (void)src;
+  (void)n;
+  (void)dst;
 #endif
+  return i;
 }
 
-detail::json_const_array_iterator ArrayEnd(const detail::json &o) {
-#ifdef TINYGLTF_USE_RAPIDJSON
-  return o.End();
+template <>
+inline size_t ConvertPacked<uint16_t, uint32_t>(const unsigned char *src,
+                                                size_t n, float, float,
+                                                uint32_t *dst) {
+  size_t i = 0;
+#if defined(TINYGLTF_INTERNAL_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 8 <= n; i += 8) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2));
+    __m128i *d = reinterpret_cast<__m128i *>(dst + i);
+    _mm_storeu_si128(d, _mm_unpacklo_epi16(v, zero));
+    _mm_storeu_si128(d + 1, _mm_unpackhi_epi16(v, zero));
+  }
+#elif defined(TINYGLTF_INTERNAL_NEON)
+  for (; i + 8 <= n; i += 8) {
+    const uint16x8_t v = vreinterpretq_u16_u8(vld1q_u8(src + i * 2));
+    vst1q_u32(dst + i, vmovl_u16(vget_low_u16(v)));
+    vst1q_u32(dst + i + 4, vmovl_u16(vget_high_u16(v)));
+  }
 #else
-  return o.end();
+  (void)src;
+  (void)n;
+  (void)dst;
 #endif
+  return i;
+}
+
+// Reads `count` elements of `components` S values, `stride` bytes apart,
+// into packed D values. See ConvertPacked for `scale` and `lo`.
+template <typename S, typename D>
+void ConvertAccessor(const unsigned char *src, size_t stride, size_t count,
+                     size_t components, float scale, float lo, D *dst) {
+  const size_t n = count * components;
+  size_t done = 0;
+  if (stride == components * sizeof(S)) {
+    done = ConvertPacked<S, D>(src, n, scale, lo, dst);
+  }
+  for (size_t i = done; i < n; i++) {
+    const size_t e = i / components;
+    const size_t c = i - e * components;
+    S v;
+    memcpy(&v, src + e * stride + c * sizeof(S), sizeof(S));
+    dst[i] = static_cast<D>(v);
+  }
+  if (scale != 1.0f) {
+    for (size_t i = done; i < n; i++) {
+      dst[i] = static_cast<D>((std::max)(float(dst[i]) * scale, lo));
+    }
+  }
+}
+
+// Normalized integer mapping, glTF 2.0 spec 3.11.
+template <typename S>
+void NormalizeParams(bool normalized, float *scale, float *lo) {
+  (*scale) = 1.0f;
+  (*lo) = -(std::numeric_limits<float>::max)();
+  if (normalized && std::numeric_limits<S>::is_integer) {
+    (*scale) = 1.0f / float((std::numeric_limits<S>::max)());
+    if (std::numeric_limits<S>::is_signed) (*lo) = -1.0f;
+  }
+}
+
+// Converts `count` elements of `components` values of `component_type`,
+// `stride` bytes apart, into packed D values.
+template <typename D>
+bool ConvertComponents(int component_type, bool normalized,
+                       const unsigned char *src, size_t stride, size_t count,
+                       size_t components, D *dst, std::string *err) {
+  const size_t c = components;
+  float scale = 1.0f;
+  float lo = 0.0f;
+  switch (component_type) {
+    case TINYGLTF_COMPONENT_TYPE_BYTE:
+      NormalizeParams<int8_t>(normalized, &scale, &lo);
+      ConvertAccessor<int8_t>(src, stride, count, c, scale, lo, dst);
+      break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+      NormalizeParams<uint8_t>(normalized, &scale, &lo);
+      ConvertAccessor<uint8_t>(src, stride, count, c, scale, lo, dst);
+      break;
+    case TINYGLTF_COMPONENT_TYPE_SHORT:
+      NormalizeParams<int16_t>(normalized, &scale, &lo);
+      ConvertAccessor<int16_t>(src, stride, count, c, scale, lo, dst);
+      break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+      NormalizeParams<uint16_t>(normalized, &scale, &lo);
+      ConvertAccessor<uint16_t>(src, stride, count, c, scale, lo, dst);
+      break;
+    case TINYGLTF_COMPONENT_TYPE_INT:
+      ConvertAccessor<int32_t>(src, stride, count, c, 1.0f, 0.0f, dst);
+      break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+      ConvertAccessor<uint32_t>(src, stride, count, c, 1.0f, 0.0f, dst);
+      break;
+    case TINYGLTF_COMPONENT_TYPE_FLOAT:
+      ConvertAccessor<float>(src, stride, count, c, 1.0f, 0.0f, dst);
+      break;
+    case TINYGLTF_COMPONENT_TYPE_DOUBLE:
+      ConvertAccessor<double>(src, stride, count, c, 1.0f, 0.0f, dst);
+      break;
+    default:
+      if (err) {
+        (*err) += "Invalid accessor componentType.\n";
+      }
+      return false;
+  }
+  return true;
 }
 
-bool IsObject(const detail::json &o) {
-#ifdef TINYGLTF_USE_RAPIDJSON
-  return o.IsObject();
-#else
-  return o.is_object();
-#endif
+// Returns the start of a tightly packed sparse sub-array(`indices` or
+// `values`) of `size` bytes after checking it against its bufferView and
+// buffer.
+static const unsigned char *GetSparseSubArray(const Model &model,
+                                              int buffer_view,
+                                              size_t byte_offset, size_t size,
+                                              std::string *err) {
+  if (buffer_view < 0 || size_t(buffer_view) >= model.bufferViews.size()) {
+    if (err) {
+      (*err) += "Sparse accessor has no valid bufferView.\n";
+    }
+    return nullptr;
+  }
+  const BufferView &view = model.bufferViews[size_t(buffer_view)];
+  if (view.buffer < 0 || size_t(view.buffer) >= model.buffers.size() ||
+      byte_offset + size > view.byteLength ||
+      view.byteOffset + view.byteLength >
+          model.buffers[size_t(view.buffer)].Size()) {
+    if (err) {
+      (*err) += "Sparse accessor exceeds its bufferView or buffer.\n";
+    }
+    return nullptr;
+  }
+  return model.buffers[size_t(view.buffer)].Data() + view.byteOffset +
+         byte_offset;
 }
 
-detail::json_const_iterator ObjectBegin(const detail::json &o) {
-#ifdef TINYGLTF_USE_RAPIDJSON
-  return o.MemberBegin();
-#else
-  return o.begin();
-#endif
+// Widens the sparse indices of `accessor` to uint32_t and locates its
+// tightly packed sparse values.
+static bool GetSparseData(const Model &model, const Accessor &accessor,
+                          size_t element_size, std::vector<uint32_t> *indices,
+                          const unsigned char **values, std::string *err) {
+  const Accessor::Sparse &sparse = accessor.sparse;
+  const int index_type = sparse.indices.componentType;
+  if (sparse.count < 0 || size_t(sparse.count) > accessor.count ||
+      (index_type != TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE &&
+       index_type != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT &&
+       index_type != TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT)) {
+    if (err) {
+      (*err) += "Invalid sparse accessor count or indices componentType.\n";
+    }
+    return false;
+  }
+  const size_t count = size_t(sparse.count);
+  const size_t index_size =
+      size_t(GetComponentSizeInBytes(static_cast<uint32_t>(index_type)));
+  const unsigned char *index_data =
+      GetSparseSubArray(model, sparse.indices.bufferView,
+                        sparse.indices.byteOffset, count * index_size, err);
+  (*values) =
+      GetSparseSubArray(model, sparse.values.bufferView,
+                        sparse.values.byteOffset, count * element_size, err);
+  if (!index_data || !(*values)) {
+    return false;
+  }
+
+  indices->resize(count);
+  ConvertComponents(index_type, false, index_data, index_size, count, 1,
+                    indices->data(), err);
+  for (size_t k = 0; k < count; k++) {
+    if ((*indices)[k] >= accessor.count) {
+      if (err) {
+        (*err) += "Sparse accessor index out of range.\n";
+      }
+      return false;
+    }
+  }
+  return true;
 }
 
-detail::json_const_iterator ObjectEnd(const detail::json &o) {
-#ifdef TINYGLTF_USE_RAPIDJSON
-  return o.MemberEnd();
-#else
-  return o.end();
-#endif
+// ScatterElements() for elements of kBytes bytes. With the size known at
+// compile time each copy is one or two register moves instead of a memcpy
+// call.
+template <size_t kBytes>
+void ScatterFixed(const std::vector<uint32_t> &indices,
+                  const unsigned char *values, unsigned char *dst) {
+  for (size_t k = 0; k < indices.size(); k++) {
+    memcpy(dst + size_t(indices[k]) * kBytes, values + k * kBytes, kBytes);
+  }
 }
 
-// Making this a const char* results in a pointer to a temporary when
-// TINYGLTF_USE_RAPIDJSON is off.
-std::string GetKey(detail::json_const_iterator &it) {
-#ifdef TINYGLTF_USE_RAPIDJSON
-  return it->name.GetString();
-#else
-  return it.key().c_str();
-#endif
+// dst[indices[k]] = values[k] for elements of `n` T values. The indices are
+// arbitrary, so elements are copied one at a time; the common 4 to 16 byte
+// sizes(scalars, VEC2-VEC4 floats) get fixed-size copies.
+template <typename T>
+void ScatterElements(const std::vector<uint32_t> &indices, const T *values,
+                     size_t n, T *dst) {
+  const unsigned char *src = reinterpret_cast<const unsigned char *>(values);
+  unsigned char *out = reinterpret_cast<unsigned char *>(dst);
+  const size_t bytes = n * sizeof(T);
+  switch (bytes) {
+    case 4:
+      ScatterFixed<4>(indices, src, out);
+      break;
+    case 8:
+      ScatterFixed<8>(indices, src, out);
+      break;
+    case 12:
+      ScatterFixed<12>(indices, src, out);
+      break;
+    case 16:
+      ScatterFixed<16>(indices, src, out);
+      break;
+    default:
+      for (size_t k = 0; k < indices.size(); k++) {
+        memcpy(out + size_t(indices[k]) * bytes, src + k * bytes, bytes);
+      }
+      break;
+  }
 }
 
-bool FindMember(const detail::json &o, const char *member,
-                detail::json_const_iterator &it) {
-#ifdef TINYGLTF_USE_RAPIDJSON
-  if (!o.IsObject()) {
-    return false;
+// ConvertComponents() for `count` elements of `accessor`, `stride` bytes
+// apart, skipping the padding after each matrix column.
+template <typename D>
+bool ConvertElements(const Accessor &accessor, bool normalized,
+                     const unsigned char *src, size_t stride, size_t count,
+                     D *dst, std::string *err) {
+  const uint32_t type = static_cast<uint32_t>(accessor.type);
+  const size_t c = size_t(GetNumComponentsInType(type));
+  const size_t columns = size_t(GetNumColumnsInType(type));
+  const size_t rows = c / columns;
+  const size_t column_stride = size_t(GetColumnStrideInBytes(
+      static_cast<uint32_t>(accessor.componentType), type));
+  const size_t component_size = size_t(
+      GetComponentSizeInBytes(static_cast<uint32_t>(accessor.componentType)));
+  if (column_stride == rows * component_size) {
+    return ConvertComponents(accessor.componentType, normalized, src, stride,
+                             count, c, dst, err);
+  }
+  // Padded columns: convert them as `rows`-vectors. When the elements are
+  // packed, all columns are evenly spaced and one call covers them.
+  if (stride == columns * column_stride) {
+    return ConvertComponents(accessor.componentType, normalized, src,
+                             column_stride, count * columns, rows, dst, err);
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (!ConvertComponents(accessor.componentType, normalized, src + i * stride,
+                           column_stride, columns, rows, dst + i * c, err)) {
+      return false;
+    }
   }
-  it = o.FindMember(member);
-  return it != o.MemberEnd();
-#else
-  it = o.find(member);
-  return it != o.end();
-#endif
+  return true;
 }
 
-bool FindMember(detail::json &o, const char *member,
-                detail::json_iterator &it) {
-#ifdef TINYGLTF_USE_RAPIDJSON
-  if (!o.IsObject()) {
+template <typename D>
+bool ReadAccessorAs(const Model &model, const Accessor &accessor,
+                    std::vector<D> *out, std::string *err) {
+  const int components =
+      GetNumComponentsInType(static_cast<uint32_t>(accessor.type));
+  const int element_size =
+      GetElementSizeInBytes(static_cast<uint32_t>(accessor.componentType),
+                            static_cast<uint32_t>(accessor.type));
+  if (components <= 0 || element_size <= 0) {
+    if (err) {
+      (*err) += "Invalid accessor type or componentType.\n";
+    }
     return false;
   }
-  it = o.FindMember(member);
-  return it != o.MemberEnd();
-#else
-  it = o.find(member);
-  return it != o.end();
-#endif
-}
+  const size_t c = size_t(components);
+  const size_t n = accessor.count * c;
+  // Integer outputs keep the raw values.
+  const bool normalized =
+      accessor.normalized && !std::numeric_limits<D>::is_integer;
 
-void Erase(detail::json &o, detail::json_iterator &it) {
-#ifdef TINYGLTF_USE_RAPIDJSON
-  o.EraseMember(it);
-#else
-  o.erase(it);
-#endif
-}
+  if (accessor.bufferView < 0) {
+    out->assign(n, D(0));
+  } else {
+    const unsigned char *src = nullptr;
+    size_t stride = 0;
+    if (!GetAccessorData(model, accessor, &src, &stride, err)) {
+      return false;
+    }
+    out->resize(n);
+    if (!ConvertElements(accessor, normalized, src, stride, accessor.count,
+                         out->data(), err)) {
+      return false;
+    }
+  }
 
-bool IsEmpty(const detail::json &o) {
-#ifdef TINYGLTF_USE_RAPIDJSON
-  return o.ObjectEmpty();
-#else
-  return o.empty();
-#endif
+  if (accessor.sparse.isSparse) {
+    std::vector<uint32_t> indices;
+    const unsigned char *values = nullptr;
+    if (!GetSparseData(model, accessor, size_t(element_size), &indices,
+                       &values, err)) {
+      return false;
+    }
+    std::vector<D> patch(indices.size() * c);
+    ConvertElements(accessor, normalized, values, size_t(element_size),
+                    indices.size(), patch.data(), err);
+    ScatterElements(indices, patch.data(), c, out->data());
+  }
+  return true;
 }
 
-const detail::json &GetValue(detail::json_const_iterator &it) {
-#ifdef TINYGLTF_USE_RAPIDJSON
-  return it->value;
-#else
-  return it.value();
-#endif
+}  // namespace detail
+
+bool ReadAccessor(const Model &model, const Accessor &accessor,
+                  std::vector<float> *out, std::string *err) {
+  return detail::ReadAccessorAs(model, accessor, out, err);
 }
 
-detail::json &GetValue(detail::json_iterator &it) {
-#ifdef TINYGLTF_USE_RAPIDJSON
-  return it->value;
-#else
-  return it.value();
-#endif
+bool ReadAccessor(const Model &model, const Accessor &accessor,
+                  std::vector<uint32_t> *out, std::string *err) {
+  if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT ||
+      accessor.componentType == TINYGLTF_COMPONENT_TYPE_DOUBLE) {
+    if (err) {
+      (*err) += "Cannot read a float accessor as uint32_t.\n";
+    }
+    return false;
+  }
+  return detail::ReadAccessorAs(model, accessor, out, err);
 }
 
-std::string JsonToString(const detail::json &o, int spacing = -1) {
-#ifdef TINYGLTF_USE_RAPIDJSON
-  using namespace rapidjson;
-  StringBuffer buffer;
-  if (spacing == -1) {
-    Writer<StringBuffer> writer(buffer);
-    // TODO: Better error handling.
-    // https://github.com/syoyo/tinygltf/issues/332
-    if (!o.Accept(writer)) {
-      return "tiny_gltf::JsonToString() failed rapidjson conversion";
+bool ResolveSparseAccessor(const Model &model, const Accessor &accessor,
+                           std::vector<unsigned char> *out, std::string *err) {
+  const int element_bytes =
+      GetElementSizeInBytes(static_cast<uint32_t>(accessor.componentType),
+                            static_cast<uint32_t>(accessor.type));
+  if (element_bytes <= 0) {
+    if (err) {
+      (*err) += "Invalid accessor type or componentType.\n";
     }
+    return false;
+  }
+  const size_t element_size = size_t(element_bytes);
+
+  if (accessor.bufferView < 0) {
+    out->assign(accessor.count * element_size, 0);
   } else {
-    PrettyWriter<StringBuffer> writer(buffer);
-    writer.SetIndent(' ', uint32_t(spacing));
-    if (!o.Accept(writer)) {
-      return "tiny_gltf::JsonToString() failed rapidjson conversion";
+    const unsigned char *src = nullptr;
+    size_t stride = 0;
+    if (!GetAccessorData(model, accessor, &src, &stride, err)) {
+      return false;
+    }
+    out->resize(accessor.count * element_size);
+    if (stride == element_size) {
+      if (!out->empty()) memcpy(out->data(), src, out->size());
+    } else {
+      for (size_t i = 0; i < accessor.count; i++) {
+        memcpy(out->data() + i * element_size, src + i * stride,
+               element_size);
+      }
     }
   }
-  return buffer.GetString();
-#else
-  return o.dump(spacing);
-#endif
+
+  if (accessor.sparse.isSparse) {
+    std::vector<uint32_t> indices;
+    const unsigned char *values = nullptr;
+    if (!detail::GetSparseData(model, accessor, element_size, &indices,
+                               &values, err)) {
+      return false;
+    }
+    detail::ScatterElements(indices, values, element_size, out->data());
+  }
+  return true;
 }
 
-}  // namespace detail
+const std::vector<unsigned char> *SparseAccessorCache::Get(int accessor_idx,
+                                                           std::string *err) {
+  if (accessor_idx < 0 || size_t(accessor_idx) >= model_->accessors.size()) {
+    if (err) {
+      (*err) += "Invalid accessor index.\n";
+    }
+    return nullptr;
+  }
+  std::map<int, std::vector<unsigned char> >::iterator it =
+      resolved_.find(accessor_idx);
+  if (it != resolved_.end()) {
+    return &it->second;
+  }
+  std::vector<unsigned char> dense;
+  if (!ResolveSparseAccessor(*model_, model_->accessors[size_t(accessor_idx)],
+                             &dense, err)) {
+    return nullptr;
+  }
+  return &(resolved_[accessor_idx] = std::move(dense));
+}
 
-static bool ParseJsonAsValue(Value *ret, const detail::json &o) {
-  Value val{};
-#ifdef TINYGLTF_USE_RAPIDJSON
-  using rapidjson::Type;
-  switch (o.GetType()) {
-    case Type::kObjectType: {
-      Value::Object value_object;
-      for (auto it = o.MemberBegin(); it != o.MemberEnd(); ++it) {
-        Value entry;
-        ParseJsonAsValue(&entry, it->value);
-        if (entry.Type() != NULL_TYPE)
-          value_object.emplace(detail::GetKey(it), std::move(entry));
-      }
-      if (value_object.size() > 0) val = Value(std::move(value_object));
-    } break;
-    case Type::kArrayType: {
-      Value::Array value_array;
-      value_array.reserve(o.Size());
-      for (auto it = o.Begin(); it != o.End(); ++it) {
-        Value entry;
-        ParseJsonAsValue(&entry, *it);
-        if (entry.Type() != NULL_TYPE)
-          value_array.emplace_back(std::move(entry));
-      }
-      if (value_array.size() > 0) val = Value(std::move(value_array));
-    } break;
-    case Type::kStringType:
-      val = Value(std::string(o.GetString()));
-      break;
-    case Type::kFalseType:
-    case Type::kTrueType:
-      val = Value(o.GetBool());
-      break;
-    case Type::kNumberType:
-      if (!o.IsDouble()) {
-        int i = 0;
-        detail::GetInt(o, i);
-        val = Value(i);
-      } else {
-        double d = 0.0;
-        detail::GetDouble(o, d);
-        val = Value(d);
-      }
-      break;
-    case Type::kNullType:
-      break;
-      // all types are covered, so no `case default`
-  }
-#else
-  switch (o.type()) {
-    case detail::json::value_t::object: {
-      Value::Object value_object;
-      for (auto it = o.begin(); it != o.end(); it++) {
-        Value entry;
-        ParseJsonAsValue(&entry, it.value());
-        if (entry.Type() != NULL_TYPE)
-          value_object.emplace(it.key(), std::move(entry));
-      }
-      if (value_object.size() > 0) val = Value(std::move(value_object));
-    } break;
-    case detail::json::value_t::array: {
-      Value::Array value_array;
-      value_array.reserve(o.size());
-      for (auto it = o.begin(); it != o.end(); it++) {
-        Value entry;
-        ParseJsonAsValue(&entry, it.value());
-        if (entry.Type() != NULL_TYPE)
-          value_array.emplace_back(std::move(entry));
-      }
-      if (value_array.size() > 0) val = Value(std::move(value_array));
-    } break;
-    case detail::json::value_t::string:
-      val = Value(o.get<std::string>());
-      break;
-    case detail::json::value_t::boolean:
-      val = Value(o.get<bool>());
-      break;
-    case detail::json::value_t::number_integer:
-    case detail::json::value_t::number_unsigned:
-      val = Value(static_cast<int>(o.get<int64_t>()));
-      break;
-    case detail::json::value_t::number_float:
-      val = Value(o.get<double>());
-      break;
-    case detail::json::value_t::null:
-    case detail::json::value_t::discarded:
-    case detail::json::value_t::binary:
-      // default:
-      break;
-  }
-#endif
-  const bool isNotNull = val.Type() != NULL_TYPE;
-
-  if (ret) *ret = std::move(val);
+namespace detail {
 
-  return isNotNull;
+// Four floats, one per node, for the FlatScene transform passes.
+#if defined(TINYGLTF_INTERNAL_SSE2)
+typedef __m128 Float4;
+inline Float4 Load4(const float *p) { return _mm_loadu_ps(p); }
+inline void Store4(float *p, Float4 v) { _mm_storeu_ps(p, v); }
+inline Float4 Splat4(float s) { return _mm_set1_ps(s); }
+inline Float4 Add4(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+inline Float4 Sub4(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+inline Float4 Mul4(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+#elif defined(TINYGLTF_INTERNAL_NEON)
+typedef float32x4_t Float4;
+inline Float4 Load4(const float *p) { return vld1q_f32(p); }
+inline void Store4(float *p, Float4 v) { vst1q_f32(p, v); }
+inline Float4 Splat4(float s) { return vdupq_n_f32(s); }
+inline Float4 Add4(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+inline Float4 Sub4(Float4 a, Float4 b) { return vsubq_f32(a, b); }
+inline Float4 Mul4(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+#else
+struct Float4 {
+  float v[4];
+};
+inline Float4 Load4(const float *p) {
+  Float4 r;
+  memcpy(r.v, p, sizeof(r.v));
+  return r;
 }
-
-static bool ParseExtrasProperty(Value *ret, const detail::json &o) {
-  detail::json_const_iterator it;
-  if (!detail::FindMember(o, "extras", it)) {
-    return false;
-  }
-
-  return ParseJsonAsValue(ret, detail::GetValue(it));
+inline void Store4(float *p, Float4 v) { memcpy(p, v.v, sizeof(v.v)); }
+inline Float4 Splat4(float s) {
+  Float4 r = {{s, s, s, s}};
+  return r;
+}
+inline Float4 Add4(Float4 a, Float4 b) {
+  for (int k = 0; k < 4; k++) a.v[k] += b.v[k];
+  return a;
+}
+inline Float4 Sub4(Float4 a, Float4 b) {
+  for (int k = 0; k < 4; k++) a.v[k] -= b.v[k];
+  return a;
 }
+inline Float4 Mul4(Float4 a, Float4 b) {
+  for (int k = 0; k < 4; k++) a.v[k] *= b.v[k];
+  return a;
+}
+#endif
 
-static bool ParseBooleanProperty(bool *ret, std::string *err,
-                                 const detail::json &o,
-                                 const std::string &property,
-                                 const bool required,
-                                 const std::string &parent_node = "") {
-  detail::json_const_iterator it;
-  if (!detail::FindMember(o, property.c_str(), it)) {
-    if (required) {
-      if (err) {
-        (*err) += "'" + property + "' property is missing";
-        if (!parent_node.empty()) {
-          (*err) += " in " + parent_node;
-        }
-        (*err) += ".\n";
-      }
+}  // namespace detail
+
+void FlatScene::Clear() {
+  nodes_.clear();
+  parents_.clear();
+  subtree_end_.clear();
+  flat_index_.clear();
+  for (int k = 0; k < 3; k++) t_[k].clear();
+  for (int k = 0; k < 4; k++) r_[k].clear();
+  for (int k = 0; k < 3; k++) s_[k].clear();
+  for (int k = 0; k < 16; k++) local_[k].clear();
+  world_.clear();
+  from_trs_.clear();
+  dirty_.clear();
+  queued_.clear();
+}
+
+bool FlatScene::Build(const Model &model, int scene, std::string *err) {
+  Clear();
+  if (scene < 0 || size_t(scene) >= model.scenes.size()) {
+    if (err) {
+      (*err) += "Invalid scene index.\n";
     }
     return false;
   }
 
-  auto &value = detail::GetValue(it);
-
-  bool isBoolean;
-  bool boolValue = false;
-#ifdef TINYGLTF_USE_RAPIDJSON
-  isBoolean = value.IsBool();
-  if (isBoolean) {
-    boolValue = value.GetBool();
-  }
-#else
-  isBoolean = value.is_boolean();
-  if (isBoolean) {
-    boolValue = value.get<bool>();
+  // Depth first, so each subtree is contiguous and follows its root.
+  std::vector<std::pair<int, int> > stack;  // node, parent's flat index
+  const std::vector<int> &roots = model.scenes[size_t(scene)].nodes;
+  for (size_t i = roots.size(); i > 0; i--) {
+    stack.push_back(std::make_pair(roots[i - 1], -1));
   }
-#endif
-  if (!isBoolean) {
-    if (required) {
+  flat_index_.assign(model.nodes.size(), -1);
+  while (!stack.empty()) {
+    const int node = stack.back().first;
+    const int parent = stack.back().second;
+    stack.pop_back();
+    if (node < 0 || size_t(node) >= model.nodes.size() ||
+        flat_index_[size_t(node)] >= 0) {
       if (err) {
-        (*err) += "'" + property + "' property is not a bool type.\n";
+        (*err) += "Invalid or repeated node " + std::to_string(node) +
+                  " in scene " + std::to_string(scene) + ".\n";
       }
+      Clear();
+      return false;
+    }
+    flat_index_[size_t(node)] = int(nodes_.size());
+    nodes_.push_back(node);
+    parents_.push_back(parent);
+    const std::vector<int> &children = model.nodes[size_t(node)].children;
+    for (size_t c = children.size(); c > 0; c--) {
+      stack.push_back(std::make_pair(children[c - 1], int(nodes_.size() - 1)));
     }
-    return false;
   }
 
-  if (ret) {
-    (*ret) = boolValue;
+  const size_t n = nodes_.size();
+  subtree_end_.resize(n);
+  for (size_t i = n; i > 0; i--) {
+    const size_t end = std::max(size_t(subtree_end_[i - 1]), i);
+    subtree_end_[i - 1] = int(end);
+    if (parents_[i - 1] >= 0) {
+      int &parent_end = subtree_end_[size_t(parents_[i - 1])];
+      parent_end = std::max(parent_end, int(end));
+    }
   }
 
+  const size_t padded = (n + 3) & ~size_t(3);
+  const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+  for (int k = 0; k < 3; k++) t_[k].assign(padded, 0.0f);
+  for (int k = 0; k < 4; k++) r_[k].assign(padded, k == 3 ? 1.0f : 0.0f);
+  for (int k = 0; k < 3; k++) s_[k].assign(padded, 1.0f);
+  for (int k = 0; k < 16; k++) local_[k].assign(padded, identity[k]);
+  world_.resize(n * 16);
+  from_trs_.assign(padded, 1);
+  queued_.assign(n, 0);
+
+  for (size_t i = 0; i < n; i++) {
+    const Node &node = model.nodes[size_t(nodes_[i])];
+    if (node.matrix.size() == 16) {
+      float m[16];
+      for (int k = 0; k < 16; k++) m[k] = float(node.matrix[size_t(k)]);
+      SetMatrix(i, m);
+      continue;
+    }
+    if (node.translation.size() == 3) {
+      SetTranslation(i, float(node.translation[0]),
+                     float(node.translation[1]), float(node.translation[2]));
+    }
+    if (node.rotation.size() == 4) {
+      SetRotation(i, float(node.rotation[0]), float(node.rotation[1]),
+                  float(node.rotation[2]), float(node.rotation[3]));
+    }
+    if (node.scale.size() == 3) {
+      SetScale(i, float(node.scale[0]), float(node.scale[1]),
+               float(node.scale[2]));
+    }
+    MarkDirty(i);
+  }
+  Update();
   return true;
 }
 
-static bool ParseIntegerProperty(int *ret, std::string *err,
-                                 const detail::json &o,
-                                 const std::string &property,
-                                 const bool required,
-                                 const std::string &parent_node = "") {
-  detail::json_const_iterator it;
-  if (!detail::FindMember(o, property.c_str(), it)) {
-    if (required) {
-      if (err) {
-        (*err) += "'" + property + "' property is missing";
-        if (!parent_node.empty()) {
-          (*err) += " in " + parent_node;
-        }
-        (*err) += ".\n";
-      }
+void FlatScene::MarkDirty(size_t i) {
+  if (!queued_[i]) {
+    queued_[i] = 1;
+    dirty_.push_back(int(i));
+  }
+}
+
+void FlatScene::UseTRS(size_t i) {
+  if (!from_trs_[i]) {
+    // Leaving the matrix behind; unset components are the identity.
+    from_trs_[i] = 1;
+    for (int k = 0; k < 3; k++) t_[k][i] = 0.0f;
+    for (int k = 0; k < 4; k++) r_[k][i] = k == 3 ? 1.0f : 0.0f;
+    for (int k = 0; k < 3; k++) s_[k][i] = 1.0f;
+  }
+  MarkDirty(i);
+}
+
+void FlatScene::SetTranslation(size_t i, float x, float y, float z) {
+  UseTRS(i);
+  t_[0][i] = x;
+  t_[1][i] = y;
+  t_[2][i] = z;
+}
+
+void FlatScene::SetRotation(size_t i, float x, float y, float z, float w) {
+  UseTRS(i);
+  r_[0][i] = x;
+  r_[1][i] = y;
+  r_[2][i] = z;
+  r_[3][i] = w;
+}
+
+void FlatScene::SetScale(size_t i, float x, float y, float z) {
+  UseTRS(i);
+  s_[0][i] = x;
+  s_[1][i] = y;
+  s_[2][i] = z;
+}
+
+void FlatScene::SetMatrix(size_t i, const float m[16]) {
+  from_trs_[i] = 0;
+  for (int k = 0; k < 16; k++) local_[k][i] = m[k];
+  MarkDirty(i);
+}
+
+// Local matrices T * R * S of the 4 nodes from `begin`. Nodes built from a
+// matrix keep theirs, and unchanged ones get identical values again.
+void FlatScene::UpdateLocal(size_t begin) {
+  using namespace detail;
+  const Float4 x = Load4(&r_[0][begin]);
+  const Float4 y = Load4(&r_[1][begin]);
+  const Float4 z = Load4(&r_[2][begin]);
+  const Float4 w = Load4(&r_[3][begin]);
+  const Float4 one = Splat4(1.0f);
+  const Float4 x2 = Add4(x, x), y2 = Add4(y, y), z2 = Add4(z, z);
+  const Float4 xx = Mul4(x, x2), yy = Mul4(y, y2), zz = Mul4(z, z2);
+  const Float4 xy = Mul4(x, y2), xz = Mul4(x, z2), yz = Mul4(y, z2);
+  const Float4 wx = Mul4(w, x2), wy = Mul4(w, y2), wz = Mul4(w, z2);
+  const Float4 sx = Load4(&s_[0][begin]);
+  const Float4 sy = Load4(&s_[1][begin]);
+  const Float4 sz = Load4(&s_[2][begin]);
+
+  Float4 m[16];
+  m[0] = Mul4(Sub4(one, Add4(yy, zz)), sx);
+  m[1] = Mul4(Add4(xy, wz), sx);
+  m[2] = Mul4(Sub4(xz, wy), sx);
+  m[4] = Mul4(Sub4(xy, wz), sy);
+  m[5] = Mul4(Sub4(one, Add4(xx, zz)), sy);
+  m[6] = Mul4(Add4(yz, wx), sy);
+  m[8] = Mul4(Add4(xz, wy), sz);
+  m[9] = Mul4(Sub4(yz, wx), sz);
+  m[10] = Mul4(Sub4(one, Add4(xx, yy)), sz);
+  m[3] = m[7] = m[11] = Splat4(0.0f);
+  m[12] = Load4(&t_[0][begin]);
+  m[13] = Load4(&t_[1][begin]);
+  m[14] = Load4(&t_[2][begin]);
+  m[15] = one;
+
+  const bool all_trs = from_trs_[begin] && from_trs_[begin + 1] &&
+                       from_trs_[begin + 2] && from_trs_[begin + 3];
+  for (int k = 0; k < 16; k++) {
+    if (all_trs) {
+      Store4(&local_[k][begin], m[k]);
+      continue;
+    }
+    float lanes[4];
+    Store4(lanes, m[k]);
+    for (size_t j = 0; j < 4; j++) {
+      if (from_trs_[begin + j]) local_[k][begin + j] = lanes[j];
+    }
+  }
+}
+
+void FlatScene::UpdateWorld(size_t i) {
+  using namespace detail;
+  float *world = &world_[i * 16];
+  const int parent = parents_[i];
+  if (parent < 0) {
+    for (int k = 0; k < 16; k++) world[k] = local_[k][i];
+    return;
+  }
+  // world = parent * local, a column at a time.
+  const float *p = &world_[size_t(parent) * 16];
+  const Float4 p0 = Load4(p);
+  const Float4 p1 = Load4(p + 4);
+  const Float4 p2 = Load4(p + 8);
+  const Float4 p3 = Load4(p + 12);
+  for (int c = 0; c < 4; c++) {
+    Float4 col = Mul4(p0, Splat4(local_[c * 4][i]));
+    col = Add4(col, Mul4(p1, Splat4(local_[c * 4 + 1][i])));
+    col = Add4(col, Mul4(p2, Splat4(local_[c * 4 + 2][i])));
+    col = Add4(col, Mul4(p3, Splat4(local_[c * 4 + 3][i])));
+    Store4(world + c * 4, col);
+  }
+}
+
+void FlatScene::Update() {
+  if (dirty_.empty()) return;
+  if (!std::is_sorted(dirty_.begin(), dirty_.end())) {
+    std::sort(dirty_.begin(), dirty_.end());
+  }
+
+  size_t block = size_t(-1);
+  for (size_t d = 0; d < dirty_.size(); d++) {
+    const size_t i = size_t(dirty_[d]);
+    queued_[i] = 0;
+    if (from_trs_[i] && (i & ~size_t(3)) != block) {
+      block = i & ~size_t(3);
+      UpdateLocal(block);
+    }
+  }
+
+  // Parents come first and subtrees are contiguous, so each changed node
+  // refreshes the range up to its subtree end, in order.
+  size_t done = 0;
+  for (size_t d = 0; d < dirty_.size(); d++) {
+    const size_t i = size_t(dirty_[d]);
+    if (i < done) continue;
+    done = size_t(subtree_end_[i]);
+    for (size_t j = i; j < done; j++) {
+      UpdateWorld(j);
+    }
+  }
+  dirty_.clear();
+}
+
+bool AnimationEvaluator::Init(const Model &model, int animation,
+                              std::string *err) {
+  samplers_.clear();
+  channels_.clear();
+  outputs_.clear();
+  duration_ = 0.0f;
+  if (animation < 0 || size_t(animation) >= model.animations.size()) {
+    if (err) {
+      (*err) += "Invalid animation index.\n";
     }
     return false;
   }
-
-  int intValue;
-  bool isInt = detail::GetInt(detail::GetValue(it), intValue);
-  if (!isInt) {
-    if (required) {
+  const Animation &anim = model.animations[size_t(animation)];
+
+  samplers_.resize(anim.samplers.size());
+  for (size_t i = 0; i < anim.samplers.size(); i++) {
+    const AnimationSampler &src = anim.samplers[i];
+    Sampler &dst = samplers_[i];
+    if (src.interpolation == "STEP") {
+      dst.interpolation = kStep;
+    } else if (src.interpolation == "CUBICSPLINE") {
+      dst.interpolation = kCubicSpline;
+    } else if (src.interpolation == "LINEAR" || src.interpolation.empty()) {
+      dst.interpolation = kLinear;
+    } else {
       if (err) {
-        (*err) += "'" + property + "' property is not an integer type.\n";
+        (*err) += "Unsupported interpolation \"" + src.interpolation +
+                  "\" in animation sampler " + std::to_string(i) + ".\n";
       }
+      return false;
     }
-    return false;
-  }
-
-  if (ret) {
-    (*ret) = intValue;
-  }
-
-  return true;
-}
-
-static bool ParseUnsignedProperty(size_t *ret, std::string *err,
-                                  const detail::json &o,
-                                  const std::string &property,
-                                  const bool required,
-                                  const std::string &parent_node = "") {
-  detail::json_const_iterator it;
-  if (!detail::FindMember(o, property.c_str(), it)) {
-    if (required) {
+    if (src.input < 0 || size_t(src.input) >= model.accessors.size() ||
+        src.output < 0 || size_t(src.output) >= model.accessors.size()) {
       if (err) {
-        (*err) += "'" + property + "' property is missing";
-        if (!parent_node.empty()) {
-          (*err) += " in " + parent_node;
-        }
-        (*err) += ".\n";
+        (*err) += "Invalid accessor in animation sampler " +
+                  std::to_string(i) + ".\n";
       }
+      return false;
     }
-    return false;
+    const Accessor &input = model.accessors[size_t(src.input)];
+    if (input.type != TINYGLTF_TYPE_SCALAR ||
+        input.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT ||
+        input.count == 0) {
+      if (err) {
+        (*err) += "Animation sampler " + std::to_string(i) +
+                  " input must be a non-empty float SCALAR accessor.\n";
+      }
+      return false;
+    }
+    if (!ReadAccessor(model, input, &dst.times, err) ||
+        !ReadAccessor(model, model.accessors[size_t(src.output)], &dst.values,
+                      err)) {
+      return false;
+    }
+    duration_ = std::max(duration_, dst.times.back());
   }
 
-  auto &value = detail::GetValue(it);
-
-  size_t uValue = 0;
-  bool isUValue;
-#ifdef TINYGLTF_USE_RAPIDJSON
-  isUValue = false;
-  if (value.IsUint()) {
-    uValue = value.GetUint();
-    isUValue = true;
-  } else if (value.IsUint64()) {
-    uValue = value.GetUint64();
-    isUValue = true;
-  }
-#else
-  isUValue = value.is_number_unsigned();
-  if (isUValue) {
-    uValue = value.get<size_t>();
-  }
-#endif
-  if (!isUValue) {
-    if (required) {
+  channels_.resize(anim.channels.size());
+  size_t offset = 0;
+  for (size_t i = 0; i < anim.channels.size(); i++) {
+    const AnimationChannel &src = anim.channels[i];
+    Channel &dst = channels_[i];
+    if (src.sampler < 0 || size_t(src.sampler) >= samplers_.size()) {
       if (err) {
-        (*err) += "'" + property + "' property is not a positive integer.\n";
+        (*err) += "Invalid sampler in animation channel " +
+                  std::to_string(i) + ".\n";
       }
+      return false;
     }
-    return false;
+    const Sampler &sampler = samplers_[size_t(src.sampler)];
+    const int output_type =
+        model.accessors[size_t(anim.samplers[size_t(src.sampler)].output)]
+            .type;
+    int expected_type = TINYGLTF_TYPE_VEC3;
+    dst.sampler = size_t(src.sampler);
+    dst.node = src.target_node;
+    dst.path = kOther;
+    dst.components = 0;
+    dst.offset = offset;
+    dst.key = 0;
+    if (src.target_path == "translation") {
+      dst.path = kTranslation;
+      dst.components = 3;
+    } else if (src.target_path == "rotation") {
+      dst.path = kRotation;
+      dst.components = 4;
+      expected_type = TINYGLTF_TYPE_VEC4;
+    } else if (src.target_path == "scale") {
+      dst.path = kScale;
+      dst.components = 3;
+    } else if (src.target_path == "weights") {
+      dst.path = kWeights;
+      expected_type = TINYGLTF_TYPE_SCALAR;
+      const size_t per_key =
+          sampler.times.size() *
+          (sampler.interpolation == kCubicSpline ? 3 : 1);
+      dst.components = sampler.values.size() / per_key;
+    } else {
+      continue;
+    }
+    const size_t stride = sampler.interpolation == kCubicSpline
+                              ? 3 * dst.components
+                              : dst.components;
+    if (output_type != expected_type || dst.components == 0 ||
+        sampler.values.size() != sampler.times.size() * stride) {
+      if (err) {
+        (*err) += "Output of animation channel " + std::to_string(i) +
+                  " does not match its path and keyframes.\n";
+      }
+      return false;
+    }
+    offset += dst.components;
   }
+  outputs_.assign(offset, 0.0f);
+  Evaluate(0.0f);
+  return true;
+}
 
-  if (ret) {
-    (*ret) = uValue;
+size_t AnimationEvaluator::FindKey(const std::vector<float> &times,
+                                   float time, size_t key) const {
+  if (time < times[key]) {
+    return size_t(std::upper_bound(times.begin(), times.begin() + key, time) -
+                  times.begin()) -
+           1;
+  }
+  if (time < times[key + 1]) return key;
+  // Usually the next interval when time is advancing.
+  if (key + 2 < times.size() && time < times[key + 2]) return key + 1;
+  return size_t(std::upper_bound(times.begin() + key + 1, times.end(), time) -
+                times.begin()) -
+         1;
+}
+
+void AnimationEvaluator::Evaluate(float time) {
+  for (size_t c = 0; c < channels_.size(); c++) {
+    Channel &channel = channels_[c];
+    const size_t n = channel.components;
+    if (n == 0) continue;
+    const Sampler &sampler = samplers_[channel.sampler];
+    const std::vector<float> &times = sampler.times;
+    const bool cubic = sampler.interpolation == kCubicSpline;
+    const size_t stride = cubic ? 3 * n : n;
+    const float *values = sampler.values.data() + (cubic ? n : 0);
+    float *out = outputs_.data() + channel.offset;
+
+    if (times.size() == 1 || time <= times.front()) {
+      memcpy(out, values, n * sizeof(float));
+      continue;
+    }
+    if (time >= times.back()) {
+      memcpy(out, values + (times.size() - 1) * stride, n * sizeof(float));
+      continue;
+    }
+    const size_t key = FindKey(times, time, channel.key);
+    channel.key = key;
+    const float *v0 = values + key * stride;
+    const float *v1 = v0 + stride;
+    if (sampler.interpolation == kStep) {
+      memcpy(out, v0, n * sizeof(float));
+      continue;
+    }
+    const float dt = times[key + 1] - times[key];
+    const float u = dt > 0.0f ? (time - times[key]) / dt : 0.0f;
+
+    if (cubic) {
+      // Hermite spline through v0 and v1 with out-tangent b0 of key and
+      // in-tangent a1 of key + 1, both scaled by the interval.
+      const float u2 = u * u;
+      const float u3 = u2 * u;
+      const float h00 = 2.0f * u3 - 3.0f * u2 + 1.0f;
+      const float h10 = (u3 - 2.0f * u2 + u) * dt;
+      const float h01 = -2.0f * u3 + 3.0f * u2;
+      const float h11 = (u3 - u2) * dt;
+      const float *b0 = v0 + n;
+      const float *a1 = v1 - n;
+      for (size_t k = 0; k < n; k++) {
+        out[k] = h00 * v0[k] + h10 * b0[k] + h01 * v1[k] + h11 * a1[k];
+      }
+    } else if (channel.path == kRotation) {
+      // Shortest arc slerp, nlerp when nearly parallel.
+      float d = v0[0] * v1[0] + v0[1] * v1[1] + v0[2] * v1[2] + v0[3] * v1[3];
+      const float sign = d < 0.0f ? -1.0f : 1.0f;
+      d *= sign;
+      float w0 = 1.0f - u;
+      float w1 = u;
+      if (d < 0.9995f) {
+        const float angle = std::acos(d);
+        const float inv_sin = 1.0f / std::sin(angle);
+        w0 = std::sin(w0 * angle) * inv_sin;
+        w1 = std::sin(w1 * angle) * inv_sin;
+      }
+      w1 *= sign;
+      for (size_t k = 0; k < 4; k++) out[k] = w0 * v0[k] + w1 * v1[k];
+    } else {
+      for (size_t k = 0; k < n; k++) out[k] = v0[k] + u * (v1[k] - v0[k]);
+      continue;
+    }
+    if (channel.path == kRotation) {
+      const float len = std::sqrt(out[0] * out[0] + out[1] * out[1] +
+                                  out[2] * out[2] + out[3] * out[3]);
+      if (len > 0.0f) {
+        for (size_t k = 0; k < 4; k++) out[k] /= len;
+      }
+    }
   }
+}
 
-  return true;
+void AnimationEvaluator::Apply(FlatScene *scene) const {
+  for (size_t c = 0; c < channels_.size(); c++) {
+    const Channel &channel = channels_[c];
+    const int i = scene->Find(channel.node);
+    if (i < 0) continue;
+    const float *v = outputs_.data() + channel.offset;
+    switch (channel.path) {
+      case kTranslation:
+        scene->SetTranslation(size_t(i), v[0], v[1], v[2]);
+        break;
+      case kRotation:
+        scene->SetRotation(size_t(i), v[0], v[1], v[2], v[3]);
+        break;
+      case kScale:
+        scene->SetScale(size_t(i), v[0], v[1], v[2]);
+        break;
+      case kWeights:
+      case kOther:
+        break;
+    }
+  }
 }
 
-static bool ParseNumberProperty(double *ret, std::string *err,
-                                const detail::json &o,
-                                const std::string &property,
-                                const bool required,
-                                const std::string &parent_node = "") {
-  detail::json_const_iterator it;
+namespace detail {
+bool GetInt(const detail::json &o, int &val) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  if (!o.IsDouble()) {
+    if (o.IsInt()) {
+      val = o.GetInt();
+      return true;
+    } else if (o.IsUint()) {
+      val = static_cast<int>(o.GetUint());
+      return true;
+    } else if (o.IsInt64()) {
+      val = static_cast<int>(o.GetInt64());
+      return true;
+    } else if (o.IsUint64()) {
+      val = static_cast<int>(o.GetUint64());
+      return true;
+    }
+  }
+
+  return false;
+#else
+  auto type = o.type();
+
+  if ((type == detail::json::value_t::number_integer) ||
+      (type == detail::json::value_t::number_unsigned)) {
+    val = static_cast<int>(o.get<int64_t>());
+    return true;
+  }
+
+  return false;
+#endif
+}
+
+#ifdef TINYGLTF_USE_RAPIDJSON
+bool GetDouble(const detail::json &o, double &val) {
+  if (o.IsDouble()) {
+    val = o.GetDouble();
+    return true;
+  }
+
+  return false;
+}
+#endif
+
+bool GetNumber(const detail::json &o, double &val) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  if (o.IsNumber()) {
+    val = o.GetDouble();
+    return true;
+  }
+
+  return false;
+#else
+  if (o.is_number()) {
+    val = o.get<double>();
+    return true;
+  }
+
+  return false;
+#endif
+}
+
+bool GetString(const detail::json &o, std::string &val) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  if (o.IsString()) {
+    val = o.GetString();
+    return true;
+  }
+
+  return false;
+#else
+  if (o.type() == detail::json::value_t::string) {
+    val = o.get<std::string>();
+    return true;
+  }
+
+  return false;
+#endif
+}
+
+bool IsArray(const detail::json &o) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  return o.IsArray();
+#else
+  return o.is_array();
+#endif
+}
+
+detail::json_const_array_iterator ArrayBegin(const detail::json &o) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  return o.Begin();
+#else
+  return o.begin();
+#endif
+}
+
+detail::json_const_array_iterator ArrayEnd(const detail::json &o) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  return o.End();
+#else
+  return o.end();
+#endif
+}
+
+bool IsObject(const detail::json &o) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  return o.IsObject();
+#else
+  return o.is_object();
+#endif
+}
+
+detail::json_const_iterator ObjectBegin(const detail::json &o) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  return o.MemberBegin();
+#else
+  return o.begin();
+#endif
+}
+
+detail::json_const_iterator ObjectEnd(const detail::json &o) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  return o.MemberEnd();
+#else
+  return o.end();
+#endif
+}
+
+// Making this a const char* results in a pointer to a temporary when
+// TINYGLTF_USE_RAPIDJSON is off.
+std::string GetKey(detail::json_const_iterator &it) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  return it->name.GetString();
+#else
+  return it.key().c_str();
+#endif
+}
+
+bool FindMember(const detail::json &o, const char *member,
+                detail::json_const_iterator &it) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  if (!o.IsObject()) {
+    return false;
+  }
+  it = o.FindMember(member);
+  return it != o.MemberEnd();
+#else
+  it = o.find(member);
+  return it != o.end();
+#endif
+}
+
+bool FindMember(detail::json &o, const char *member,
+                detail::json_iterator &it) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  if (!o.IsObject()) {
+    return false;
+  }
+  it = o.FindMember(member);
+  return it != o.MemberEnd();
+#else
+  it = o.find(member);
+  return it != o.end();
+#endif
+}
+
+void Erase(detail::json &o, detail::json_iterator &it) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  o.EraseMember(it);
+#else
+  o.erase(it);
+#endif
+}
+
+bool IsEmpty(const detail::json &o) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  return o.ObjectEmpty();
+#else
+  return o.empty();
+#endif
+}
+
+const detail::json &GetValue(detail::json_const_iterator &it) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  return it->value;
+#else
+  return it.value();
+#endif
+}
+
+detail::json &GetValue(detail::json_iterator &it) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  return it->value;
+#else
+  return it.value();
+#endif
+}
+
+std::string JsonToString(const detail::json &o, int spacing = -1) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  using namespace rapidjson;
+  StringBuffer buffer;
+  if (spacing == -1) {
+    Writer<StringBuffer> writer(buffer);
+    // TODO: Better error handling.
+    // https://github.com/syoyo/tinygltf/issues/332
+    if (!o.Accept(writer)) {
+      return "tiny_gltf::JsonToString() failed rapidjson conversion";
+    }
+  } else {
+    PrettyWriter<StringBuffer> writer(buffer);
+    writer.SetIndent(' ', uint32_t(spacing));
+    if (!o.Accept(writer)) {
+      return "tiny_gltf::JsonToString() failed rapidjson conversion";
+    }
+  }
+  return buffer.GetString();
+#else
+  return o.dump(spacing);
+#endif
+}
+
+}  // namespace detail
+
+static bool ParseJsonAsValue(Value *ret, const detail::json &o) {
+  Value val{};
+#ifdef TINYGLTF_USE_RAPIDJSON
+  using rapidjson::Type;
+  switch (o.GetType()) {
+    case Type::kObjectType: {
+      Value::Object value_object;
+      value_object.reserve(o.MemberCount());
+      for (auto it = o.MemberBegin(); it != o.MemberEnd(); ++it) {
+        Value entry;
+        ParseJsonAsValue(&entry, it->value);
+        if (entry.Type() != NULL_TYPE)
+          value_object.emplace(detail::GetKey(it), std::move(entry));
+      }
+      if (value_object.size() > 0) val = Value(std::move(value_object));
+    } break;
+    case Type::kArrayType: {
+      Value::Array value_array;
+      value_array.reserve(o.Size());
+      for (auto it = o.Begin(); it != o.End(); ++it) {
+        Value entry;
+        ParseJsonAsValue(&entry, *it);
+        if (entry.Type() != NULL_TYPE)
+          value_array.emplace_back(std::move(entry));
+      }
+      if (value_array.size() > 0) val = Value(std::move(value_array));
+    } break;
+    case Type::kStringType:
+      val = Value(std::string(o.GetString()));
+      break;
+    case Type::kFalseType:
+    case Type::kTrueType:
+      val = Value(o.GetBool());
+      break;
+    case Type::kNumberType:
+      if (!o.IsDouble()) {
+        int i = 0;
+        detail::GetInt(o, i);
+        val = Value(i);
+      } else {
+        double d = 0.0;
+        detail::GetDouble(o, d);
+        val = Value(d);
+      }
+      break;
+    case Type::kNullType:
+      break;
+      // all types are covered, so no `case default`
+  }
+#else
+  switch (o.type()) {
+    case detail::json::value_t::object: {
+      Value::Object value_object;
+      value_object.reserve(o.size());
+      for (auto it = o.begin(); it != o.end(); it++) {
+        Value entry;
+        ParseJsonAsValue(&entry, it.value());
+        if (entry.Type() != NULL_TYPE)
+          value_object.emplace(it.key(), std::move(entry));
+      }
+      if (value_object.size() > 0) val = Value(std::move(value_object));
+    } break;
+    case detail::json::value_t::array: {
+      Value::Array value_array;
+      value_array.reserve(o.size());
+      for (auto it = o.begin(); it != o.end(); it++) {
+        Value entry;
+        ParseJsonAsValue(&entry, it.value());
+        if (entry.Type() != NULL_TYPE)
+          value_array.emplace_back(std::move(entry));
+      }
+      if (value_array.size() > 0) val = Value(std::move(value_array));
+    } break;
+    case detail::json::value_t::string:
+      val = Value(o.get<std::string>());
+      break;
+    case detail::json::value_t::boolean:
+      val = Value(o.get<bool>());
+      break;
+    case detail::json::value_t::number_integer:
+    case detail::json::value_t::number_unsigned:
+      val = Value(static_cast<int>(o.get<int64_t>()));
+      break;
+    case detail::json::value_t::number_float:
+      val = Value(o.get<double>());
+      break;
+    case detail::json::value_t::null:
+    case detail::json::value_t::discarded:
+    case detail::json::value_t::binary:
+      // default:
+      break;
+  }
+#endif
+  const bool isNotNull = val.Type() != NULL_TYPE;
+
+  if (ret) *ret = std::move(val);
+
+  return isNotNull;
+}
+
+static bool ParseExtrasProperty(Value *ret, const detail::json &o) {
+  detail::json_const_iterator it;
+  if (!detail::FindMember(o, "extras", it)) {
+    return false;
+  }
+
+  return ParseJsonAsValue(ret, detail::GetValue(it));
+}
+
+static bool ParseBooleanProperty(bool *ret, std::string *err,
+                                 const detail::json &o,
+                                 const std::string &property,
+                                 const bool required,
+                                 const std::string &parent_node = "") {
+  detail::json_const_iterator it;
+  if (!detail::FindMember(o, property.c_str(), it)) {
+    if (required) {
+      if (err) {
+        (*err) += "'" + property + "' property is missing";
+        if (!parent_node.empty()) {
+          (*err) += " in " + parent_node;
+        }
+        (*err) += ".\n";
+      }
+    }
+    return false;
+  }
+
+  auto &value = detail::GetValue(it);
+
+  bool isBoolean;
+  bool boolValue = false;
+#ifdef TINYGLTF_USE_RAPIDJSON
+  isBoolean = value.IsBool();
+  if (isBoolean) {
+    boolValue = value.GetBool();
+  }
+#else
+  isBoolean = value.is_boolean();
+  if (isBoolean) {
+    boolValue = value.get<bool>();
+  }
+#endif
+  if (!isBoolean) {
+    if (required) {
+      if (err) {
+        (*err) += "'" + property + "' property is not a bool type.\n";
+      }
+    }
+    return false;
+  }
+
+  if (ret) {
+    (*ret) = boolValue;
+  }
+
+  return true;
+}
+
+static bool ParseIntegerProperty(int *ret, std::string *err,
+                                 const detail::json &o,
+                                 const std::string &property,
+                                 const bool required,
+                                 const std::string &parent_node = "") {
+  detail::json_const_iterator it;
+  if (!detail::FindMember(o, property.c_str(), it)) {
+    if (required) {
+      if (err) {
+        (*err) += "'" + property + "' property is missing";
+        if (!parent_node.empty()) {
+          (*err) += " in " + parent_node;
+        }
+        (*err) += ".\n";
+      }
+    }
+    return false;
+  }
+
+  int intValue;
+  bool isInt = detail::GetInt(detail::GetValue(it), intValue);
+  if (!isInt) {
+    if (required) {
+      if (err) {
+        (*err) += "'" + property + "' property is not an integer type.\n";
+      }
+    }
+    return false;
+  }
+
+  if (ret) {
+    (*ret) = intValue;
+  }
+
+  return true;
+}
+
+static bool ParseUnsignedProperty(size_t *ret, std::string *err,
+                                  const detail::json &o,
+                                  const std::string &property,
+                                  const bool required,
+                                  const std::string &parent_node = "") {
+  detail::json_const_iterator it;
+  if (!detail::FindMember(o, property.c_str(), it)) {
+    if (required) {
+      if (err) {
+        (*err) += "'" + property + "' property is missing";
+        if (!parent_node.empty()) {
+          (*err) += " in " + parent_node;
+        }
+        (*err) += ".\n";
+      }
+    }
+    return false;
+  }
+
+  auto &value = detail::GetValue(it);
+
+  size_t uValue = 0;
+  bool isUValue;
+#ifdef TINYGLTF_USE_RAPIDJSON
+  isUValue = false;
+  if (value.IsUint()) {
+    uValue = value.GetUint();
+    isUValue = true;
+  } else if (value.IsUint64()) {
+    uValue = value.GetUint64();
+    isUValue = true;
+  }
+#else
+  isUValue = value.is_number_unsigned();
+  if (isUValue) {
+    uValue = value.get<size_t>();
+  }
+#endif
+  if (!isUValue) {
+    if (required) {
+      if (err) {
+        (*err) += "'" + property + "' property is not a positive integer.\n";
+      }
+    }
+    return false;
+  }
+
+  if (ret) {
+    (*ret) = uValue;
+  }
+
+  return true;
+}
+
+static bool ParseNumberProperty(double *ret, std::string *err,
+                                const detail::json &o,
+                                const std::string &property,
+                                const bool required,
+                                const std::string &parent_node = "") {
+  detail::json_const_iterator it;
+
+  if (!detail::FindMember(o, property.c_str(), it)) {
+    if (required) {
+      if (err) {
+        (*err) += "'" + property + "' property is missing";
+        if (!parent_node.empty()) {
+          (*err) += " in " + parent_node;
+        }
+        (*err) += ".\n";
+      }
+    }
+    return false;
+  }
+
+  double numberValue;
+  bool isNumber = detail::GetNumber(detail::GetValue(it), numberValue);
+
+  if (!isNumber) {
+    if (required) {
+      if (err) {
+        (*err) += "'" + property + "' property is not a number type.\n";
+      }
+    }
+    return false;
+  }
+
+  if (ret) {
+    (*ret) = numberValue;
+  }
+
+  return true;
+}
+
+static bool ParseNumberArrayProperty(std::vector<double> *ret, std::string *err,
+                                     const detail::json &o,
+                                     const std::string &property, bool required,
+                                     const std::string &parent_node = "") {
+  detail::json_const_iterator it;
+  if (!detail::FindMember(o, property.c_str(), it)) {
+    if (required) {
+      if (err) {
+        (*err) += "'" + property + "' property is missing";
+        if (!parent_node.empty()) {
+          (*err) += " in " + parent_node;
+        }
+        (*err) += ".\n";
+      }
+    }
+    return false;
+  }
+
+  if (!detail::IsArray(detail::GetValue(it))) {
+    if (required) {
+      if (err) {
+        (*err) += "'" + property + "' property is not an array";
+        if (!parent_node.empty()) {
+          (*err) += " in " + parent_node;
+        }
+        (*err) += ".\n";
+      }
+    }
+    return false;
+  }
+
+  ret->clear();
+  auto end = detail::ArrayEnd(detail::GetValue(it));
+  for (auto i = detail::ArrayBegin(detail::GetValue(it)); i != end; ++i) {
+    double numberValue;
+    const bool isNumber = detail::GetNumber(*i, numberValue);
+    if (!isNumber) {
+      if (required) {
+        if (err) {
+          (*err) += "'" + property + "' property is not a number.\n";
+          if (!parent_node.empty()) {
+            (*err) += " in " + parent_node;
+          }
+          (*err) += ".\n";
+        }
+      }
+      return false;
+    }
+    ret->push_back(numberValue);
+  }
+
+  return true;
+}
+
+static bool ParseIntegerArrayProperty(std::vector<int> *ret, std::string *err,
+                                      const detail::json &o,
+                                      const std::string &property,
+                                      bool required,
+                                      const std::string &parent_node = "") {
+  detail::json_const_iterator it;
+  if (!detail::FindMember(o, property.c_str(), it)) {
+    if (required) {
+      if (err) {
+        (*err) += "'" + property + "' property is missing";
+        if (!parent_node.empty()) {
+          (*err) += " in " + parent_node;
+        }
+        (*err) += ".\n";
+      }
+    }
+    return false;
+  }
+
+  if (!detail::IsArray(detail::GetValue(it))) {
+    if (required) {
+      if (err) {
+        (*err) += "'" + property + "' property is not an array";
+        if (!parent_node.empty()) {
+          (*err) += " in " + parent_node;
+        }
+        (*err) += ".\n";
+      }
+    }
+    return false;
+  }
+
+  ret->clear();
+  auto end = detail::ArrayEnd(detail::GetValue(it));
+  for (auto i = detail::ArrayBegin(detail::GetValue(it)); i != end; ++i) {
+    int numberValue;
+    bool isNumber = detail::GetInt(*i, numberValue);
+    if (!isNumber) {
+      if (required) {
+        if (err) {
+          (*err) += "'" + property + "' property is not an integer type.\n";
+          if (!parent_node.empty()) {
+            (*err) += " in " + parent_node;
+          }
+          (*err) += ".\n";
+        }
+      }
+      return false;
+    }
+    ret->push_back(numberValue);
+  }
+
+  return true;
+}
+
+static bool ParseStringProperty(
+    std::string *ret, std::string *err, const detail::json &o,
+    const std::string &property, bool required,
+    const std::string &parent_node = std::string()) {
+  detail::json_const_iterator it;
+  if (!detail::FindMember(o, property.c_str(), it)) {
+    if (required) {
+      if (err) {
+        (*err) += "'" + property + "' property is missing";
+        if (parent_node.empty()) {
+          (*err) += ".\n";
+        } else {
+          (*err) += " in `" + parent_node + "'.\n";
+        }
+      }
+    }
+    return false;
+  }
+
+  std::string strValue;
+  if (!detail::GetString(detail::GetValue(it), strValue)) {
+    if (required) {
+      if (err) {
+        (*err) += "'" + property + "' property is not a string type.\n";
+      }
+    }
+    return false;
+  }
+
+  if (ret) {
+    (*ret) = std::move(strValue);
+  }
+
+  return true;
+}
+
+static bool ParseStringIntegerProperty(std::map<std::string, int> *ret,
+                                       std::string *err, const detail::json &o,
+                                       const std::string &property,
+                                       bool required,
+                                       const std::string &parent = "") {
+  detail::json_const_iterator it;
+  if (!detail::FindMember(o, property.c_str(), it)) {
+    if (required) {
+      if (err) {
+        if (!parent.empty()) {
+          (*err) +=
+              "'" + property + "' property is missing in " + parent + ".\n";
+        } else {
+          (*err) += "'" + property + "' property is missing.\n";
+        }
+      }
+    }
+    return false;
+  }
+
+  const detail::json &dict = detail::GetValue(it);
+
+  // Make sure we are dealing with an object / dictionary.
+  if (!detail::IsObject(dict)) {
+    if (required) {
+      if (err) {
+        (*err) += "'" + property + "' property is not an object.\n";
+      }
+    }
+    return false;
+  }
+
+  ret->clear();
+
+  detail::json_const_iterator dictIt(detail::ObjectBegin(dict));
+  detail::json_const_iterator dictItEnd(detail::ObjectEnd(dict));
+
+  for (; dictIt != dictItEnd; ++dictIt) {
+    int intVal;
+    if (!detail::GetInt(detail::GetValue(dictIt), intVal)) {
+      if (required) {
+        if (err) {
+          (*err) += "'" + property + "' value is not an integer type.\n";
+        }
+      }
+      return false;
+    }
+
+    // Insert into the list.
+    (*ret)[detail::GetKey(dictIt)] = intVal;
+  }
+  return true;
+}
+
+static bool ParseJSONProperty(std::map<std::string, double> *ret,
+                              std::string *err, const detail::json &o,
+                              const std::string &property, bool required) {
+  detail::json_const_iterator it;
+  if (!detail::FindMember(o, property.c_str(), it)) {
+    if (required) {
+      if (err) {
+        (*err) += "'" + property + "' property is missing. \n'";
+      }
+    }
+    return false;
+  }
+
+  const detail::json &obj = detail::GetValue(it);
+
+  if (!detail::IsObject(obj)) {
+    if (required) {
+      if (err) {
+        (*err) += "'" + property + "' property is not a JSON object.\n";
+      }
+    }
+    return false;
+  }
+
+  ret->clear();
+
+  detail::json_const_iterator it2(detail::ObjectBegin(obj));
+  detail::json_const_iterator itEnd(detail::ObjectEnd(obj));
+  for (; it2 != itEnd; ++it2) {
+    double numVal;
+    if (detail::GetNumber(detail::GetValue(it2), numVal))
+      ret->emplace(std::string(detail::GetKey(it2)), numVal);
+  }
+
+  return true;
+}
+
+static bool ParseParameterProperty(Parameter *param, std::string *err,
+                                   const detail::json &o,
+                                   const std::string &prop, bool required) {
+  // A parameter value can either be a string or an array of either a boolean or
+  // a number. Booleans of any kind aren't supported here. Granted, it
+  // complicates the Parameter structure and breaks it semantically in the sense
+  // that the client probably works off the assumption that if the string is
+  // empty the vector is used, etc. Would a tagged union work?
+  if (ParseStringProperty(&param->string_value, err, o, prop, false)) {
+    // Found string property.
+    return true;
+  } else if (ParseNumberArrayProperty(&param->number_array, err, o, prop,
+                                      false)) {
+    // Found a number array.
+    return true;
+  } else if (ParseNumberProperty(&param->number_value, err, o, prop, false)) {
+    param->has_number_value = true;
+    return true;
+  } else if (ParseJSONProperty(&param->json_double_value, err, o, prop,
+                               false)) {
+    return true;
+  } else if (ParseBooleanProperty(&param->bool_value, err, o, prop, false)) {
+    return true;
+  } else {
+    if (required) {
+      if (err) {
+        (*err) += "parameter must be a string or number / number array.\n";
+      }
+    }
+    return false;
+  }
+}
+
+static bool ParseExtensionsProperty(ExtensionMap *ret, std::string *err,
+                                    const detail::json &o) {
+  (void)err;
+
+  detail::json_const_iterator it;
+  if (!detail::FindMember(o, "extensions", it)) {
+    return false;
+  }
+
+  auto &obj = detail::GetValue(it);
+  if (!detail::IsObject(obj)) {
+    return false;
+  }
+  ExtensionMap extensions;
+  detail::json_const_iterator extIt =
+      detail::ObjectBegin(obj);  // it.value().begin();
+  detail::json_const_iterator extEnd = detail::ObjectEnd(obj);
+  for (; extIt != extEnd; ++extIt) {
+    auto &itObj = detail::GetValue(extIt);
+    if (!detail::IsObject(itObj)) continue;
+    std::string key(detail::GetKey(extIt));
+    if (!ParseJsonAsValue(&extensions[key], itObj)) {
+      if (!key.empty()) {
+        // create empty object so that an extension object is still of type
+        // object
+        extensions[key] = Value{Value::Object{}};
+      }
+    }
+  }
+  if (ret) {
+    (*ret) = std::move(extensions);
+  }
+  return true;
+}
+
+template <typename GltfType>
+static bool ParseExtrasAndExtensions(GltfType *target, std::string *err,
+                                     const detail::json &o,
+                                     bool store_json_strings) {
+  ParseExtensionsProperty(&target->extensions, err, o);
+  ParseExtrasProperty(&target->extras, o);
+
+  if (store_json_strings) {
+    {
+      detail::json_const_iterator it;
+      if (detail::FindMember(o, "extensions", it)) {
+        target->extensions_json_string =
+            detail::JsonToString(detail::GetValue(it));
+      }
+    }
+    {
+      detail::json_const_iterator it;
+      if (detail::FindMember(o, "extras", it)) {
+        target->extras_json_string = detail::JsonToString(detail::GetValue(it));
+      }
+    }
+  }
+  return true;
+}
+
+static bool ParseAsset(Asset *asset, std::string *err, const detail::json &o,
+                       bool store_original_json_for_extras_and_extensions) {
+  ParseStringProperty(&asset->version, err, o, "version", true, "Asset");
+  ParseStringProperty(&asset->generator, err, o, "generator", false, "Asset");
+  ParseStringProperty(&asset->minVersion, err, o, "minVersion", false, "Asset");
+  ParseStringProperty(&asset->copyright, err, o, "copyright", false, "Asset");
+
+  ParseExtrasAndExtensions(asset, err, o,
+                           store_original_json_for_extras_and_extensions);
+  return true;
+}
+
+static bool ParseImage(Image *image, const int image_idx, std::string *err,
+                       std::string *warn, const detail::json &o,
+                       bool store_original_json_for_extras_and_extensions,
+                       const std::string &basedir, const size_t max_file_size,
+                       const FsCallbacks *fs, const URICallbacks *uri_cb,
+                       const LoadImageDataFunction *LoadImageData = nullptr,
+                       void *load_image_user_data = nullptr,
+                       std::vector<unsigned char> *deferred_bytes = nullptr) {
+  // A glTF image must either reference a bufferView or an image uri
+  //
+  // When `deferred_bytes` is given, encoded image bytes are stored there and
+  // LoadImageData is not called(the caller decodes them later).
+
+  // schema says oneOf [`bufferView`, `uri`]
+  // TODO(syoyo): Check the type of each parameters.
+  detail::json_const_iterator it;
+  bool hasBufferView = detail::FindMember(o, "bufferView", it);
+  bool hasURI = detail::FindMember(o, "uri", it);
+
+  ParseStringProperty(&image->name, err, o, "name", false);
+
+  if (hasBufferView && hasURI) {
+    // Should not both defined.
+    if (err) {
+      (*err) +=
+          "Only one of `bufferView` or `uri` should be defined, but both are "
+          "defined for image[" +
+          std::to_string(image_idx) + "] name = \"" + image->name + "\"\n";
+    }
+    return false;
+  }
+
+  if (!hasBufferView && !hasURI) {
+    if (err) {
+      (*err) += "Neither required `bufferView` nor `uri` defined for image[" +
+                std::to_string(image_idx) + "] name = \"" + image->name +
+                "\"\n";
+    }
+    return false;
+  }
+
+  ParseExtrasAndExtensions(image, err, o,
+                           store_original_json_for_extras_and_extensions);
+
+  if (hasBufferView) {
+    int bufferView = -1;
+    if (!ParseIntegerProperty(&bufferView, err, o, "bufferView", true)) {
+      if (err) {
+        (*err) += "Failed to parse `bufferView` for image[" +
+                  std::to_string(image_idx) + "] name = \"" + image->name +
+                  "\"\n";
+      }
+      return false;
+    }
+
+    std::string mime_type;
+    ParseStringProperty(&mime_type, err, o, "mimeType", false);
+
+    int width = 0;
+    ParseIntegerProperty(&width, err, o, "width", false);
+
+    int height = 0;
+    ParseIntegerProperty(&height, err, o, "height", false);
+
+    // Just only save some information here. Loading actual image data from
+    // bufferView is done after this `ParseImage` function.
+    image->bufferView = bufferView;
+    image->mimeType = mime_type;
+    image->width = width;
+    image->height = height;
 
-  if (!detail::FindMember(o, property.c_str(), it)) {
-    if (required) {
-      if (err) {
-        (*err) += "'" + property + "' property is missing";
-        if (!parent_node.empty()) {
-          (*err) += " in " + parent_node;
-        }
-        (*err) += ".\n";
-      }
-    }
-    return false;
+    return true;
   }
 
-  double numberValue;
-  bool isNumber = detail::GetNumber(detail::GetValue(it), numberValue);
+  // Parse URI & Load image data.
 
-  if (!isNumber) {
-    if (required) {
-      if (err) {
-        (*err) += "'" + property + "' property is not a number type.\n";
-      }
+  std::string uri;
+  std::string tmp_err;
+  if (!ParseStringProperty(&uri, &tmp_err, o, "uri", true)) {
+    if (err) {
+      (*err) += "Failed to parse `uri` for image[" + std::to_string(image_idx) +
+                "] name = \"" + image->name + "\".\n";
     }
     return false;
   }
 
-  if (ret) {
-    (*ret) = numberValue;
-  }
-
-  return true;
-}
+  std::vector<unsigned char> img;
 
-static bool ParseNumberArrayProperty(std::vector<double> *ret, std::string *err,
-                                     const detail::json &o,
-                                     const std::string &property, bool required,
-                                     const std::string &parent_node = "") {
-  detail::json_const_iterator it;
-  if (!detail::FindMember(o, property.c_str(), it)) {
-    if (required) {
+  if (IsDataURI(uri)) {
+    if (!DecodeDataURI(&img, image->mimeType, uri, 0, false)) {
       if (err) {
-        (*err) += "'" + property + "' property is missing";
-        if (!parent_node.empty()) {
-          (*err) += " in " + parent_node;
-        }
-        (*err) += ".\n";
+        (*err) += "Failed to decode 'uri' for image[" +
+                  std::to_string(image_idx) + "] name = \"" + image->name +
+                  "\"\n";
       }
+      return false;
     }
-    return false;
-  }
+  } else {
+    // Assume external file
+    // Keep texture path (for textures that cannot be decoded)
+    image->uri = uri;
+#ifdef TINYGLTF_NO_EXTERNAL_IMAGE
+    return true;
+#else
+    std::string decoded_uri;
+    if (!uri_cb->decode(uri, &decoded_uri, uri_cb->user_data)) {
+      if (warn) {
+        (*warn) += "Failed to decode 'uri' for image[" +
+                   std::to_string(image_idx) + "] name = \"" + image->name +
+                   "\"\n";
+      }
 
-  if (!detail::IsArray(detail::GetValue(it))) {
-    if (required) {
-      if (err) {
-        (*err) += "'" + property + "' property is not an array";
-        if (!parent_node.empty()) {
-          (*err) += " in " + parent_node;
-        }
-        (*err) += ".\n";
+      // Image loading failure is not critical to overall gltf loading.
+      return true;
+    }
+
+    if (!LoadExternalFile(&img, err, warn, decoded_uri, basedir,
+                          /* required */ false, /* required bytes */ 0,
+                          /* checksize */ false,
+                          /* max file size */ max_file_size, fs)) {
+      if (warn) {
+        (*warn) += "Failed to load external 'uri' for image[" +
+                   std::to_string(image_idx) + "] name = \"" + decoded_uri +
+                   "\"\n";
       }
+      // If the image cannot be loaded, keep uri as image->uri.
+      return true;
     }
-    return false;
-  }
 
-  ret->clear();
-  auto end = detail::ArrayEnd(detail::GetValue(it));
-  for (auto i = detail::ArrayBegin(detail::GetValue(it)); i != end; ++i) {
-    double numberValue;
-    const bool isNumber = detail::GetNumber(*i, numberValue);
-    if (!isNumber) {
-      if (required) {
-        if (err) {
-          (*err) += "'" + property + "' property is not a number.\n";
-          if (!parent_node.empty()) {
-            (*err) += " in " + parent_node;
-          }
-          (*err) += ".\n";
-        }
+    if (img.empty()) {
+      if (warn) {
+        (*warn) += "Image data is empty for image[" +
+                   std::to_string(image_idx) + "] name = \"" + image->name +
+                   "\" \n";
       }
       return false;
     }
-    ret->push_back(numberValue);
+#endif
   }
 
-  return true;
-}
-
-static bool ParseIntegerArrayProperty(std::vector<int> *ret, std::string *err,
-                                      const detail::json &o,
-                                      const std::string &property,
-                                      bool required,
-                                      const std::string &parent_node = "") {
-  detail::json_const_iterator it;
-  if (!detail::FindMember(o, property.c_str(), it)) {
-    if (required) {
-      if (err) {
-        (*err) += "'" + property + "' property is missing";
-        if (!parent_node.empty()) {
-          (*err) += " in " + parent_node;
-        }
-        (*err) += ".\n";
-      }
-    }
-    return false;
+  if (deferred_bytes) {
+    deferred_bytes->swap(img);
+    return true;
   }
 
-  if (!detail::IsArray(detail::GetValue(it))) {
-    if (required) {
-      if (err) {
-        (*err) += "'" + property + "' property is not an array";
-        if (!parent_node.empty()) {
-          (*err) += " in " + parent_node;
-        }
-        (*err) += ".\n";
-      }
+  if (*LoadImageData == nullptr) {
+    if (err) {
+      (*err) += "No LoadImageData callback specified.\n";
     }
     return false;
   }
+  return (*LoadImageData)(image, image_idx, err, warn, 0, 0, &img.at(0),
+                          static_cast<int>(img.size()), load_image_user_data);
+}
 
-  ret->clear();
-  auto end = detail::ArrayEnd(detail::GetValue(it));
-  for (auto i = detail::ArrayBegin(detail::GetValue(it)); i != end; ++i) {
-    int numberValue;
-    bool isNumber = detail::GetInt(*i, numberValue);
-    if (!isNumber) {
-      if (required) {
-        if (err) {
-          (*err) += "'" + property + "' property is not an integer type.\n";
-          if (!parent_node.empty()) {
-            (*err) += " in " + parent_node;
-          }
-          (*err) += ".\n";
-        }
-      }
-      return false;
-    }
-    ret->push_back(numberValue);
-  }
+static bool ParseTexture(Texture *texture, std::string *err,
+                         const detail::json &o,
+                         bool store_original_json_for_extras_and_extensions,
+                         const std::string &basedir) {
+  (void)basedir;
+  int sampler = -1;
+  int source = -1;
+  ParseIntegerProperty(&sampler, err, o, "sampler", false);
+
+  ParseIntegerProperty(&source, err, o, "source", false);
+
+  texture->sampler = sampler;
+  texture->source = source;
+
+  ParseExtrasAndExtensions(texture, err, o,
+                           store_original_json_for_extras_and_extensions);
+
+  ParseStringProperty(&texture->name, err, o, "name", false);
 
   return true;
 }
 
-static bool ParseStringProperty(
-    std::string *ret, std::string *err, const detail::json &o,
-    const std::string &property, bool required,
-    const std::string &parent_node = std::string()) {
-  detail::json_const_iterator it;
-  if (!detail::FindMember(o, property.c_str(), it)) {
-    if (required) {
-      if (err) {
-        (*err) += "'" + property + "' property is missing";
-        if (parent_node.empty()) {
-          (*err) += ".\n";
-        } else {
-          (*err) += " in `" + parent_node + "'.\n";
-        }
-      }
-    }
+static bool ParseTextureInfo(
+    TextureInfo *texinfo, std::string *err, const detail::json &o,
+    bool store_original_json_for_extras_and_extensions) {
+  if (texinfo == nullptr) {
     return false;
   }
 
-  std::string strValue;
-  if (!detail::GetString(detail::GetValue(it), strValue)) {
-    if (required) {
-      if (err) {
-        (*err) += "'" + property + "' property is not a string type.\n";
-      }
-    }
+  if (!ParseIntegerProperty(&texinfo->index, err, o, "index",
+                            /* required */ true, "TextureInfo")) {
     return false;
   }
 
-  if (ret) {
-    (*ret) = std::move(strValue);
-  }
+  ParseIntegerProperty(&texinfo->texCoord, err, o, "texCoord", false);
+
+  ParseExtrasAndExtensions(texinfo, err, o,
+                           store_original_json_for_extras_and_extensions);
 
   return true;
 }
 
-static bool ParseStringIntegerProperty(std::map<std::string, int> *ret,
-                                       std::string *err, const detail::json &o,
-                                       const std::string &property,
-                                       bool required,
-                                       const std::string &parent = "") {
-  detail::json_const_iterator it;
-  if (!detail::FindMember(o, property.c_str(), it)) {
-    if (required) {
-      if (err) {
-        if (!parent.empty()) {
-          (*err) +=
-              "'" + property + "' property is missing in " + parent + ".\n";
-        } else {
-          (*err) += "'" + property + "' property is missing.\n";
-        }
-      }
-    }
+static bool ParseNormalTextureInfo(
+    NormalTextureInfo *texinfo, std::string *err, const detail::json &o,
+    bool store_original_json_for_extras_and_extensions) {
+  if (texinfo == nullptr) {
     return false;
   }
 
-  const detail::json &dict = detail::GetValue(it);
-
-  // Make sure we are dealing with an object / dictionary.
-  if (!detail::IsObject(dict)) {
-    if (required) {
-      if (err) {
-        (*err) += "'" + property + "' property is not an object.\n";
-      }
-    }
+  if (!ParseIntegerProperty(&texinfo->index, err, o, "index",
+                            /* required */ true, "NormalTextureInfo")) {
     return false;
   }
 
-  ret->clear();
-
-  detail::json_const_iterator dictIt(detail::ObjectBegin(dict));
-  detail::json_const_iterator dictItEnd(detail::ObjectEnd(dict));
+  ParseIntegerProperty(&texinfo->texCoord, err, o, "texCoord", false);
+  ParseNumberProperty(&texinfo->scale, err, o, "scale", false);
 
-  for (; dictIt != dictItEnd; ++dictIt) {
-    int intVal;
-    if (!detail::GetInt(detail::GetValue(dictIt), intVal)) {
-      if (required) {
-        if (err) {
-          (*err) += "'" + property + "' value is not an integer type.\n";
-        }
-      }
-      return false;
-    }
+  ParseExtrasAndExtensions(texinfo, err, o,
+                           store_original_json_for_extras_and_extensions);
 
-    // Insert into the list.
-    (*ret)[detail::GetKey(dictIt)] = intVal;
-  }
   return true;
 }
 
-static bool ParseJSONProperty(std::map<std::string, double> *ret,
-                              std::string *err, const detail::json &o,
-                              const std::string &property, bool required) {
-  detail::json_const_iterator it;
-  if (!detail::FindMember(o, property.c_str(), it)) {
-    if (required) {
-      if (err) {
-        (*err) += "'" + property + "' property is missing. \n'";
-      }
-    }
+static bool ParseOcclusionTextureInfo(
+    OcclusionTextureInfo *texinfo, std::string *err, const detail::json &o,
+    bool store_original_json_for_extras_and_extensions) {
+  if (texinfo == nullptr) {
     return false;
   }
 
-  const detail::json &obj = detail::GetValue(it);
-
-  if (!detail::IsObject(obj)) {
-    if (required) {
-      if (err) {
-        (*err) += "'" + property + "' property is not a JSON object.\n";
-      }
-    }
+  if (!ParseIntegerProperty(&texinfo->index, err, o, "index",
+                            /* required */ true, "NormalTextureInfo")) {
     return false;
   }
 
-  ret->clear();
+  ParseIntegerProperty(&texinfo->texCoord, err, o, "texCoord", false);
+  ParseNumberProperty(&texinfo->strength, err, o, "strength", false);
 
-  detail::json_const_iterator it2(detail::ObjectBegin(obj));
-  detail::json_const_iterator itEnd(detail::ObjectEnd(obj));
-  for (; it2 != itEnd; ++it2) {
-    double numVal;
-    if (detail::GetNumber(detail::GetValue(it2), numVal))
-      ret->emplace(std::string(detail::GetKey(it2)), numVal);
-  }
+  ParseExtrasAndExtensions(texinfo, err, o,
+                           store_original_json_for_extras_and_extensions);
 
   return true;
 }
 
-static bool ParseParameterProperty(Parameter *param, std::string *err,
-                                   const detail::json &o,
-                                   const std::string &prop, bool required) {
-  // A parameter value can either be a string or an array of either a boolean or
-  // a number. Booleans of any kind aren't supported here. Granted, it
-  // complicates the Parameter structure and breaks it semantically in the sense
-  // that the client probably works off the assumption that if the string is
-  // empty the vector is used, etc. Would a tagged union work?
-  if (ParseStringProperty(&param->string_value, err, o, prop, false)) {
-    // Found string property.
-    return true;
-  } else if (ParseNumberArrayProperty(&param->number_array, err, o, prop,
-                                      false)) {
-    // Found a number array.
-    return true;
-  } else if (ParseNumberProperty(&param->number_value, err, o, prop, false)) {
-    param->has_number_value = true;
-    return true;
-  } else if (ParseJSONProperty(&param->json_double_value, err, o, prop,
-                               false)) {
-    return true;
-  } else if (ParseBooleanProperty(&param->bool_value, err, o, prop, false)) {
-    return true;
-  } else {
-    if (required) {
-      if (err) {
-        (*err) += "parameter must be a string or number / number array.\n";
-      }
-    }
+static bool ParseBuffer(Buffer *buffer, std::string *err, const detail::json &o,
+                        bool store_original_json_for_extras_and_extensions,
+                        const FsCallbacks *fs, const URICallbacks *uri_cb,
+                        const std::string &basedir,
+                        const size_t max_buffer_size, bool is_binary = false,
+                        const unsigned char *bin_data = nullptr,
+                        size_t bin_size = 0, bool borrow_bin_data = false) {
+  size_t byteLength;
+  if (!ParseUnsignedProperty(&byteLength, err, o, "byteLength", true,
+                             "Buffer")) {
     return false;
   }
-}
 
-static bool ParseExtensionsProperty(ExtensionMap *ret, std::string *err,
-                                    const detail::json &o) {
-  (void)err;
+  // In glTF 2.0, uri is not mandatory anymore
+  buffer->uri.clear();
+  ParseStringProperty(&buffer->uri, err, o, "uri", false, "Buffer");
 
-  detail::json_const_iterator it;
-  if (!detail::FindMember(o, "extensions", it)) {
-    return false;
+  // An EXT_meshopt_compression fallback buffer without a uri has no data;
+  // its bufferViews are decoded into it once they are parsed.
+  bool meshopt_fallback = false;
+  detail::json_const_iterator extensions, meshopt;
+  if (buffer->uri.empty() &&
+      detail::FindMember(o, "extensions", extensions) &&
+      detail::FindMember(detail::GetValue(extensions),
+                         "EXT_meshopt_compression", meshopt)) {
+    ParseBooleanProperty(&meshopt_fallback, nullptr, detail::GetValue(meshopt),
+                         "fallback", false);
+  }
+  if (meshopt_fallback) {
+    buffer->data.resize(byteLength);
+    ParseStringProperty(&buffer->name, err, o, "name", false);
+    ParseExtrasAndExtensions(buffer, err, o,
+                             store_original_json_for_extras_and_extensions);
+    return true;
   }
 
-  auto &obj = detail::GetValue(it);
-  if (!detail::IsObject(obj)) {
-    return false;
+  // having an empty uri for a non embedded image should not be valid
+  if (!is_binary && buffer->uri.empty()) {
+    if (err) {
+      (*err) += "'uri' is missing from non binary glTF file buffer.\n";
+    }
   }
-  ExtensionMap extensions;
-  detail::json_const_iterator extIt =
-      detail::ObjectBegin(obj);  // it.value().begin();
-  detail::json_const_iterator extEnd = detail::ObjectEnd(obj);
-  for (; extIt != extEnd; ++extIt) {
-    auto &itObj = detail::GetValue(extIt);
-    if (!detail::IsObject(itObj)) continue;
-    std::string key(detail::GetKey(extIt));
-    if (!ParseJsonAsValue(&extensions[key], itObj)) {
-      if (!key.empty()) {
-        // create empty object so that an extension object is still of type
-        // object
-        extensions[key] = Value{Value::Object{}};
+
+  detail::json_const_iterator type;
+  if (detail::FindMember(o, "type", type)) {
+    std::string typeStr;
+    if (detail::GetString(detail::GetValue(type), typeStr)) {
+      if (typeStr.compare("arraybuffer") == 0) {
+        // buffer.type = "arraybuffer";
       }
     }
   }
-  if (ret) {
-    (*ret) = std::move(extensions);
-  }
-  return true;
-}
 
-template <typename GltfType>
-static bool ParseExtrasAndExtensions(GltfType *target, std::string *err,
-                                     const detail::json &o,
-                                     bool store_json_strings) {
-  ParseExtensionsProperty(&target->extensions, err, o);
-  ParseExtrasProperty(&target->extras, o);
+  if (is_binary) {
+    // Still binary glTF accepts external dataURI.
+    if (!buffer->uri.empty()) {
+      // First try embedded data URI.
+      if (IsDataURI(buffer->uri)) {
+        std::string mime_type;
+        if (!DecodeDataURI(&buffer->data, mime_type, buffer->uri, byteLength,
+                           true)) {
+          if (err) {
+            (*err) +=
+                "Failed to decode 'uri' : " + buffer->uri + " in Buffer\n";
+          }
+          return false;
+        }
+      } else {
+        // External .bin file.
+        std::string decoded_uri;
+        if (!uri_cb->decode(buffer->uri, &decoded_uri, uri_cb->user_data)) {
+          return false;
+        }
+        if (!LoadExternalFile(&buffer->data, err, /* warn */ nullptr,
+                              decoded_uri, basedir, /* required */ true,
+                              byteLength, /* checkSize */ true,
+                              /* max_file_size */ max_buffer_size, fs)) {
+          return false;
+        }
+      }
+    } else {
+      // load data from (embedded) binary data
 
-  if (store_json_strings) {
-    {
-      detail::json_const_iterator it;
-      if (detail::FindMember(o, "extensions", it)) {
-        target->extensions_json_string =
-            detail::JsonToString(detail::GetValue(it));
+      if ((bin_size == 0) || (bin_data == nullptr)) {
+        if (err) {
+          (*err) +=
+              "Invalid binary data in `Buffer', or GLB with empty BIN chunk.\n";
+        }
+        return false;
+      }
+
+      if (byteLength > bin_size) {
+        if (err) {
+          std::stringstream ss;
+          ss << "Invalid `byteLength'. Must be equal or less than binary size: "
+                "`byteLength' = "
+             << byteLength << ", binary size = " << bin_size << std::endl;
+          (*err) += ss.str();
+        }
+        return false;
+      }
+
+      if (borrow_bin_data) {
+        // Reference the BIN chunk directly. No copy.
+        buffer->data.clear();
+        buffer->borrowed_data = bin_data;
+        buffer->borrowed_size = static_cast<size_t>(byteLength);
+      } else {
+        // Read buffer data
+        buffer->data.resize(static_cast<size_t>(byteLength));
+        memcpy(&(buffer->data.at(0)), bin_data,
+               static_cast<size_t>(byteLength));
       }
     }
-    {
-      detail::json_const_iterator it;
-      if (detail::FindMember(o, "extras", it)) {
-        target->extras_json_string = detail::JsonToString(detail::GetValue(it));
+
+  } else {
+    if (IsDataURI(buffer->uri)) {
+      std::string mime_type;
+      if (!DecodeDataURI(&buffer->data, mime_type, buffer->uri, byteLength,
+                         true)) {
+        if (err) {
+          (*err) += "Failed to decode 'uri' : " + buffer->uri + " in Buffer\n";
+        }
+        return false;
+      }
+    } else {
+      // Assume external .bin file.
+      std::string decoded_uri;
+      if (!uri_cb->decode(buffer->uri, &decoded_uri, uri_cb->user_data)) {
+        return false;
+      }
+      if (!LoadExternalFile(&buffer->data, err, /* warn */ nullptr, decoded_uri,
+                            basedir, /* required */ true, byteLength,
+                            /* checkSize */ true,
+                            /* max file size */ max_buffer_size, fs)) {
+        return false;
       }
     }
   }
-  return true;
-}
 
-static bool ParseAsset(Asset *asset, std::string *err, const detail::json &o,
-                       bool store_original_json_for_extras_and_extensions) {
-  ParseStringProperty(&asset->version, err, o, "version", true, "Asset");
-  ParseStringProperty(&asset->generator, err, o, "generator", false, "Asset");
-  ParseStringProperty(&asset->minVersion, err, o, "minVersion", false, "Asset");
-  ParseStringProperty(&asset->copyright, err, o, "copyright", false, "Asset");
+  ParseStringProperty(&buffer->name, err, o, "name", false);
 
-  ParseExtrasAndExtensions(asset, err, o,
+  ParseExtrasAndExtensions(buffer, err, o,
                            store_original_json_for_extras_and_extensions);
+
   return true;
 }
 
-static bool ParseImage(Image *image, const int image_idx, std::string *err,
-                       std::string *warn, const detail::json &o,
-                       bool store_original_json_for_extras_and_extensions,
-                       const std::string &basedir, const size_t max_file_size,
-                       FsCallbacks *fs, const URICallbacks *uri_cb,
-                       LoadImageDataFunction *LoadImageData = nullptr,
-                       void *load_image_user_data = nullptr) {
-  // A glTF image must either reference a bufferView or an image uri
-
-  // schema says oneOf [`bufferView`, `uri`]
-  // TODO(syoyo): Check the type of each parameters.
-  detail::json_const_iterator it;
-  bool hasBufferView = detail::FindMember(o, "bufferView", it);
-  bool hasURI = detail::FindMember(o, "uri", it);
+static bool ParseBufferView(
+    BufferView *bufferView, std::string *err, const detail::json &o,
+    bool store_original_json_for_extras_and_extensions) {
+  int buffer = -1;
+  if (!ParseIntegerProperty(&buffer, err, o, "buffer", true, "BufferView")) {
+    return false;
+  }
 
-  ParseStringProperty(&image->name, err, o, "name", false);
+  size_t byteOffset = 0;
+  ParseUnsignedProperty(&byteOffset, err, o, "byteOffset", false);
 
-  if (hasBufferView && hasURI) {
-    // Should not both defined.
-    if (err) {
-      (*err) +=
-          "Only one of `bufferView` or `uri` should be defined, but both are "
-          "defined for image[" +
-          std::to_string(image_idx) + "] name = \"" + image->name + "\"\n";
-    }
+  size_t byteLength = 1;
+  if (!ParseUnsignedProperty(&byteLength, err, o, "byteLength", true,
+                             "BufferView")) {
     return false;
   }
 
-  if (!hasBufferView && !hasURI) {
+  size_t byteStride = 0;
+  if (!ParseUnsignedProperty(&byteStride, err, o, "byteStride", false)) {
+    // Spec says: When byteStride of referenced bufferView is not defined, it
+    // means that accessor elements are tightly packed, i.e., effective stride
+    // equals the size of the element.
+    // We cannot determine the actual byteStride until Accessor are parsed, thus
+    // set 0(= tightly packed) here(as done in OpenGL's VertexAttribPoiner)
+    byteStride = 0;
+  }
+
+  if ((byteStride > 252) || ((byteStride % 4) != 0)) {
     if (err) {
-      (*err) += "Neither required `bufferView` nor `uri` defined for image[" +
-                std::to_string(image_idx) + "] name = \"" + image->name +
-                "\"\n";
+      std::stringstream ss;
+      ss << "Invalid `byteStride' value. `byteStride' must be the multiple of "
+            "4 : "
+         << byteStride << std::endl;
+
+      (*err) += ss.str();
     }
     return false;
   }
 
-  ParseExtrasAndExtensions(image, err, o,
-                           store_original_json_for_extras_and_extensions);
+  int target = 0;
+  ParseIntegerProperty(&target, err, o, "target", false);
+  if ((target == TINYGLTF_TARGET_ARRAY_BUFFER) ||
+      (target == TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER)) {
+    // OK
+  } else {
+    target = 0;
+  }
+  bufferView->target = target;
 
-  if (hasBufferView) {
-    int bufferView = -1;
-    if (!ParseIntegerProperty(&bufferView, err, o, "bufferView", true)) {
-      if (err) {
-        (*err) += "Failed to parse `bufferView` for image[" +
-                  std::to_string(image_idx) + "] name = \"" + image->name +
-                  "\"\n";
-      }
-      return false;
-    }
+  ParseStringProperty(&bufferView->name, err, o, "name", false);
 
-    std::string mime_type;
-    ParseStringProperty(&mime_type, err, o, "mimeType", false);
+  ParseExtrasAndExtensions(bufferView, err, o,
+                           store_original_json_for_extras_and_extensions);
 
-    int width = 0;
-    ParseIntegerProperty(&width, err, o, "width", false);
+  bufferView->buffer = buffer;
+  bufferView->byteOffset = byteOffset;
+  bufferView->byteLength = byteLength;
+  bufferView->byteStride = byteStride;
+  return true;
+}
 
-    int height = 0;
-    ParseIntegerProperty(&height, err, o, "height", false);
+namespace detail {
 
-    // Just only save some information here. Loading actual image data from
-    // bufferView is done after this `ParseImage` function.
-    image->bufferView = bufferView;
-    image->mimeType = mime_type;
-    image->width = width;
-    image->height = height;
+// EXT_meshopt_compression bitstreams, as specified by the extension and
+// produced by meshoptimizer's encoders.
+
+const size_t kMeshoptByteGroupSize = 16;
+const size_t kMeshoptByteGroupDecodeLimit = 24;
+const size_t kMeshoptVertexBlockSizeBytes = 8192;
+const size_t kMeshoptVertexBlockMaxSize = 256;
+const size_t kMeshoptTailMaxSize = 32;
+
+// Unpacks 16 values of `bits` 2 or 4 bits. Values of all ones are escapes
+// for a whole byte, stored after the packed ones.
+template <int bits>
+static const unsigned char *MeshoptDecodeBytesGroup(const unsigned char *data,
+                                                    unsigned char *out) {
+  const unsigned escape = (1u << bits) - 1;
+#if defined(TINYGLTF_INTERNAL_SSE2)
+  // Without escapes, which is the common case, all values are in place
+  // after spreading the packed ones to bytes.
+  const __m128i mask = _mm_set1_epi8(char(escape));
+  __m128i v;
+  if (bits == 4) {
+    const __m128i b =
+        _mm_loadl_epi64(reinterpret_cast<const __m128i *>(data));
+    v = _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(b, 4), mask),
+                          _mm_and_si128(b, mask));
+  } else {
+    int32_t word;
+    memcpy(&word, data, 4);
+    const __m128i b = _mm_cvtsi32_si128(word);
+    const __m128i ab =
+        _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(b, 6), mask),
+                          _mm_and_si128(_mm_srli_epi16(b, 4), mask));
+    const __m128i cd =
+        _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(b, 2), mask),
+                          _mm_and_si128(b, mask));
+    v = _mm_unpacklo_epi16(ab, cd);
+  }
+  if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, mask)) == 0) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), v);
+    return data + bits * 2;
+  }
+#elif defined(TINYGLTF_INTERNAL_NEON)
+  const uint8x8_t mask = vdup_n_u8(static_cast<uint8_t>(escape));
+  uint8x16_t v;
+  if (bits == 4) {
+    const uint8x8_t b = vld1_u8(data);
+    const uint8x8x2_t z = vzip_u8(vshr_n_u8(b, 4), vand_u8(b, mask));
+    v = vcombine_u8(z.val[0], z.val[1]);
+  } else {
+    uint32_t word;
+    memcpy(&word, data, 4);
+    const uint8x8_t b = vreinterpret_u8_u32(vdup_n_u32(word));
+    const uint8x8x2_t ab =
+        vzip_u8(vshr_n_u8(b, 6), vand_u8(vshr_n_u8(b, 4), mask));
+    const uint8x8x2_t cd =
+        vzip_u8(vand_u8(vshr_n_u8(b, 2), mask), vand_u8(b, mask));
+    const uint16x4x2_t z = vzip_u16(vreinterpret_u16_u8(ab.val[0]),
+                                    vreinterpret_u16_u8(cd.val[0]));
+    v = vcombine_u8(vreinterpret_u8_u16(z.val[0]),
+                    vreinterpret_u8_u16(z.val[1]));
+  }
+  if (!AnyLane(vceqq_u8(v, vcombine_u8(mask, mask)))) {
+    vst1q_u8(out, v);
+    return data + bits * 2;
+  }
+#endif
+  const unsigned char *escapes = data + bits * 2;
+  for (int i = 0; i < 16; i += 8 / bits) {
+    unsigned byte = *data++;
+    for (int k = 0; k < 8 / bits; k++) {
+      const unsigned e = (byte >> (8 - bits * (k + 1))) & escape;
+      out[i + k] = e == escape ? *escapes : static_cast<unsigned char>(e);
+      escapes += e == escape;
+    }
+  }
+  return escapes;
+}
+
+static const unsigned char *MeshoptDecodeBytes(const unsigned char *data,
+                                               const unsigned char *data_end,
+                                               unsigned char *out,
+                                               size_t size) {
+  // 2 bits per group: all zeros, 2 bit, 4 bit or raw byte values.
+  const unsigned char *header = data;
+  const size_t header_size = (size / kMeshoptByteGroupSize + 3) / 4;
+  if (size_t(data_end - data) < header_size) return nullptr;
+  data += header_size;
+
+  for (size_t i = 0; i < size; i += kMeshoptByteGroupSize) {
+    // The tail guarantees this much readable input for any group.
+    if (size_t(data_end - data) < kMeshoptByteGroupDecodeLimit) return nullptr;
+    const size_t group = i / kMeshoptByteGroupSize;
+    switch ((header[group / 4] >> ((group % 4) * 2)) & 3) {
+      case 0:
+        memset(out + i, 0, kMeshoptByteGroupSize);
+        break;
+      case 1:
+        data = MeshoptDecodeBytesGroup<2>(data, out + i);
+        break;
+      case 2:
+        data = MeshoptDecodeBytesGroup<4>(data, out + i);
+        break;
+      default:
+        memcpy(out + i, data, kMeshoptByteGroupSize);
+        data += kMeshoptByteGroupSize;
+        break;
+    }
+  }
+  return data;
+}
+
+// Undoes the zigzag encoded byte deltas of 4 consecutive bytes of `count`
+// vertices, `deltas` holding one row of `row_size` per byte, and stores the
+// results `stride` apart. `last` holds the bytes of the vertex before.
+static void MeshoptUndoDeltas(const unsigned char *deltas, size_t row_size,
+                              size_t count, const unsigned char *last,
+                              unsigned char *out, size_t stride) {
+  size_t i = 0;
+#if defined(TINYGLTF_INTERNAL_SSE2)
+  // Prefix sums of 16 deltas of each row, transposed to 16 4-byte stores.
+  __m128i p[4];
+  for (int k = 0; k < 4; k++) p[k] = _mm_set1_epi8(char(last[k]));
+  for (; i + 16 <= count; i += 16) {
+    __m128i r[4];
+    for (size_t k = 0; k < 4; k++) {
+      const __m128i d = _mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(deltas + k * row_size + i));
+      __m128i v = _mm_xor_si128(
+          _mm_and_si128(_mm_srli_epi16(d, 1), _mm_set1_epi8(0x7f)),
+          _mm_sub_epi8(_mm_setzero_si128(),
+                       _mm_and_si128(d, _mm_set1_epi8(1))));
+      v = _mm_add_epi8(v, _mm_slli_si128(v, 1));
+      v = _mm_add_epi8(v, _mm_slli_si128(v, 2));
+      v = _mm_add_epi8(v, _mm_slli_si128(v, 4));
+      v = _mm_add_epi8(v, _mm_slli_si128(v, 8));
+      r[k] = _mm_add_epi8(v, p[k]);
+      // Broadcast the last byte.
+      v = _mm_unpackhi_epi8(r[k], r[k]);
+      p[k] = _mm_shuffle_epi32(_mm_unpackhi_epi16(v, v), 0xff);
+    }
+    const __m128i t0 = _mm_unpacklo_epi8(r[0], r[1]);
+    const __m128i t1 = _mm_unpackhi_epi8(r[0], r[1]);
+    const __m128i t2 = _mm_unpacklo_epi8(r[2], r[3]);
+    const __m128i t3 = _mm_unpackhi_epi8(r[2], r[3]);
+    __m128i q[4] = {_mm_unpacklo_epi16(t0, t2), _mm_unpackhi_epi16(t0, t2),
+                    _mm_unpacklo_epi16(t1, t3), _mm_unpackhi_epi16(t1, t3)};
+    for (size_t j = 0; j < 16; j++) {
+      const int32_t v = _mm_cvtsi128_si32(q[j / 4]);
+      memcpy(out + (i + j) * stride, &v, 4);
+      q[j / 4] = _mm_srli_si128(q[j / 4], 4);
+    }
+  }
+  unsigned char tail[4];
+  for (int k = 0; k < 4; k++) {
+    tail[k] = static_cast<unsigned char>(_mm_cvtsi128_si32(p[k]));
+  }
+  last = tail;
+#elif defined(TINYGLTF_INTERNAL_NEON)
+  const uint8x16_t zero = vdupq_n_u8(0);
+  uint8x16_t p[4];
+  for (int k = 0; k < 4; k++) p[k] = vdupq_n_u8(last[k]);
+  for (; i + 16 <= count; i += 16) {
+    uint8x16_t r[4];
+    for (size_t k = 0; k < 4; k++) {
+      const uint8x16_t d = vld1q_u8(deltas + k * row_size + i);
+      uint8x16_t v = veorq_u8(vshrq_n_u8(d, 1),
+                              vsubq_u8(zero, vandq_u8(d, vdupq_n_u8(1))));
+      v = vaddq_u8(v, vextq_u8(zero, v, 15));
+      v = vaddq_u8(v, vextq_u8(zero, v, 14));
+      v = vaddq_u8(v, vextq_u8(zero, v, 12));
+      v = vaddq_u8(v, vextq_u8(zero, v, 8));
+      r[k] = vaddq_u8(v, p[k]);
+      p[k] = vdupq_n_u8(vgetq_lane_u8(r[k], 15));
+    }
+    const uint8x16x2_t t01 = vzipq_u8(r[0], r[1]);
+    const uint8x16x2_t t23 = vzipq_u8(r[2], r[3]);
+    const uint16x8x2_t lo = vzipq_u16(vreinterpretq_u16_u8(t01.val[0]),
+                                      vreinterpretq_u16_u8(t23.val[0]));
+    const uint16x8x2_t hi = vzipq_u16(vreinterpretq_u16_u8(t01.val[1]),
+                                      vreinterpretq_u16_u8(t23.val[1]));
+    unsigned char values[64];
+    vst1q_u8(values, vreinterpretq_u8_u16(lo.val[0]));
+    vst1q_u8(values + 16, vreinterpretq_u8_u16(lo.val[1]));
+    vst1q_u8(values + 32, vreinterpretq_u8_u16(hi.val[0]));
+    vst1q_u8(values + 48, vreinterpretq_u8_u16(hi.val[1]));
+    for (size_t j = 0; j < 16; j++) {
+      memcpy(out + (i + j) * stride, values + j * 4, 4);
+    }
+  }
+  unsigned char tail[4];
+  for (int k = 0; k < 4; k++) tail[k] = vgetq_lane_u8(p[k], 0);
+  last = tail;
+#endif
+  for (size_t k = 0; k < 4; k++) {
+    unsigned char v = last[k];
+    for (size_t j = i; j < count; j++) {
+      const unsigned char d = deltas[k * row_size + j];
+      v = static_cast<unsigned char>(v + ((0 - (d & 1)) ^ (d >> 1)));
+      out[j * stride + k] = v;
+    }
+  }
+}
 
-    return true;
+///
+/// Decodes `count` vertices of `stride` bytes from the "ATTRIBUTES"
+/// bitstream `data`. Returns false for malformed data.
+///
+static bool MeshoptDecodeVertexBuffer(unsigned char *out, size_t count,
+                                      size_t stride, const unsigned char *data,
+                                      size_t size) {
+  if (stride == 0 || stride > 256 || stride % 4 != 0) return false;
+  if (size < 1 + stride) return false;
+  const unsigned char *data_end = data + size;
+  if (*data++ != 0xa0) return false;  // Version 0 only
+
+  unsigned char last_vertex[256];
+  memcpy(last_vertex, data_end - stride, stride);
+
+  size_t block_size = (kMeshoptVertexBlockSizeBytes / stride) &
+                      ~(kMeshoptByteGroupSize - 1);
+  block_size = (std::min)(block_size, kMeshoptVertexBlockMaxSize);
+
+  // A block is stored byte by byte; the rows of all bytes fit in here.
+  std::vector<unsigned char> deltas(kMeshoptVertexBlockSizeBytes);
+  for (size_t offset = 0; offset < count; offset += block_size) {
+    const size_t n = (std::min)(block_size, count - offset);
+    const size_t n_aligned =
+        (n + kMeshoptByteGroupSize - 1) & ~(kMeshoptByteGroupSize - 1);
+    for (size_t k = 0; k < stride; k++) {
+      data = MeshoptDecodeBytes(data, data_end, &deltas[k * n_aligned],
+                                n_aligned);
+      if (!data) return false;
+    }
+    unsigned char *block = out + offset * stride;
+    for (size_t k = 0; k < stride; k += 4) {
+      MeshoptUndoDeltas(&deltas[k * n_aligned], n_aligned, n, last_vertex + k,
+                        block + k, stride);
+    }
+    memcpy(last_vertex, block + (n - 1) * stride, stride);
+  }
+
+  const size_t tail_size = (std::max)(stride, kMeshoptTailMaxSize);
+  return size_t(data_end - data) == tail_size;
+}
+
+static unsigned MeshoptDecodeVByte(const unsigned char *&data) {
+  const unsigned char lead = *data++;
+  if (lead < 128) return lead;
+
+  // Up to 4 more bytes; always stops, even for malformed data.
+  unsigned result = lead & 127;
+  unsigned shift = 7;
+  for (int i = 0; i < 4; i++) {
+    const unsigned char group = *data++;
+    result |= unsigned(group & 127) << shift;
+    shift += 7;
+    if (group < 128) break;
   }
+  return result;
+}
 
-  // Parse URI & Load image data.
+static unsigned MeshoptDecodeIndex(const unsigned char *&data,
+                                   unsigned last) {
+  const unsigned v = MeshoptDecodeVByte(data);
+  return last + ((v >> 1) ^ (0u - (v & 1)));
+}
 
-  std::string uri;
-  std::string tmp_err;
-  if (!ParseStringProperty(&uri, &tmp_err, o, "uri", true)) {
-    if (err) {
-      (*err) += "Failed to parse `uri` for image[" + std::to_string(image_idx) +
-                "] name = \"" + image->name + "\".\n";
-    }
-    return false;
+static void MeshoptWriteIndex(unsigned char *out, size_t i, size_t index_size,
+                              unsigned v) {
+  if (index_size == 2) {
+    const uint16_t v16 = static_cast<uint16_t>(v);
+    memcpy(out + i * 2, &v16, 2);
+  } else {
+    memcpy(out + i * 4, &v, 4);
   }
+}
 
-  std::vector<unsigned char> img;
+///
+/// Decodes `count` triangle indices(a multiple of 3) of `index_size` 2 or 4
+/// from the "TRIANGLES" bitstream `data`. Returns false for malformed data.
+///
+static bool MeshoptDecodeIndexBuffer(unsigned char *out, size_t count,
+                                     size_t index_size,
+                                     const unsigned char *data, size_t size) {
+  if (count % 3 != 0 || (index_size != 2 && index_size != 4)) return false;
+  // Header, a byte per triangle and the 16 byte codeaux table at least.
+  if (size < 1 + count / 3 + 16) return false;
+  if ((data[0] & 0xf0) != 0xe0) return false;
+  const int version = data[0] & 0x0f;
+  if (version > 1) return false;
+
+  // Recently seen edges and vertices, 16 entries each.
+  unsigned edges[16][2];
+  unsigned vertices[16];
+  memset(edges, -1, sizeof(edges));
+  memset(vertices, -1, sizeof(vertices));
+  size_t edge_offset = 0;
+  size_t vertex_offset = 0;
+  auto push_edge = [&](unsigned a, unsigned b) {
+    edges[edge_offset][0] = a;
+    edges[edge_offset][1] = b;
+    edge_offset = (edge_offset + 1) & 15;
+  };
+  auto push_vertex = [&](unsigned v, bool cond) {
+    vertices[vertex_offset] = v;
+    vertex_offset = (vertex_offset + (cond ? 1 : 0)) & 15;
+  };
 
-  if (IsDataURI(uri)) {
-    if (!DecodeDataURI(&img, image->mimeType, uri, 0, false)) {
-      if (err) {
-        (*err) += "Failed to decode 'uri' for image[" +
-                  std::to_string(image_idx) + "] name = \"" + image->name +
-                  "\"\n";
-      }
-      return false;
-    }
-  } else {
-    // Assume external file
-    // Keep texture path (for textures that cannot be decoded)
-    image->uri = uri;
-#ifdef TINYGLTF_NO_EXTERNAL_IMAGE
-    return true;
-#else
-    std::string decoded_uri;
-    if (!uri_cb->decode(uri, &decoded_uri, uri_cb->user_data)) {
-      if (warn) {
-        (*warn) += "Failed to decode 'uri' for image[" +
-                   std::to_string(image_idx) + "] name = \"" + image->name +
-                   "\"\n";
+  unsigned next = 0;
+  unsigned last = 0;
+  // Version 1 turns vertex fifo references 13 and 14 into last -/+ 1.
+  const int fecmax = version >= 1 ? 13 : 15;
+
+  const unsigned char *code = data + 1;
+  const unsigned char *p = code + count / 3;
+  const unsigned char *data_safe_end = data + size - 16;
+  const unsigned char *codeaux_table = data_safe_end;
+
+  for (size_t i = 0; i < count; i += 3) {
+    // A triangle reads at most 16 bytes: 1 codeaux and 5 per free index.
+    if (p > data_safe_end) return false;
+
+    const unsigned char codetri = *code++;
+    unsigned a, b, c;
+    if (codetri < 0xf0) {
+      // An edge from the fifo, and a new, cached or free third vertex.
+      const unsigned *edge = edges[(edge_offset - 1 - (codetri >> 4)) & 15];
+      a = edge[0];
+      b = edge[1];
+      const int fec = codetri & 15;
+      if (fec < fecmax) {
+        c = fec == 0 ? next : vertices[(vertex_offset - 1 - size_t(fec)) & 15];
+        next += fec == 0;
+        push_vertex(c, fec == 0);
+      } else {
+        // fec - (fec ^ 3) maps 13 and 14 to -1 and 1.
+        c = last = fec != 15 ? last + unsigned(fec - (fec ^ 3))
+                             : MeshoptDecodeIndex(p, last);
+        push_vertex(c, true);
       }
+      push_edge(c, b);
+      push_edge(a, c);
+    } else {
+      // Up to three new vertices, cached ones or, when escaped, free ones.
+      const bool escaped = codetri >= 0xfe;
+      unsigned char codeaux;
+      if (escaped) {
+        codeaux = *p++;
+        if (codeaux == 0) next = 0;  // Restart
+      } else {
+        codeaux = codeaux_table[codetri & 15];
+      }
+      const int fea = codetri == 0xff ? 15 : 0;
+      const int feb = codeaux >> 4;
+      const int fec = codeaux & 15;
+      // `next` advances for all three vertices before free indices are
+      // decoded, like the encoder does.
+      a = fea == 0 ? next++ : 0;
+      b = feb == 0 ? next++ : vertices[(vertex_offset - size_t(feb)) & 15];
+      c = fec == 0 ? next++ : vertices[(vertex_offset - size_t(fec)) & 15];
+      const bool free_b = escaped && feb == 15;
+      const bool free_c = escaped && fec == 15;
+      if (fea == 15) last = a = MeshoptDecodeIndex(p, last);
+      if (free_b) last = b = MeshoptDecodeIndex(p, last);
+      if (free_c) last = c = MeshoptDecodeIndex(p, last);
+
+      push_vertex(a, true);
+      push_vertex(b, feb == 0 || free_b);
+      push_vertex(c, fec == 0 || free_c);
+      push_edge(b, a);
+      push_edge(c, b);
+      push_edge(a, c);
+    }
+    MeshoptWriteIndex(out, i, index_size, a);
+    MeshoptWriteIndex(out, i + 1, index_size, b);
+    MeshoptWriteIndex(out, i + 2, index_size, c);
+  }
+
+  // All data consumed, up to the codeaux table.
+  return p == data_safe_end;
+}
 
-      // Image loading failure is not critical to overall gltf loading.
-      return true;
-    }
+///
+/// Decodes `count` indices of `index_size` 2 or 4 from the "INDICES"
+/// bitstream `data`. Returns false for malformed data.
+///
+static bool MeshoptDecodeIndexSequence(unsigned char *out, size_t count,
+                                       size_t index_size,
+                                       const unsigned char *data, size_t size) {
+  if (index_size != 2 && index_size != 4) return false;
+  // Header, a byte per index and a 4 byte tail at least.
+  if (size < 1 + count + 4) return false;
+  if ((data[0] & 0xf0) != 0xd0 || (data[0] & 0x0f) > 1) return false;
+
+  const unsigned char *p = data + 1;
+  const unsigned char *data_safe_end = data + size - 4;
+  // Deltas are relative to one of two baselines, picked by the low bit.
+  unsigned last[2] = {0, 0};
+  for (size_t i = 0; i < count; i++) {
+    // An index reads at most 5 bytes, and the tail has 4.
+    if (p >= data_safe_end) return false;
+    unsigned v = MeshoptDecodeVByte(p);
+    const unsigned current = v & 1;
+    v >>= 1;
+    last[current] += (v >> 1) ^ (0u - (v & 1));
+    MeshoptWriteIndex(out, i, index_size, last[current]);
+  }
+  return p == data_safe_end;
+}
+
+// Rounds to the nearest integer, halfway cases away from zero.
+static inline int MeshoptRound(float v) {
+  return int(v + (v >= 0.f ? 0.5f : -0.5f));
+}
 
-    if (!LoadExternalFile(&img, err, warn, decoded_uri, basedir,
-                          /* required */ false, /* required bytes */ 0,
-                          /* checksize */ false,
-                          /* max file size */ max_file_size, fs)) {
-      if (warn) {
-        (*warn) += "Failed to load external 'uri' for image[" +
-                   std::to_string(image_idx) + "] name = \"" + decoded_uri +
-                   "\"\n";
+///
+/// Octahedral filter: 4 components of T(int8_t or int16_t) per vector.
+/// x and y are octahedral coordinates and z holds the scale; the result is
+/// a normalized vector, w untouched.
+///
+template <typename T>
+static void MeshoptDecodeFilterOct(T *data, size_t count) {
+  const float max = float((1 << (sizeof(T) * 8 - 1)) - 1);
+  size_t i = 0;
+#if defined(TINYGLTF_INTERNAL_SSE2)
+  const __m128 sign = _mm_set1_ps(-0.f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  for (; i + 4 <= count; i += 4) {
+    __m128 x = _mm_setr_ps(float(data[i * 4]), float(data[i * 4 + 4]),
+                           float(data[i * 4 + 8]), float(data[i * 4 + 12]));
+    __m128 y = _mm_setr_ps(float(data[i * 4 + 1]), float(data[i * 4 + 5]),
+                           float(data[i * 4 + 9]), float(data[i * 4 + 13]));
+    __m128 z = _mm_setr_ps(float(data[i * 4 + 2]), float(data[i * 4 + 6]),
+                           float(data[i * 4 + 10]), float(data[i * 4 + 14]));
+    z = _mm_sub_ps(_mm_sub_ps(z, _mm_andnot_ps(sign, x)),
+                   _mm_andnot_ps(sign, y));
+    // Fold back for z < 0: t = min(z, 0), applied against the sign of x/y.
+    const __m128 t = _mm_min_ps(z, _mm_setzero_ps());
+    x = _mm_add_ps(x, _mm_xor_ps(t, _mm_and_ps(sign, x)));
+    y = _mm_add_ps(y, _mm_xor_ps(t, _mm_and_ps(sign, y)));
+    const __m128 l = _mm_sqrt_ps(_mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+    const __m128 s = _mm_div_ps(_mm_set1_ps(max), l);
+    __m128i r[3];
+    const __m128 v[3] = {x, y, z};
+    for (int c = 0; c < 3; c++) {
+      const __m128 scaled = _mm_mul_ps(v[c], s);
+      r[c] = _mm_cvttps_epi32(
+          _mm_add_ps(scaled, _mm_or_ps(half, _mm_and_ps(sign, scaled))));
+    }
+    int32_t out[3][4];
+    for (int c = 0; c < 3; c++) {
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out[c]), r[c]);
+    }
+    for (size_t k = 0; k < 4; k++) {
+      for (size_t c = 0; c < 3; c++) {
+        data[(i + k) * 4 + c] = T(out[c][k]);
+      }
+    }
+  }
+#elif defined(TINYGLTF_INTERNAL_NEON) && defined(__aarch64__)
+  for (; i + 4 <= count; i += 4) {
+    float in[3][4];
+    for (size_t k = 0; k < 4; k++) {
+      for (size_t c = 0; c < 3; c++) in[c][k] = float(data[(i + k) * 4 + c]);
+    }
+    float32x4_t x = vld1q_f32(in[0]);
+    float32x4_t y = vld1q_f32(in[1]);
+    float32x4_t z = vsubq_f32(vsubq_f32(vld1q_f32(in[2]), vabsq_f32(x)),
+                              vabsq_f32(y));
+    const float32x4_t t = vminq_f32(z, vdupq_n_f32(0.f));
+    x = vaddq_f32(x, vbslq_f32(vcgeq_f32(x, vdupq_n_f32(0.f)), t,
+                               vnegq_f32(t)));
+    y = vaddq_f32(y, vbslq_f32(vcgeq_f32(y, vdupq_n_f32(0.f)), t,
+                               vnegq_f32(t)));
+    const float32x4_t l = vsqrtq_f32(vaddq_f32(
+        vaddq_f32(vmulq_f32(x, x), vmulq_f32(y, y)), vmulq_f32(z, z)));
+    const float32x4_t s = vdivq_f32(vdupq_n_f32(max), l);
+    const float32x4_t v[3] = {x, y, z};
+    int32_t out[3][4];
+    for (int c = 0; c < 3; c++) {
+      const float32x4_t scaled = vmulq_f32(v[c], s);
+      const float32x4_t half =
+          vbslq_f32(vcgeq_f32(scaled, vdupq_n_f32(0.f)), vdupq_n_f32(0.5f),
+                    vdupq_n_f32(-0.5f));
+      vst1q_s32(out[c], vcvtq_s32_f32(vaddq_f32(scaled, half)));
+    }
+    for (size_t k = 0; k < 4; k++) {
+      for (size_t c = 0; c < 3; c++) {
+        data[(i + k) * 4 + c] = T(out[c][k]);
       }
-      // If the image cannot be loaded, keep uri as image->uri.
-      return true;
     }
+  }
+#endif
+  for (; i < count; i++) {
+    float x = float(data[i * 4 + 0]);
+    float y = float(data[i * 4 + 1]);
+    float z = float(data[i * 4 + 2]) - fabsf(x) - fabsf(y);
 
-    if (img.empty()) {
-      if (warn) {
-        (*warn) += "Image data is empty for image[" +
-                   std::to_string(image_idx) + "] name = \"" + image->name +
-                   "\" \n";
+    const float t = (z >= 0.f) ? 0.f : z;
+    x += (x >= 0.f) ? t : -t;
+    y += (y >= 0.f) ? t : -t;
+
+    const float s = max / sqrtf(x * x + y * y + z * z);
+    data[i * 4 + 0] = T(MeshoptRound(x * s));
+    data[i * 4 + 1] = T(MeshoptRound(y * s));
+    data[i * 4 + 2] = T(MeshoptRound(z * s));
+  }
+}
+
+///
+/// Quaternion filter: 4 int16_t per quaternion. Three components and the
+/// index of the largest, omitted one; the result is a normalized
+/// quaternion.
+///
+static void MeshoptDecodeFilterQuat(int16_t *data, size_t count) {
+  const float scale = 1.f / sqrtf(2.f);
+  size_t i = 0;
+#if defined(TINYGLTF_INTERNAL_SSE2)
+  const __m128 sign = _mm_set1_ps(-0.f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  for (; i + 4 <= count; i += 4) {
+    const int16_t *q = data + i * 4;
+    const __m128 ss = _mm_div_ps(
+        _mm_set1_ps(scale),
+        _mm_setr_ps(float(q[3] | 3), float(q[7] | 3), float(q[11] | 3),
+                    float(q[15] | 3)));
+    const __m128 x = _mm_mul_ps(
+        _mm_setr_ps(float(q[0]), float(q[4]), float(q[8]), float(q[12])), ss);
+    const __m128 y = _mm_mul_ps(
+        _mm_setr_ps(float(q[1]), float(q[5]), float(q[9]), float(q[13])), ss);
+    const __m128 z = _mm_mul_ps(
+        _mm_setr_ps(float(q[2]), float(q[6]), float(q[10]), float(q[14])),
+        ss);
+    const __m128 ww = _mm_sub_ps(
+        _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.f), _mm_mul_ps(x, x)),
+                   _mm_mul_ps(y, y)),
+        _mm_mul_ps(z, z));
+    const __m128 w = _mm_sqrt_ps(_mm_max_ps(ww, _mm_setzero_ps()));
+    int32_t out[4][4];
+    const __m128 v[4] = {w, x, y, z};
+    for (int c = 0; c < 4; c++) {
+      const __m128 scaled = _mm_mul_ps(v[c], _mm_set1_ps(32767.f));
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i *>(out[c]),
+          _mm_cvttps_epi32(_mm_add_ps(
+              scaled, _mm_or_ps(half, _mm_and_ps(sign, scaled)))));
+    }
+    for (size_t k = 0; k < 4; k++) {
+      const size_t qc = size_t(data[(i + k) * 4 + 3] & 3);
+      for (size_t c = 0; c < 4; c++) {
+        data[(i + k) * 4 + ((qc + c) & 3)] = int16_t(out[c][k]);
+      }
+    }
+  }
+#elif defined(TINYGLTF_INTERNAL_NEON) && defined(__aarch64__)
+  for (; i + 4 <= count; i += 4) {
+    float in[4][4];
+    for (size_t k = 0; k < 4; k++) {
+      for (size_t c = 0; c < 3; c++) in[c][k] = float(data[(i + k) * 4 + c]);
+      in[3][k] = float(data[(i + k) * 4 + 3] | 3);
+    }
+    const float32x4_t ss = vdivq_f32(vdupq_n_f32(scale), vld1q_f32(in[3]));
+    const float32x4_t x = vmulq_f32(vld1q_f32(in[0]), ss);
+    const float32x4_t y = vmulq_f32(vld1q_f32(in[1]), ss);
+    const float32x4_t z = vmulq_f32(vld1q_f32(in[2]), ss);
+    const float32x4_t ww = vsubq_f32(
+        vsubq_f32(vsubq_f32(vdupq_n_f32(1.f), vmulq_f32(x, x)),
+                  vmulq_f32(y, y)),
+        vmulq_f32(z, z));
+    const float32x4_t w = vsqrtq_f32(vmaxq_f32(ww, vdupq_n_f32(0.f)));
+    const float32x4_t v[4] = {w, x, y, z};
+    int32_t out[4][4];
+    for (int c = 0; c < 4; c++) {
+      const float32x4_t scaled = vmulq_f32(v[c], vdupq_n_f32(32767.f));
+      const float32x4_t half =
+          vbslq_f32(vcgeq_f32(scaled, vdupq_n_f32(0.f)), vdupq_n_f32(0.5f),
+                    vdupq_n_f32(-0.5f));
+      vst1q_s32(out[c], vcvtq_s32_f32(vaddq_f32(scaled, half)));
+    }
+    for (size_t k = 0; k < 4; k++) {
+      const size_t qc = size_t(data[(i + k) * 4 + 3] & 3);
+      for (size_t c = 0; c < 4; c++) {
+        data[(i + k) * 4 + ((qc + c) & 3)] = int16_t(out[c][k]);
       }
-      return false;
     }
+  }
 #endif
+  for (; i < count; i++) {
+    // The scale is in the high bits of the last component.
+    const float ss = scale / float(data[i * 4 + 3] | 3);
+    const float x = float(data[i * 4 + 0]) * ss;
+    const float y = float(data[i * 4 + 1]) * ss;
+    const float z = float(data[i * 4 + 2]) * ss;
+    const float ww = 1.f - x * x - y * y - z * z;
+    const float w = sqrtf(ww >= 0.f ? ww : 0.f);
+
+    const int qc = data[i * 4 + 3] & 3;
+    data[i * 4 + ((qc + 1) & 3)] = int16_t(MeshoptRound(x * 32767.f));
+    data[i * 4 + ((qc + 2) & 3)] = int16_t(MeshoptRound(y * 32767.f));
+    data[i * 4 + ((qc + 3) & 3)] = int16_t(MeshoptRound(z * 32767.f));
+    data[i * 4 + ((qc + 0) & 3)] = int16_t(MeshoptRound(w * 32767.f));
   }
+}
 
-  if (*LoadImageData == nullptr) {
-    if (err) {
-      (*err) += "No LoadImageData callback specified.\n";
-    }
+///
+/// Exponential filter: each 32-bit value is a 24-bit signed mantissa and an
+/// 8-bit signed exponent, and becomes the float m * 2^e.
+///
+static void MeshoptDecodeFilterExp(uint32_t *data, size_t count) {
+  size_t i = 0;
+#if defined(TINYGLTF_INTERNAL_SSE2)
+  for (; i + 4 <= count; i += 4) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    const __m128i m = _mm_srai_epi32(_mm_slli_epi32(v, 8), 8);
+    const __m128i e = _mm_srai_epi32(v, 24);
+    // 2^e built from its bits, then scaled by the mantissa.
+    const __m128 f = _mm_mul_ps(
+        _mm_castsi128_ps(
+            _mm_slli_epi32(_mm_add_epi32(e, _mm_set1_epi32(127)), 23)),
+        _mm_cvtepi32_ps(m));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(data + i),
+                     _mm_castps_si128(f));
+  }
+#elif defined(TINYGLTF_INTERNAL_NEON)
+  for (; i + 4 <= count; i += 4) {
+    const int32_t *src = reinterpret_cast<const int32_t *>(data + i);
+    const int32x4_t v = vld1q_s32(src);
+    const int32x4_t m = vshrq_n_s32(vshlq_n_s32(v, 8), 8);
+    const int32x4_t e = vshrq_n_s32(v, 24);
+    const float32x4_t f = vmulq_f32(
+        vreinterpretq_f32_s32(vshlq_n_s32(vaddq_s32(e, vdupq_n_s32(127)), 23)),
+        vcvtq_f32_s32(m));
+    vst1q_u32(data + i, vreinterpretq_u32_f32(f));
+  }
+#endif
+  for (; i < count; i++) {
+    const uint32_t v = data[i];
+    const int32_t m = int32_t(v << 8) >> 8;
+    const int32_t e = int32_t(v) >> 24;
+    const uint32_t bits = uint32_t(e + 127) << 23;
+    float f;
+    memcpy(&f, &bits, 4);
+    f *= float(m);
+    memcpy(data + i, &f, 4);
+  }
+}
+
+// Reads member `name` of `o` as a non-negative integer that fits in size_t.
+// A missing member reads as `fallback` when `optional` is set.
+static bool GetMeshoptSize(const Value &o, const char *name, bool optional,
+                           size_t fallback, size_t *out) {
+  const Value &v = o.Get(name);
+  if (!v.IsNumber()) {
+    (*out) = fallback;
+    return optional && v.Type() == NULL_TYPE;
+  }
+  const double d = v.GetNumberAsDouble();
+  // size_t max rounds up to a power of two as a double, so `<` is exact.
+  if (!(d >= 0.0) ||
+      !(d < static_cast<double>((std::numeric_limits<size_t>::max)())) ||
+      d != std::floor(d)) {
     return false;
   }
-  return (*LoadImageData)(image, image_idx, err, warn, 0, 0, &img.at(0),
-                          static_cast<int>(img.size()), load_image_user_data);
+  (*out) = static_cast<size_t>(d);
+  return true;
 }
 
-static bool ParseTexture(Texture *texture, std::string *err,
-                         const detail::json &o,
-                         bool store_original_json_for_extras_and_extensions,
-                         const std::string &basedir) {
-  (void)basedir;
-  int sampler = -1;
-  int source = -1;
-  ParseIntegerProperty(&sampler, err, o, "sampler", false);
-
-  ParseIntegerProperty(&source, err, o, "source", false);
-
-  texture->sampler = sampler;
-  texture->source = source;
-
-  ParseExtrasAndExtensions(texture, err, o,
-                           store_original_json_for_extras_and_extensions);
-
-  ParseStringProperty(&texture->name, err, o, "name", false);
+///
+/// Decodes every bufferView with EXT_meshopt_compression into its own range
+/// of its buffer(usually a fallback buffer without data of its own), so
+/// accessors see plain data.
+///
+static bool DecodeMeshoptBufferViews(Model *model, std::string *err) {
+  for (size_t i = 0; i < model->bufferViews.size(); i++) {
+    BufferView &view = model->bufferViews[i];
+    auto ext = view.extensions.find("EXT_meshopt_compression");
+    if (ext == view.extensions.end()) continue;
+
+    const std::string where =
+        "EXT_meshopt_compression of bufferView[" + std::to_string(i) + "]";
+    const Value &o = ext->second;
+    const int source = o.Get("buffer").IsNumber()
+                           ? o.Get("buffer").GetNumberAsInt()
+                           : -1;
+    size_t byteOffset = 0;
+    size_t byteLength = 0;
+    size_t byteStride = 0;
+    size_t count = 0;
+    const bool sizes_ok =
+        GetMeshoptSize(o, "byteOffset", true, 0, &byteOffset) &&
+        GetMeshoptSize(o, "byteLength", false, 0, &byteLength) &&
+        GetMeshoptSize(o, "byteStride", false, 0, &byteStride) &&
+        GetMeshoptSize(o, "count", false, 0, &count);
+    const std::string mode = o.Get("mode").IsString()
+                                 ? o.Get("mode").Get<std::string>()
+                                 : std::string();
+    const std::string filter = o.Get("filter").IsString()
+                                   ? o.Get("filter").Get<std::string>()
+                                   : std::string("NONE");
+
+    // Sizes come from the file; compare without overflowing.
+    if (!sizes_ok || byteStride == 0 || source < 0 ||
+        size_t(source) >= model->buffers.size() ||
+        byteOffset > model->buffers[size_t(source)].Size() ||
+        byteLength > model->buffers[size_t(source)].Size() - byteOffset ||
+        view.buffer < 0 || size_t(view.buffer) >= model->buffers.size() ||
+        view.byteOffset > model->buffers[size_t(view.buffer)].Size() ||
+        view.byteLength >
+            model->buffers[size_t(view.buffer)].Size() - view.byteOffset ||
+        count > view.byteLength / byteStride || source == view.buffer) {
+      if (err) (*err) += "Invalid " + where + ".\n";
+      return false;
+    }
 
+    Buffer &target = model->buffers[size_t(view.buffer)];
+    // Borrowed bytes are read-only.
+    target.MakeOwned();
+    unsigned char *out = target.data.data() + view.byteOffset;
+    const unsigned char *data =
+        model->buffers[size_t(source)].Data() + byteOffset;
+
+    bool ok = false;
+    if (mode == "ATTRIBUTES") {
+      ok = MeshoptDecodeVertexBuffer(out, count, byteStride, data, byteLength);
+    } else if (mode == "TRIANGLES") {
+      ok = MeshoptDecodeIndexBuffer(out, count, byteStride, data, byteLength);
+    } else if (mode == "INDICES") {
+      ok = MeshoptDecodeIndexSequence(out, count, byteStride, data,
+                                      byteLength);
+    }
+    if (ok && filter != "NONE") {
+      if (mode != "ATTRIBUTES") {
+        ok = false;
+      } else if (filter == "OCTAHEDRAL" && byteStride == 4) {
+        MeshoptDecodeFilterOct(reinterpret_cast<int8_t *>(out), count);
+      } else if (filter == "OCTAHEDRAL" && byteStride == 8) {
+        MeshoptDecodeFilterOct(reinterpret_cast<int16_t *>(out), count);
+      } else if (filter == "QUATERNION" && byteStride == 8) {
+        MeshoptDecodeFilterQuat(reinterpret_cast<int16_t *>(out), count);
+      } else if (filter == "EXPONENTIAL") {
+        MeshoptDecodeFilterExp(reinterpret_cast<uint32_t *>(out),
+                               count * byteStride / 4);
+      } else {
+        ok = false;
+      }
+    }
+    if (!ok) {
+      if (err) (*err) += "Failed to decode " + where + ".\n";
+      return false;
+    }
+  }
   return true;
 }
 
-static bool ParseTextureInfo(
-    TextureInfo *texinfo, std::string *err, const detail::json &o,
+}  // namespace detail
+
+static bool ParseSparseAccessor(
+    Accessor::Sparse *sparse, std::string *err, const detail::json &o,
     bool store_original_json_for_extras_and_extensions) {
-  if (texinfo == nullptr) {
+  sparse->isSparse = true;
+
+  int count = 0;
+  if (!ParseIntegerProperty(&count, err, o, "count", true, "SparseAccessor")) {
     return false;
   }
 
-  if (!ParseIntegerProperty(&texinfo->index, err, o, "index",
-                            /* required */ true, "TextureInfo")) {
+  ParseExtrasAndExtensions(sparse, err, o,
+                           store_original_json_for_extras_and_extensions);
+
+  detail::json_const_iterator indices_iterator;
+  detail::json_const_iterator values_iterator;
+  if (!detail::FindMember(o, "indices", indices_iterator)) {
+    (*err) = "the sparse object of this accessor doesn't have indices";
     return false;
   }
 
-  ParseIntegerProperty(&texinfo->texCoord, err, o, "texCoord", false);
-
-  ParseExtrasAndExtensions(texinfo, err, o,
-                           store_original_json_for_extras_and_extensions);
+  if (!detail::FindMember(o, "values", values_iterator)) {
+    (*err) = "the sparse object of this accessor doesn't have values";
+    return false;
+  }
 
-  return true;
-}
+  const detail::json &indices_obj = detail::GetValue(indices_iterator);
+  const detail::json &values_obj = detail::GetValue(values_iterator);
 
-static bool ParseNormalTextureInfo(
-    NormalTextureInfo *texinfo, std::string *err, const detail::json &o,
-    bool store_original_json_for_extras_and_extensions) {
-  if (texinfo == nullptr) {
+  int indices_buffer_view = 0, component_type = 0;
+  size_t indices_byte_offset = 0;
+  if (!ParseIntegerProperty(&indices_buffer_view, err, indices_obj,
+                            "bufferView", true, "SparseAccessor")) {
+    return false;
+  }
+  ParseUnsignedProperty(&indices_byte_offset, err, indices_obj, "byteOffset",
+                       false);
+  if (!ParseIntegerProperty(&component_type, err, indices_obj, "componentType",
+                            true, "SparseAccessor")) {
     return false;
   }
 
-  if (!ParseIntegerProperty(&texinfo->index, err, o, "index",
-                            /* required */ true, "NormalTextureInfo")) {
+  int values_buffer_view = 0;
+  size_t values_byte_offset = 0;
+  if (!ParseIntegerProperty(&values_buffer_view, err, values_obj, "bufferView",
+                            true, "SparseAccessor")) {
     return false;
   }
+  ParseUnsignedProperty(&values_byte_offset, err, values_obj, "byteOffset",
+                       false);
 
-  ParseIntegerProperty(&texinfo->texCoord, err, o, "texCoord", false);
-  ParseNumberProperty(&texinfo->scale, err, o, "scale", false);
+  sparse->count = count;
+  sparse->indices.bufferView = indices_buffer_view;
+  sparse->indices.byteOffset = indices_byte_offset;
+  sparse->indices.componentType = component_type;
+  ParseExtrasAndExtensions(&sparse->indices, err, indices_obj,
+                           store_original_json_for_extras_and_extensions);
 
-  ParseExtrasAndExtensions(texinfo, err, o,
+  sparse->values.bufferView = values_buffer_view;
+  sparse->values.byteOffset = values_byte_offset;
+  ParseExtrasAndExtensions(&sparse->values, err, values_obj,
                            store_original_json_for_extras_and_extensions);
 
   return true;
 }
 
-static bool ParseOcclusionTextureInfo(
-    OcclusionTextureInfo *texinfo, std::string *err, const detail::json &o,
-    bool store_original_json_for_extras_and_extensions) {
-  if (texinfo == nullptr) {
+static bool ParseAccessor(Accessor *accessor, std::string *err,
+                          const detail::json &o,
+                          bool store_original_json_for_extras_and_extensions) {
+  int bufferView = -1;
+  ParseIntegerProperty(&bufferView, err, o, "bufferView", false, "Accessor");
+
+  size_t byteOffset = 0;
+  ParseUnsignedProperty(&byteOffset, err, o, "byteOffset", false, "Accessor");
+
+  bool normalized = false;
+  ParseBooleanProperty(&normalized, err, o, "normalized", false, "Accessor");
+
+  size_t componentType = 0;
+  if (!ParseUnsignedProperty(&componentType, err, o, "componentType", true,
+                             "Accessor")) {
     return false;
   }
 
-  if (!ParseIntegerProperty(&texinfo->index, err, o, "index",
-                            /* required */ true, "NormalTextureInfo")) {
+  size_t count = 0;
+  if (!ParseUnsignedProperty(&count, err, o, "count", true, "Accessor")) {
     return false;
   }
 
-  ParseIntegerProperty(&texinfo->texCoord, err, o, "texCoord", false);
-  ParseNumberProperty(&texinfo->strength, err, o, "strength", false);
-
-  ParseExtrasAndExtensions(texinfo, err, o,
-                           store_original_json_for_extras_and_extensions);
-
-  return true;
-}
-
-static bool ParseBuffer(Buffer *buffer, std::string *err, const detail::json &o,
-                        bool store_original_json_for_extras_and_extensions,
-                        FsCallbacks *fs, const URICallbacks *uri_cb,
-                        const std::string &basedir,
-                        const size_t max_buffer_size, bool is_binary = false,
-                        const unsigned char *bin_data = nullptr,
-                        size_t bin_size = 0) {
-  size_t byteLength;
-  if (!ParseUnsignedProperty(&byteLength, err, o, "byteLength", true,
-                             "Buffer")) {
+  std::string type;
+  if (!ParseStringProperty(&type, err, o, "type", true, "Accessor")) {
     return false;
   }
 
-  // In glTF 2.0, uri is not mandatory anymore
-  buffer->uri.clear();
-  ParseStringProperty(&buffer->uri, err, o, "uri", false, "Buffer");
-
-  // having an empty uri for a non embedded image should not be valid
-  if (!is_binary && buffer->uri.empty()) {
+  if (type.compare("SCALAR") == 0) {
+    accessor->type = TINYGLTF_TYPE_SCALAR;
+  } else if (type.compare("VEC2") == 0) {
+    accessor->type = TINYGLTF_TYPE_VEC2;
+  } else if (type.compare("VEC3") == 0) {
+    accessor->type = TINYGLTF_TYPE_VEC3;
+  } else if (type.compare("VEC4") == 0) {
+    accessor->type = TINYGLTF_TYPE_VEC4;
+  } else if (type.compare("MAT2") == 0) {
+    accessor->type = TINYGLTF_TYPE_MAT2;
+  } else if (type.compare("MAT3") == 0) {
+    accessor->type = TINYGLTF_TYPE_MAT3;
+  } else if (type.compare("MAT4") == 0) {
+    accessor->type = TINYGLTF_TYPE_MAT4;
+  } else {
+    std::stringstream ss;
+    ss << "Unsupported `type` for accessor object. Got \"" << type << "\"\n";
     if (err) {
-      (*err) += "'uri' is missing from non binary glTF file buffer.\n";
+      (*err) += ss.str();
     }
+    return false;
   }
 
-  detail::json_const_iterator type;
-  if (detail::FindMember(o, "type", type)) {
-    std::string typeStr;
-    if (detail::GetString(detail::GetValue(type), typeStr)) {
-      if (typeStr.compare("arraybuffer") == 0) {
-        // buffer.type = "arraybuffer";
+  ParseStringProperty(&accessor->name, err, o, "name", false);
+
+  accessor->minValues.clear();
+  accessor->maxValues.clear();
+  ParseNumberArrayProperty(&accessor->minValues, err, o, "min", false,
+                           "Accessor");
+
+  ParseNumberArrayProperty(&accessor->maxValues, err, o, "max", false,
+                           "Accessor");
+
+  accessor->count = count;
+  accessor->bufferView = bufferView;
+  accessor->byteOffset = byteOffset;
+  accessor->normalized = normalized;
+  {
+    if (componentType >= TINYGLTF_COMPONENT_TYPE_BYTE &&
+        componentType <= TINYGLTF_COMPONENT_TYPE_DOUBLE) {
+      // OK
+      accessor->componentType = int(componentType);
+    } else {
+      std::stringstream ss;
+      ss << "Invalid `componentType` in accessor. Got " << componentType
+         << "\n";
+      if (err) {
+        (*err) += ss.str();
       }
+      return false;
     }
   }
 
-  if (is_binary) {
-    // Still binary glTF accepts external dataURI.
-    if (!buffer->uri.empty()) {
-      // First try embedded data URI.
-      if (IsDataURI(buffer->uri)) {
-        std::string mime_type;
-        if (!DecodeDataURI(&buffer->data, mime_type, buffer->uri, byteLength,
-                           true)) {
-          if (err) {
-            (*err) +=
-                "Failed to decode 'uri' : " + buffer->uri + " in Buffer\n";
-          }
-          return false;
-        }
-      } else {
-        // External .bin file.
-        std::string decoded_uri;
-        if (!uri_cb->decode(buffer->uri, &decoded_uri, uri_cb->user_data)) {
-          return false;
-        }
-        if (!LoadExternalFile(&buffer->data, err, /* warn */ nullptr,
-                              decoded_uri, basedir, /* required */ true,
-                              byteLength, /* checkSize */ true,
-                              /* max_file_size */ max_buffer_size, fs)) {
-          return false;
-        }
-      }
-    } else {
-      // load data from (embedded) binary data
+  ParseExtrasAndExtensions(accessor, err, o,
+                           store_original_json_for_extras_and_extensions);
 
-      if ((bin_size == 0) || (bin_data == nullptr)) {
-        if (err) {
-          (*err) +=
-              "Invalid binary data in `Buffer', or GLB with empty BIN chunk.\n";
-        }
-        return false;
-      }
+  // check if accessor has a "sparse" object:
+  detail::json_const_iterator iterator;
+  if (detail::FindMember(o, "sparse", iterator)) {
+    // here this accessor has a "sparse" subobject
+    return ParseSparseAccessor(&accessor->sparse, err,
+                               detail::GetValue(iterator),
+                               store_original_json_for_extras_and_extensions);
+  }
 
-      if (byteLength > bin_size) {
-        if (err) {
-          std::stringstream ss;
-          ss << "Invalid `byteLength'. Must be equal or less than binary size: "
-                "`byteLength' = "
-             << byteLength << ", binary size = " << bin_size << std::endl;
-          (*err) += ss.str();
-        }
-        return false;
-      }
+  return true;
+}
 
-      // Read buffer data
-      buffer->data.resize(static_cast<size_t>(byteLength));
-      memcpy(&(buffer->data.at(0)), bin_data, static_cast<size_t>(byteLength));
-    }
+#ifdef TINYGLTF_ENABLE_DRACO
+
+namespace detail {
 
+static void DecodeIndexBuffer(const draco::Mesh *mesh, size_t componentSize,
+                              unsigned char *out) {
+  if (componentSize == 4) {
+    static_assert(sizeof(draco::Mesh::Face) == 3 * sizeof(uint32_t),
+                  "Draco faces are expected to be packed uint32_t indices");
+    if (mesh->num_faces() > 0) {
+      memcpy(out, &mesh->face(draco::FaceIndex(0))[0],
+             mesh->num_faces() * sizeof(draco::Mesh::Face));
+    }
   } else {
-    if (IsDataURI(buffer->uri)) {
-      std::string mime_type;
-      if (!DecodeDataURI(&buffer->data, mime_type, buffer->uri, byteLength,
-                         true)) {
-        if (err) {
-          (*err) += "Failed to decode 'uri' : " + buffer->uri + " in Buffer\n";
-        }
-        return false;
-      }
-    } else {
-      // Assume external .bin file.
-      std::string decoded_uri;
-      if (!uri_cb->decode(buffer->uri, &decoded_uri, uri_cb->user_data)) {
-        return false;
-      }
-      if (!LoadExternalFile(&buffer->data, err, /* warn */ nullptr, decoded_uri,
-                            basedir, /* required */ true, byteLength,
-                            /* checkSize */ true,
-                            /* max file size */ max_buffer_size, fs)) {
-        return false;
+    size_t faceStride = componentSize * 3;
+    for (draco::FaceIndex f(0); f < mesh->num_faces(); ++f) {
+      const draco::Mesh::Face &face = mesh->face(f);
+      if (componentSize == 2) {
+        uint16_t indices[3] = {(uint16_t)face[0].value(),
+                               (uint16_t)face[1].value(),
+                               (uint16_t)face[2].value()};
+        memcpy(out + f.value() * faceStride, &indices[0], faceStride);
+      } else {
+        uint8_t indices[3] = {(uint8_t)face[0].value(),
+                              (uint8_t)face[1].value(),
+                              (uint8_t)face[2].value()};
+        memcpy(out + f.value() * faceStride, &indices[0], faceStride);
       }
     }
   }
+}
 
-  ParseStringProperty(&buffer->name, err, o, "name", false);
+// `type` is the Draco equivalent of T.
+template <typename T>
+static bool GetAttributeForAllPoints(const draco::Mesh *mesh,
+                                     const draco::PointAttribute *pAttribute,
+                                     draco::DataType type, unsigned char *out) {
+  const size_t num_components = size_t(pAttribute->num_components());
+  // Already in the requested type and point order: copy it whole.
+  if (pAttribute->is_mapping_identity() && pAttribute->data_type() == type &&
+      pAttribute->byte_stride() == int64_t(sizeof(T) * num_components) &&
+      pAttribute->size() >= size_t(mesh->num_points())) {
+    if (mesh->num_points() > 0) {
+      memcpy(out, pAttribute->GetAddress(draco::AttributeValueIndex(0)),
+             sizeof(T) * num_components * mesh->num_points());
+    }
+    return true;
+  }
 
-  ParseExtrasAndExtensions(buffer, err, o,
-                           store_original_json_for_extras_and_extensions);
+  size_t byteOffset = 0;
+  T values[4] = {0, 0, 0, 0};
+  for (draco::PointIndex i(0); i < mesh->num_points(); ++i) {
+    const draco::AttributeValueIndex val_index = pAttribute->mapped_index(i);
+    if (!pAttribute->ConvertValue<T>(val_index, pAttribute->num_components(),
+                                     values))
+      return false;
+
+    memcpy(out + byteOffset, &values[0], sizeof(T) * num_components);
+    byteOffset += sizeof(T) * num_components;
+  }
+
+  return true;
+}
+
+static bool GetAttributeForAllPoints(uint32_t componentType,
+                                     const draco::Mesh *mesh,
+                                     const draco::PointAttribute *pAttribute,
+                                     unsigned char *out) {
+  switch (componentType) {
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+      return GetAttributeForAllPoints<uint8_t>(mesh, pAttribute,
+                                               draco::DT_UINT8, out);
+    case TINYGLTF_COMPONENT_TYPE_BYTE:
+      return GetAttributeForAllPoints<int8_t>(mesh, pAttribute,
+                                              draco::DT_INT8, out);
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+      return GetAttributeForAllPoints<uint16_t>(mesh, pAttribute,
+                                                draco::DT_UINT16, out);
+    case TINYGLTF_COMPONENT_TYPE_SHORT:
+      return GetAttributeForAllPoints<int16_t>(mesh, pAttribute,
+                                               draco::DT_INT16, out);
+    case TINYGLTF_COMPONENT_TYPE_INT:
+      return GetAttributeForAllPoints<int32_t>(mesh, pAttribute,
+                                               draco::DT_INT32, out);
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+      return GetAttributeForAllPoints<uint32_t>(mesh, pAttribute,
+                                                draco::DT_UINT32, out);
+    case TINYGLTF_COMPONENT_TYPE_FLOAT:
+      return GetAttributeForAllPoints<float>(mesh, pAttribute,
+                                             draco::DT_FLOAT32, out);
+    case TINYGLTF_COMPONENT_TYPE_DOUBLE:
+      return GetAttributeForAllPoints<double>(mesh, pAttribute,
+                                              draco::DT_FLOAT64, out);
+    default:
+      return false;
+  }
+}
+
+// One compressed bufferView, and the accessors it fills.
+struct DracoTask {
+  size_t mesh_idx;
+  size_t primitive_idx;
+  int buffer_view;
+  int indices;                                // Accessor, or -1
+  std::vector<std::pair<int, int> > attributes;  // (accessor, Draco id)
+
+  std::unique_ptr<draco::Mesh> mesh;
+  std::vector<const draco::PointAttribute *> draco_attributes;
+  bool ok = false;
+};
 
-  return true;
-}
+// A region of the decoded buffer: the indices(attribute < 0) or one
+// attribute of a task.
+struct DracoRegion {
+  size_t task;
+  int attribute;
+  size_t offset;
+  size_t size;
+  bool ok = true;
+};
 
-static bool ParseBufferView(
-    BufferView *bufferView, std::string *err, const detail::json &o,
-    bool store_original_json_for_extras_and_extensions) {
-  int buffer = -1;
-  if (!ParseIntegerProperty(&buffer, err, o, "buffer", true, "BufferView")) {
-    return false;
+// Collects the KHR_draco_mesh_compression primitives whose bufferView,
+// attributes and accessors are valid. Like before, a bufferView shared by
+// several primitives is decoded for the first one only.
+static void CollectDracoTasks(Model *model, std::vector<DracoTask> *tasks) {
+  for (size_t m = 0; m < model->meshes.size(); m++) {
+    const Mesh &mesh = model->meshes[m];
+    for (size_t p = 0; p < mesh.primitives.size(); p++) {
+      const Primitive &primitive = mesh.primitives[p];
+      auto ext = primitive.extensions.find("KHR_draco_mesh_compression");
+      if (ext == primitive.extensions.end()) continue;
+
+      const Value &bufferViewValue = ext->second.Get("bufferView");
+      const Value &attributesValue = ext->second.Get("attributes");
+      if (!bufferViewValue.IsInt() || !attributesValue.IsObject()) continue;
+      const int view = bufferViewValue.Get<int>();
+      if (view < 0 || size_t(view) >= model->bufferViews.size()) continue;
+      BufferView &bufferView = model->bufferViews[size_t(view)];
+      if (bufferView.dracoDecoded) continue;
+      if (bufferView.buffer < 0 ||
+          size_t(bufferView.buffer) >= model->buffers.size() ||
+          bufferView.byteOffset + bufferView.byteLength >
+              model->buffers[size_t(bufferView.buffer)].Size()) {
+        continue;
+      }
+      if (primitive.indices >= int(model->accessors.size())) continue;
+
+      DracoTask task;
+      task.mesh_idx = m;
+      task.primitive_idx = p;
+      task.buffer_view = view;
+      task.indices = primitive.indices;
+      bool valid = true;
+      for (const auto &attribute : attributesValue.Get<Value::Object>()) {
+        auto accessor = primitive.attributes.find(attribute.first);
+        if (!attribute.second.IsInt() ||
+            accessor == primitive.attributes.end() || accessor->second < 0 ||
+            size_t(accessor->second) >= model->accessors.size()) {
+          valid = false;
+          break;
+        }
+        task.attributes.emplace_back(accessor->second,
+                                     attribute.second.Get<int>());
+      }
+      if (!valid) continue;
+
+      bufferView.dracoDecoded = true;
+      tasks->emplace_back(std::move(task));
+    }
   }
+}
 
-  size_t byteOffset = 0;
-  ParseUnsignedProperty(&byteOffset, err, o, "byteOffset", false);
+// Decodes the Draco mesh of `task`. Touches nothing but `task`.
+static void DecodeDracoTask(const Model &model, DracoTask *task) {
+  const BufferView &view = model.bufferViews[size_t(task->buffer_view)];
+  const Buffer &buffer = model.buffers[size_t(view.buffer)];
 
-  size_t byteLength = 1;
-  if (!ParseUnsignedProperty(&byteLength, err, o, "byteLength", true,
-                             "BufferView")) {
-    return false;
-  }
+  draco::DecoderBuffer decoderBuffer;
+  decoderBuffer.Init(reinterpret_cast<const char *>(buffer.Data() +
+                                                    view.byteOffset),
+                     view.byteLength);
+  draco::Decoder decoder;
+  auto decodeResult = decoder.DecodeMeshFromBuffer(&decoderBuffer);
+  if (!decodeResult.ok()) return;
+  task->mesh = std::move(decodeResult).value();
 
-  size_t byteStride = 0;
-  if (!ParseUnsignedProperty(&byteStride, err, o, "byteStride", false)) {
-    // Spec says: When byteStride of referenced bufferView is not defined, it
-    // means that accessor elements are tightly packed, i.e., effective stride
-    // equals the size of the element.
-    // We cannot determine the actual byteStride until Accessor are parsed, thus
-    // set 0(= tightly packed) here(as done in OpenGL's VertexAttribPoiner)
-    byteStride = 0;
+  for (const auto &attribute : task->attributes) {
+    const draco::PointAttribute *pAttribute =
+        task->mesh->GetAttributeByUniqueId(uint32_t(attribute.second));
+    if (!pAttribute || pAttribute->num_components() < 1 ||
+        pAttribute->num_components() > 4 ||
+        GetComponentSizeInBytes(uint32_t(
+            model.accessors[size_t(attribute.first)].componentType)) < 0) {
+      task->mesh.reset();
+      return;
+    }
+    task->draco_attributes.push_back(pAttribute);
   }
+  task->ok = true;
+}
 
-  if ((byteStride > 252) || ((byteStride % 4) != 0)) {
-    if (err) {
-      std::stringstream ss;
-      ss << "Invalid `byteStride' value. `byteStride' must be the multiple of "
-            "4 : "
-         << byteStride << std::endl;
+///
+/// Decodes every KHR_draco_mesh_compression primitive on up to
+/// `num_threads` threads and points its accessors at the result.
+///
+/// Meshes are decoded in parallel first. Then all their indices and
+/// attributes get regions of one new Buffer, each with its own BufferView,
+/// and the regions are filled in parallel. Primitives that fail to decode
+/// keep their accessors and add to `warn`.
+///
+static void DecodeDracoPrimitives(Model *model, std::string *warn,
+                                  ParseStrictness strictness,
+                                  int num_threads) {
+  std::vector<DracoTask> tasks;
+  CollectDracoTasks(model, &tasks);
+  if (tasks.empty()) return;
+
+  ParallelFor(tasks.size(), num_threads,
+              [&](size_t i) { DecodeDracoTask(*model, &tasks[i]); });
+
+  // Lay out the decoded data. 8-byte aligned regions suit every component
+  // type, doubles included.
+  std::vector<DracoRegion> regions;
+  size_t size = 0;
+  auto add_region = [&](size_t task, int attribute, size_t bytes) {
+    DracoRegion region;
+    region.task = task;
+    region.attribute = attribute;
+    region.offset = size;
+    region.size = bytes;
+    regions.push_back(region);
+    size = (size + bytes + 7) & ~size_t(7);
+  };
+  for (size_t t = 0; t < tasks.size(); t++) {
+    DracoTask &task = tasks[t];
+    if (!task.ok) {
+      if (warn) {
+        (*warn) += "Failed to decode KHR_draco_mesh_compression of mesh[" +
+                   std::to_string(task.mesh_idx) + "].primitives[" +
+                   std::to_string(task.primitive_idx) + "].\n";
+      }
+      continue;
+    }
+
+    if (task.indices >= 0) {
+      Accessor &accessor = model->accessors[size_t(task.indices)];
+      if (strictness == ParseStrictness::Permissive) {
+        const draco::PointIndex::ValueType numPoint =
+            task.mesh->num_points();
+        // handle the situation where the stored component type does not
+        // match the required type for the actual number of stored points
+        int supposedComponentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+        if (numPoint < static_cast<draco::PointIndex::ValueType>(
+                           std::numeric_limits<uint8_t>::max())) {
+          supposedComponentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+        } else if (numPoint < static_cast<draco::PointIndex::ValueType>(
+                                  std::numeric_limits<uint16_t>::max())) {
+          supposedComponentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+        } else {
+          supposedComponentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
+        }
 
-      (*err) += ss.str();
+        if (supposedComponentType > accessor.componentType) {
+          if (warn) {
+            (*warn) +=
+                "GLTF component type " +
+                std::to_string(accessor.componentType) +
+                " is not sufficient for number of stored points,"
+                " treating as " +
+                std::to_string(supposedComponentType) + "\n";
+          }
+          accessor.componentType = supposedComponentType;
+        }
+      }
+      const int32_t componentSize =
+          GetComponentSizeInBytes(uint32_t(accessor.componentType));
+      if (componentSize != 1 && componentSize != 2 && componentSize != 4) {
+        task.ok = false;
+        continue;
+      }
+      add_region(t, -1, task.mesh->num_faces() * 3 * size_t(componentSize));
+    }
+    for (size_t a = 0; a < task.attributes.size(); a++) {
+      const Accessor &accessor =
+          model->accessors[size_t(task.attributes[a].first)];
+      add_region(t, int(a),
+                 task.mesh->num_points() *
+                     size_t(task.draco_attributes[a]->num_components()) *
+                     size_t(GetComponentSizeInBytes(
+                         uint32_t(accessor.componentType))));
+    }
+  }
+  if (regions.empty()) return;
+
+  const int buffer_idx = int(model->buffers.size());
+  model->buffers.emplace_back();
+  Buffer &decoded = model->buffers.back();
+  decoded.data.resize(size);
+
+  ParallelFor(regions.size(), num_threads, [&](size_t r) {
+    DracoRegion &region = regions[r];
+    const DracoTask &task = tasks[region.task];
+    unsigned char *out = decoded.data.data() + region.offset;
+    if (region.attribute < 0) {
+      DecodeIndexBuffer(task.mesh.get(),
+                        size_t(GetComponentSizeInBytes(uint32_t(
+                            model->accessors[size_t(task.indices)]
+                                .componentType))),
+                        out);
+    } else {
+      const size_t a = size_t(region.attribute);
+      region.ok = GetAttributeForAllPoints(
+          uint32_t(model->accessors[size_t(task.attributes[a].first)]
+                       .componentType),
+          task.mesh.get(), task.draco_attributes[a], out);
+    }
+  });
+
+  for (const DracoRegion &region : regions) {
+    const DracoTask &task = tasks[region.task];
+    const int accessor_idx = region.attribute < 0
+                                 ? task.indices
+                                 : task.attributes[size_t(region.attribute)]
+                                       .first;
+    Accessor &accessor = model->accessors[size_t(accessor_idx)];
+    if (!region.ok) {
+      if (warn) {
+        (*warn) += "Failed to convert KHR_draco_mesh_compression data of "
+                   "accessor[" +
+                   std::to_string(accessor_idx) + "].\n";
+      }
+      continue;
     }
-    return false;
-  }
 
-  int target = 0;
-  ParseIntegerProperty(&target, err, o, "target", false);
-  if ((target == TINYGLTF_TARGET_ARRAY_BUFFER) ||
-      (target == TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER)) {
-    // OK
-  } else {
-    target = 0;
+    BufferView view;
+    view.buffer = buffer_idx;
+    view.byteOffset = region.offset;
+    view.byteLength = region.size;
+    view.target = region.attribute < 0 ? TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER
+                                       : TINYGLTF_TARGET_ARRAY_BUFFER;
+    model->bufferViews.emplace_back(std::move(view));
+
+    accessor.bufferView = int(model->bufferViews.size() - 1);
+    accessor.byteOffset = 0;
+    accessor.count = region.attribute < 0
+                         ? size_t(task.mesh->num_faces()) * 3
+                         : size_t(task.mesh->num_points());
   }
-  bufferView->target = target;
+}
 
-  ParseStringProperty(&bufferView->name, err, o, "name", false);
+}  // namespace detail
 
-  ParseExtrasAndExtensions(bufferView, err, o,
-                           store_original_json_for_extras_and_extensions);
+#endif
 
-  bufferView->buffer = buffer;
-  bufferView->byteOffset = byteOffset;
-  bufferView->byteLength = byteLength;
-  bufferView->byteStride = byteStride;
-  return true;
-}
+static bool ParsePrimitive(Primitive *primitive, std::string *err,
+                           const detail::json &o,
+                           bool store_original_json_for_extras_and_extensions) {
+  int material = -1;
+  ParseIntegerProperty(&material, err, o, "material", false);
+  primitive->material = material;
 
-static bool ParseSparseAccessor(
-    Accessor::Sparse *sparse, std::string *err, const detail::json &o,
-    bool store_original_json_for_extras_and_extensions) {
-  sparse->isSparse = true;
+  int mode = TINYGLTF_MODE_TRIANGLES;
+  ParseIntegerProperty(&mode, err, o, "mode", false);
+  primitive->mode = mode;  // Why only triangles were supported ?
 
-  int count = 0;
-  if (!ParseIntegerProperty(&count, err, o, "count", true, "SparseAccessor")) {
+  int indices = -1;
+  ParseIntegerProperty(&indices, err, o, "indices", false);
+  primitive->indices = indices;
+  if (!ParseStringIntegerProperty(&primitive->attributes, err, o, "attributes",
+                                  true, "Primitive")) {
     return false;
   }
 
-  ParseExtrasAndExtensions(sparse, err, o,
-                           store_original_json_for_extras_and_extensions);
+  // Look for morph targets
+  detail::json_const_iterator targetsObject;
+  if (detail::FindMember(o, "targets", targetsObject) &&
+      detail::IsArray(detail::GetValue(targetsObject))) {
+    auto targetsObjectEnd = detail::ArrayEnd(detail::GetValue(targetsObject));
+    for (detail::json_const_array_iterator i =
+             detail::ArrayBegin(detail::GetValue(targetsObject));
+         i != targetsObjectEnd; ++i) {
+      std::map<std::string, int> targetAttribues;
 
-  detail::json_const_iterator indices_iterator;
-  detail::json_const_iterator values_iterator;
-  if (!detail::FindMember(o, "indices", indices_iterator)) {
-    (*err) = "the sparse object of this accessor doesn't have indices";
-    return false;
-  }
+      const detail::json &dict = *i;
+      if (detail::IsObject(dict)) {
+        detail::json_const_iterator dictIt(detail::ObjectBegin(dict));
+        detail::json_const_iterator dictItEnd(detail::ObjectEnd(dict));
 
-  if (!detail::FindMember(o, "values", values_iterator)) {
-    (*err) = "the sparse object of this accessor doesn't have values";
-    return false;
+        for (; dictIt != dictItEnd; ++dictIt) {
+          int iVal;
+          if (detail::GetInt(detail::GetValue(dictIt), iVal))
+            targetAttribues[detail::GetKey(dictIt)] = iVal;
+        }
+        primitive->targets.emplace_back(std::move(targetAttribues));
+      }
+    }
   }
 
-  const detail::json &indices_obj = detail::GetValue(indices_iterator);
-  const detail::json &values_obj = detail::GetValue(values_iterator);
+  // KHR_draco_mesh_compression is decoded once all meshes are parsed, see
+  // DecodeDracoPrimitives().
+  ParseExtrasAndExtensions(primitive, err, o,
+                           store_original_json_for_extras_and_extensions);
 
-  int indices_buffer_view = 0, component_type = 0;
-  size_t indices_byte_offset = 0;
-  if (!ParseIntegerProperty(&indices_buffer_view, err, indices_obj,
-                            "bufferView", true, "SparseAccessor")) {
-    return false;
-  }
-  ParseUnsignedProperty(&indices_byte_offset, err, indices_obj, "byteOffset",
-                       false);
-  if (!ParseIntegerProperty(&component_type, err, indices_obj, "componentType",
-                            true, "SparseAccessor")) {
-    return false;
-  }
+  return true;
+}
 
-  int values_buffer_view = 0;
-  size_t values_byte_offset = 0;
-  if (!ParseIntegerProperty(&values_buffer_view, err, values_obj, "bufferView",
-                            true, "SparseAccessor")) {
-    return false;
+static bool ParseMesh(Mesh *mesh, std::string *err, const detail::json &o,
+                      bool store_original_json_for_extras_and_extensions) {
+  ParseStringProperty(&mesh->name, err, o, "name", false);
+
+  mesh->primitives.clear();
+  detail::json_const_iterator primObject;
+  if (detail::FindMember(o, "primitives", primObject) &&
+      detail::IsArray(detail::GetValue(primObject))) {
+    detail::json_const_array_iterator primEnd =
+        detail::ArrayEnd(detail::GetValue(primObject));
+    for (detail::json_const_array_iterator i =
+             detail::ArrayBegin(detail::GetValue(primObject));
+         i != primEnd; ++i) {
+      Primitive primitive;
+      if (ParsePrimitive(&primitive, err, *i,
+                         store_original_json_for_extras_and_extensions)) {
+        // Only add the primitive if the parsing succeeds.
+        mesh->primitives.emplace_back(std::move(primitive));
+      }
+    }
   }
-  ParseUnsignedProperty(&values_byte_offset, err, values_obj, "byteOffset",
-                       false);
 
-  sparse->count = count;
-  sparse->indices.bufferView = indices_buffer_view;
-  sparse->indices.byteOffset = indices_byte_offset;
-  sparse->indices.componentType = component_type;
-  ParseExtrasAndExtensions(&sparse->indices, err, indices_obj,
-                           store_original_json_for_extras_and_extensions);
+  // Should probably check if has targets and if dimensions fit
+  ParseNumberArrayProperty(&mesh->weights, err, o, "weights", false);
 
-  sparse->values.bufferView = values_buffer_view;
-  sparse->values.byteOffset = values_byte_offset;
-  ParseExtrasAndExtensions(&sparse->values, err, values_obj,
+  ParseExtrasAndExtensions(mesh, err, o,
                            store_original_json_for_extras_and_extensions);
 
   return true;
 }
 
-static bool ParseAccessor(Accessor *accessor, std::string *err,
-                          const detail::json &o,
-                          bool store_original_json_for_extras_and_extensions) {
-  int bufferView = -1;
-  ParseIntegerProperty(&bufferView, err, o, "bufferView", false, "Accessor");
-
-  size_t byteOffset = 0;
-  ParseUnsignedProperty(&byteOffset, err, o, "byteOffset", false, "Accessor");
+static bool ParseNode(Node *node, std::string *err, const detail::json &o,
+                      bool store_original_json_for_extras_and_extensions) {
+  ParseStringProperty(&node->name, err, o, "name", false);
 
-  bool normalized = false;
-  ParseBooleanProperty(&normalized, err, o, "normalized", false, "Accessor");
+  int skin = -1;
+  ParseIntegerProperty(&skin, err, o, "skin", false);
+  node->skin = skin;
 
-  size_t componentType = 0;
-  if (!ParseUnsignedProperty(&componentType, err, o, "componentType", true,
-                             "Accessor")) {
-    return false;
+  // Matrix and T/R/S are exclusive
+  if (!ParseNumberArrayProperty(&node->matrix, err, o, "matrix", false)) {
+    ParseNumberArrayProperty(&node->rotation, err, o, "rotation", false);
+    ParseNumberArrayProperty(&node->scale, err, o, "scale", false);
+    ParseNumberArrayProperty(&node->translation, err, o, "translation", false);
   }
 
-  size_t count = 0;
-  if (!ParseUnsignedProperty(&count, err, o, "count", true, "Accessor")) {
-    return false;
-  }
+  int camera = -1;
+  ParseIntegerProperty(&camera, err, o, "camera", false);
+  node->camera = camera;
 
-  std::string type;
-  if (!ParseStringProperty(&type, err, o, "type", true, "Accessor")) {
-    return false;
-  }
+  int mesh = -1;
+  ParseIntegerProperty(&mesh, err, o, "mesh", false);
+  node->mesh = mesh;
 
-  if (type.compare("SCALAR") == 0) {
-    accessor->type = TINYGLTF_TYPE_SCALAR;
-  } else if (type.compare("VEC2") == 0) {
-    accessor->type = TINYGLTF_TYPE_VEC2;
-  } else if (type.compare("VEC3") == 0) {
-    accessor->type = TINYGLTF_TYPE_VEC3;
-  } else if (type.compare("VEC4") == 0) {
-    accessor->type = TINYGLTF_TYPE_VEC4;
-  } else if (type.compare("MAT2") == 0) {
-    accessor->type = TINYGLTF_TYPE_MAT2;
-  } else if (type.compare("MAT3") == 0) {
-    accessor->type = TINYGLTF_TYPE_MAT3;
-  } else if (type.compare("MAT4") == 0) {
-    accessor->type = TINYGLTF_TYPE_MAT4;
-  } else {
-    std::stringstream ss;
-    ss << "Unsupported `type` for accessor object. Got \"" << type << "\"\n";
-    if (err) {
-      (*err) += ss.str();
+  node->children.clear();
+  ParseIntegerArrayProperty(&node->children, err, o, "children", false);
+
+  ParseNumberArrayProperty(&node->weights, err, o, "weights", false);
+
+  ParseExtrasAndExtensions(node, err, o,
+                           store_original_json_for_extras_and_extensions);
+
+  // KHR_lights_punctual: parse light source reference
+  int light = -1;
+  if (node->extensions.count("KHR_lights_punctual") != 0) {
+    auto const &light_ext = node->extensions["KHR_lights_punctual"];
+    if (light_ext.Has("light")) {
+      light = light_ext.Get("light").GetNumberAsInt();
+    } else {
+      if (err) {
+        *err +=
+            "Node has extension KHR_lights_punctual, but does not reference "
+            "a light source.\n";
+      }
+      return false;
     }
-    return false;
   }
+  node->light = light;
 
-  ParseStringProperty(&accessor->name, err, o, "name", false);
-
-  accessor->minValues.clear();
-  accessor->maxValues.clear();
-  ParseNumberArrayProperty(&accessor->minValues, err, o, "min", false,
-                           "Accessor");
-
-  ParseNumberArrayProperty(&accessor->maxValues, err, o, "max", false,
-                           "Accessor");
-
-  accessor->count = count;
-  accessor->bufferView = bufferView;
-  accessor->byteOffset = byteOffset;
-  accessor->normalized = normalized;
-  {
-    if (componentType >= TINYGLTF_COMPONENT_TYPE_BYTE &&
-        componentType <= TINYGLTF_COMPONENT_TYPE_DOUBLE) {
-      // OK
-      accessor->componentType = int(componentType);
+  // KHR_audio: parse audio source reference
+  int emitter = -1;
+  if (node->extensions.count("KHR_audio") != 0) {
+    auto const &audio_ext = node->extensions["KHR_audio"];
+    if (audio_ext.Has("emitter")) {
+      emitter = audio_ext.Get("emitter").GetNumberAsInt();
     } else {
-      std::stringstream ss;
-      ss << "Invalid `componentType` in accessor. Got " << componentType
-         << "\n";
       if (err) {
-        (*err) += ss.str();
+        *err +=
+            "Node has extension KHR_audio, but does not reference "
+            "a audio emitter.\n";
       }
       return false;
     }
   }
+  node->emitter = emitter;
 
-  ParseExtrasAndExtensions(accessor, err, o,
+  return true;
+}
+
+static bool ParseScene(Scene *scene, std::string *err, const detail::json &o,
+                       bool store_original_json_for_extras_and_extensions) {
+  ParseStringProperty(&scene->name, err, o, "name", false);
+  ParseIntegerArrayProperty(&scene->nodes, err, o, "nodes", false);
+
+  ParseExtrasAndExtensions(scene, err, o,
                            store_original_json_for_extras_and_extensions);
 
-  // check if accessor has a "sparse" object:
-  detail::json_const_iterator iterator;
-  if (detail::FindMember(o, "sparse", iterator)) {
-    // here this accessor has a "sparse" subobject
-    return ParseSparseAccessor(&accessor->sparse, err,
-                               detail::GetValue(iterator),
-                               store_original_json_for_extras_and_extensions);
+  // Parse KHR_audio global emitters
+  if (scene->extensions.count("KHR_audio") != 0) {
+    auto const &audio_ext = scene->extensions["KHR_audio"];
+    if (audio_ext.Has("emitters")) {
+      auto emittersArr = audio_ext.Get("emitters");
+      for (size_t i = 0; i < emittersArr.ArrayLen(); ++i) {
+        scene->audioEmitters.emplace_back(emittersArr.Get(i).GetNumberAsInt());
+      }
+    } else {
+      if (err) {
+        *err +=
+            "Node has extension KHR_audio, but does not reference "
+            "a audio emitter.\n";
+      }
+      return false;
+    }
   }
 
   return true;
 }
 
-#ifdef TINYGLTF_ENABLE_DRACO
+static bool ParsePbrMetallicRoughness(
+    PbrMetallicRoughness *pbr, std::string *err, const detail::json &o,
+    bool store_original_json_for_extras_and_extensions) {
+  if (pbr == nullptr) {
+    return false;
+  }
 
-static void DecodeIndexBuffer(draco::Mesh *mesh, size_t componentSize,
-                              std::vector<uint8_t> &outBuffer) {
-  if (componentSize == 4) {
-    assert(sizeof(mesh->face(draco::FaceIndex(0))[0]) == componentSize);
-    memcpy(outBuffer.data(), &mesh->face(draco::FaceIndex(0))[0],
-           outBuffer.size());
-  } else {
-    size_t faceStride = componentSize * 3;
-    for (draco::FaceIndex f(0); f < mesh->num_faces(); ++f) {
-      const draco::Mesh::Face &face = mesh->face(f);
-      if (componentSize == 2) {
-        uint16_t indices[3] = {(uint16_t)face[0].value(),
-                               (uint16_t)face[1].value(),
-                               (uint16_t)face[2].value()};
-        memcpy(outBuffer.data() + f.value() * faceStride, &indices[0],
-               faceStride);
-      } else {
-        uint8_t indices[3] = {(uint8_t)face[0].value(),
-                              (uint8_t)face[1].value(),
-                              (uint8_t)face[2].value()};
-        memcpy(outBuffer.data() + f.value() * faceStride, &indices[0],
-               faceStride);
+  std::vector<double> baseColorFactor;
+  if (ParseNumberArrayProperty(&baseColorFactor, err, o, "baseColorFactor",
+                               /* required */ false)) {
+    if (baseColorFactor.size() != 4) {
+      if (err) {
+        (*err) +=
+            "Array length of `baseColorFactor` parameter in "
+            "pbrMetallicRoughness must be 4, but got " +
+            std::to_string(baseColorFactor.size()) + "\n";
       }
+      return false;
     }
+    pbr->baseColorFactor = baseColorFactor;
   }
-}
 
-template <typename T>
-static bool GetAttributeForAllPoints(draco::Mesh *mesh,
-                                     const draco::PointAttribute *pAttribute,
-                                     std::vector<uint8_t> &outBuffer) {
-  size_t byteOffset = 0;
-  T values[4] = {0, 0, 0, 0};
-  for (draco::PointIndex i(0); i < mesh->num_points(); ++i) {
-    const draco::AttributeValueIndex val_index = pAttribute->mapped_index(i);
-    if (!pAttribute->ConvertValue<T>(val_index, pAttribute->num_components(),
-                                     values))
-      return false;
+  {
+    detail::json_const_iterator it;
+    if (detail::FindMember(o, "baseColorTexture", it)) {
+      ParseTextureInfo(&pbr->baseColorTexture, err, detail::GetValue(it),
+                       store_original_json_for_extras_and_extensions);
+    }
+  }
 
-    memcpy(outBuffer.data() + byteOffset, &values[0],
-           sizeof(T) * pAttribute->num_components());
-    byteOffset += sizeof(T) * pAttribute->num_components();
+  {
+    detail::json_const_iterator it;
+    if (detail::FindMember(o, "metallicRoughnessTexture", it)) {
+      ParseTextureInfo(&pbr->metallicRoughnessTexture, err,
+                       detail::GetValue(it),
+                       store_original_json_for_extras_and_extensions);
+    }
   }
 
+  ParseNumberProperty(&pbr->metallicFactor, err, o, "metallicFactor", false);
+  ParseNumberProperty(&pbr->roughnessFactor, err, o, "roughnessFactor", false);
+
+  ParseExtrasAndExtensions(pbr, err, o,
+                           store_original_json_for_extras_and_extensions);
+
   return true;
 }
 
-static bool GetAttributeForAllPoints(uint32_t componentType, draco::Mesh *mesh,
-                                     const draco::PointAttribute *pAttribute,
-                                     std::vector<uint8_t> &outBuffer) {
-  bool decodeResult = false;
-  switch (componentType) {
-    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-      decodeResult =
-          GetAttributeForAllPoints<uint8_t>(mesh, pAttribute, outBuffer);
-      break;
-    case TINYGLTF_COMPONENT_TYPE_BYTE:
-      decodeResult =
-          GetAttributeForAllPoints<int8_t>(mesh, pAttribute, outBuffer);
-      break;
-    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-      decodeResult =
-          GetAttributeForAllPoints<uint16_t>(mesh, pAttribute, outBuffer);
-      break;
-    case TINYGLTF_COMPONENT_TYPE_SHORT:
-      decodeResult =
-          GetAttributeForAllPoints<int16_t>(mesh, pAttribute, outBuffer);
-      break;
-    case TINYGLTF_COMPONENT_TYPE_INT:
-      decodeResult =
-          GetAttributeForAllPoints<int32_t>(mesh, pAttribute, outBuffer);
-      break;
-    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
-      decodeResult =
-          GetAttributeForAllPoints<uint32_t>(mesh, pAttribute, outBuffer);
-      break;
-    case TINYGLTF_COMPONENT_TYPE_FLOAT:
-      decodeResult =
-          GetAttributeForAllPoints<float>(mesh, pAttribute, outBuffer);
-      break;
-    case TINYGLTF_COMPONENT_TYPE_DOUBLE:
-      decodeResult =
-          GetAttributeForAllPoints<double>(mesh, pAttribute, outBuffer);
-      break;
-    default:
+static bool ParseMaterial(Material *material, std::string *err, std::string *warn,
+                          const detail::json &o,
+                          bool store_original_json_for_extras_and_extensions,
+                          ParseStrictness strictness) {
+  ParseStringProperty(&material->name, err, o, "name", /* required */ false);
+
+  if (ParseNumberArrayProperty(&material->emissiveFactor, err, o,
+                               "emissiveFactor",
+                               /* required */ false)) {
+    if (strictness==ParseStrictness::Permissive && material->emissiveFactor.size() == 4) {
+      if (warn) {
+        (*warn) +=
+            "Array length of `emissiveFactor` parameter in "
+            "material must be 3, but got 4\n";
+      }
+      material->emissiveFactor.resize(3);
+    }
+    else if (material->emissiveFactor.size() != 3) {
+      if (err) {
+        (*err) +=
+            "Array length of `emissiveFactor` parameter in "
+            "material must be 3, but got " +
+            std::to_string(material->emissiveFactor.size()) + "\n";
+      }
       return false;
+    }
+  } else {
+    // fill with default values
+    material->emissiveFactor = {0.0, 0.0, 0.0};
   }
 
-  return decodeResult;
-}
+  ParseStringProperty(&material->alphaMode, err, o, "alphaMode",
+                      /* required */ false);
+  ParseNumberProperty(&material->alphaCutoff, err, o, "alphaCutoff",
+                      /* required */ false);
+  ParseBooleanProperty(&material->doubleSided, err, o, "doubleSided",
+                       /* required */ false);
 
-static bool ParseDracoExtension(Primitive *primitive, Model *model,
-                                std::string *err, std::string *warn,
-                                const Value &dracoExtensionValue,
-                                ParseStrictness strictness) {
-  (void)err;
-  auto bufferViewValue = dracoExtensionValue.Get("bufferView");
-  if (!bufferViewValue.IsInt()) return false;
-  auto attributesValue = dracoExtensionValue.Get("attributes");
-  if (!attributesValue.IsObject()) return false;
+  {
+    detail::json_const_iterator it;
+    if (detail::FindMember(o, "pbrMetallicRoughness", it)) {
+      ParsePbrMetallicRoughness(&material->pbrMetallicRoughness, err,
+                                detail::GetValue(it),
+                                store_original_json_for_extras_and_extensions);
+    }
+  }
 
-  auto attributesObject = attributesValue.Get<Value::Object>();
-  int bufferView = bufferViewValue.Get<int>();
+  {
+    detail::json_const_iterator it;
+    if (detail::FindMember(o, "normalTexture", it)) {
+      ParseNormalTextureInfo(&material->normalTexture, err,
+                             detail::GetValue(it),
+                             store_original_json_for_extras_and_extensions);
+    }
+  }
 
-  BufferView &view = model->bufferViews[bufferView];
-  Buffer &buffer = model->buffers[view.buffer];
-  // BufferView has already been decoded
-  if (view.dracoDecoded) return true;
-  view.dracoDecoded = true;
+  {
+    detail::json_const_iterator it;
+    if (detail::FindMember(o, "occlusionTexture", it)) {
+      ParseOcclusionTextureInfo(&material->occlusionTexture, err,
+                                detail::GetValue(it),
+                                store_original_json_for_extras_and_extensions);
+    }
+  }
 
-  const char *bufferViewData =
-      reinterpret_cast<const char *>(buffer.data.data() + view.byteOffset);
-  size_t bufferViewSize = view.byteLength;
+  {
+    detail::json_const_iterator it;
+    if (detail::FindMember(o, "emissiveTexture", it)) {
+      ParseTextureInfo(&material->emissiveTexture, err, detail::GetValue(it),
+                       store_original_json_for_extras_and_extensions);
+    }
+  }
 
-  // decode draco
-  draco::DecoderBuffer decoderBuffer;
-  decoderBuffer.Init(bufferViewData, bufferViewSize);
-  draco::Decoder decoder;
-  auto decodeResult = decoder.DecodeMeshFromBuffer(&decoderBuffer);
-  if (!decodeResult.ok()) {
-    return false;
-  }
-  const std::unique_ptr<draco::Mesh> &mesh = decodeResult.value();
-
-  // create new bufferView for indices
-  if (primitive->indices >= 0) {
-    if (strictness == ParseStrictness::Permissive) {
-      const draco::PointIndex::ValueType numPoint = mesh->num_points();
-      // handle the situation where the stored component type does not match the
-      // required type for the actual number of stored points
-      int supposedComponentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
-      if (numPoint < static_cast<draco::PointIndex::ValueType>(
-                         std::numeric_limits<uint8_t>::max())) {
-        supposedComponentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
-      } else if (
-          numPoint < static_cast<draco::PointIndex::ValueType>(
-                         std::numeric_limits<uint16_t>::max())) {
-        supposedComponentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
-      } else {
-        supposedComponentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
-      }
+  // Old code path. For backward compatibility, we still store material values
+  // as Parameter. This will create duplicated information for
+  // example(pbrMetallicRoughness), but should be negligible in terms of memory
+  // consumption.
+  // TODO(syoyo): Remove in the next major release.
+  material->values.clear();
+  material->additionalValues.clear();
 
-      if (supposedComponentType > model->accessors[primitive->indices].componentType) {
-        if (warn) {
-          (*warn) +=
-              "GLTF component type " + std::to_string(model->accessors[primitive->indices].componentType) +
-              " is not sufficient for number of stored points,"
-              " treating as " + std::to_string(supposedComponentType) + "\n";
+  detail::json_const_iterator it(detail::ObjectBegin(o));
+  detail::json_const_iterator itEnd(detail::ObjectEnd(o));
+
+  for (; it != itEnd; ++it) {
+    std::string key(detail::GetKey(it));
+    if (key == "pbrMetallicRoughness") {
+      if (detail::IsObject(detail::GetValue(it))) {
+        const detail::json &values_object = detail::GetValue(it);
+
+        detail::json_const_iterator itVal(detail::ObjectBegin(values_object));
+        detail::json_const_iterator itValEnd(detail::ObjectEnd(values_object));
+
+        for (; itVal != itValEnd; ++itVal) {
+          Parameter param;
+          if (ParseParameterProperty(&param, err, values_object,
+                                     detail::GetKey(itVal), false)) {
+            material->values.emplace(detail::GetKey(itVal), std::move(param));
+          }
         }
-        model->accessors[primitive->indices].componentType = supposedComponentType;
+      }
+    } else if (key == "extensions" || key == "extras") {
+      // done later, skip, otherwise poorly parsed contents will be saved in the
+      // parametermap and serialized again later
+    } else {
+      Parameter param;
+      if (ParseParameterProperty(&param, err, o, key, false)) {
+        // names of materials have already been parsed. Putting it in this map
+        // doesn't correctly reflect the glTF specification
+        if (key != "name")
+          material->additionalValues.emplace(std::move(key), std::move(param));
       }
     }
+  }
 
-    int32_t componentSize = GetComponentSizeInBytes(
-        model->accessors[primitive->indices].componentType);
-    Buffer decodedIndexBuffer;
-    decodedIndexBuffer.data.resize(mesh->num_faces() * 3 * componentSize);
-
-    DecodeIndexBuffer(mesh.get(), componentSize, decodedIndexBuffer.data);
-
-    model->buffers.emplace_back(std::move(decodedIndexBuffer));
+  material->extensions.clear();  // Note(agnat): Why?
+  ParseExtrasAndExtensions(material, err, o,
+                           store_original_json_for_extras_and_extensions);
 
-    BufferView decodedIndexBufferView;
-    decodedIndexBufferView.buffer = int(model->buffers.size() - 1);
-    decodedIndexBufferView.byteLength =
-        int(mesh->num_faces() * 3 * componentSize);
-    decodedIndexBufferView.byteOffset = 0;
-    decodedIndexBufferView.byteStride = 0;
-    decodedIndexBufferView.target = TINYGLTF_TARGET_ARRAY_BUFFER;
-    model->bufferViews.emplace_back(std::move(decodedIndexBufferView));
+  return true;
+}
 
-    model->accessors[primitive->indices].bufferView =
-        int(model->bufferViews.size() - 1);
-    model->accessors[primitive->indices].count = int(mesh->num_faces() * 3);
+static bool ParseAnimationChannel(
+    AnimationChannel *channel, std::string *err, const detail::json &o,
+    bool store_original_json_for_extras_and_extensions) {
+  int samplerIndex = -1;
+  int targetIndex = -1;
+  if (!ParseIntegerProperty(&samplerIndex, err, o, "sampler", true,
+                            "AnimationChannel")) {
+    if (err) {
+      (*err) += "`sampler` field is missing in animation channels\n";
+    }
+    return false;
   }
 
-  for (const auto &attribute : attributesObject) {
-    if (!attribute.second.IsInt()) return false;
-    auto primitiveAttribute = primitive->attributes.find(attribute.first);
-    if (primitiveAttribute == primitive->attributes.end()) return false;
-
-    int dracoAttributeIndex = attribute.second.Get<int>();
-    const auto pAttribute = mesh->GetAttributeByUniqueId(dracoAttributeIndex);
-    const auto componentType =
-        model->accessors[primitiveAttribute->second].componentType;
+  detail::json_const_iterator targetIt;
+  if (detail::FindMember(o, "target", targetIt) &&
+      detail::IsObject(detail::GetValue(targetIt))) {
+    const detail::json &target_object = detail::GetValue(targetIt);
 
-    // Create a new buffer for this decoded buffer
-    Buffer decodedBuffer;
-    size_t bufferSize = mesh->num_points() * pAttribute->num_components() *
-                        GetComponentSizeInBytes(componentType);
-    decodedBuffer.data.resize(bufferSize);
+    ParseIntegerProperty(&targetIndex, err, target_object, "node", false);
 
-    if (!GetAttributeForAllPoints(componentType, mesh.get(), pAttribute,
-                                  decodedBuffer.data))
+    if (!ParseStringProperty(&channel->target_path, err, target_object, "path",
+                             true)) {
+      if (err) {
+        (*err) += "`path` field is missing in animation.channels.target\n";
+      }
       return false;
+    }
+    ParseExtensionsProperty(&channel->target_extensions, err, target_object);
+    ParseExtrasProperty(&channel->target_extras, target_object);
+    if (store_original_json_for_extras_and_extensions) {
+      {
+        detail::json_const_iterator it;
+        if (detail::FindMember(target_object, "extensions", it)) {
+          channel->target_extensions_json_string =
+              detail::JsonToString(detail::GetValue(it));
+        }
+      }
+      {
+        detail::json_const_iterator it;
+        if (detail::FindMember(target_object, "extras", it)) {
+          channel->target_extras_json_string =
+              detail::JsonToString(detail::GetValue(it));
+        }
+      }
+    }
+  }
 
-    model->buffers.emplace_back(std::move(decodedBuffer));
-
-    BufferView decodedBufferView;
-    decodedBufferView.buffer = int(model->buffers.size() - 1);
-    decodedBufferView.byteLength = bufferSize;
-    decodedBufferView.byteOffset = pAttribute->byte_offset();
-    decodedBufferView.byteStride = pAttribute->byte_stride();
-    decodedBufferView.target = primitive->indices >= 0
-                                   ? TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER
-                                   : TINYGLTF_TARGET_ARRAY_BUFFER;
-    model->bufferViews.emplace_back(std::move(decodedBufferView));
+  channel->sampler = samplerIndex;
+  channel->target_node = targetIndex;
 
-    model->accessors[primitiveAttribute->second].bufferView =
-        int(model->bufferViews.size() - 1);
-    model->accessors[primitiveAttribute->second].count =
-        int(mesh->num_points());
-  }
+  ParseExtrasAndExtensions(channel, err, o,
+                           store_original_json_for_extras_and_extensions);
 
   return true;
 }
-#endif
 
-static bool ParsePrimitive(Primitive *primitive, Model *model,
-                           std::string *err, std::string *warn,
+static bool ParseAnimation(Animation *animation, std::string *err,
                            const detail::json &o,
-                           bool store_original_json_for_extras_and_extensions,
-                           ParseStrictness strictness) {
-  int material = -1;
-  ParseIntegerProperty(&material, err, o, "material", false);
-  primitive->material = material;
-
-  int mode = TINYGLTF_MODE_TRIANGLES;
-  ParseIntegerProperty(&mode, err, o, "mode", false);
-  primitive->mode = mode;  // Why only triangles were supported ?
-
-  int indices = -1;
-  ParseIntegerProperty(&indices, err, o, "indices", false);
-  primitive->indices = indices;
-  if (!ParseStringIntegerProperty(&primitive->attributes, err, o, "attributes",
-                                  true, "Primitive")) {
-    return false;
+                           bool store_original_json_for_extras_and_extensions) {
+  {
+    detail::json_const_iterator channelsIt;
+    if (detail::FindMember(o, "channels", channelsIt) &&
+        detail::IsArray(detail::GetValue(channelsIt))) {
+      detail::json_const_array_iterator channelEnd =
+          detail::ArrayEnd(detail::GetValue(channelsIt));
+      for (detail::json_const_array_iterator i =
+               detail::ArrayBegin(detail::GetValue(channelsIt));
+           i != channelEnd; ++i) {
+        AnimationChannel channel;
+        if (ParseAnimationChannel(
+                &channel, err, *i,
+                store_original_json_for_extras_and_extensions)) {
+          // Only add the channel if the parsing succeeds.
+          animation->channels.emplace_back(std::move(channel));
+        }
+      }
+    }
   }
 
-  // Look for morph targets
-  detail::json_const_iterator targetsObject;
-  if (detail::FindMember(o, "targets", targetsObject) &&
-      detail::IsArray(detail::GetValue(targetsObject))) {
-    auto targetsObjectEnd = detail::ArrayEnd(detail::GetValue(targetsObject));
-    for (detail::json_const_array_iterator i =
-             detail::ArrayBegin(detail::GetValue(targetsObject));
-         i != targetsObjectEnd; ++i) {
-      std::map<std::string, int> targetAttribues;
+  {
+    detail::json_const_iterator samplerIt;
+    if (detail::FindMember(o, "samplers", samplerIt) &&
+        detail::IsArray(detail::GetValue(samplerIt))) {
+      const detail::json &sampler_array = detail::GetValue(samplerIt);
 
-      const detail::json &dict = *i;
-      if (detail::IsObject(dict)) {
-        detail::json_const_iterator dictIt(detail::ObjectBegin(dict));
-        detail::json_const_iterator dictItEnd(detail::ObjectEnd(dict));
+      detail::json_const_array_iterator it = detail::ArrayBegin(sampler_array);
+      detail::json_const_array_iterator itEnd = detail::ArrayEnd(sampler_array);
 
-        for (; dictIt != dictItEnd; ++dictIt) {
-          int iVal;
-          if (detail::GetInt(detail::GetValue(dictIt), iVal))
-            targetAttribues[detail::GetKey(dictIt)] = iVal;
+      for (; it != itEnd; ++it) {
+        const detail::json &s = *it;
+
+        AnimationSampler sampler;
+        int inputIndex = -1;
+        int outputIndex = -1;
+        if (!ParseIntegerProperty(&inputIndex, err, s, "input", true)) {
+          if (err) {
+            (*err) += "`input` field is missing in animation.sampler\n";
+          }
+          return false;
         }
-        primitive->targets.emplace_back(std::move(targetAttribues));
+        ParseStringProperty(&sampler.interpolation, err, s, "interpolation",
+                            false);
+        if (!ParseIntegerProperty(&outputIndex, err, s, "output", true)) {
+          if (err) {
+            (*err) += "`output` field is missing in animation.sampler\n";
+          }
+          return false;
+        }
+        sampler.input = inputIndex;
+        sampler.output = outputIndex;
+        ParseExtrasAndExtensions(&sampler, err, o,
+                                 store_original_json_for_extras_and_extensions);
+
+        animation->samplers.emplace_back(std::move(sampler));
       }
     }
   }
 
-  ParseExtrasAndExtensions(primitive, err, o,
-                           store_original_json_for_extras_and_extensions);
+  ParseStringProperty(&animation->name, err, o, "name", false);
 
-#ifdef TINYGLTF_ENABLE_DRACO
-  auto dracoExtension =
-      primitive->extensions.find("KHR_draco_mesh_compression");
-  if (dracoExtension != primitive->extensions.end()) {
-    ParseDracoExtension(primitive, model, err, warn, dracoExtension->second, strictness);
-  }
-#else
-  (void)model;
-  (void)warn;
-  (void)strictness;
-#endif
+  ParseExtrasAndExtensions(animation, err, o,
+                           store_original_json_for_extras_and_extensions);
 
   return true;
 }
 
-static bool ParseMesh(Mesh *mesh, Model *model,
-                      std::string *err, std::string *warn,
-                      const detail::json &o,
-                      bool store_original_json_for_extras_and_extensions,
-                      ParseStrictness strictness) {
-  ParseStringProperty(&mesh->name, err, o, "name", false);
+static bool ParseSampler(Sampler *sampler, std::string *err,
+                         const detail::json &o,
+                         bool store_original_json_for_extras_and_extensions) {
+  ParseStringProperty(&sampler->name, err, o, "name", false);
 
-  mesh->primitives.clear();
-  detail::json_const_iterator primObject;
-  if (detail::FindMember(o, "primitives", primObject) &&
-      detail::IsArray(detail::GetValue(primObject))) {
-    detail::json_const_array_iterator primEnd =
-        detail::ArrayEnd(detail::GetValue(primObject));
-    for (detail::json_const_array_iterator i =
-             detail::ArrayBegin(detail::GetValue(primObject));
-         i != primEnd; ++i) {
-      Primitive primitive;
-      if (ParsePrimitive(&primitive, model, err, warn, *i,
-                         store_original_json_for_extras_and_extensions,
-                         strictness)) {
-        // Only add the primitive if the parsing succeeds.
-        mesh->primitives.emplace_back(std::move(primitive));
-      }
-    }
-  }
+  int minFilter = -1;
+  int magFilter = -1;
+  int wrapS = TINYGLTF_TEXTURE_WRAP_REPEAT;
+  int wrapT = TINYGLTF_TEXTURE_WRAP_REPEAT;
+  // int wrapR = TINYGLTF_TEXTURE_WRAP_REPEAT;
+  ParseIntegerProperty(&minFilter, err, o, "minFilter", false);
+  ParseIntegerProperty(&magFilter, err, o, "magFilter", false);
+  ParseIntegerProperty(&wrapS, err, o, "wrapS", false);
+  ParseIntegerProperty(&wrapT, err, o, "wrapT", false);
+  // ParseIntegerProperty(&wrapR, err, o, "wrapR", false);  // tinygltf
+  // extension
 
-  // Should probably check if has targets and if dimensions fit
-  ParseNumberArrayProperty(&mesh->weights, err, o, "weights", false);
+  // TODO(syoyo): Check the value is allowed one.
+  // (e.g. we allow 9728(NEAREST), but don't allow 9727)
 
-  ParseExtrasAndExtensions(mesh, err, o,
+  sampler->minFilter = minFilter;
+  sampler->magFilter = magFilter;
+  sampler->wrapS = wrapS;
+  sampler->wrapT = wrapT;
+  // sampler->wrapR = wrapR;
+
+  ParseExtrasAndExtensions(sampler, err, o,
                            store_original_json_for_extras_and_extensions);
 
   return true;
 }
 
-static bool ParseNode(Node *node, std::string *err, const detail::json &o,
+static bool ParseSkin(Skin *skin, std::string *err, const detail::json &o,
                       bool store_original_json_for_extras_and_extensions) {
-  ParseStringProperty(&node->name, err, o, "name", false);
-
-  int skin = -1;
-  ParseIntegerProperty(&skin, err, o, "skin", false);
-  node->skin = skin;
+  ParseStringProperty(&skin->name, err, o, "name", false, "Skin");
 
-  // Matrix and T/R/S are exclusive
-  if (!ParseNumberArrayProperty(&node->matrix, err, o, "matrix", false)) {
-    ParseNumberArrayProperty(&node->rotation, err, o, "rotation", false);
-    ParseNumberArrayProperty(&node->scale, err, o, "scale", false);
-    ParseNumberArrayProperty(&node->translation, err, o, "translation", false);
+  std::vector<int> joints;
+  if (!ParseIntegerArrayProperty(&joints, err, o, "joints", false, "Skin")) {
+    return false;
   }
+  skin->joints = std::move(joints);
 
-  int camera = -1;
-  ParseIntegerProperty(&camera, err, o, "camera", false);
-  node->camera = camera;
-
-  int mesh = -1;
-  ParseIntegerProperty(&mesh, err, o, "mesh", false);
-  node->mesh = mesh;
-
-  node->children.clear();
-  ParseIntegerArrayProperty(&node->children, err, o, "children", false);
+  int skeleton = -1;
+  ParseIntegerProperty(&skeleton, err, o, "skeleton", false, "Skin");
+  skin->skeleton = skeleton;
 
-  ParseNumberArrayProperty(&node->weights, err, o, "weights", false);
+  int invBind = -1;
+  ParseIntegerProperty(&invBind, err, o, "inverseBindMatrices", true, "Skin");
+  skin->inverseBindMatrices = invBind;
 
-  ParseExtrasAndExtensions(node, err, o,
+  ParseExtrasAndExtensions(skin, err, o,
                            store_original_json_for_extras_and_extensions);
 
-  // KHR_lights_punctual: parse light source reference
-  int light = -1;
-  if (node->extensions.count("KHR_lights_punctual") != 0) {
-    auto const &light_ext = node->extensions["KHR_lights_punctual"];
-    if (light_ext.Has("light")) {
-      light = light_ext.Get("light").GetNumberAsInt();
-    } else {
-      if (err) {
-        *err +=
-            "Node has extension KHR_lights_punctual, but does not reference "
-            "a light source.\n";
-      }
-      return false;
-    }
+  return true;
+}
+
+static bool ParsePerspectiveCamera(
+    PerspectiveCamera *camera, std::string *err, const detail::json &o,
+    bool store_original_json_for_extras_and_extensions) {
+  double yfov = 0.0;
+  if (!ParseNumberProperty(&yfov, err, o, "yfov", true, "OrthographicCamera")) {
+    return false;
   }
-  node->light = light;
 
-  // KHR_audio: parse audio source reference
-  int emitter = -1;
-  if (node->extensions.count("KHR_audio") != 0) {
-    auto const &audio_ext = node->extensions["KHR_audio"];
-    if (audio_ext.Has("emitter")) {
-      emitter = audio_ext.Get("emitter").GetNumberAsInt();
-    } else {
-      if (err) {
-        *err +=
-            "Node has extension KHR_audio, but does not reference "
-            "a audio emitter.\n";
-      }
-      return false;
-    }
+  double znear = 0.0;
+  if (!ParseNumberProperty(&znear, err, o, "znear", true,
+                           "PerspectiveCamera")) {
+    return false;
   }
-  node->emitter = emitter;
+
+  double aspectRatio = 0.0;  // = invalid
+  ParseNumberProperty(&aspectRatio, err, o, "aspectRatio", false,
+                      "PerspectiveCamera");
+
+  double zfar = 0.0;  // = invalid
+  ParseNumberProperty(&zfar, err, o, "zfar", false, "PerspectiveCamera");
+
+  camera->aspectRatio = aspectRatio;
+  camera->zfar = zfar;
+  camera->yfov = yfov;
+  camera->znear = znear;
+
+  ParseExtrasAndExtensions(camera, err, o,
+                           store_original_json_for_extras_and_extensions);
+
+  // TODO(syoyo): Validate parameter values.
 
   return true;
 }
 
-static bool ParseScene(Scene *scene, std::string *err, const detail::json &o,
-                       bool store_original_json_for_extras_and_extensions) {
-  ParseStringProperty(&scene->name, err, o, "name", false);
-  ParseIntegerArrayProperty(&scene->nodes, err, o, "nodes", false);
+static bool ParseSpotLight(SpotLight *light, std::string *err,
+                           const detail::json &o,
+                           bool store_original_json_for_extras_and_extensions) {
+  ParseNumberProperty(&light->innerConeAngle, err, o, "innerConeAngle", false);
+  ParseNumberProperty(&light->outerConeAngle, err, o, "outerConeAngle", false);
 
-  ParseExtrasAndExtensions(scene, err, o,
+  ParseExtrasAndExtensions(light, err, o,
                            store_original_json_for_extras_and_extensions);
 
-  // Parse KHR_audio global emitters
-  if (scene->extensions.count("KHR_audio") != 0) {
-    auto const &audio_ext = scene->extensions["KHR_audio"];
-    if (audio_ext.Has("emitters")) {
-      auto emittersArr = audio_ext.Get("emitters");
-      for (size_t i = 0; i < emittersArr.ArrayLen(); ++i) {
-        scene->audioEmitters.emplace_back(emittersArr.Get(i).GetNumberAsInt());
-      }
-    } else {
-      if (err) {
-        *err +=
-            "Node has extension KHR_audio, but does not reference "
-            "a audio emitter.\n";
-      }
-      return false;
-    }
-  }
+  // TODO(syoyo): Validate parameter values.
 
   return true;
 }
 
-static bool ParsePbrMetallicRoughness(
-    PbrMetallicRoughness *pbr, std::string *err, const detail::json &o,
+static bool ParseOrthographicCamera(
+    OrthographicCamera *camera, std::string *err, const detail::json &o,
     bool store_original_json_for_extras_and_extensions) {
-  if (pbr == nullptr) {
+  double xmag = 0.0;
+  if (!ParseNumberProperty(&xmag, err, o, "xmag", true, "OrthographicCamera")) {
     return false;
   }
 
-  std::vector<double> baseColorFactor;
-  if (ParseNumberArrayProperty(&baseColorFactor, err, o, "baseColorFactor",
-                               /* required */ false)) {
-    if (baseColorFactor.size() != 4) {
-      if (err) {
-        (*err) +=
-            "Array length of `baseColorFactor` parameter in "
-            "pbrMetallicRoughness must be 4, but got " +
-            std::to_string(baseColorFactor.size()) + "\n";
-      }
-      return false;
-    }
-    pbr->baseColorFactor = baseColorFactor;
+  double ymag = 0.0;
+  if (!ParseNumberProperty(&ymag, err, o, "ymag", true, "OrthographicCamera")) {
+    return false;
   }
 
-  {
-    detail::json_const_iterator it;
-    if (detail::FindMember(o, "baseColorTexture", it)) {
-      ParseTextureInfo(&pbr->baseColorTexture, err, detail::GetValue(it),
-                       store_original_json_for_extras_and_extensions);
-    }
+  double zfar = 0.0;
+  if (!ParseNumberProperty(&zfar, err, o, "zfar", true, "OrthographicCamera")) {
+    return false;
   }
 
-  {
-    detail::json_const_iterator it;
-    if (detail::FindMember(o, "metallicRoughnessTexture", it)) {
-      ParseTextureInfo(&pbr->metallicRoughnessTexture, err,
-                       detail::GetValue(it),
-                       store_original_json_for_extras_and_extensions);
-    }
+  double znear = 0.0;
+  if (!ParseNumberProperty(&znear, err, o, "znear", true,
+                           "OrthographicCamera")) {
+    return false;
   }
 
-  ParseNumberProperty(&pbr->metallicFactor, err, o, "metallicFactor", false);
-  ParseNumberProperty(&pbr->roughnessFactor, err, o, "roughnessFactor", false);
-
-  ParseExtrasAndExtensions(pbr, err, o,
+  ParseExtrasAndExtensions(camera, err, o,
                            store_original_json_for_extras_and_extensions);
 
+  camera->xmag = xmag;
+  camera->ymag = ymag;
+  camera->zfar = zfar;
+  camera->znear = znear;
+
+  // TODO(syoyo): Validate parameter values.
+
   return true;
 }
 
-static bool ParseMaterial(Material *material, std::string *err, std::string *warn,
-                          const detail::json &o,
-                          bool store_original_json_for_extras_and_extensions,
-                          ParseStrictness strictness) {
-  ParseStringProperty(&material->name, err, o, "name", /* required */ false);
+static bool ParseCamera(Camera *camera, std::string *err, const detail::json &o,
+                        bool store_original_json_for_extras_and_extensions) {
+  if (!ParseStringProperty(&camera->type, err, o, "type", true, "Camera")) {
+    return false;
+  }
 
-  if (ParseNumberArrayProperty(&material->emissiveFactor, err, o,
-                               "emissiveFactor",
-                               /* required */ false)) {
-    if (strictness==ParseStrictness::Permissive && material->emissiveFactor.size() == 4) {
-      if (warn) {
-        (*warn) +=
-            "Array length of `emissiveFactor` parameter in "
-            "material must be 3, but got 4\n";
-      }
-      material->emissiveFactor.resize(3);
-    }
-    else if (material->emissiveFactor.size() != 3) {
+  if (camera->type.compare("orthographic") == 0) {
+    detail::json_const_iterator orthoIt;
+    if (!detail::FindMember(o, "orthographic", orthoIt)) {
       if (err) {
-        (*err) +=
-            "Array length of `emissiveFactor` parameter in "
-            "material must be 3, but got " +
-            std::to_string(material->emissiveFactor.size()) + "\n";
+        std::stringstream ss;
+        ss << "Orthographic camera description not found." << std::endl;
+        (*err) += ss.str();
       }
       return false;
     }
-  } else {
-    // fill with default values
-    material->emissiveFactor = {0.0, 0.0, 0.0};
-  }
-
-  ParseStringProperty(&material->alphaMode, err, o, "alphaMode",
-                      /* required */ false);
-  ParseNumberProperty(&material->alphaCutoff, err, o, "alphaCutoff",
-                      /* required */ false);
-  ParseBooleanProperty(&material->doubleSided, err, o, "doubleSided",
-                       /* required */ false);
-
-  {
-    detail::json_const_iterator it;
-    if (detail::FindMember(o, "pbrMetallicRoughness", it)) {
-      ParsePbrMetallicRoughness(&material->pbrMetallicRoughness, err,
-                                detail::GetValue(it),
-                                store_original_json_for_extras_and_extensions);
-    }
-  }
 
-  {
-    detail::json_const_iterator it;
-    if (detail::FindMember(o, "normalTexture", it)) {
-      ParseNormalTextureInfo(&material->normalTexture, err,
-                             detail::GetValue(it),
-                             store_original_json_for_extras_and_extensions);
+    const detail::json &v = detail::GetValue(orthoIt);
+    if (!detail::IsObject(v)) {
+      if (err) {
+        std::stringstream ss;
+        ss << "\"orthographic\" is not a JSON object." << std::endl;
+        (*err) += ss.str();
+      }
+      return false;
     }
-  }
 
-  {
-    detail::json_const_iterator it;
-    if (detail::FindMember(o, "occlusionTexture", it)) {
-      ParseOcclusionTextureInfo(&material->occlusionTexture, err,
-                                detail::GetValue(it),
-                                store_original_json_for_extras_and_extensions);
+    if (!ParseOrthographicCamera(
+            &camera->orthographic, err, v,
+            store_original_json_for_extras_and_extensions)) {
+      return false;
     }
-  }
-
-  {
-    detail::json_const_iterator it;
-    if (detail::FindMember(o, "emissiveTexture", it)) {
-      ParseTextureInfo(&material->emissiveTexture, err, detail::GetValue(it),
-                       store_original_json_for_extras_and_extensions);
+  } else if (camera->type.compare("perspective") == 0) {
+    detail::json_const_iterator perspIt;
+    if (!detail::FindMember(o, "perspective", perspIt)) {
+      if (err) {
+        std::stringstream ss;
+        ss << "Perspective camera description not found." << std::endl;
+        (*err) += ss.str();
+      }
+      return false;
     }
-  }
-
-  // Old code path. For backward compatibility, we still store material values
-  // as Parameter. This will create duplicated information for
-  // example(pbrMetallicRoughness), but should be negligible in terms of memory
-  // consumption.
-  // TODO(syoyo): Remove in the next major release.
-  material->values.clear();
-  material->additionalValues.clear();
-
-  detail::json_const_iterator it(detail::ObjectBegin(o));
-  detail::json_const_iterator itEnd(detail::ObjectEnd(o));
-
-  for (; it != itEnd; ++it) {
-    std::string key(detail::GetKey(it));
-    if (key == "pbrMetallicRoughness") {
-      if (detail::IsObject(detail::GetValue(it))) {
-        const detail::json &values_object = detail::GetValue(it);
-
-        detail::json_const_iterator itVal(detail::ObjectBegin(values_object));
-        detail::json_const_iterator itValEnd(detail::ObjectEnd(values_object));
 
-        for (; itVal != itValEnd; ++itVal) {
-          Parameter param;
-          if (ParseParameterProperty(&param, err, values_object,
-                                     detail::GetKey(itVal), false)) {
-            material->values.emplace(detail::GetKey(itVal), std::move(param));
-          }
-        }
-      }
-    } else if (key == "extensions" || key == "extras") {
-      // done later, skip, otherwise poorly parsed contents will be saved in the
-      // parametermap and serialized again later
-    } else {
-      Parameter param;
-      if (ParseParameterProperty(&param, err, o, key, false)) {
-        // names of materials have already been parsed. Putting it in this map
-        // doesn't correctly reflect the glTF specification
-        if (key != "name")
-          material->additionalValues.emplace(std::move(key), std::move(param));
+    const detail::json &v = detail::GetValue(perspIt);
+    if (!detail::IsObject(v)) {
+      if (err) {
+        std::stringstream ss;
+        ss << "\"perspective\" is not a JSON object." << std::endl;
+        (*err) += ss.str();
       }
+      return false;
+    }
+
+    if (!ParsePerspectiveCamera(
+            &camera->perspective, err, v,
+            store_original_json_for_extras_and_extensions)) {
+      return false;
+    }
+  } else {
+    if (err) {
+      std::stringstream ss;
+      ss << "Invalid camera type: \"" << camera->type
+         << "\". Must be \"perspective\" or \"orthographic\"" << std::endl;
+      (*err) += ss.str();
     }
+    return false;
   }
 
-  material->extensions.clear();  // Note(agnat): Why?
-  ParseExtrasAndExtensions(material, err, o,
+  ParseStringProperty(&camera->name, err, o, "name", false);
+
+  ParseExtrasAndExtensions(camera, err, o,
                            store_original_json_for_extras_and_extensions);
 
   return true;
 }
 
-static bool ParseAnimationChannel(
-    AnimationChannel *channel, std::string *err, const detail::json &o,
-    bool store_original_json_for_extras_and_extensions) {
-  int samplerIndex = -1;
-  int targetIndex = -1;
-  if (!ParseIntegerProperty(&samplerIndex, err, o, "sampler", true,
-                            "AnimationChannel")) {
-    if (err) {
-      (*err) += "`sampler` field is missing in animation channels\n";
-    }
+static bool ParseLight(Light *light, std::string *err, const detail::json &o,
+                       bool store_original_json_for_extras_and_extensions) {
+  if (!ParseStringProperty(&light->type, err, o, "type", true)) {
     return false;
   }
 
-  detail::json_const_iterator targetIt;
-  if (detail::FindMember(o, "target", targetIt) &&
-      detail::IsObject(detail::GetValue(targetIt))) {
-    const detail::json &target_object = detail::GetValue(targetIt);
-
-    ParseIntegerProperty(&targetIndex, err, target_object, "node", false);
-
-    if (!ParseStringProperty(&channel->target_path, err, target_object, "path",
-                             true)) {
+  if (light->type == "spot") {
+    detail::json_const_iterator spotIt;
+    if (!detail::FindMember(o, "spot", spotIt)) {
       if (err) {
-        (*err) += "`path` field is missing in animation.channels.target\n";
+        std::stringstream ss;
+        ss << "Spot light description not found." << std::endl;
+        (*err) += ss.str();
       }
       return false;
     }
-    ParseExtensionsProperty(&channel->target_extensions, err, target_object);
-    ParseExtrasProperty(&channel->target_extras, target_object);
-    if (store_original_json_for_extras_and_extensions) {
-      {
-        detail::json_const_iterator it;
-        if (detail::FindMember(target_object, "extensions", it)) {
-          channel->target_extensions_json_string =
-              detail::JsonToString(detail::GetValue(it));
-        }
-      }
-      {
-        detail::json_const_iterator it;
-        if (detail::FindMember(target_object, "extras", it)) {
-          channel->target_extras_json_string =
-              detail::JsonToString(detail::GetValue(it));
-        }
+
+    const detail::json &v = detail::GetValue(spotIt);
+    if (!detail::IsObject(v)) {
+      if (err) {
+        std::stringstream ss;
+        ss << "\"spot\" is not a JSON object." << std::endl;
+        (*err) += ss.str();
       }
+      return false;
+    }
+
+    if (!ParseSpotLight(&light->spot, err, v,
+                        store_original_json_for_extras_and_extensions)) {
+      return false;
     }
   }
 
-  channel->sampler = samplerIndex;
-  channel->target_node = targetIndex;
+  ParseStringProperty(&light->name, err, o, "name", false);
+  ParseNumberArrayProperty(&light->color, err, o, "color", false);
+  ParseNumberProperty(&light->range, err, o, "range", false);
+  ParseNumberProperty(&light->intensity, err, o, "intensity", false);
 
-  ParseExtrasAndExtensions(channel, err, o,
+  ParseExtrasAndExtensions(light, err, o,
                            store_original_json_for_extras_and_extensions);
 
   return true;
 }
 
-static bool ParseAnimation(Animation *animation, std::string *err,
-                           const detail::json &o,
-                           bool store_original_json_for_extras_and_extensions) {
-  {
-    detail::json_const_iterator channelsIt;
-    if (detail::FindMember(o, "channels", channelsIt) &&
-        detail::IsArray(detail::GetValue(channelsIt))) {
-      detail::json_const_array_iterator channelEnd =
-          detail::ArrayEnd(detail::GetValue(channelsIt));
-      for (detail::json_const_array_iterator i =
-               detail::ArrayBegin(detail::GetValue(channelsIt));
-           i != channelEnd; ++i) {
-        AnimationChannel channel;
-        if (ParseAnimationChannel(
-                &channel, err, *i,
-                store_original_json_for_extras_and_extensions)) {
-          // Only add the channel if the parsing succeeds.
-          animation->channels.emplace_back(std::move(channel));
-        }
-      }
-    }
-  }
+static bool ParsePositionalEmitter(
+    PositionalEmitter *positional, std::string *err, const detail::json &o,
+    bool store_original_json_for_extras_and_extensions) {
+  ParseNumberProperty(&positional->coneInnerAngle, err, o, "coneInnerAngle",
+                      false);
+  ParseNumberProperty(&positional->coneOuterAngle, err, o, "coneOuterAngle",
+                      false);
+  ParseNumberProperty(&positional->coneOuterGain, err, o, "coneOuterGain",
+                      false);
+  ParseNumberProperty(&positional->maxDistance, err, o, "maxDistance", false);
+  ParseNumberProperty(&positional->refDistance, err, o, "refDistance", false);
+  ParseNumberProperty(&positional->rolloffFactor, err, o, "rolloffFactor",
+                      false);
 
-  {
-    detail::json_const_iterator samplerIt;
-    if (detail::FindMember(o, "samplers", samplerIt) &&
-        detail::IsArray(detail::GetValue(samplerIt))) {
-      const detail::json &sampler_array = detail::GetValue(samplerIt);
+  ParseExtrasAndExtensions(positional, err, o,
+                           store_original_json_for_extras_and_extensions);
 
-      detail::json_const_array_iterator it = detail::ArrayBegin(sampler_array);
-      detail::json_const_array_iterator itEnd = detail::ArrayEnd(sampler_array);
+  return true;
+}
 
-      for (; it != itEnd; ++it) {
-        const detail::json &s = *it;
+static bool ParseAudioEmitter(
+    AudioEmitter *emitter, std::string *err, const detail::json &o,
+    bool store_original_json_for_extras_and_extensions) {
+  if (!ParseStringProperty(&emitter->type, err, o, "type", true)) {
+    return false;
+  }
 
-        AnimationSampler sampler;
-        int inputIndex = -1;
-        int outputIndex = -1;
-        if (!ParseIntegerProperty(&inputIndex, err, s, "input", true)) {
-          if (err) {
-            (*err) += "`input` field is missing in animation.sampler\n";
-          }
-          return false;
-        }
-        ParseStringProperty(&sampler.interpolation, err, s, "interpolation",
-                            false);
-        if (!ParseIntegerProperty(&outputIndex, err, s, "output", true)) {
-          if (err) {
-            (*err) += "`output` field is missing in animation.sampler\n";
-          }
-          return false;
-        }
-        sampler.input = inputIndex;
-        sampler.output = outputIndex;
-        ParseExtrasAndExtensions(&sampler, err, o,
-                                 store_original_json_for_extras_and_extensions);
+  if (emitter->type == "positional") {
+    detail::json_const_iterator positionalIt;
+    if (!detail::FindMember(o, "positional", positionalIt)) {
+      if (err) {
+        std::stringstream ss;
+        ss << "Positional emitter description not found." << std::endl;
+        (*err) += ss.str();
+      }
+      return false;
+    }
 
-        animation->samplers.emplace_back(std::move(sampler));
+    const detail::json &v = detail::GetValue(positionalIt);
+    if (!detail::IsObject(v)) {
+      if (err) {
+        std::stringstream ss;
+        ss << "\"positional\" is not a JSON object." << std::endl;
+        (*err) += ss.str();
       }
+      return false;
+    }
+
+    if (!ParsePositionalEmitter(
+            &emitter->positional, err, v,
+            store_original_json_for_extras_and_extensions)) {
+      return false;
     }
   }
 
-  ParseStringProperty(&animation->name, err, o, "name", false);
+  ParseStringProperty(&emitter->name, err, o, "name", false);
+  ParseNumberProperty(&emitter->gain, err, o, "gain", false);
+  ParseBooleanProperty(&emitter->loop, err, o, "loop", false);
+  ParseBooleanProperty(&emitter->playing, err, o, "playing", false);
+  ParseStringProperty(&emitter->distanceModel, err, o, "distanceModel", false);
+  ParseIntegerProperty(&emitter->source, err, o, "source", true);
 
-  ParseExtrasAndExtensions(animation, err, o,
+  ParseExtrasAndExtensions(emitter, err, o,
                            store_original_json_for_extras_and_extensions);
 
   return true;
 }
 
-static bool ParseSampler(Sampler *sampler, std::string *err,
-                         const detail::json &o,
-                         bool store_original_json_for_extras_and_extensions) {
-  ParseStringProperty(&sampler->name, err, o, "name", false);
+static bool ParseAudioSource(
+    AudioSource *source, std::string *err, const detail::json &o,
+    bool store_original_json_for_extras_and_extensions) {
+  ParseStringProperty(&source->name, err, o, "name", false);
+  ParseStringProperty(&source->uri, err, o, "uri", false);
 
-  int minFilter = -1;
-  int magFilter = -1;
-  int wrapS = TINYGLTF_TEXTURE_WRAP_REPEAT;
-  int wrapT = TINYGLTF_TEXTURE_WRAP_REPEAT;
-  // int wrapR = TINYGLTF_TEXTURE_WRAP_REPEAT;
-  ParseIntegerProperty(&minFilter, err, o, "minFilter", false);
-  ParseIntegerProperty(&magFilter, err, o, "magFilter", false);
-  ParseIntegerProperty(&wrapS, err, o, "wrapS", false);
-  ParseIntegerProperty(&wrapT, err, o, "wrapT", false);
-  // ParseIntegerProperty(&wrapR, err, o, "wrapR", false);  // tinygltf
-  // extension
+  if (source->uri.empty()) {
+    ParseIntegerProperty(&source->bufferView, err, o, "bufferView", true);
+    ParseStringProperty(&source->mimeType, err, o, "mimeType", true);
+  }
+
+  ParseExtrasAndExtensions(source, err, o,
+                           store_original_json_for_extras_and_extensions);
+
+  return true;
+}
+
+namespace detail {
+
+template <typename Callback>
+bool ForEachInArray(const detail::json &_v, const char *member, Callback &&cb) {
+  detail::json_const_iterator itm;
+  if (detail::FindMember(_v, member, itm) &&
+      detail::IsArray(detail::GetValue(itm))) {
+    const detail::json &root = detail::GetValue(itm);
+    auto it = detail::ArrayBegin(root);
+    auto end = detail::ArrayEnd(root);
+    for (; it != end; ++it) {
+      if (!cb(*it)) return false;
+    }
+  }
+  return true;
+};
+
+///
+/// Same as ForEachInArray, but frees each element's DOM subtree as soon as
+/// `cb` has converted it, then removes `member` from `_v`. This keeps peak
+/// memory near max(DOM, Model) instead of DOM + Model while loading.
+/// With the RapidJSON MemoryPoolAllocator, memory is only reclaimed when the
+/// document is destroyed.
+///
+template <typename Callback>
+bool ConsumeArray(detail::json &_v, const char *member, Callback &&cb) {
+  detail::json_iterator itm;
+  if (!detail::FindMember(_v, member, itm)) {
+    return true;
+  }
+  detail::json &root = detail::GetValue(itm);
+  if (detail::IsArray(root)) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+    for (auto it = root.Begin(); it != root.End(); ++it) {
+      if (!cb(static_cast<const detail::json &>(*it))) return false;
+      it->SetNull();
+    }
+#else
+    for (auto &elem : root) {
+      if (!cb(static_cast<const detail::json &>(elem))) return false;
+      elem = nullptr;
+    }
+#endif
+  }
+  detail::Erase(_v, itm);
+  return true;
+}
 
-  // TODO(syoyo): Check the value is allowed one.
-  // (e.g. we allow 9728(NEAREST), but don't allow 9727)
+// A top-level array of the glTF document whose elements are converted one
+// at a time while parsing(see JsonParseStreaming).
+struct StreamedSection {
+  StreamedSection(const char *name_,
+                  std::function<bool(const detail::json &)> convert_)
+      : name(name_), convert(std::move(convert_)) {}
 
-  sampler->minFilter = minFilter;
-  sampler->magFilter = magFilter;
-  sampler->wrapS = wrapS;
-  sampler->wrapT = wrapT;
-  // sampler->wrapR = wrapR;
+  const char *name;
+  std::function<bool(const detail::json &)> convert;
+  bool seen = false;  // The member was present as an array.
+#ifndef TINYGLTF_USE_RAPIDJSON
+  // Elements converted after parsing, in order(see StreamingJsonHandler).
+  std::vector<detail::json> deferred;
+#endif
+};
 
-  ParseExtrasAndExtensions(sampler, err, o,
-                           store_original_json_for_extras_and_extensions);
+#ifndef TINYGLTF_USE_RAPIDJSON
+// Builds the DOM of one streamed element from SAX events. Unlike
+// nlohmann's json_sax_dom_parser it moves strings out of the parser, so a
+// large data URI isn't held twice while the element is converted.
+class JsonElementBuilder {
+ public:
+  explicit JsonElementBuilder(json *root) : root_(root) {}
 
-  return true;
-}
+  // Containers of the element still open; 0 once the element is complete.
+  size_t depth() const { return stack_.size(); }
 
-static bool ParseSkin(Skin *skin, std::string *err, const detail::json &o,
-                      bool store_original_json_for_extras_and_extensions) {
-  ParseStringProperty(&skin->name, err, o, "name", false, "Skin");
+  // Whether the element holds a string of at least kLargeString bytes;
+  // resets for the next element.
+  bool TakeHasLargeString() {
+    const bool large = has_large_string_;
+    has_large_string_ = false;
+    return large;
+  }
 
-  std::vector<int> joints;
-  if (!ParseIntegerArrayProperty(&joints, err, o, "joints", false, "Skin")) {
-    return false;
+  void Value(json &&value) {
+    if (value.is_string() &&
+        value.get_ref<const std::string &>().size() >= kLargeString) {
+      has_large_string_ = true;
+    }
+    Insert(std::move(value));
   }
-  skin->joints = std::move(joints);
+  void Open(json::value_t type) { stack_.push_back(Insert(json(type))); }
+  void Key(const std::string &key) { key_ = &(*stack_.back())[key]; }
+  void Close() { stack_.pop_back(); }
 
-  int skeleton = -1;
-  ParseIntegerProperty(&skeleton, err, o, "skeleton", false, "Skin");
-  skin->skeleton = skeleton;
+ private:
+  json *Insert(json &&value) {
+    if (stack_.empty()) {
+      *root_ = std::move(value);
+      return root_;
+    }
+    json &parent = *stack_.back();
+    if (parent.is_array()) {
+      parent.push_back(std::move(value));
+      return &parent.back();
+    }
+    *key_ = std::move(value);
+    return key_;
+  }
 
-  int invBind = -1;
-  ParseIntegerProperty(&invBind, err, o, "inverseBindMatrices", true, "Skin");
-  skin->inverseBindMatrices = invBind;
+  static const size_t kLargeString = 1024 * 1024;
 
-  ParseExtrasAndExtensions(skin, err, o,
-                           store_original_json_for_extras_and_extensions);
+  json *root_;
+  std::vector<json *> stack_;
+  json *key_ = nullptr;
+  bool has_large_string_ = false;
+};
 
-  return true;
-}
+// nlohmann::json SAX handler that builds the DOM of one element of a
+// streamed section at a time, hands it to the section's `convert` and frees
+// it. All other members go to the root document as usual.
+// The parser keeps a copy of its largest token until parsing ends, so an
+// element with a large string(typically a data URI) is not converted while
+// parsing but deferred, with the rest of its section to keep their order.
+class StreamingJsonHandler {
+ public:
+  using Builder = nlohmann::detail::json_sax_dom_parser<json>;
 
-static bool ParsePerspectiveCamera(
-    PerspectiveCamera *camera, std::string *err, const detail::json &o,
-    bool store_original_json_for_extras_and_extensions) {
-  double yfov = 0.0;
-  if (!ParseNumberProperty(&yfov, err, o, "yfov", true, "OrthographicCamera")) {
-    return false;
-  }
+  StreamingJsonHandler(json &root, std::vector<StreamedSection> *sections,
+                       bool throwExc)
+      : root_builder_(root, throwExc),
+        sections_(sections),
+        element_builder_(&element_) {}
 
-  double znear = 0.0;
-  if (!ParseNumberProperty(&znear, err, o, "znear", true,
-                           "PerspectiveCamera")) {
-    return false;
+  bool converter_failed() const { return converter_failed_; }
+
+  bool null() {
+    return Scalar(nullptr, [](Builder &b) { return b.null(); });
+  }
+  bool boolean(bool val) {
+    return Scalar(val, [&](Builder &b) { return b.boolean(val); });
+  }
+  bool number_integer(json::number_integer_t val) {
+    return Scalar(val, [&](Builder &b) { return b.number_integer(val); });
+  }
+  bool number_unsigned(json::number_unsigned_t val) {
+    return Scalar(val, [&](Builder &b) { return b.number_unsigned(val); });
+  }
+  bool number_float(json::number_float_t val, const json::string_t &s) {
+    return Scalar(val, [&](Builder &b) { return b.number_float(val, s); });
+  }
+  bool string(json::string_t &val) {
+    // Only moved from when it goes to a streamed element.
+    return Scalar(std::move(val), [&](Builder &b) { return b.string(val); });
+  }
+  bool binary(json::binary_t &val) {
+    return Scalar(val, [&](Builder &b) { return b.binary(val); });
   }
 
-  double aspectRatio = 0.0;  // = invalid
-  ParseNumberProperty(&aspectRatio, err, o, "aspectRatio", false,
-                      "PerspectiveCamera");
+  bool start_object(std::size_t len) {
+    return Open(json::value_t::object,
+                [&](Builder &b) { return b.start_object(len); });
+  }
+  bool start_array(std::size_t len) {
+    if (pending_) {
+      // The elements of `pending_` are streamed; the root never sees it.
+      streaming_ = pending_;
+      streaming_->seen = true;
+      pending_ = nullptr;
+      depth_++;
+      return true;
+    }
+    return Open(json::value_t::array,
+                [&](Builder &b) { return b.start_array(len); });
+  }
+  bool end_object() {
+    return Close([](Builder &b) { return b.end_object(); });
+  }
+  bool end_array() {
+    if (streaming_ && element_builder_.depth() == 0) {
+      streaming_ = nullptr;
+      depth_--;
+      return true;
+    }
+    return Close([](Builder &b) { return b.end_array(); });
+  }
 
-  double zfar = 0.0;  // = invalid
-  ParseNumberProperty(&zfar, err, o, "zfar", false, "PerspectiveCamera");
+  bool key(json::string_t &val) {
+    if (streaming_) {
+      element_builder_.Key(val);
+      return true;
+    }
+    if (depth_ == 1) {
+      for (StreamedSection &section : *sections_) {
+        if (val == section.name) {
+          // Held back until the value shows whether it is an array.
+          pending_ = &section;
+          pending_key_ = val;
+          return true;
+        }
+      }
+    }
+    return root_builder_.key(val);
+  }
 
-  camera->aspectRatio = aspectRatio;
-  camera->zfar = zfar;
-  camera->yfov = yfov;
-  camera->znear = znear;
+  bool parse_error(std::size_t position, const std::string &last_token,
+                   const nlohmann::detail::exception &ex) {
+    return root_builder_.parse_error(position, last_token, ex);
+  }
 
-  ParseExtrasAndExtensions(camera, err, o,
-                           store_original_json_for_extras_and_extensions);
+ private:
+  // Passes a held back section key to the root when its value is not an
+  // array.
+  bool FlushPendingKey() {
+    if (!pending_) {
+      return true;
+    }
+    pending_ = nullptr;
+    return root_builder_.key(pending_key_);
+  }
 
-  // TODO(syoyo): Validate parameter values.
+  // Converts the element once its last container is closed.
+  bool ConvertIfComplete() {
+    if (element_builder_.depth() > 0) {
+      return true;
+    }
+    if (element_builder_.TakeHasLargeString() ||
+        !streaming_->deferred.empty()) {
+      streaming_->deferred.push_back(std::move(element_));
+      element_ = nullptr;
+      return true;
+    }
+    if (!streaming_->convert(element_)) {
+      converter_failed_ = true;
+      return false;
+    }
+    element_ = nullptr;
+    return true;
+  }
 
-  return true;
-}
+  template <typename Value, typename Event>
+  bool Scalar(Value &&value, Event root_event) {
+    if (!FlushPendingKey()) {
+      return false;
+    }
+    if (streaming_) {
+      element_builder_.Value(json(std::forward<Value>(value)));
+      return ConvertIfComplete();
+    }
+    return root_event(root_builder_);
+  }
 
-static bool ParseSpotLight(SpotLight *light, std::string *err,
-                           const detail::json &o,
-                           bool store_original_json_for_extras_and_extensions) {
-  ParseNumberProperty(&light->innerConeAngle, err, o, "innerConeAngle", false);
-  ParseNumberProperty(&light->outerConeAngle, err, o, "outerConeAngle", false);
+  template <typename Event>
+  bool Open(json::value_t type, Event root_event) {
+    if (!FlushPendingKey()) {
+      return false;
+    }
+    depth_++;
+    if (streaming_) {
+      element_builder_.Open(type);
+      return true;
+    }
+    return root_event(root_builder_);
+  }
 
-  ParseExtrasAndExtensions(light, err, o,
-                           store_original_json_for_extras_and_extensions);
+  template <typename Event>
+  bool Close(Event root_event) {
+    depth_--;
+    if (streaming_) {
+      element_builder_.Close();
+      return ConvertIfComplete();
+    }
+    return root_event(root_builder_);
+  }
 
-  // TODO(syoyo): Validate parameter values.
+  Builder root_builder_;
+  std::vector<StreamedSection> *sections_;
+  int depth_ = 0;  // Of the container being parsed; 1 is the root object.
+  StreamedSection *pending_ = nullptr;
+  std::string pending_key_;
+  StreamedSection *streaming_ = nullptr;
+  json element_;
+  JsonElementBuilder element_builder_;
+  bool converter_failed_ = false;
+};
+#endif
 
+///
+/// Parses like JsonParse, except that elements of the top-level arrays
+/// named in `sections` are passed to their `convert` as soon as each one is
+/// parsed(or right after parsing, see StreamingJsonHandler), and are not
+/// added to `doc`. Peak memory is then one element's DOM plus the rest of
+/// the document instead of the whole DOM.
+/// Returns false when a `convert` fails. With RapidJSON the whole DOM is
+/// built and `sections` are left to the caller.
+///
+bool JsonParseStreaming(JsonDocument &doc, const char *str, size_t length,
+                        std::vector<StreamedSection> *sections,
+                        bool throwExc = false) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  (void)sections;
+  JsonParse(doc, str, length, throwExc);
+  return true;
+#else
+  StreamingJsonHandler handler(doc, sections, throwExc);
+  if (!json::sax_parse(str, str + length, &handler)) {
+    if (handler.converter_failed()) {
+      return false;
+    }
+    doc = json(json::value_t::discarded);
+    return true;
+  }
+  for (StreamedSection &section : *sections) {
+    for (json &element : section.deferred) {
+      if (!section.convert(element)) {
+        return false;
+      }
+      element = nullptr;
+    }
+    section.deferred.clear();
+  }
   return true;
+#endif
 }
 
-static bool ParseOrthographicCamera(
-    OrthographicCamera *camera, std::string *err, const detail::json &o,
-    bool store_original_json_for_extras_and_extensions) {
-  double xmag = 0.0;
-  if (!ParseNumberProperty(&xmag, err, o, "xmag", true, "OrthographicCamera")) {
-    return false;
+static void MarkUsed(std::vector<char> *used, int idx) {
+  if (idx < 0) {
+    return;
   }
-
-  double ymag = 0.0;
-  if (!ParseNumberProperty(&ymag, err, o, "ymag", true, "OrthographicCamera")) {
-    return false;
+  if (size_t(idx) >= used->size()) {
+    used->resize(size_t(idx) + 1, 0);
   }
+  (*used)[size_t(idx)] = 1;
+}
 
-  double zfar = 0.0;
-  if (!ParseNumberProperty(&zfar, err, o, "zfar", true, "OrthographicCamera")) {
-    return false;
+static bool IsUsed(const std::vector<char> &used, size_t idx) {
+  return idx < used.size() && used[idx];
+}
+
+///
+/// Marks the nodes reached from `model.scenes[scene]`, and the meshes and
+/// skins those nodes use.
+///
+static void MarkSceneNodes(const Model &model, int scene,
+                           std::vector<char> *node_used,
+                           std::vector<char> *mesh_used,
+                           std::vector<char> *skin_used) {
+  node_used->assign(model.nodes.size(), 0);
+  std::vector<int> stack = model.scenes[size_t(scene)].nodes;
+  while (!stack.empty()) {
+    const int n = stack.back();
+    stack.pop_back();
+    if (n < 0 || size_t(n) >= model.nodes.size() || (*node_used)[size_t(n)]) {
+      continue;
+    }
+    (*node_used)[size_t(n)] = 1;
+    const Node &node = model.nodes[size_t(n)];
+    stack.insert(stack.end(), node.children.begin(), node.children.end());
+    MarkUsed(mesh_used, node.mesh);
+    MarkUsed(skin_used, node.skin);
   }
+}
 
-  double znear = 0.0;
-  if (!ParseNumberProperty(&znear, err, o, "znear", true,
-                           "OrthographicCamera")) {
+}  // end of namespace detail
+
+TinyGLTF::LoadContext TinyGLTF::NewLoadContext() const {
+  LoadContext ctx;
+  ctx.borrow_binary_chunk = borrow_binary_chunk_;
+  ctx.image_threads = image_loading_threads_;
+  ctx.filter = load_filter_;
+  return ctx;
+}
+
+bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
+                              const char *json_str,
+                              unsigned int json_str_length,
+                              const std::string &base_dir,
+                              unsigned int check_sections,
+                              const LoadContext &ctx) const {
+  if (json_str_length < 4) {
+    if (err) {
+      (*err) = "JSON string too short.\n";
+    }
     return false;
   }
 
-  ParseExtrasAndExtensions(camera, err, o,
-                           store_original_json_for_extras_and_extensions);
+  model->buffers.clear();
+  model->bufferViews.clear();
+  model->accessors.clear();
+  model->meshes.clear();
+  model->cameras.clear();
+  model->nodes.clear();
+  model->extensionsUsed.clear();
+  model->extensionsRequired.clear();
+  model->extensions.clear();
+  model->defaultScene = -1;
 
-  camera->xmag = xmag;
-  camera->ymag = ymag;
-  camera->zfar = zfar;
-  camera->znear = znear;
+  using detail::ForEachInArray;
+  using detail::ConsumeArray;
 
-  // TODO(syoyo): Validate parameter values.
+  const LoadFilter &filter = ctx.filter;
+  const bool skip_buffers = (filter.skip_sections & SKIP_BUFFERS) != 0;
 
-  return true;
-}
+  // Nodes, meshes and skins reached from the filtered scene(set once scenes
+  // are parsed).
+  int filter_scene = filter.scene;
+  std::vector<char> node_used, mesh_used, skin_used;
 
-static bool ParseCamera(Camera *camera, std::string *err, const detail::json &o,
-                        bool store_original_json_for_extras_and_extensions) {
-  if (!ParseStringProperty(&camera->type, err, o, "type", true, "Camera")) {
-    return false;
+  void *load_image_user_data{nullptr};
+
+  LoadImageDataOption load_image_option;
+
+  if (user_image_loader_) {
+    // Use user supplied pointer
+    load_image_user_data = load_image_user_data_;
+  } else {
+    load_image_option.preserve_channels = preserve_image_channels_;
+    load_image_user_data = reinterpret_cast<void *>(&load_image_option);
   }
 
-  if (camera->type.compare("orthographic") == 0) {
-    detail::json_const_iterator orthoIt;
-    if (!detail::FindMember(o, "orthographic", orthoIt)) {
+  // Encoded image bytes to decode after parsing(image_loading_threads_ > 1).
+  struct ImageDecodeTask {
+    int image_idx = 0;
+    const unsigned char *bytes = nullptr;  // Points into a buffer, or
+    std::vector<unsigned char> data;       // owns data URI/external bytes.
+    size_t size = 0;
+    int req_width = 0;
+    int req_height = 0;
+    std::string err;
+    std::string warn;
+    bool ret = false;
+  };
+  const bool defer_decode = !lazy_image_loading_ && (ctx.image_threads > 1);
+  std::vector<ImageDecodeTask> decode_tasks;
+  const size_t image_offset = model->images.size();
+
+  // Converters of one element of each top-level array. A streaming parse
+  // calls them while parsing(in document order), otherwise they run over
+  // the DOM in the numbered order below.
+  auto parse_buffer = [&](const detail::json &o) {
+    if (!detail::IsObject(o)) {
       if (err) {
-        std::stringstream ss;
-        ss << "Orthographic camera description not found." << std::endl;
-        (*err) += ss.str();
+        (*err) += "`buffers' does not contain an JSON object.";
+      }
+      return false;
+    }
+    Buffer buffer;
+    if (skip_buffers) {
+      ParseStringProperty(&buffer.name, err, o, "name", false);
+      ParseStringProperty(&buffer.uri, err, o, "uri", false);
+      if (IsDataURI(buffer.uri)) {
+        buffer.uri.clear();
+      }
+      model->buffers.emplace_back(std::move(buffer));
+      return true;
+    }
+    if (!ParseBuffer(&buffer, err, o,
+                     store_original_json_for_extras_and_extensions_, &fs,
+                     &uri_cb, base_dir, max_external_file_size_,
+                     ctx.is_binary, ctx.bin_data, ctx.bin_size,
+                     ctx.borrow_binary_chunk)) {
+      return false;
+    }
+
+    model->buffers.emplace_back(std::move(buffer));
+    return true;
+  };
+
+  auto parse_buffer_view = [&](const detail::json &o) {
+    if (!detail::IsObject(o)) {
+      if (err) {
+        (*err) += "`bufferViews' does not contain an JSON object.";
+      }
+      return false;
+    }
+    BufferView bufferView;
+    if (!ParseBufferView(&bufferView, err, o,
+                         store_original_json_for_extras_and_extensions_)) {
+      return false;
+    }
+
+    model->bufferViews.emplace_back(std::move(bufferView));
+    return true;
+  };
+
+  auto parse_accessor = [&](const detail::json &o) {
+    if (!detail::IsObject(o)) {
+      if (err) {
+        (*err) += "`accessors' does not contain an JSON object.";
       }
       return false;
     }
+    Accessor accessor;
+    if (!ParseAccessor(&accessor, err, o,
+                       store_original_json_for_extras_and_extensions_)) {
+      return false;
+    }
+
+    model->accessors.emplace_back(std::move(accessor));
+    return true;
+  };
+
+  auto parse_node = [&](const detail::json &o) {
+    if (!detail::IsObject(o)) {
+      if (err) {
+        (*err) += "`nodes' does not contain an JSON object.";
+      }
+      return false;
+    }
+    Node node;
+    if (!ParseNode(&node, err, o,
+                   store_original_json_for_extras_and_extensions_)) {
+      return false;
+    }
+
+    model->nodes.emplace_back(std::move(node));
+    return true;
+  };
 
-    const detail::json &v = detail::GetValue(orthoIt);
-    if (!detail::IsObject(v)) {
+  auto parse_scene = [&](const detail::json &o) {
+    if (!detail::IsObject(o)) {
       if (err) {
-        std::stringstream ss;
-        ss << "\"orthographic\" is not a JSON object." << std::endl;
-        (*err) += ss.str();
+        (*err) += "`scenes' does not contain an JSON object.";
       }
       return false;
     }
 
-    if (!ParseOrthographicCamera(
-            &camera->orthographic, err, v,
-            store_original_json_for_extras_and_extensions)) {
+    Scene scene;
+    if (!ParseScene(&scene, err, o,
+                    store_original_json_for_extras_and_extensions_)) {
       return false;
     }
-  } else if (camera->type.compare("perspective") == 0) {
-    detail::json_const_iterator perspIt;
-    if (!detail::FindMember(o, "perspective", perspIt)) {
+
+    model->scenes.emplace_back(std::move(scene));
+    return true;
+  };
+
+  size_t mesh_idx = 0;
+  auto parse_mesh = [&](const detail::json &o) {
+    if (!detail::IsObject(o)) {
       if (err) {
-        std::stringstream ss;
-        ss << "Perspective camera description not found." << std::endl;
-        (*err) += ss.str();
+        (*err) += "`meshes' does not contain an JSON object.";
       }
       return false;
     }
+    Mesh mesh;
+    ParseStringProperty(&mesh.name, err, o, "name", false);
+    const bool keep =
+        !(filter.skip_sections & SKIP_MESHES) &&
+        (filter_scene == -1 || detail::IsUsed(mesh_used, mesh_idx)) &&
+        (!filter.mesh_filter ||
+         filter.mesh_filter(mesh.name, filter.mesh_filter_user_data));
+    ++mesh_idx;
+    if (!keep) {
+      model->meshes.emplace_back(std::move(mesh));
+      return true;
+    }
+    if (!ParseMesh(&mesh, err, o,
+                   store_original_json_for_extras_and_extensions_)) {
+      return false;
+    }
 
-    const detail::json &v = detail::GetValue(perspIt);
-    if (!detail::IsObject(v)) {
+    model->meshes.emplace_back(std::move(mesh));
+    return true;
+  };
+
+  auto parse_material = [&](const detail::json &o) {
+    if (!detail::IsObject(o)) {
       if (err) {
-        std::stringstream ss;
-        ss << "\"perspective\" is not a JSON object." << std::endl;
-        (*err) += ss.str();
+        (*err) += "`materials' does not contain an JSON object.";
       }
       return false;
     }
+    Material material;
+    ParseStringProperty(&material.name, err, o, "name", false);
 
-    if (!ParsePerspectiveCamera(
-            &camera->perspective, err, v,
-            store_original_json_for_extras_and_extensions)) {
+    if (!ParseMaterial(&material, err, warn, o,
+                       store_original_json_for_extras_and_extensions_,
+                       strictness_)) {
       return false;
     }
-  } else {
-    if (err) {
-      std::stringstream ss;
-      ss << "Invalid camera type: \"" << camera->type
-         << "\". Must be \"perspective\" or \"orthographic\"" << std::endl;
-      (*err) += ss.str();
-    }
-    return false;
-  }
 
-  ParseStringProperty(&camera->name, err, o, "name", false);
+    model->materials.emplace_back(std::move(material));
+    return true;
+  };
 
-  ParseExtrasAndExtensions(camera, err, o,
-                           store_original_json_for_extras_and_extensions);
+  int idx = 0;
+  auto parse_image = [&](const detail::json &o) {
+    if (!detail::IsObject(o)) {
+      if (err) {
+        (*err) += "image[" + std::to_string(idx) + "] is not a JSON object.";
+      }
+      return false;
+    }
+    Image image;
+    ImageDecodeTask task;
+    if (filter.skip_sections & SKIP_IMAGES) {
+      ParseStringProperty(&image.name, err, o, "name", false);
+      ParseStringProperty(&image.uri, err, o, "uri", false);
+      if (IsDataURI(image.uri)) {
+        image.uri.clear();
+      }
+      ParseStringProperty(&image.mimeType, err, o, "mimeType", false);
+      ParseIntegerProperty(&image.bufferView, err, o, "bufferView", false);
+      model->images.emplace_back(std::move(image));
+      ++idx;
+      return true;
+    }
+    if (!ParseImage(&image, idx, err, warn, o,
+                    store_original_json_for_extras_and_extensions_, base_dir,
+                    max_external_file_size_, &fs, &uri_cb,
+                    &this->LoadImageData, load_image_user_data,
+                    lazy_image_loading_
+                        ? &image.encoded
+                        : (defer_decode ? &task.data : nullptr))) {
+      return false;
+    }
 
-  return true;
-}
+    if (defer_decode && !task.data.empty()) {
+      task.image_idx = idx;
+      task.size = task.data.size();
+      decode_tasks.emplace_back(std::move(task));
+    }
 
-static bool ParseLight(Light *light, std::string *err, const detail::json &o,
-                       bool store_original_json_for_extras_and_extensions) {
-  if (!ParseStringProperty(&light->type, err, o, "type", true)) {
-    return false;
-  }
+    model->images.emplace_back(std::move(image));
+    ++idx;
+    return true;
+  };
 
-  if (light->type == "spot") {
-    detail::json_const_iterator spotIt;
-    if (!detail::FindMember(o, "spot", spotIt)) {
+  auto parse_texture = [&](const detail::json &o) {
+    if (!detail::IsObject(o)) {
       if (err) {
-        std::stringstream ss;
-        ss << "Spot light description not found." << std::endl;
-        (*err) += ss.str();
+        (*err) += "`textures' does not contain an JSON object.";
       }
       return false;
     }
+    Texture texture;
+    if (!ParseTexture(&texture, err, o,
+                      store_original_json_for_extras_and_extensions_,
+                      base_dir)) {
+      return false;
+    }
 
-    const detail::json &v = detail::GetValue(spotIt);
-    if (!detail::IsObject(v)) {
+    model->textures.emplace_back(std::move(texture));
+    return true;
+  };
+
+  auto parse_animation = [&](const detail::json &o) {
+    if (!detail::IsObject(o)) {
       if (err) {
-        std::stringstream ss;
-        ss << "\"spot\" is not a JSON object." << std::endl;
-        (*err) += ss.str();
+        (*err) += "`animations' does not contain an JSON object.";
       }
       return false;
     }
-
-    if (!ParseSpotLight(&light->spot, err, v,
-                        store_original_json_for_extras_and_extensions)) {
+    Animation animation;
+    if (filter.skip_sections & SKIP_ANIMATIONS) {
+      ParseStringProperty(&animation.name, err, o, "name", false);
+      model->animations.emplace_back(std::move(animation));
+      return true;
+    }
+    if (!ParseAnimation(&animation, err, o,
+                        store_original_json_for_extras_and_extensions_)) {
       return false;
     }
-  }
-
-  ParseStringProperty(&light->name, err, o, "name", false);
-  ParseNumberArrayProperty(&light->color, err, o, "color", false);
-  ParseNumberProperty(&light->range, err, o, "range", false);
-  ParseNumberProperty(&light->intensity, err, o, "intensity", false);
-
-  ParseExtrasAndExtensions(light, err, o,
-                           store_original_json_for_extras_and_extensions);
-
-  return true;
-}
-
-static bool ParsePositionalEmitter(
-    PositionalEmitter *positional, std::string *err, const detail::json &o,
-    bool store_original_json_for_extras_and_extensions) {
-  ParseNumberProperty(&positional->coneInnerAngle, err, o, "coneInnerAngle",
-                      false);
-  ParseNumberProperty(&positional->coneOuterAngle, err, o, "coneOuterAngle",
-                      false);
-  ParseNumberProperty(&positional->coneOuterGain, err, o, "coneOuterGain",
-                      false);
-  ParseNumberProperty(&positional->maxDistance, err, o, "maxDistance", false);
-  ParseNumberProperty(&positional->refDistance, err, o, "refDistance", false);
-  ParseNumberProperty(&positional->rolloffFactor, err, o, "rolloffFactor",
-                      false);
-
-  ParseExtrasAndExtensions(positional, err, o,
-                           store_original_json_for_extras_and_extensions);
-
-  return true;
-}
 
-static bool ParseAudioEmitter(
-    AudioEmitter *emitter, std::string *err, const detail::json &o,
-    bool store_original_json_for_extras_and_extensions) {
-  if (!ParseStringProperty(&emitter->type, err, o, "type", true)) {
-    return false;
-  }
+    model->animations.emplace_back(std::move(animation));
+    return true;
+  };
 
-  if (emitter->type == "positional") {
-    detail::json_const_iterator positionalIt;
-    if (!detail::FindMember(o, "positional", positionalIt)) {
+  size_t skin_idx = 0;
+  auto parse_skin = [&](const detail::json &o) {
+    if (!detail::IsObject(o)) {
       if (err) {
-        std::stringstream ss;
-        ss << "Positional emitter description not found." << std::endl;
-        (*err) += ss.str();
+        (*err) += "`skins' does not contain an JSON object.";
       }
       return false;
     }
+    Skin skin;
+    const bool keep =
+        !(filter.skip_sections & SKIP_SKINS) &&
+        (filter_scene == -1 || detail::IsUsed(skin_used, skin_idx));
+    ++skin_idx;
+    if (!keep) {
+      ParseStringProperty(&skin.name, err, o, "name", false);
+      model->skins.emplace_back(std::move(skin));
+      return true;
+    }
+    if (!ParseSkin(&skin, err, o,
+                   store_original_json_for_extras_and_extensions_)) {
+      return false;
+    }
 
-    const detail::json &v = detail::GetValue(positionalIt);
-    if (!detail::IsObject(v)) {
+    model->skins.emplace_back(std::move(skin));
+    return true;
+  };
+
+  auto parse_sampler = [&](const detail::json &o) {
+    if (!detail::IsObject(o)) {
       if (err) {
-        std::stringstream ss;
-        ss << "\"positional\" is not a JSON object." << std::endl;
-        (*err) += ss.str();
+        (*err) += "`samplers' does not contain an JSON object.";
       }
       return false;
     }
-
-    if (!ParsePositionalEmitter(
-            &emitter->positional, err, v,
-            store_original_json_for_extras_and_extensions)) {
+    Sampler sampler;
+    if (!ParseSampler(&sampler, err, o,
+                      store_original_json_for_extras_and_extensions_)) {
       return false;
     }
-  }
-
-  ParseStringProperty(&emitter->name, err, o, "name", false);
-  ParseNumberProperty(&emitter->gain, err, o, "gain", false);
-  ParseBooleanProperty(&emitter->loop, err, o, "loop", false);
-  ParseBooleanProperty(&emitter->playing, err, o, "playing", false);
-  ParseStringProperty(&emitter->distanceModel, err, o, "distanceModel", false);
-  ParseIntegerProperty(&emitter->source, err, o, "source", true);
-
-  ParseExtrasAndExtensions(emitter, err, o,
-                           store_original_json_for_extras_and_extensions);
-
-  return true;
-}
-
-static bool ParseAudioSource(
-    AudioSource *source, std::string *err, const detail::json &o,
-    bool store_original_json_for_extras_and_extensions) {
-  ParseStringProperty(&source->name, err, o, "name", false);
-  ParseStringProperty(&source->uri, err, o, "uri", false);
 
-  if (source->uri.empty()) {
-    ParseIntegerProperty(&source->bufferView, err, o, "bufferView", true);
-    ParseStringProperty(&source->mimeType, err, o, "mimeType", true);
-  }
-
-  ParseExtrasAndExtensions(source, err, o,
-                           store_original_json_for_extras_and_extensions);
-
-  return true;
-}
-
-namespace detail {
+    model->samplers.emplace_back(std::move(sampler));
+    return true;
+  };
 
-template <typename Callback>
-bool ForEachInArray(const detail::json &_v, const char *member, Callback &&cb) {
-  detail::json_const_iterator itm;
-  if (detail::FindMember(_v, member, itm) &&
-      detail::IsArray(detail::GetValue(itm))) {
-    const detail::json &root = detail::GetValue(itm);
-    auto it = detail::ArrayBegin(root);
-    auto end = detail::ArrayEnd(root);
-    for (; it != end; ++it) {
-      if (!cb(*it)) return false;
+  auto parse_camera = [&](const detail::json &o) {
+    if (!detail::IsObject(o)) {
+      if (err) {
+        (*err) += "`cameras' does not contain an JSON object.";
+      }
+      return false;
+    }
+    Camera camera;
+    if (!ParseCamera(&camera, err, o,
+                     store_original_json_for_extras_and_extensions_)) {
+      return false;
     }
-  }
-  return true;
-};
 
-}  // end of namespace detail
+    model->cameras.emplace_back(std::move(camera));
+    return true;
+  };
 
-bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
-                              const char *json_str,
-                              unsigned int json_str_length,
-                              const std::string &base_dir,
-                              unsigned int check_sections) {
-  if (json_str_length < 4) {
-    if (err) {
-      (*err) = "JSON string too short.\n";
+  // Meshes and skins depend on the filtered scene, so they are streamed only
+  // without one.
+  std::vector<detail::StreamedSection> sections;
+  if (streaming_parse_) {
+    sections = {{"buffers", parse_buffer},
+                {"bufferViews", parse_buffer_view},
+                {"accessors", parse_accessor},
+                {"nodes", parse_node},
+                {"scenes", parse_scene},
+                {"materials", parse_material},
+                {"images", parse_image},
+                {"textures", parse_texture},
+                {"animations", parse_animation},
+                {"samplers", parse_sampler},
+                {"cameras", parse_camera}};
+    if (filter_scene == -1) {
+      sections.emplace_back("meshes", parse_mesh);
+      sections.emplace_back("skins", parse_skin);
     }
-    return false;
   }
 
   detail::JsonDocument v;
@@ -5883,8 +9930,10 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
      defined(_CPPUNWIND)) &&                               \
     !defined(TINYGLTF_NOEXCEPTION)
   try {
-    detail::JsonParse(v, json_str, json_str_length, true);
-
+    if (!detail::JsonParseStreaming(v, json_str, json_str_length, &sections,
+                                    true)) {
+      return false;  // A converter failed and set `err`.
+    }
   } catch (const std::exception &e) {
     if (err) {
       (*err) = e.what();
@@ -5893,7 +9942,10 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
   }
 #else
   {
-    detail::JsonParse(v, json_str, json_str_length);
+    if (!detail::JsonParseStreaming(v, json_str, json_str_length,
+                                    &sections)) {
+      return false;  // A converter failed and set `err`.
+    }
 
     if (!detail::IsObject(v)) {
       // Assume parsing was failed.
@@ -5939,8 +9991,13 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
   // scene is not mandatory.
   // FIXME Maybe a better way to handle it than removing the code
 
-  auto IsArrayMemberPresent = [](const detail::json &_v,
-                                 const char *name) -> bool {
+  auto IsArrayMemberPresent = [&](const detail::json &_v,
+                                  const char *name) -> bool {
+    for (const detail::StreamedSection &section : sections) {
+      if (section.seen && strcmp(section.name, name) == 0) {
+        return true;
+      }
+    }
     detail::json_const_iterator it;
     return detail::FindMember(_v, name, it) &&
            detail::IsArray(detail::GetValue(it));
@@ -5995,17 +10052,6 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
     }
   }
 
-  model->buffers.clear();
-  model->bufferViews.clear();
-  model->accessors.clear();
-  model->meshes.clear();
-  model->cameras.clear();
-  model->nodes.clear();
-  model->extensionsUsed.clear();
-  model->extensionsRequired.clear();
-  model->extensions.clear();
-  model->defaultScene = -1;
-
   // 1. Parse Asset
   {
     detail::json_const_iterator it;
@@ -6018,8 +10064,6 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
     }
   }
 
-  using detail::ForEachInArray;
-
   // 2. Parse extensionUsed
   {
     ForEachInArray(v, "extensionsUsed", [&](const detail::json &o) {
@@ -6031,34 +10075,17 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
   }
 
   {
-    ForEachInArray(v, "extensionsRequired", [&](const detail::json &o) {
-      std::string str;
-      detail::GetString(o, str);
-      model->extensionsRequired.emplace_back(std::move(str));
-      return true;
-    });
-  }
-
-  // 3. Parse Buffer
-  {
-    bool success = ForEachInArray(v, "buffers", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`buffers' does not contain an JSON object.";
-        }
-        return false;
-      }
-      Buffer buffer;
-      if (!ParseBuffer(&buffer, err, o,
-                       store_original_json_for_extras_and_extensions_, &fs,
-                       &uri_cb, base_dir, max_external_file_size_, is_binary_,
-                       bin_data_, bin_size_)) {
-        return false;
-      }
-
-      model->buffers.emplace_back(std::move(buffer));
+    ForEachInArray(v, "extensionsRequired", [&](const detail::json &o) {
+      std::string str;
+      detail::GetString(o, str);
+      model->extensionsRequired.emplace_back(std::move(str));
       return true;
     });
+  }
+
+  // 3. Parse Buffer
+  {
+    bool success = ConsumeArray(v, "buffers", parse_buffer);
 
     if (!success) {
       return false;
@@ -6066,77 +10093,85 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
   }
   // 4. Parse BufferView
   {
-    bool success = ForEachInArray(v, "bufferViews", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`bufferViews' does not contain an JSON object.";
-        }
-        return false;
-      }
-      BufferView bufferView;
-      if (!ParseBufferView(&bufferView, err, o,
-                           store_original_json_for_extras_and_extensions_)) {
-        return false;
-      }
-
-      model->bufferViews.emplace_back(std::move(bufferView));
-      return true;
-    });
+    bool success = ConsumeArray(v, "bufferViews", parse_buffer_view);
 
     if (!success) {
       return false;
     }
+
+    if (!skip_buffers && !detail::DecodeMeshoptBufferViews(model, err)) {
+      return false;
+    }
   }
 
   // 5. Parse Accessor
   {
-    bool success = ForEachInArray(v, "accessors", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`accessors' does not contain an JSON object.";
-        }
-        return false;
-      }
-      Accessor accessor;
-      if (!ParseAccessor(&accessor, err, o,
-                         store_original_json_for_extras_and_extensions_)) {
-        return false;
-      }
+    bool success = ConsumeArray(v, "accessors", parse_accessor);
 
-      model->accessors.emplace_back(std::move(accessor));
-      return true;
-    });
+    if (!success) {
+      return false;
+    }
+  }
+
+  // 6. Parse Node
+  {
+    bool success = ConsumeArray(v, "nodes", parse_node);
 
     if (!success) {
       return false;
     }
   }
 
-  // 6. Parse Mesh
+  // 7. Parse scenes.
   {
-    bool success = ForEachInArray(v, "meshes", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`meshes' does not contain an JSON object.";
-        }
-        return false;
-      }
-      Mesh mesh;
-      if (!ParseMesh(&mesh, model, err, warn, o,
-                     store_original_json_for_extras_and_extensions_,
-                     strictness_)) {
-        return false;
+    bool success = ConsumeArray(v, "scenes", parse_scene);
+
+    if (!success) {
+      return false;
+    }
+  }
+
+  // 8. Parse default scenes.
+  {
+    detail::json_const_iterator rootIt;
+    int iVal;
+    if (detail::FindMember(v, "scene", rootIt) &&
+        detail::GetInt(detail::GetValue(rootIt), iVal)) {
+      model->defaultScene = iVal;
+    }
+  }
+
+  if (filter_scene != -1) {
+    if (filter_scene == LoadFilter::kDefaultScene) {
+      filter_scene = (model->defaultScene >= 0) ? model->defaultScene : 0;
+    }
+    if (filter_scene < 0 || size_t(filter_scene) >= model->scenes.size()) {
+      if (err) {
+        (*err) += "LoadFilter scene " + std::to_string(filter_scene) +
+                  " not found.\n";
       }
+      return false;
+    }
+    detail::MarkSceneNodes(*model, filter_scene, &node_used, &mesh_used,
+                           &skin_used);
+  }
 
-      model->meshes.emplace_back(std::move(mesh));
-      return true;
-    });
+  // 9. Parse Mesh
+  {
+    bool success = ConsumeArray(v, "meshes", parse_mesh);
 
     if (!success) {
       return false;
     }
   }
 
+#ifdef TINYGLTF_ENABLE_DRACO
+  if (!skip_buffers) {
+    detail::DecodeDracoPrimitives(model, warn, strictness_,
+                                  draco_decoding_threads_);
+  }
+#endif
+
   // Assign missing bufferView target types
   // - Look for missing Mesh indices
   // - Look for missing Mesh attributes
@@ -6197,191 +10232,114 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
     }
   }
 
-  // 7. Parse Node
+  // 10. Parse Material
   {
-    bool success = ForEachInArray(v, "nodes", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`nodes' does not contain an JSON object.";
-        }
-        return false;
-      }
-      Node node;
-      if (!ParseNode(&node, err, o,
-                     store_original_json_for_extras_and_extensions_)) {
-        return false;
-      }
-
-      model->nodes.emplace_back(std::move(node));
-      return true;
-    });
+    bool success = ConsumeArray(v, "materials", parse_material);
 
     if (!success) {
       return false;
     }
   }
 
-  // 8. Parse scenes.
+  // 11. Parse Image
   {
-    bool success = ForEachInArray(v, "scenes", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`scenes' does not contain an JSON object.";
-        }
-        return false;
-      }
-
-      Scene scene;
-      if (!ParseScene(&scene, err, o,
-                      store_original_json_for_extras_and_extensions_)) {
-        return false;
-      }
-
-      model->scenes.emplace_back(std::move(scene));
-      return true;
-    });
+    bool success = ConsumeArray(v, "images", parse_image);
 
     if (!success) {
       return false;
     }
-  }
-
-  // 9. Parse default scenes.
-  {
-    detail::json_const_iterator rootIt;
-    int iVal;
-    if (detail::FindMember(v, "scene", rootIt) &&
-        detail::GetInt(detail::GetValue(rootIt), iVal)) {
-      model->defaultScene = iVal;
-    }
-  }
 
-  // 10. Parse Material
-  {
-    bool success = ForEachInArray(v, "materials", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
+    // Images in bufferViews are decoded once every buffer is loaded; a
+    // streaming parse may see "images" before "buffers" or "bufferViews".
+    for (size_t i = image_offset; i < model->images.size(); i++) {
+      Image &image = model->images[i];
+      const int idx = int(i - image_offset);
+      if (image.bufferView == -1 || (filter.skip_sections & SKIP_IMAGES)) {
+        continue;
+      }
+      if (size_t(image.bufferView) >= model->bufferViews.size()) {
         if (err) {
-          (*err) += "`materials' does not contain an JSON object.";
+          std::stringstream ss;
+          ss << "image[" << idx << "] bufferView \"" << image.bufferView
+             << "\" not found in the scene." << std::endl;
+          (*err) += ss.str();
         }
         return false;
       }
-      Material material;
-      ParseStringProperty(&material.name, err, o, "name", false);
-
-      if (!ParseMaterial(&material, err, warn, o,
-                         store_original_json_for_extras_and_extensions_,
-                         strictness_)) {
-        return false;
-      }
-
-      model->materials.emplace_back(std::move(material));
-      return true;
-    });
-
-    if (!success) {
-      return false;
-    }
-  }
-
-  // 11. Parse Image
-  void *load_image_user_data{nullptr};
-
-  LoadImageDataOption load_image_option;
-
-  if (user_image_loader_) {
-    // Use user supplied pointer
-    load_image_user_data = load_image_user_data_;
-  } else {
-    load_image_option.preserve_channels = preserve_image_channels_;
-    load_image_user_data = reinterpret_cast<void *>(&load_image_option);
-  }
 
-  {
-    int idx = 0;
-    bool success = ForEachInArray(v, "images", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
+      const BufferView &bufferView =
+          model->bufferViews[size_t(image.bufferView)];
+      if (size_t(bufferView.buffer) >= model->buffers.size()) {
         if (err) {
-          (*err) += "image[" + std::to_string(idx) + "] is not a JSON object.";
+          std::stringstream ss;
+          ss << "image[" << idx << "] buffer \"" << bufferView.buffer
+             << "\" not found in the scene." << std::endl;
+          (*err) += ss.str();
         }
         return false;
       }
-      Image image;
-      if (!ParseImage(&image, idx, err, warn, o,
-                      store_original_json_for_extras_and_extensions_, base_dir,
-                      max_external_file_size_, &fs, &uri_cb,
-                      &this->LoadImageData, load_image_user_data)) {
-        return false;
-      }
-
-      if (image.bufferView != -1) {
-        // Load image from the buffer view.
-        if (size_t(image.bufferView) >= model->bufferViews.size()) {
-          if (err) {
-            std::stringstream ss;
-            ss << "image[" << idx << "] bufferView \"" << image.bufferView
-               << "\" not found in the scene." << std::endl;
-            (*err) += ss.str();
-          }
-          return false;
-        }
-
-        const BufferView &bufferView =
-            model->bufferViews[size_t(image.bufferView)];
-        if (size_t(bufferView.buffer) >= model->buffers.size()) {
-          if (err) {
-            std::stringstream ss;
-            ss << "image[" << idx << "] buffer \"" << bufferView.buffer
-               << "\" not found in the scene." << std::endl;
-            (*err) += ss.str();
-          }
-          return false;
-        }
-        const Buffer &buffer = model->buffers[size_t(bufferView.buffer)];
+      const Buffer &buffer = model->buffers[size_t(bufferView.buffer)];
 
-        if (*LoadImageData == nullptr) {
-          if (err) {
-            (*err) += "No LoadImageData callback specified.\n";
-          }
-          return false;
+      if (lazy_image_loading_ || skip_buffers) {
+        // Decoded later by DecodeImage(), or no buffer data to decode.
+      } else if (*LoadImageData == nullptr) {
+        if (err) {
+          (*err) += "No LoadImageData callback specified.\n";
         }
+        return false;
+      } else if (defer_decode) {
+        ImageDecodeTask task;
+        task.image_idx = idx;
+        task.bytes = buffer.Data() + bufferView.byteOffset;
+        task.size = bufferView.byteLength;
+        task.req_width = image.width;
+        task.req_height = image.height;
+        decode_tasks.emplace_back(std::move(task));
+      } else {
         bool ret = LoadImageData(
             &image, idx, err, warn, image.width, image.height,
-            &buffer.data[bufferView.byteOffset],
+            buffer.Data() + bufferView.byteOffset,
             static_cast<int>(bufferView.byteLength), load_image_user_data);
         if (!ret) {
           return false;
         }
       }
-
-      model->images.emplace_back(std::move(image));
-      ++idx;
-      return true;
-    });
-
-    if (!success) {
-      return false;
     }
-  }
 
-  // 12. Parse Texture
-  {
-    bool success = ForEachInArray(v, "textures", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
+    if (!decode_tasks.empty()) {
+      if (*LoadImageData == nullptr) {
         if (err) {
-          (*err) += "`textures' does not contain an JSON object.";
+          (*err) += "No LoadImageData callback specified.\n";
         }
         return false;
       }
-      Texture texture;
-      if (!ParseTexture(&texture, err, o,
-                        store_original_json_for_extras_and_extensions_,
-                        base_dir)) {
-        return false;
+
+      // Each task writes only its own Image and messages, so results don't
+      // depend on scheduling.
+      detail::ParallelFor(
+          decode_tasks.size(), ctx.image_threads, [&](size_t i) {
+            ImageDecodeTask &t = decode_tasks[i];
+            const unsigned char *bytes = t.bytes ? t.bytes : t.data.data();
+            t.ret = LoadImageData(
+                &model->images[image_offset + size_t(t.image_idx)],
+                t.image_idx, &t.err, &t.warn, t.req_width, t.req_height,
+                bytes, static_cast<int>(t.size), load_image_user_data);
+            std::vector<unsigned char>().swap(t.data);
+          });
+
+      for (const ImageDecodeTask &t : decode_tasks) {
+        if (warn) (*warn) += t.warn;
+        if (err) (*err) += t.err;
+        if (!t.ret) {
+          return false;
+        }
       }
+    }
+  }
 
-      model->textures.emplace_back(std::move(texture));
-      return true;
-    });
+  // 12. Parse Texture
+  {
+    bool success = ConsumeArray(v, "textures", parse_texture);
 
     if (!success) {
       return false;
@@ -6390,22 +10348,7 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
 
   // 13. Parse Animation
   {
-    bool success = ForEachInArray(v, "animations", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`animations' does not contain an JSON object.";
-        }
-        return false;
-      }
-      Animation animation;
-      if (!ParseAnimation(&animation, err, o,
-                          store_original_json_for_extras_and_extensions_)) {
-        return false;
-      }
-
-      model->animations.emplace_back(std::move(animation));
-      return true;
-    });
+    bool success = ConsumeArray(v, "animations", parse_animation);
 
     if (!success) {
       return false;
@@ -6414,46 +10357,43 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
 
   // 14. Parse Skin
   {
-    bool success = ForEachInArray(v, "skins", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`skins' does not contain an JSON object.";
-        }
-        return false;
-      }
-      Skin skin;
-      if (!ParseSkin(&skin, err, o,
-                     store_original_json_for_extras_and_extensions_)) {
-        return false;
-      }
-
-      model->skins.emplace_back(std::move(skin));
-      return true;
-    });
+    bool success = ConsumeArray(v, "skins", parse_skin);
 
     if (!success) {
       return false;
     }
   }
 
-  // 15. Parse Sampler
-  {
-    bool success = ForEachInArray(v, "samplers", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`samplers' does not contain an JSON object.";
+  // Nodes and scenes outside the filtered scene are reduced to their names,
+  // except the joints of kept skins.
+  if (filter_scene != -1) {
+    for (size_t i = 0; i < model->skins.size(); i++) {
+      if (detail::IsUsed(skin_used, i)) {
+        for (int joint : model->skins[i].joints) {
+          detail::MarkUsed(&node_used, joint);
         }
-        return false;
+        detail::MarkUsed(&node_used, model->skins[i].skeleton);
       }
-      Sampler sampler;
-      if (!ParseSampler(&sampler, err, o,
-                        store_original_json_for_extras_and_extensions_)) {
-        return false;
+    }
+    for (size_t i = 0; i < model->nodes.size(); i++) {
+      if (!detail::IsUsed(node_used, i)) {
+        Node node;
+        node.name = std::move(model->nodes[i].name);
+        model->nodes[i] = std::move(node);
       }
+    }
+    for (size_t i = 0; i < model->scenes.size(); i++) {
+      if (int(i) != filter_scene) {
+        Scene scene;
+        scene.name = std::move(model->scenes[i].name);
+        model->scenes[i] = std::move(scene);
+      }
+    }
+  }
 
-      model->samplers.emplace_back(std::move(sampler));
-      return true;
-    });
+  // 15. Parse Sampler
+  {
+    bool success = ConsumeArray(v, "samplers", parse_sampler);
 
     if (!success) {
       return false;
@@ -6462,22 +10402,7 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
 
   // 16. Parse Camera
   {
-    bool success = ForEachInArray(v, "cameras", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`cameras' does not contain an JSON object.";
-        }
-        return false;
-      }
-      Camera camera;
-      if (!ParseCamera(&camera, err, o,
-                       store_original_json_for_extras_and_extensions_)) {
-        return false;
-      }
-
-      model->cameras.emplace_back(std::move(camera));
-      return true;
-    });
+    bool success = ConsumeArray(v, "cameras", parse_camera);
 
     if (!success) {
       return false;
@@ -6568,25 +10493,94 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
     }
   }
 
-  return true;
+  return true;
+}
+
+bool TinyGLTF::DecodeImage(Model *model, int image_idx, std::string *err,
+                           std::string *warn) const {
+  if ((image_idx < 0) || (size_t(image_idx) >= model->images.size())) {
+    if (err) {
+      (*err) += "Invalid image index " + std::to_string(image_idx) + "\n";
+    }
+    return false;
+  }
+
+  Image &image = model->images[size_t(image_idx)];
+  if (image.IsDecoded()) {
+    return true;
+  }
+
+  const unsigned char *bytes = nullptr;
+  size_t size = 0;
+  int req_width = 0;
+  int req_height = 0;
+  if (!image.encoded.empty()) {
+    bytes = image.encoded.data();
+    size = image.encoded.size();
+  } else if (image.bufferView != -1) {
+    if (size_t(image.bufferView) >= model->bufferViews.size()) {
+      if (err) {
+        (*err) += "image[" + std::to_string(image_idx) + "] bufferView \"" +
+                  std::to_string(image.bufferView) +
+                  "\" not found in the scene.\n";
+      }
+      return false;
+    }
+    const BufferView &bufferView = model->bufferViews[size_t(image.bufferView)];
+    if ((size_t(bufferView.buffer) >= model->buffers.size()) ||
+        (bufferView.byteOffset + bufferView.byteLength >
+         model->buffers[size_t(bufferView.buffer)].Size())) {
+      if (err) {
+        (*err) += "image[" + std::to_string(image_idx) +
+                  "] bufferView points outside of its buffer.\n";
+      }
+      return false;
+    }
+    bytes = model->buffers[size_t(bufferView.buffer)].Data() +
+            bufferView.byteOffset;
+    size = bufferView.byteLength;
+    req_width = image.width;
+    req_height = image.height;
+  } else {
+    if (err) {
+      (*err) += "image[" + std::to_string(image_idx) + "] name = \"" +
+                image.name + "\" has no encoded data to decode.\n";
+    }
+    return false;
+  }
+
+  if (*LoadImageData == nullptr) {
+    if (err) {
+      (*err) += "No LoadImageData callback specified.\n";
+    }
+    return false;
+  }
+
+  void *load_image_user_data{nullptr};
+  LoadImageDataOption load_image_option;
+  if (user_image_loader_) {
+    load_image_user_data = load_image_user_data_;
+  } else {
+    load_image_option.preserve_channels = preserve_image_channels_;
+    load_image_user_data = reinterpret_cast<void *>(&load_image_option);
+  }
+
+  return LoadImageData(&image, image_idx, err, warn, req_width, req_height,
+                       bytes, static_cast<int>(size), load_image_user_data);
 }
 
 bool TinyGLTF::LoadASCIIFromString(Model *model, std::string *err,
                                    std::string *warn, const char *str,
                                    unsigned int length,
                                    const std::string &base_dir,
-                                   unsigned int check_sections) {
-  is_binary_ = false;
-  bin_data_ = nullptr;
-  bin_size_ = 0;
-
+                                   unsigned int check_sections) const {
   return LoadFromString(model, err, warn, str, length, base_dir,
-                        check_sections);
+                        check_sections, NewLoadContext());
 }
 
 bool TinyGLTF::LoadASCIIFromFile(Model *model, std::string *err,
                                  std::string *warn, const std::string &filename,
-                                 unsigned int check_sections) {
+                                 unsigned int check_sections) const {
   std::stringstream ss;
 
   if (fs.ReadWholeFile == nullptr) {
@@ -6599,9 +10593,9 @@ bool TinyGLTF::LoadASCIIFromFile(Model *model, std::string *err,
     return false;
   }
 
-  std::vector<unsigned char> data;
+  detail::FileBytes data;
   std::string fileerr;
-  bool fileread = fs.ReadWholeFile(&data, &fileerr, filename, fs.user_data);
+  bool fileread = data.Read(&fileerr, filename, &fs);
   if (!fileread) {
     ss << "Failed to read file: " << filename << ": " << fileerr << std::endl;
     if (err) {
@@ -6610,7 +10604,7 @@ bool TinyGLTF::LoadASCIIFromFile(Model *model, std::string *err,
     return false;
   }
 
-  size_t sz = data.size();
+  size_t sz = data.size;
   if (sz == 0) {
     if (err) {
       (*err) = "Empty file.";
@@ -6621,8 +10615,8 @@ bool TinyGLTF::LoadASCIIFromFile(Model *model, std::string *err,
   std::string basedir = GetBaseDir(filename);
 
   bool ret = LoadASCIIFromString(
-      model, err, warn, reinterpret_cast<const char *>(&data.at(0)),
-      static_cast<unsigned int>(data.size()), basedir, check_sections);
+      model, err, warn, reinterpret_cast<const char *>(data.data),
+      static_cast<unsigned int>(sz), basedir, check_sections);
 
   return ret;
 }
@@ -6632,7 +10626,15 @@ bool TinyGLTF::LoadBinaryFromMemory(Model *model, std::string *err,
                                     const unsigned char *bytes,
                                     unsigned int size,
                                     const std::string &base_dir,
-                                    unsigned int check_sections) {
+                                    unsigned int check_sections) const {
+  return LoadBinary(model, err, warn, bytes, size, base_dir, check_sections,
+                    NewLoadContext());
+}
+
+bool TinyGLTF::LoadBinary(Model *model, std::string *err, std::string *warn,
+                          const unsigned char *bytes, unsigned int size,
+                          const std::string &base_dir,
+                          unsigned int check_sections, LoadContext ctx) const {
   if (size < 20) {
     if (err) {
       (*err) = "Too short data size for glTF Binary.";
@@ -6705,8 +10707,8 @@ bool TinyGLTF::LoadBinaryFromMemory(Model *model, std::string *err,
   // other means, this chunk SHOULD be omitted. So when header + JSON data ==
   // binary size, Chunk1 is omitted.
   if (header_and_json_size == uint64_t(length)) {
-    bin_data_ = nullptr;
-    bin_size_ = 0;
+    ctx.bin_data = nullptr;
+    ctx.bin_size = 0;
   } else {
     // Read Chunk1 info(BIN data)
     // At least Chunk1 should have 12 bytes(8 bytes(header) + 4 bytes(bin
@@ -6769,17 +10771,18 @@ bool TinyGLTF::LoadBinaryFromMemory(Model *model, std::string *err,
 
     // std::cout << "chunk1_length = " << chunk1_length << "\n";
 
-    bin_data_ = bytes + header_and_json_size +
-                8;  // 4 bytes (bin_buffer_length) + 4 bytes(bin_buffer_format)
+    ctx.bin_data =
+        bytes + header_and_json_size +
+        8;  // 4 bytes (bin_buffer_length) + 4 bytes(bin_buffer_format)
 
-    bin_size_ = size_t(chunk1_length);
+    ctx.bin_size = size_t(chunk1_length);
   }
 
-  is_binary_ = true;
+  ctx.is_binary = true;
 
   bool ret = LoadFromString(model, err, warn,
                             reinterpret_cast<const char *>(&bytes[20]),
-                            chunk0_length, base_dir, check_sections);
+                            chunk0_length, base_dir, check_sections, ctx);
   if (!ret) {
     return ret;
   }
@@ -6790,7 +10793,7 @@ bool TinyGLTF::LoadBinaryFromMemory(Model *model, std::string *err,
 bool TinyGLTF::LoadBinaryFromFile(Model *model, std::string *err,
                                   std::string *warn,
                                   const std::string &filename,
-                                  unsigned int check_sections) {
+                                  unsigned int check_sections) const {
   std::stringstream ss;
 
   if (fs.ReadWholeFile == nullptr) {
@@ -6803,9 +10806,9 @@ bool TinyGLTF::LoadBinaryFromFile(Model *model, std::string *err,
     return false;
   }
 
-  std::vector<unsigned char> data;
+  detail::FileBytes data;
   std::string fileerr;
-  bool fileread = fs.ReadWholeFile(&data, &fileerr, filename, fs.user_data);
+  bool fileread = data.Read(&fileerr, filename, &fs);
   if (!fileread) {
     ss << "Failed to read file: " << filename << ": " << fileerr << std::endl;
     if (err) {
@@ -6816,11 +10819,80 @@ bool TinyGLTF::LoadBinaryFromFile(Model *model, std::string *err,
 
   std::string basedir = GetBaseDir(filename);
 
-  bool ret = LoadBinaryFromMemory(model, err, warn, &data.at(0),
-                                  static_cast<unsigned int>(data.size()),
-                                  basedir, check_sections);
+  // `data` is released on return, so the BIN chunk can't be borrowed here.
+  LoadContext ctx = NewLoadContext();
+  ctx.borrow_binary_chunk = false;
 
-  return ret;
+  return LoadBinary(model, err, warn, data.data,
+                    static_cast<unsigned int>(data.size), basedir,
+                    check_sections, ctx);
+}
+
+bool TinyGLTF::LoadFromBytes(Model *model, std::string *err, std::string *warn,
+                             const unsigned char *bytes, size_t size,
+                             const std::string &base_dir,
+                             unsigned int check_sections,
+                             const LoadContext &ctx) const {
+  if (size > (std::numeric_limits<unsigned int>::max)()) {
+    if (err) {
+      (*err) = "File too large.\n";
+    }
+    return false;
+  }
+  if (size >= 4 && memcmp(bytes, "glTF", 4) == 0) {
+    return LoadBinary(model, err, warn, bytes, static_cast<unsigned int>(size),
+                      base_dir, check_sections, ctx);
+  }
+  return LoadFromString(model, err, warn, reinterpret_cast<const char *>(bytes),
+                        static_cast<unsigned int>(size), base_dir,
+                        check_sections, ctx);
+}
+
+bool TinyGLTF::LoadFromFiles(const std::vector<std::string> &filenames,
+                             int num_threads, std::vector<LoadResult> *results,
+                             unsigned int check_sections) const {
+  if (!results) {
+    return false;
+  }
+  results->clear();
+  results->resize(filenames.size());
+
+  LoadContext ctx = NewLoadContext();
+  // Each file is released once loaded, so its BIN chunk can't be borrowed.
+  ctx.borrow_binary_chunk = false;
+  if (num_threads > 1) {
+    // The files are the parallelism; threads per image set on top of that
+    // would only oversubscribe the cores.
+    ctx.image_threads = 1;
+  }
+
+  detail::ParallelFor(
+      filenames.size(), num_threads, [&](size_t i) {
+        LoadResult &result = (*results)[i];
+        const std::string &filename = filenames[i];
+        if (fs.ReadWholeFile == nullptr) {
+          result.err = "Failed to read file: " + filename +
+                       ": one or more FS callback not set\n";
+          return;
+        }
+        detail::FileBytes data;
+        std::string fileerr;
+        if (!data.Read(&fileerr, filename, &fs)) {
+          result.err =
+              "Failed to read file: " + filename + ": " + fileerr + "\n";
+          return;
+        }
+        result.ok = LoadFromBytes(&result.model, &result.err, &result.warn,
+                                  data.data, data.size, GetBaseDir(filename),
+                                  check_sections, ctx);
+      });
+
+  for (const LoadResult &result : *results) {
+    if (!result.ok) {
+      return false;
+    }
+  }
+  return true;
 }
 
 ///////////////////////
@@ -6986,7 +11058,7 @@ static bool ValueToJson(const Value &value, detail::json *ret) {
       break;
     case OBJECT_TYPE: {
       obj.SetObject();
-      Value::Object objMap = value.Get<Value::Object>();
+      const Value::Object &objMap = value.Get<Value::Object>();
       for (auto &it : objMap) {
         detail::json elementJson;
         if (ValueToJson(it.second, &elementJson)) {
@@ -7029,7 +11101,7 @@ static bool ValueToJson(const Value &value, detail::json *ret) {
       return false;
       break;
     case OBJECT_TYPE: {
-      Value::Object objMap = value.Get<Value::Object>();
+      const Value::Object &objMap = value.Get<Value::Object>();
       for (auto &it : objMap) {
         detail::json elementJson;
         if (ValueToJson(it.second, &elementJson)) obj[it.first] = elementJson;
@@ -7053,12 +11125,12 @@ static void SerializeValue(const std::string &key, const Value &value,
   }
 }
 
-static void SerializeGltfBufferData(const std::vector<unsigned char> &data,
+static void SerializeGltfBufferData(const unsigned char *data, size_t size,
                                     detail::json &o) {
   std::string header = "data:application/octet-stream;base64,";
-  if (data.size() > 0) {
+  if (size > 0) {
     std::string encodedData =
-        base64_encode(&data[0], static_cast<unsigned int>(data.size()));
+        base64_encode(data, static_cast<unsigned int>(size));
     SerializeStringProperty("uri", header + encodedData, o);
   } else {
     // Issue #229
@@ -7067,7 +11139,7 @@ static void SerializeGltfBufferData(const std::vector<unsigned char> &data,
   }
 }
 
-static bool SerializeGltfBufferData(const std::vector<unsigned char> &data,
+static bool SerializeGltfBufferData(const unsigned char *data, size_t size,
                                     const std::string &binFilename) {
 #ifdef _WIN32
 #if defined(__GLIBCXX__)  // mingw
@@ -7088,9 +11160,8 @@ static bool SerializeGltfBufferData(const std::vector<unsigned char> &data,
   std::ofstream output(binFilename.c_str(), std::ofstream::binary);
   if (!output.is_open()) return false;
 #endif
-  if (data.size() > 0) {
-    output.write(reinterpret_cast<const char *>(&data[0]),
-                 std::streamsize(data.size()));
+  if (size > 0) {
+    output.write(reinterpret_cast<const char *>(data), std::streamsize(size));
   } else {
     // Issue #229
     // size 0 will be still valid buffer data.
@@ -7349,19 +11420,136 @@ static void SerializeGltfAsset(const Asset &asset, detail::json &o) {
   SerializeExtrasAndExtensions(asset, o);
 }
 
-static void SerializeGltfBufferBin(const Buffer &buffer, detail::json &o,
-                                   std::vector<unsigned char> &binBuffer) {
-  SerializeNumberProperty("byteLength", buffer.data.size(), o);
-  binBuffer = buffer.data;
+static void SerializeGltfBufferBin(const Buffer &buffer, detail::json &o) {
+  SerializeNumberProperty("byteLength", buffer.Size(), o);
 
   if (buffer.name.size()) SerializeStringProperty("name", buffer.name, o);
 
   SerializeExtrasAndExtensions(buffer, o);
 }
 
-static void SerializeGltfBuffer(const Buffer &buffer, detail::json &o) {
-  SerializeNumberProperty("byteLength", buffer.data.size(), o);
-  SerializeGltfBufferData(buffer.data, o);
+namespace detail {
+
+// Serialized glTF JSON, plus buffers to base64 encode into it while it is
+// written out, so embedded buffers never exist as strings. Each buffer's
+// bytes replace the data URI marker at `pos` in `text`.
+struct JsonOutput {
+  struct Splice {
+    size_t pos;
+    size_t marker_size;
+    const unsigned char *data;
+    size_t size;
+  };
+  struct Pending {
+    std::string marker;
+    unsigned int index;  // In "buffers"
+    const Buffer *buffer;
+  };
+
+  std::string text;
+  std::vector<Splice> splices;   // Ordered by `pos`
+  std::vector<Pending> pending;  // Markers not located in `text` yet
+};
+
+size_t CountOccurrences(const std::string &text, const std::string &s) {
+  size_t count = 0;
+  for (size_t pos = text.find(s); pos != std::string::npos;
+       pos = text.find(s, pos + s.size())) {
+    count++;
+  }
+  return count;
+}
+
+// Dumps `doc` and locates the markers of `out->pending` in it. An unescaped
+// quote can't appear inside a JSON string, so the quoted marker only matches
+// a whole string. Should user data contain that exact string, the buffer's
+// real data URI is put in `doc` instead and it is dumped again.
+void FinishJsonOutput(detail::JsonDocument &doc, int spacing,
+                      JsonOutput *out) {
+  out->text = JsonToString(doc, spacing);
+  bool patched = false;
+  for (JsonOutput::Pending &p : out->pending) {
+    if (CountOccurrences(out->text, '"' + p.marker + '"') == 1) continue;
+    detail::json_iterator it;
+    if (!FindMember(doc, "buffers", it)) continue;
+#ifdef TINYGLTF_USE_RAPIDJSON
+    detail::json &o = GetValue(it)[rapidjson::SizeType(p.index)];
+#else
+    detail::json &o = GetValue(it)[p.index];
+#endif
+    SerializeStringProperty(
+        "uri",
+        "data:application/octet-stream;base64," +
+            base64_encode(p.buffer->Data(),
+                          static_cast<unsigned int>(p.buffer->Size())),
+        o);
+    p.buffer = nullptr;
+    patched = true;
+  }
+  if (patched) {
+    out->text = JsonToString(doc, spacing);
+  }
+
+  for (const JsonOutput::Pending &p : out->pending) {
+    if (!p.buffer) continue;  // Patched above
+    const size_t pos = out->text.find('"' + p.marker + '"');
+    JsonOutput::Splice splice = {pos + 1, p.marker.size(), p.buffer->Data(),
+                                 p.buffer->Size()};
+    out->splices.push_back(splice);
+  }
+  std::sort(out->splices.begin(), out->splices.end(),
+            [](const JsonOutput::Splice &a, const JsonOutput::Splice &b) {
+              return a.pos < b.pos;
+            });
+  out->pending.clear();
+}
+
+size_t JsonOutputSize(const JsonOutput &out) {
+  size_t size = out.text.size();
+  for (const JsonOutput::Splice &splice : out.splices) {
+    size += Base64Size(splice.size) - splice.marker_size;
+  }
+  return size;
+}
+
+void WriteJsonOutput(std::ostream &stream, const JsonOutput &out) {
+  // Whole 3-byte groups per chunk, so only the last one is padded.
+  const size_t kChunk = 3 * 16 * 1024;
+  std::vector<char> encoded;
+  size_t pos = 0;
+  for (const JsonOutput::Splice &splice : out.splices) {
+    stream.write(out.text.data() + pos, std::streamsize(splice.pos - pos));
+    const char *header = "data:application/octet-stream;base64,";
+    stream.write(header, std::streamsize(strlen(header)));
+    encoded.resize(Base64Size(kChunk));
+    for (size_t off = 0; off < splice.size; off += kChunk) {
+      const size_t n = (std::min)(kChunk, splice.size - off);
+      Base64Encode(splice.data + off, n, encoded.data());
+      stream.write(encoded.data(), std::streamsize(Base64Size(n)));
+    }
+    pos = splice.pos + splice.marker_size;
+  }
+  stream.write(out.text.data() + pos, std::streamsize(out.text.size() - pos));
+}
+
+}  // namespace detail
+
+// Embeds `buffer`, the `index`th in "buffers", as a data URI that is filled
+// in by WriteJsonOutput.
+static void SerializeGltfBuffer(const Buffer &buffer, unsigned int index,
+                                detail::json &o, detail::JsonOutput *out) {
+  SerializeNumberProperty("byteLength", buffer.Size(), o);
+  if (buffer.Size() == 0) {
+    SerializeGltfBufferData(buffer.Data(), buffer.Size(), o);
+  } else {
+    // Stands in for the whole data URI, header included.
+    detail::JsonOutput::Pending p;
+    p.marker = "#tinygltf-buffer-" + std::to_string(out->pending.size()) + "#";
+    p.index = index;
+    p.buffer = &buffer;
+    SerializeStringProperty("uri", p.marker, o);
+    out->pending.push_back(std::move(p));
+  }
 
   if (buffer.name.size()) SerializeStringProperty("name", buffer.name, o);
 
@@ -7371,8 +11559,9 @@ static void SerializeGltfBuffer(const Buffer &buffer, detail::json &o) {
 static bool SerializeGltfBuffer(const Buffer &buffer, detail::json &o,
                                 const std::string &binFilename,
                                 const std::string &binUri) {
-  if (!SerializeGltfBufferData(buffer.data, binFilename)) return false;
-  SerializeNumberProperty("byteLength", buffer.data.size(), o);
+  if (!SerializeGltfBufferData(buffer.Data(), buffer.Size(), binFilename))
+    return false;
+  SerializeNumberProperty("byteLength", buffer.Size(), o);
   SerializeStringProperty("uri", binUri, o);
 
   if (buffer.name.size()) SerializeStringProperty("name", buffer.name, o);
@@ -8206,13 +12395,15 @@ static void SerializeGltfModel(const Model *model, detail::json &o) {
   }
 }
 
-static bool WriteGltfStream(std::ostream &stream, const std::string &content) {
-  stream << content << std::endl;
+static bool WriteGltfStream(std::ostream &stream,
+                            const detail::JsonOutput &content) {
+  detail::WriteJsonOutput(stream, content);
+  stream << std::endl;
   return stream.good();
 }
 
 static bool WriteGltfFile(const std::string &output,
-                          const std::string &content) {
+                          const detail::JsonOutput &content) {
 #ifdef _WIN32
 #if defined(_MSC_VER)
   std::ofstream gltfFile(UTF8ToWchar(output).c_str());
@@ -8234,14 +12425,15 @@ static bool WriteGltfFile(const std::string &output,
   return WriteGltfStream(gltfFile, content);
 }
 
+// `bin` is written as is, never copied.
 static bool WriteBinaryGltfStream(std::ostream &stream,
-                                  const std::string &content,
-                                  const std::vector<unsigned char> &binBuffer) {
+                                  const detail::JsonOutput &content,
+                                  const unsigned char *bin, size_t bin_size) {
   const std::string header = "glTF";
   const int version = 2;
 
-  const uint32_t content_size = uint32_t(content.size());
-  const uint32_t binBuffer_size = uint32_t(binBuffer.size());
+  const uint32_t content_size = uint32_t(detail::JsonOutputSize(content));
+  const uint32_t binBuffer_size = uint32_t(bin_size);
   // determine number of padding bytes required to ensure 4 byte alignment
   const uint32_t content_padding_size =
       content_size % 4 == 0 ? 0 : 4 - content_size % 4;
@@ -8259,29 +12451,29 @@ static bool WriteBinaryGltfStream(std::ostream &stream,
   stream.write(reinterpret_cast<const char *>(&length), sizeof(length));
 
   // JSON chunk info, then JSON data
-  const uint32_t model_length = uint32_t(content.size()) + content_padding_size;
+  const uint32_t model_length = content_size + content_padding_size;
   const uint32_t model_format = 0x4E4F534A;
   stream.write(reinterpret_cast<const char *>(&model_length),
                sizeof(model_length));
   stream.write(reinterpret_cast<const char *>(&model_format),
                sizeof(model_format));
-  stream.write(content.c_str(), std::streamsize(content.size()));
+  detail::WriteJsonOutput(stream, content);
 
   // Chunk must be multiplies of 4, so pad with spaces
   if (content_padding_size > 0) {
     const std::string padding = std::string(size_t(content_padding_size), ' ');
     stream.write(padding.c_str(), std::streamsize(padding.size()));
   }
-  if (binBuffer.size() > 0) {
+  if (bin_size > 0) {
     // BIN chunk info, then BIN data
-    const uint32_t bin_length = uint32_t(binBuffer.size()) + bin_padding_size;
+    const uint32_t bin_length = binBuffer_size + bin_padding_size;
     const uint32_t bin_format = 0x004e4942;
     stream.write(reinterpret_cast<const char *>(&bin_length),
                  sizeof(bin_length));
     stream.write(reinterpret_cast<const char *>(&bin_format),
                  sizeof(bin_format));
-    stream.write(reinterpret_cast<const char *>(binBuffer.data()),
-                 std::streamsize(binBuffer.size()));
+    stream.write(reinterpret_cast<const char *>(bin),
+                 std::streamsize(bin_size));
     // Chunksize must be multiplies of 4, so pad with zeroes
     if (bin_padding_size > 0) {
       const std::vector<unsigned char> padding =
@@ -8296,8 +12488,8 @@ static bool WriteBinaryGltfStream(std::ostream &stream,
 }
 
 static bool WriteBinaryGltfFile(const std::string &output,
-                                const std::string &content,
-                                const std::vector<unsigned char> &binBuffer) {
+                                const detail::JsonOutput &content,
+                                const unsigned char *bin, size_t bin_size) {
 #ifdef _WIN32
 #if defined(_MSC_VER)
   std::ofstream gltfFile(UTF8ToWchar(output).c_str(), std::ios::binary);
@@ -8313,7 +12505,7 @@ static bool WriteBinaryGltfFile(const std::string &output,
 #else
   std::ofstream gltfFile(output.c_str(), std::ios::binary);
 #endif
-  return WriteBinaryGltfStream(gltfFile, content, binBuffer);
+  return WriteBinaryGltfStream(gltfFile, content, bin, bin_size);
 }
 
 bool TinyGLTF::WriteGltfSceneToStream(const Model *model, std::ostream &stream,
@@ -8325,16 +12517,20 @@ bool TinyGLTF::WriteGltfSceneToStream(const Model *model, std::ostream &stream,
   SerializeGltfModel(model, output);
 
   // BUFFERS
-  std::vector<unsigned char> binBuffer;
+  detail::JsonOutput content;
+  const unsigned char *bin = nullptr;
+  size_t bin_size = 0;
   if (model->buffers.size()) {
     detail::json buffers;
     detail::JsonReserveArray(buffers, model->buffers.size());
     for (unsigned int i = 0; i < model->buffers.size(); ++i) {
       detail::json buffer;
       if (writeBinary && i == 0 && model->buffers[i].uri.empty()) {
-        SerializeGltfBufferBin(model->buffers[i], buffer, binBuffer);
+        SerializeGltfBufferBin(model->buffers[i], buffer);
+        bin = model->buffers[i].Data();
+        bin_size = model->buffers[i].Size();
       } else {
-        SerializeGltfBuffer(model->buffers[i], buffer);
+        SerializeGltfBuffer(model->buffers[i], i, buffer, &content);
       }
       detail::JsonPushBack(buffers, std::move(buffer));
     }
@@ -8365,11 +12561,11 @@ bool TinyGLTF::WriteGltfSceneToStream(const Model *model, std::ostream &stream,
   }
 
   if (writeBinary) {
-    return WriteBinaryGltfStream(stream, detail::JsonToString(output),
-                                 binBuffer);
+    detail::FinishJsonOutput(output, -1, &content);
+    return WriteBinaryGltfStream(stream, content, bin, bin_size);
   } else {
-    return WriteGltfStream(stream,
-                           detail::JsonToString(output, prettyPrint ? 2 : -1));
+    detail::FinishJsonOutput(output, prettyPrint ? 2 : -1, &content);
+    return WriteGltfStream(stream, content);
   }
 }
 
@@ -8397,16 +12593,20 @@ bool TinyGLTF::WriteGltfSceneToFile(const Model *model,
 
   // BUFFERS
   std::vector<std::string> usedFilenames;
-  std::vector<unsigned char> binBuffer;
+  detail::JsonOutput content;
+  const unsigned char *bin = nullptr;
+  size_t bin_size = 0;
   if (model->buffers.size()) {
     detail::json buffers;
     detail::JsonReserveArray(buffers, model->buffers.size());
     for (unsigned int i = 0; i < model->buffers.size(); ++i) {
       detail::json buffer;
       if (writeBinary && i == 0 && model->buffers[i].uri.empty()) {
-        SerializeGltfBufferBin(model->buffers[i], buffer, binBuffer);
+        SerializeGltfBufferBin(model->buffers[i], buffer);
+        bin = model->buffers[i].Data();
+        bin_size = model->buffers[i].Size();
       } else if (embedBuffers) {
-        SerializeGltfBuffer(model->buffers[i], buffer);
+        SerializeGltfBuffer(model->buffers[i], i, buffer, &content);
       } else {
         std::string binSavePath;
         std::string binFilename;
@@ -8473,12 +12673,1070 @@ bool TinyGLTF::WriteGltfSceneToFile(const Model *model,
   }
 
   if (writeBinary) {
-    return WriteBinaryGltfFile(filename, detail::JsonToString(output),
-                               binBuffer);
+    detail::FinishJsonOutput(output, -1, &content);
+    return WriteBinaryGltfFile(filename, content, bin, bin_size);
   } else {
-    return WriteGltfFile(filename,
-                         detail::JsonToString(output, (prettyPrint ? 2 : -1)));
+    detail::FinishJsonOutput(output, prettyPrint ? 2 : -1, &content);
+    return WriteGltfFile(filename, content);
+  }
+}
+
+uint64_t HashBytes(const unsigned char *data, size_t size) {
+  // FNV-1a over 8-byte words with an extra shift per word, then the
+  // MurmurHash3 finalizer.
+  const uint64_t kPrime = 0x100000001b3ULL;
+  uint64_t h = 0xcbf29ce484222325ULL ^ uint64_t(size);
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t w;
+    memcpy(&w, data + i, sizeof(w));
+    h = (h ^ w) * kPrime;
+    h ^= h >> 29;
+  }
+  for (; i < size; i++) {
+    h = (h ^ data[i]) * kPrime;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+namespace detail {
+
+const char kSnapshotMagic[8] = {'T', 'G', 'L', 'T', 'F', 'S', 'N', 'P'};
+const uint32_t kSnapshotVersion = 2;
+const uint32_t kSnapshotByteOrder = 0x01020304;
+const size_t kSnapshotAlignment = 4096;
+
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;  // kSnapshotByteOrder as stored by the writer
+  uint64_t source_hash;
+  uint64_t size;  // Whole snapshot
+  uint64_t tables_offset;
+  uint64_t tables_size;
+  uint64_t data_offset;  // Blob offsets in the tables are relative to this
+};
+
+size_t AlignSnapshotOffset(size_t offset) {
+  return (offset + kSnapshotAlignment - 1) & ~(kSnapshotAlignment - 1);
+}
+
+// Writes the snapshot tables in host byte order. Sizes and counts are
+// 64-bit.
+class SnapshotWriter {
+ public:
+  explicit SnapshotWriter(std::vector<unsigned char> *out) : out_(out) {}
+
+  void Bytes(const void *data, size_t size) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    out_->insert(out_->end(), p, p + size);
+  }
+  template <typename T>
+  void Pod(const T &v) {
+    Bytes(&v, sizeof(T));
+  }
+  void Size(size_t n) { Pod(uint64_t(n)); }
+  void Bool(bool b) { Pod(uint8_t(b ? 1 : 0)); }
+  void Int(int v) { Pod(int32_t(v)); }
+  void Double(double v) { Pod(v); }
+  void String(const std::string &s) {
+    Size(s.size());
+    Bytes(s.data(), s.size());
+  }
+  template <typename T>
+  void PodArray(const std::vector<T> &v) {
+    Size(v.size());
+    if (!v.empty()) Bytes(v.data(), v.size() * sizeof(T));
+  }
+
+ private:
+  std::vector<unsigned char> *out_;
+};
+
+// Reads what SnapshotWriter wrote. Reads past the end, and counts the
+// remaining bytes can't hold, fail and leave ok() false for good.
+class SnapshotReader {
+ public:
+  SnapshotReader(const unsigned char *data, size_t size)
+      : p_(data), end_(data + size) {}
+
+  bool ok() const { return ok_; }
+  void Fail() { ok_ = false; }
+
+  bool Bytes(void *dst, size_t size) {
+    if (!ok_ || size > size_t(end_ - p_)) {
+      ok_ = false;
+      return false;
+    }
+    if (size) memcpy(dst, p_, size);
+    p_ += size;
+    return true;
+  }
+  template <typename T>
+  T Pod() {
+    T v = T();
+    Bytes(&v, sizeof(T));
+    return v;
+  }
+  size_t Size() {
+    const uint64_t n = Pod<uint64_t>();
+    if (n > (std::numeric_limits<size_t>::max)()) ok_ = false;
+    return ok_ ? size_t(n) : 0;
+  }
+  // Element count of an array whose elements take at least `min_bytes`.
+  size_t Count(size_t min_bytes = 1) {
+    const size_t n = Size();
+    if (n > size_t(end_ - p_) / min_bytes) ok_ = false;
+    return ok_ ? n : 0;
+  }
+  bool Bool() { return Pod<uint8_t>() != 0; }
+  int Int() { return int(Pod<int32_t>()); }
+  double Double() { return Pod<double>(); }
+  void String(std::string *s) {
+    const size_t n = Count();
+    s->assign(reinterpret_cast<const char *>(p_), n);
+    p_ += n;
+  }
+  template <typename T>
+  void PodArray(std::vector<T> *v) {
+    v->resize(Count(sizeof(T)));
+    if (!v->empty()) Bytes(v->data(), v->size() * sizeof(T));
+  }
+
+ private:
+  const unsigned char *p_;
+  const unsigned char *end_;
+  bool ok_ = true;
+};
+
+void SnapshotWrite(SnapshotWriter &w, const Value &v) {
+  w.Pod(uint8_t(v.Type()));
+  switch (v.Type()) {
+    case BOOL_TYPE:
+      w.Bool(v.Get<bool>());
+      break;
+    case INT_TYPE:
+      w.Int(v.Get<int>());
+      break;
+    case REAL_TYPE:
+      w.Double(v.Get<double>());
+      break;
+    case STRING_TYPE:
+      w.String(v.Get<std::string>());
+      break;
+    case BINARY_TYPE:
+      w.PodArray(v.Get<std::vector<unsigned char> >());
+      break;
+    case ARRAY_TYPE:
+      w.Size(v.ArrayLen());
+      for (const Value &e : v.Get<Value::Array>()) SnapshotWrite(w, e);
+      break;
+    case OBJECT_TYPE:
+      w.Size(v.Size());
+      for (const auto &it : v.Get<Value::Object>()) {
+        w.String(it.first);
+        SnapshotWrite(w, it.second);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void SnapshotRead(SnapshotReader &r, Value *v) {
+  switch (r.Pod<uint8_t>()) {
+    case NULL_TYPE:
+      *v = Value();
+      break;
+    case BOOL_TYPE:
+      *v = Value(r.Bool());
+      break;
+    case INT_TYPE:
+      *v = Value(r.Int());
+      break;
+    case REAL_TYPE:
+      *v = Value(r.Double());
+      break;
+    case STRING_TYPE: {
+      std::string s;
+      r.String(&s);
+      *v = Value(std::move(s));
+      break;
+    }
+    case BINARY_TYPE: {
+      std::vector<unsigned char> bytes;
+      r.PodArray(&bytes);
+      *v = Value(std::move(bytes));
+      break;
+    }
+    case ARRAY_TYPE: {
+      Value::Array a(r.Count());
+      for (Value &e : a) SnapshotRead(r, &e);
+      *v = Value(std::move(a));
+      break;
+    }
+    case OBJECT_TYPE: {
+      // Written in key order, so each emplace appends.
+      const size_t n = r.Count();
+      Value::Object o;
+      o.reserve(n);
+      for (size_t i = 0; i < n && r.ok(); i++) {
+        std::string key;
+        r.String(&key);
+        Value e;
+        SnapshotRead(r, &e);
+        o.emplace(std::move(key), std::move(e));
+      }
+      *v = Value(std::move(o));
+      break;
+    }
+    default:
+      r.Fail();
+      break;
+  }
+}
+
+template <typename T>
+void SnapshotWrite(SnapshotWriter &w, const std::map<std::string, T> &m) {
+  w.Size(m.size());
+  for (const auto &it : m) {
+    w.String(it.first);
+    SnapshotWrite(w, it.second);
+  }
+}
+
+template <typename T>
+void SnapshotRead(SnapshotReader &r, std::map<std::string, T> *m) {
+  m->clear();
+  const size_t n = r.Count();
+  for (size_t i = 0; i < n && r.ok(); i++) {
+    std::string key;
+    r.String(&key);
+    SnapshotRead(r, &(*m)[key]);
+  }
+}
+
+void SnapshotWrite(SnapshotWriter &w, int v) { w.Int(v); }
+void SnapshotRead(SnapshotReader &r, int *v) { *v = r.Int(); }
+void SnapshotWrite(SnapshotWriter &w, double v) { w.Double(v); }
+void SnapshotRead(SnapshotReader &r, double *v) { *v = r.Double(); }
+void SnapshotWrite(SnapshotWriter &w, const std::string &s) { w.String(s); }
+void SnapshotRead(SnapshotReader &r, std::string *s) { r.String(s); }
+
+template <typename T>
+void SnapshotWrite(SnapshotWriter &w, const std::vector<T> &v) {
+  w.Size(v.size());
+  for (const T &e : v) SnapshotWrite(w, e);
+}
+
+template <typename T>
+void SnapshotRead(SnapshotReader &r, std::vector<T> *v) {
+  v->resize(r.Count());
+  for (size_t i = 0; i < v->size() && r.ok(); i++) {
+    SnapshotRead(r, &(*v)[i]);
+  }
+}
+
+// The members every glTF object carries.
+template <typename T>
+void SnapshotWriteExtras(SnapshotWriter &w, const T &obj) {
+  SnapshotWrite(w, obj.extras);
+  SnapshotWrite(w, obj.extensions);
+  w.String(obj.extras_json_string);
+  w.String(obj.extensions_json_string);
+}
+
+template <typename T>
+void SnapshotReadExtras(SnapshotReader &r, T *obj) {
+  SnapshotRead(r, &obj->extras);
+  SnapshotRead(r, &obj->extensions);
+  r.String(&obj->extras_json_string);
+  r.String(&obj->extensions_json_string);
+}
+
+void SnapshotWrite(SnapshotWriter &w, const Parameter &p) {
+  w.Bool(p.bool_value);
+  w.Bool(p.has_number_value);
+  w.String(p.string_value);
+  w.PodArray(p.number_array);
+  SnapshotWrite(w, p.json_double_value);
+  w.Double(p.number_value);
+}
+
+void SnapshotRead(SnapshotReader &r, Parameter *p) {
+  p->bool_value = r.Bool();
+  p->has_number_value = r.Bool();
+  r.String(&p->string_value);
+  r.PodArray(&p->number_array);
+  SnapshotRead(r, &p->json_double_value);
+  p->number_value = r.Double();
+}
+
+void SnapshotWrite(SnapshotWriter &w, const Accessor &a) {
+  w.Int(a.bufferView);
+  w.String(a.name);
+  w.Size(a.byteOffset);
+  w.Bool(a.normalized);
+  w.Int(a.componentType);
+  w.Size(a.count);
+  w.Int(a.type);
+  SnapshotWriteExtras(w, a);
+  w.PodArray(a.minValues);
+  w.PodArray(a.maxValues);
+  w.Bool(a.sparse.isSparse);
+  if (!a.sparse.isSparse) return;
+  w.Int(a.sparse.count);
+  w.Size(a.sparse.indices.byteOffset);
+  w.Int(a.sparse.indices.bufferView);
+  w.Int(a.sparse.indices.componentType);
+  SnapshotWriteExtras(w, a.sparse.indices);
+  w.Int(a.sparse.values.bufferView);
+  w.Size(a.sparse.values.byteOffset);
+  SnapshotWriteExtras(w, a.sparse.values);
+  SnapshotWriteExtras(w, a.sparse);
+}
+
+void SnapshotRead(SnapshotReader &r, Accessor *a) {
+  a->bufferView = r.Int();
+  r.String(&a->name);
+  a->byteOffset = r.Size();
+  a->normalized = r.Bool();
+  a->componentType = r.Int();
+  a->count = r.Size();
+  a->type = r.Int();
+  SnapshotReadExtras(r, a);
+  r.PodArray(&a->minValues);
+  r.PodArray(&a->maxValues);
+  a->sparse.isSparse = r.Bool();
+  if (!a->sparse.isSparse) return;
+  a->sparse.count = r.Int();
+  a->sparse.indices.byteOffset = r.Size();
+  a->sparse.indices.bufferView = r.Int();
+  a->sparse.indices.componentType = r.Int();
+  SnapshotReadExtras(r, &a->sparse.indices);
+  a->sparse.values.bufferView = r.Int();
+  a->sparse.values.byteOffset = r.Size();
+  SnapshotReadExtras(r, &a->sparse.values);
+  SnapshotReadExtras(r, &a->sparse);
+}
+
+void SnapshotWrite(SnapshotWriter &w, const AnimationChannel &c) {
+  w.Int(c.sampler);
+  w.Int(c.target_node);
+  w.String(c.target_path);
+  SnapshotWriteExtras(w, c);
+  SnapshotWrite(w, c.target_extras);
+  SnapshotWrite(w, c.target_extensions);
+  w.String(c.target_extras_json_string);
+  w.String(c.target_extensions_json_string);
+}
+
+void SnapshotRead(SnapshotReader &r, AnimationChannel *c) {
+  c->sampler = r.Int();
+  c->target_node = r.Int();
+  r.String(&c->target_path);
+  SnapshotReadExtras(r, c);
+  SnapshotRead(r, &c->target_extras);
+  SnapshotRead(r, &c->target_extensions);
+  r.String(&c->target_extras_json_string);
+  r.String(&c->target_extensions_json_string);
+}
+
+void SnapshotWrite(SnapshotWriter &w, const AnimationSampler &s) {
+  w.Int(s.input);
+  w.Int(s.output);
+  w.String(s.interpolation);
+  SnapshotWriteExtras(w, s);
+}
+
+void SnapshotRead(SnapshotReader &r, AnimationSampler *s) {
+  s->input = r.Int();
+  s->output = r.Int();
+  r.String(&s->interpolation);
+  SnapshotReadExtras(r, s);
+}
+
+void SnapshotWrite(SnapshotWriter &w, const Animation &a) {
+  w.String(a.name);
+  SnapshotWrite(w, a.channels);
+  SnapshotWrite(w, a.samplers);
+  SnapshotWriteExtras(w, a);
+}
+
+void SnapshotRead(SnapshotReader &r, Animation *a) {
+  r.String(&a->name);
+  SnapshotRead(r, &a->channels);
+  SnapshotRead(r, &a->samplers);
+  SnapshotReadExtras(r, a);
+}
+
+void SnapshotWrite(SnapshotWriter &w, const BufferView &v) {
+  w.String(v.name);
+  w.Int(v.buffer);
+  w.Size(v.byteOffset);
+  w.Size(v.byteLength);
+  w.Size(v.byteStride);
+  w.Int(v.target);
+  SnapshotWriteExtras(w, v);
+  w.Bool(v.dracoDecoded);
+}
+
+void SnapshotRead(SnapshotReader &r, BufferView *v) {
+  r.String(&v->name);
+  v->buffer = r.Int();
+  v->byteOffset = r.Size();
+  v->byteLength = r.Size();
+  v->byteStride = r.Size();
+  v->target = r.Int();
+  SnapshotReadExtras(r, v);
+  v->dracoDecoded = r.Bool();
+}
+
+void SnapshotWrite(SnapshotWriter &w, const TextureInfo &t) {
+  w.Int(t.index);
+  w.Int(t.texCoord);
+  SnapshotWriteExtras(w, t);
+}
+
+void SnapshotRead(SnapshotReader &r, TextureInfo *t) {
+  t->index = r.Int();
+  t->texCoord = r.Int();
+  SnapshotReadExtras(r, t);
+}
+
+void SnapshotWrite(SnapshotWriter &w, const Material &m) {
+  w.String(m.name);
+  w.PodArray(m.emissiveFactor);
+  w.String(m.alphaMode);
+  w.Double(m.alphaCutoff);
+  w.Bool(m.doubleSided);
+  const PbrMetallicRoughness &pbr = m.pbrMetallicRoughness;
+  w.PodArray(pbr.baseColorFactor);
+  SnapshotWrite(w, pbr.baseColorTexture);
+  w.Double(pbr.metallicFactor);
+  w.Double(pbr.roughnessFactor);
+  SnapshotWrite(w, pbr.metallicRoughnessTexture);
+  SnapshotWriteExtras(w, pbr);
+  w.Int(m.normalTexture.index);
+  w.Int(m.normalTexture.texCoord);
+  w.Double(m.normalTexture.scale);
+  SnapshotWriteExtras(w, m.normalTexture);
+  w.Int(m.occlusionTexture.index);
+  w.Int(m.occlusionTexture.texCoord);
+  w.Double(m.occlusionTexture.strength);
+  SnapshotWriteExtras(w, m.occlusionTexture);
+  SnapshotWrite(w, m.emissiveTexture);
+  SnapshotWrite(w, m.values);
+  SnapshotWrite(w, m.additionalValues);
+  SnapshotWriteExtras(w, m);
+}
+
+void SnapshotRead(SnapshotReader &r, Material *m) {
+  r.String(&m->name);
+  r.PodArray(&m->emissiveFactor);
+  r.String(&m->alphaMode);
+  m->alphaCutoff = r.Double();
+  m->doubleSided = r.Bool();
+  PbrMetallicRoughness &pbr = m->pbrMetallicRoughness;
+  r.PodArray(&pbr.baseColorFactor);
+  SnapshotRead(r, &pbr.baseColorTexture);
+  pbr.metallicFactor = r.Double();
+  pbr.roughnessFactor = r.Double();
+  SnapshotRead(r, &pbr.metallicRoughnessTexture);
+  SnapshotReadExtras(r, &pbr);
+  m->normalTexture.index = r.Int();
+  m->normalTexture.texCoord = r.Int();
+  m->normalTexture.scale = r.Double();
+  SnapshotReadExtras(r, &m->normalTexture);
+  m->occlusionTexture.index = r.Int();
+  m->occlusionTexture.texCoord = r.Int();
+  m->occlusionTexture.strength = r.Double();
+  SnapshotReadExtras(r, &m->occlusionTexture);
+  SnapshotRead(r, &m->emissiveTexture);
+  SnapshotRead(r, &m->values);
+  SnapshotRead(r, &m->additionalValues);
+  SnapshotReadExtras(r, m);
+}
+
+void SnapshotWrite(SnapshotWriter &w, const Primitive &p) {
+  SnapshotWrite(w, p.attributes);
+  w.Int(p.material);
+  w.Int(p.indices);
+  w.Int(p.mode);
+  SnapshotWrite(w, p.targets);
+  SnapshotWriteExtras(w, p);
+}
+
+void SnapshotRead(SnapshotReader &r, Primitive *p) {
+  SnapshotRead(r, &p->attributes);
+  p->material = r.Int();
+  p->indices = r.Int();
+  p->mode = r.Int();
+  SnapshotRead(r, &p->targets);
+  SnapshotReadExtras(r, p);
+}
+
+void SnapshotWrite(SnapshotWriter &w, const Mesh &m) {
+  w.String(m.name);
+  SnapshotWrite(w, m.primitives);
+  w.PodArray(m.weights);
+  SnapshotWriteExtras(w, m);
+}
+
+void SnapshotRead(SnapshotReader &r, Mesh *m) {
+  r.String(&m->name);
+  SnapshotRead(r, &m->primitives);
+  r.PodArray(&m->weights);
+  SnapshotReadExtras(r, m);
+}
+
+void SnapshotWrite(SnapshotWriter &w, const Node &n) {
+  w.Int(n.camera);
+  w.String(n.name);
+  w.Int(n.skin);
+  w.Int(n.mesh);
+  w.Int(n.light);
+  w.Int(n.emitter);
+  w.PodArray(n.children);
+  w.PodArray(n.rotation);
+  w.PodArray(n.scale);
+  w.PodArray(n.translation);
+  w.PodArray(n.matrix);
+  w.PodArray(n.weights);
+  SnapshotWriteExtras(w, n);
+}
+
+void SnapshotRead(SnapshotReader &r, Node *n) {
+  n->camera = r.Int();
+  r.String(&n->name);
+  n->skin = r.Int();
+  n->mesh = r.Int();
+  n->light = r.Int();
+  n->emitter = r.Int();
+  r.PodArray(&n->children);
+  r.PodArray(&n->rotation);
+  r.PodArray(&n->scale);
+  r.PodArray(&n->translation);
+  r.PodArray(&n->matrix);
+  r.PodArray(&n->weights);
+  SnapshotReadExtras(r, n);
+}
+
+void SnapshotWrite(SnapshotWriter &w, const Texture &t) {
+  w.String(t.name);
+  w.Int(t.sampler);
+  w.Int(t.source);
+  SnapshotWriteExtras(w, t);
+}
+
+void SnapshotRead(SnapshotReader &r, Texture *t) {
+  r.String(&t->name);
+  t->sampler = r.Int();
+  t->source = r.Int();
+  SnapshotReadExtras(r, t);
+}
+
+void SnapshotWrite(SnapshotWriter &w, const Skin &s) {
+  w.String(s.name);
+  w.Int(s.inverseBindMatrices);
+  w.Int(s.skeleton);
+  w.PodArray(s.joints);
+  SnapshotWriteExtras(w, s);
+}
+
+void SnapshotRead(SnapshotReader &r, Skin *s) {
+  r.String(&s->name);
+  s->inverseBindMatrices = r.Int();
+  s->skeleton = r.Int();
+  r.PodArray(&s->joints);
+  SnapshotReadExtras(r, s);
+}
+
+void SnapshotWrite(SnapshotWriter &w, const Sampler &s) {
+  w.String(s.name);
+  w.Int(s.minFilter);
+  w.Int(s.magFilter);
+  w.Int(s.wrapS);
+  w.Int(s.wrapT);
+  SnapshotWriteExtras(w, s);
+}
+
+void SnapshotRead(SnapshotReader &r, Sampler *s) {
+  r.String(&s->name);
+  s->minFilter = r.Int();
+  s->magFilter = r.Int();
+  s->wrapS = r.Int();
+  s->wrapT = r.Int();
+  SnapshotReadExtras(r, s);
+}
+
+void SnapshotWrite(SnapshotWriter &w, const Camera &c) {
+  w.String(c.type);
+  w.String(c.name);
+  w.Double(c.perspective.aspectRatio);
+  w.Double(c.perspective.yfov);
+  w.Double(c.perspective.zfar);
+  w.Double(c.perspective.znear);
+  SnapshotWriteExtras(w, c.perspective);
+  w.Double(c.orthographic.xmag);
+  w.Double(c.orthographic.ymag);
+  w.Double(c.orthographic.zfar);
+  w.Double(c.orthographic.znear);
+  SnapshotWriteExtras(w, c.orthographic);
+  SnapshotWriteExtras(w, c);
+}
+
+void SnapshotRead(SnapshotReader &r, Camera *c) {
+  r.String(&c->type);
+  r.String(&c->name);
+  c->perspective.aspectRatio = r.Double();
+  c->perspective.yfov = r.Double();
+  c->perspective.zfar = r.Double();
+  c->perspective.znear = r.Double();
+  SnapshotReadExtras(r, &c->perspective);
+  c->orthographic.xmag = r.Double();
+  c->orthographic.ymag = r.Double();
+  c->orthographic.zfar = r.Double();
+  c->orthographic.znear = r.Double();
+  SnapshotReadExtras(r, &c->orthographic);
+  SnapshotReadExtras(r, c);
+}
+
+void SnapshotWrite(SnapshotWriter &w, const Scene &s) {
+  w.String(s.name);
+  w.PodArray(s.nodes);
+  w.PodArray(s.audioEmitters);
+  SnapshotWriteExtras(w, s);
+}
+
+void SnapshotRead(SnapshotReader &r, Scene *s) {
+  r.String(&s->name);
+  r.PodArray(&s->nodes);
+  r.PodArray(&s->audioEmitters);
+  SnapshotReadExtras(r, s);
+}
+
+void SnapshotWrite(SnapshotWriter &w, const Light &l) {
+  w.String(l.name);
+  w.PodArray(l.color);
+  w.Double(l.intensity);
+  w.String(l.type);
+  w.Double(l.range);
+  w.Double(l.spot.innerConeAngle);
+  w.Double(l.spot.outerConeAngle);
+  SnapshotWriteExtras(w, l.spot);
+  SnapshotWriteExtras(w, l);
+}
+
+void SnapshotRead(SnapshotReader &r, Light *l) {
+  r.String(&l->name);
+  r.PodArray(&l->color);
+  l->intensity = r.Double();
+  r.String(&l->type);
+  l->range = r.Double();
+  l->spot.innerConeAngle = r.Double();
+  l->spot.outerConeAngle = r.Double();
+  SnapshotReadExtras(r, &l->spot);
+  SnapshotReadExtras(r, l);
+}
+
+void SnapshotWrite(SnapshotWriter &w, const AudioEmitter &e) {
+  w.String(e.name);
+  w.Double(e.gain);
+  w.Bool(e.loop);
+  w.Bool(e.playing);
+  w.String(e.type);
+  w.String(e.distanceModel);
+  const PositionalEmitter &p = e.positional;
+  w.Double(p.coneInnerAngle);
+  w.Double(p.coneOuterAngle);
+  w.Double(p.coneOuterGain);
+  w.Double(p.maxDistance);
+  w.Double(p.refDistance);
+  w.Double(p.rolloffFactor);
+  SnapshotWriteExtras(w, p);
+  w.Int(e.source);
+  SnapshotWriteExtras(w, e);
+}
+
+void SnapshotRead(SnapshotReader &r, AudioEmitter *e) {
+  r.String(&e->name);
+  e->gain = r.Double();
+  e->loop = r.Bool();
+  e->playing = r.Bool();
+  r.String(&e->type);
+  r.String(&e->distanceModel);
+  PositionalEmitter &p = e->positional;
+  p.coneInnerAngle = r.Double();
+  p.coneOuterAngle = r.Double();
+  p.coneOuterGain = r.Double();
+  p.maxDistance = r.Double();
+  p.refDistance = r.Double();
+  p.rolloffFactor = r.Double();
+  SnapshotReadExtras(r, &p);
+  e->source = r.Int();
+  SnapshotReadExtras(r, e);
+}
+
+void SnapshotWrite(SnapshotWriter &w, const AudioSource &s) {
+  w.String(s.name);
+  w.String(s.uri);
+  w.Int(s.bufferView);
+  w.String(s.mimeType);
+  SnapshotWriteExtras(w, s);
+}
+
+void SnapshotRead(SnapshotReader &r, AudioSource *s) {
+  r.String(&s->name);
+  r.String(&s->uri);
+  s->bufferView = r.Int();
+  r.String(&s->mimeType);
+  SnapshotReadExtras(r, s);
+}
+
+void SnapshotWrite(SnapshotWriter &w, const Asset &a) {
+  w.String(a.version);
+  w.String(a.generator);
+  w.String(a.minVersion);
+  w.String(a.copyright);
+  SnapshotWriteExtras(w, a);
+}
+
+void SnapshotRead(SnapshotReader &r, Asset *a) {
+  r.String(&a->version);
+  r.String(&a->generator);
+  r.String(&a->minVersion);
+  r.String(&a->copyright);
+  SnapshotReadExtras(r, a);
+}
+
+// Where the bytes of a buffer or image are in the data section.
+struct SnapshotBlob {
+  size_t offset;
+  size_t size;
+};
+
+void SnapshotWrite(SnapshotWriter &w, const SnapshotBlob &blob) {
+  w.Size(blob.offset);
+  w.Size(blob.size);
+}
+
+// False if the blob lies outside the `data_size` bytes of the data section.
+bool SnapshotRead(SnapshotReader &r, size_t data_size, SnapshotBlob *blob) {
+  blob->offset = r.Size();
+  blob->size = r.Size();
+  return r.ok() && blob->offset <= data_size &&
+         blob->size <= data_size - blob->offset;
+}
+
+}  // namespace detail
+
+bool TinyGLTF::WriteSnapshotToMemory(const Model *model, uint64_t source_hash,
+                                     std::vector<unsigned char> *out,
+                                     std::string *err) const {
+  (void)err;
+
+  // Blobs as (source, size), laid out in this order.
+  std::vector<std::pair<const unsigned char *, size_t> > blobs;
+  size_t data_size = 0;
+  auto add_blob = [&](const unsigned char *data, size_t size) {
+    data_size = detail::AlignSnapshotOffset(data_size);
+    detail::SnapshotBlob blob = {data_size, size};
+    blobs.push_back(std::make_pair(data, size));
+    data_size += size;
+    return blob;
+  };
+
+  std::vector<unsigned char> tables;
+  detail::SnapshotWriter w(&tables);
+  detail::SnapshotWrite(w, model->asset);
+  w.Int(model->defaultScene);
+  detail::SnapshotWrite(w, model->extensionsUsed);
+  detail::SnapshotWrite(w, model->extensionsRequired);
+  detail::SnapshotWriteExtras(w, *model);
+  detail::SnapshotWrite(w, model->accessors);
+  detail::SnapshotWrite(w, model->animations);
+  w.Size(model->buffers.size());
+  for (const Buffer &buffer : model->buffers) {
+    w.String(buffer.name);
+    w.String(buffer.uri);
+    detail::SnapshotWriteExtras(w, buffer);
+    detail::SnapshotWrite(w, add_blob(buffer.Data(), buffer.Size()));
+  }
+  detail::SnapshotWrite(w, model->bufferViews);
+  detail::SnapshotWrite(w, model->materials);
+  detail::SnapshotWrite(w, model->meshes);
+  detail::SnapshotWrite(w, model->nodes);
+  detail::SnapshotWrite(w, model->textures);
+  w.Size(model->images.size());
+  for (const Image &image : model->images) {
+    w.String(image.name);
+    w.Int(image.width);
+    w.Int(image.height);
+    w.Int(image.component);
+    w.Int(image.bits);
+    w.Int(image.pixel_type);
+    w.Int(image.bufferView);
+    w.String(image.mimeType);
+    w.String(image.uri);
+    detail::SnapshotWriteExtras(w, image);
+    w.Bool(image.as_is);
+    // Decoded pixels, else the encoded bytes of a lazily loaded image.
+    w.Bool(image.IsDecoded());
+    const std::vector<unsigned char> &bytes =
+        image.IsDecoded() ? image.image : image.encoded;
+    detail::SnapshotWrite(w, add_blob(bytes.data(), bytes.size()));
+  }
+  detail::SnapshotWrite(w, model->skins);
+  detail::SnapshotWrite(w, model->samplers);
+  detail::SnapshotWrite(w, model->cameras);
+  detail::SnapshotWrite(w, model->scenes);
+  detail::SnapshotWrite(w, model->lights);
+  detail::SnapshotWrite(w, model->audioEmitters);
+  detail::SnapshotWrite(w, model->audioSources);
+
+  detail::SnapshotHeader header;
+  memcpy(header.magic, detail::kSnapshotMagic, sizeof(header.magic));
+  header.version = detail::kSnapshotVersion;
+  header.byte_order = detail::kSnapshotByteOrder;
+  header.source_hash = source_hash;
+  header.tables_offset = sizeof(header);
+  header.tables_size = tables.size();
+  header.data_offset = detail::AlignSnapshotOffset(
+      size_t(header.tables_offset + tables.size()));
+  header.size = header.data_offset + data_size;
+
+  out->assign(size_t(header.size), 0);
+  unsigned char *dst = out->data();
+  memcpy(dst, &header, sizeof(header));
+  memcpy(dst + header.tables_offset, tables.data(), tables.size());
+  size_t offset = 0;
+  for (const auto &blob : blobs) {
+    offset = detail::AlignSnapshotOffset(offset);
+    if (blob.second) {
+      memcpy(dst + header.data_offset + offset, blob.first, blob.second);
+    }
+    offset += blob.second;
+  }
+  return true;
+}
+
+bool TinyGLTF::WriteSnapshotToFile(const Model *model, uint64_t source_hash,
+                                   const std::string &filename,
+                                   std::string *err) const {
+  if (fs.WriteWholeFile == nullptr) {
+    if (err) {
+      (*err) += "Failed to write snapshot: WriteWholeFile callback not set.\n";
+    }
+    return false;
+  }
+  std::vector<unsigned char> bytes;
+  if (!WriteSnapshotToMemory(model, source_hash, &bytes, err)) {
+    return false;
+  }
+  return fs.WriteWholeFile(err, filename, bytes, fs.user_data);
+}
+
+bool TinyGLTF::LoadSnapshotFromMemory(Model *model, std::string *err,
+                                      std::string *warn,
+                                      const unsigned char *bytes, size_t size,
+                                      uint64_t source_hash) const {
+  return LoadSnapshot(model, err, warn, bytes, size, source_hash,
+                      NewLoadContext());
+}
+
+bool TinyGLTF::LoadSnapshot(Model *model, std::string *err, std::string *warn,
+                            const unsigned char *bytes, size_t size,
+                            uint64_t source_hash,
+                            const LoadContext &ctx) const {
+  (void)warn;
+  detail::SnapshotHeader header;
+  if (size < sizeof(header)) {
+    if (err) {
+      (*err) += "Snapshot is too short.\n";
+    }
+    return false;
+  }
+  memcpy(&header, bytes, sizeof(header));
+  if (memcmp(header.magic, detail::kSnapshotMagic, sizeof(header.magic)) != 0 ||
+      header.version != detail::kSnapshotVersion ||
+      header.byte_order != detail::kSnapshotByteOrder) {
+    if (err) {
+      (*err) += "Not a snapshot of this format version.\n";
+    }
+    return false;
+  }
+  if (header.source_hash != source_hash) {
+    if (err) {
+      (*err) += "Snapshot is stale.\n";
+    }
+    return false;
+  }
+  if (header.size != size || header.tables_offset > size ||
+      header.tables_size > size - header.tables_offset ||
+      header.data_offset > size) {
+    if (err) {
+      (*err) += "Corrupt snapshot.\n";
+    }
+    return false;
+  }
+
+  const unsigned char *data = bytes + header.data_offset;
+  const size_t data_size = size - size_t(header.data_offset);
+
+  // Build into a temporary so a failure leaves `model` untouched.
+  Model loaded;
+  detail::SnapshotReader r(bytes + header.tables_offset,
+                           size_t(header.tables_size));
+  detail::SnapshotRead(r, &loaded.asset);
+  loaded.defaultScene = r.Int();
+  detail::SnapshotRead(r, &loaded.extensionsUsed);
+  detail::SnapshotRead(r, &loaded.extensionsRequired);
+  detail::SnapshotReadExtras(r, &loaded);
+  detail::SnapshotRead(r, &loaded.accessors);
+  detail::SnapshotRead(r, &loaded.animations);
+  loaded.buffers.resize(r.Count());
+  for (Buffer &buffer : loaded.buffers) {
+    r.String(&buffer.name);
+    r.String(&buffer.uri);
+    detail::SnapshotReadExtras(r, &buffer);
+    detail::SnapshotBlob blob;
+    if (!detail::SnapshotRead(r, data_size, &blob)) {
+      r.Fail();
+      break;
+    }
+    if (ctx.borrow_binary_chunk) {
+      buffer.borrowed_data = data + blob.offset;
+      buffer.borrowed_size = blob.size;
+    } else {
+      buffer.data.assign(data + blob.offset, data + blob.offset + blob.size);
+    }
+  }
+  detail::SnapshotRead(r, &loaded.bufferViews);
+  detail::SnapshotRead(r, &loaded.materials);
+  detail::SnapshotRead(r, &loaded.meshes);
+  detail::SnapshotRead(r, &loaded.nodes);
+  detail::SnapshotRead(r, &loaded.textures);
+  loaded.images.resize(r.Count());
+  for (Image &image : loaded.images) {
+    r.String(&image.name);
+    image.width = r.Int();
+    image.height = r.Int();
+    image.component = r.Int();
+    image.bits = r.Int();
+    image.pixel_type = r.Int();
+    image.bufferView = r.Int();
+    r.String(&image.mimeType);
+    r.String(&image.uri);
+    detail::SnapshotReadExtras(r, &image);
+    image.as_is = r.Bool();
+    const bool decoded = r.Bool();
+    detail::SnapshotBlob blob;
+    if (!detail::SnapshotRead(r, data_size, &blob)) {
+      r.Fail();
+      break;
+    }
+    std::vector<unsigned char> &dst = decoded ? image.image : image.encoded;
+    dst.assign(data + blob.offset, data + blob.offset + blob.size);
+  }
+  detail::SnapshotRead(r, &loaded.skins);
+  detail::SnapshotRead(r, &loaded.samplers);
+  detail::SnapshotRead(r, &loaded.cameras);
+  detail::SnapshotRead(r, &loaded.scenes);
+  detail::SnapshotRead(r, &loaded.lights);
+  detail::SnapshotRead(r, &loaded.audioEmitters);
+  detail::SnapshotRead(r, &loaded.audioSources);
+  if (!r.ok()) {
+    if (err) {
+      (*err) += "Corrupt snapshot tables.\n";
+    }
+    return false;
+  }
+
+  (*model) = std::move(loaded);
+  return true;
+}
+
+bool TinyGLTF::LoadSnapshotFromFile(Model *model, std::string *err,
+                                    std::string *warn,
+                                    const std::string &filename,
+                                    uint64_t source_hash) const {
+  if (fs.ReadWholeFile == nullptr) {
+    if (err) {
+      (*err) += "Failed to read snapshot: one or more FS callback not set.\n";
+    }
+    return false;
+  }
+
+  std::shared_ptr<detail::FileBytes> data =
+      std::make_shared<detail::FileBytes>();
+  if (!data->Read(err, filename, &fs)) {
+    return false;
+  }
+
+  // Borrowed buffers share ownership of the file bytes.
+  if (!LoadSnapshot(model, err, warn, data->data, data->size, source_hash,
+                    NewLoadContext())) {
+    return false;
+  }
+  detail::SetBorrowedOwner(model, data);
+  return true;
+}
+
+bool TinyGLTF::LoadFromFileCached(Model *model, std::string *err,
+                                  std::string *warn,
+                                  const std::string &filename,
+                                  const std::string &snapshot_filename,
+                                  unsigned int check_sections) const {
+  if (fs.ReadWholeFile == nullptr) {
+    if (err) {
+      (*err) = "Failed to read file: " + filename +
+               ": one or more FS callback not set\n";
+    }
+    return false;
+  }
+
+  std::shared_ptr<detail::FileBytes> data =
+      std::make_shared<detail::FileBytes>();
+  std::string fileerr;
+  if (!data->Read(&fileerr, filename, &fs)) {
+    if (err) {
+      (*err) = "Failed to read file: " + filename + ": " + fileerr + "\n";
+    }
+    return false;
+  }
+
+  const uint64_t hash = HashBytes(data->data, data->size);
+  {
+    // A missing or stale snapshot is not an error.
+    std::string snapshot_err;
+    if (LoadSnapshotFromFile(model, &snapshot_err, warn, snapshot_filename,
+                             hash)) {
+      return true;
+    }
+  }
+
+  // The snapshot stands for the whole file, so it is never filtered.
+  LoadContext ctx = NewLoadContext();
+  ctx.filter = LoadFilter();
+  if (!LoadFromBytes(model, err, warn, data->data, data->size,
+                     GetBaseDir(filename), check_sections, ctx)) {
+    return false;
+  }
+  detail::SetBorrowedOwner(model, data);
+
+  std::string snapshot_err;
+  if (!WriteSnapshotToFile(model, hash, snapshot_filename, &snapshot_err) &&
+      warn) {
+    (*warn) += "Failed to write snapshot " + snapshot_filename + ": " +
+               snapshot_err + "\n";
   }
+  return true;
 }
 
 }  // namespace tinygltf